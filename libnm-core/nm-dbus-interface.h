@@ -34,6 +34,7 @@
 #define NM_DBUS_SERVICE                     "org.freedesktop.NetworkManager"
 
 #define NM_DBUS_PATH                        "/org/freedesktop/NetworkManager"
+#define NM_DBUS_PATH_OBJECT_MANAGER         "/org/freedesktop"
 #define NM_DBUS_INTERFACE                   "org.freedesktop.NetworkManager"
 #define NM_DBUS_INTERFACE_DEVICE            NM_DBUS_INTERFACE ".Device"
 #define NM_DBUS_INTERFACE_DEVICE_WIRED      NM_DBUS_INTERFACE_DEVICE ".Wired"
@@ -545,6 +545,16 @@ new_connection_cb (DBusGProxy *proxy, const char *path, gpointer user_data)
 	return connection;
 }
 
+static void
+connections_added_cb (DBusGProxy *proxy, GPtrArray *paths, gpointer user_data)
+{
+	int i;
+
+	/* Sent instead of NewConnection for batched requests */
+	for (i = 0; i < paths->len; i++)
+		new_connection_cb (proxy, g_ptr_array_index (paths, i), user_data);
+}
+
 static void
 fetch_connections_done (DBusGProxy *proxy,
                         DBusGProxyCall *call,
@@ -1201,6 +1211,14 @@ constructed (GObject *object)
 	                             object,
 	                             NULL);
 
+	dbus_g_proxy_add_signal (priv->proxy, "ConnectionsAdded",
+	                         DBUS_TYPE_G_ARRAY_OF_OBJECT_PATH,
+	                         G_TYPE_INVALID);
+	dbus_g_proxy_connect_signal (priv->proxy, "ConnectionsAdded",
+	                             G_CALLBACK (connections_added_cb),
+	                             object,
+	                             NULL);
+
 	/* D-Bus properties proxy */
 	priv->props_proxy = _nm_dbus_new_proxy_for_connection (priv->bus,
 	                                                       NM_DBUS_PATH_SETTINGS,
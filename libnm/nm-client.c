@@ -1727,19 +1727,33 @@ init_sync (GInitable *initable, GCancellable *cancellable, GError **error)
 {
 	NMClient *client = NM_CLIENT (initable);
 	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (client);
+	GDBusConnection *connection;
+	gboolean success = FALSE;
 
-	if (!g_initable_init (G_INITABLE (priv->manager), cancellable, error))
-		return FALSE;
-	if (!g_initable_init (G_INITABLE (priv->settings), cancellable, error))
-		return FALSE;
+	/* Fetch the state of all objects in one go rather than object by object;
+	 * the manager and settings use the same connection.
+	 */
+	connection = _nm_dbus_new_connection (cancellable, NULL);
+	if (connection)
+		_nm_object_cache_snapshot_load (connection, cancellable);
+
+	if (   g_initable_init (G_INITABLE (priv->manager), cancellable, error)
+	    && g_initable_init (G_INITABLE (priv->settings), cancellable, error))
+		success = TRUE;
 
-	return TRUE;
+	if (connection) {
+		_nm_object_cache_snapshot_release ();
+		g_object_unref (connection);
+	}
+
+	return success;
 }
 
 typedef struct {
 	NMClient *client;
 	GCancellable *cancellable;
 	GSimpleAsyncResult *result;
+	gboolean snapshot_loaded;
 	gboolean manager_inited;
 	gboolean settings_inited;
 } NMClientInitData;
@@ -1747,6 +1761,9 @@ typedef struct {
 static void
 init_async_complete (NMClientInitData *init_data)
 {
+	if (init_data->snapshot_loaded)
+		_nm_object_cache_snapshot_release ();
+
 	g_simple_async_result_complete (init_data->result);
 	g_object_unref (init_data->result);
 	g_clear_object (&init_data->cancellable);
@@ -1781,12 +1798,46 @@ init_async_inited_settings (GObject *object, GAsyncResult *result, gpointer user
 		init_async_complete (init_data);
 }
 
+static void
+init_async_got_snapshot (gpointer user_data)
+{
+	NMClientInitData *init_data = user_data;
+	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (init_data->client);
+
+	g_async_initable_init_async (G_ASYNC_INITABLE (priv->manager),
+	                             G_PRIORITY_DEFAULT, init_data->cancellable,
+	                             init_async_inited_manager, init_data);
+	g_async_initable_init_async (G_ASYNC_INITABLE (priv->settings),
+	                             G_PRIORITY_DEFAULT, init_data->cancellable,
+	                             init_async_inited_settings, init_data);
+}
+
+static void
+init_async_got_bus (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+	NMClientInitData *init_data = user_data;
+	GDBusConnection *connection;
+
+	/* If this failed, the manager and settings will fail the same way and
+	 * report it.
+	 */
+	connection = _nm_dbus_new_connection_finish (result, NULL);
+	if (!connection) {
+		init_async_got_snapshot (init_data);
+		return;
+	}
+
+	init_data->snapshot_loaded = TRUE;
+	_nm_object_cache_snapshot_load_async (connection, init_data->cancellable,
+	                                      init_async_got_snapshot, init_data);
+	g_object_unref (connection);
+}
+
 static void
 init_async (GAsyncInitable *initable, int io_priority,
             GCancellable *cancellable, GAsyncReadyCallback callback,
             gpointer user_data)
 {
-	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (initable);
 	NMClientInitData *init_data;
 
 	init_data = g_slice_new0 (NMClientInitData);
@@ -1796,12 +1847,8 @@ init_async (GAsyncInitable *initable, int io_priority,
 	                                               user_data, init_async);
 	g_simple_async_result_set_op_res_gboolean (init_data->result, TRUE);
 
-	g_async_initable_init_async (G_ASYNC_INITABLE (priv->manager),
-	                             G_PRIORITY_DEFAULT, init_data->cancellable,
-	                             init_async_inited_manager, init_data);
-	g_async_initable_init_async (G_ASYNC_INITABLE (priv->settings),
-	                             G_PRIORITY_DEFAULT, init_data->cancellable,
-	                             init_async_inited_settings, init_data);
+	/* Fetch the state of all objects in one go rather than object by object */
+	_nm_dbus_new_connection_async (init_data->cancellable, init_async_got_bus, init_data);
 }
 
 static gboolean
@@ -32,6 +32,7 @@
 #define DBUS_INTERFACE_INTROSPECTABLE "org.freedesktop.DBus.Introspectable"
 #define DBUS_INTERFACE_PROPERTIES     "org.freedesktop.DBus.Properties"
 #define DBUS_INTERFACE_PEER           "org.freedesktop.DBus.Peer"
+#define DBUS_INTERFACE_OBJECT_MANAGER "org.freedesktop.DBus.ObjectManager"
 
 
 GBusType _nm_dbus_bus_type (void);
@@ -24,6 +24,9 @@
 #include <glib.h>
 #include "nm-object-cache.h"
 #include "nm-object.h"
+#include "nm-object-private.h"
+#include "nm-dbus-interface.h"
+#include "nm-dbus-helpers.h"
 
 static GHashTable *cache = NULL;
 
@@ -88,3 +91,289 @@ _nm_object_cache_clear (void)
 		g_hash_table_iter_remove (&iter);
 	}
 }
+
+/**************************************************************/
+
+typedef struct {
+	GDBusConnection *connection;
+	GHashTable *objects;   /* path -> (interface -> a{sv}) */
+	guint signal_id;
+	guint users;
+	guint free_id;
+} Snapshot;
+
+static Snapshot *snapshot = NULL;
+
+static void
+snapshot_properties_changed (GDBusConnection *connection,
+                             const char *sender_name,
+                             const char *object_path,
+                             const char *interface_name,
+                             const char *signal_name,
+                             GVariant *parameters,
+                             gpointer user_data)
+{
+	NMObject *object;
+	GVariant *properties;
+
+	if (!snapshot)
+		return;
+
+	/* What the snapshot knows about the object is stale now; if the object
+	 * isn't created yet, it will fetch its properties itself.
+	 */
+	if (g_hash_table_remove (snapshot->objects, object_path))
+		return;
+
+	/* Otherwise it may have been created after the signal arrived but
+	 * before its own proxies were around to see it.  Signals are handled
+	 * in order, so applying it again is harmless.
+	 */
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
+		return;
+
+	object = _nm_object_cache_get (object_path);
+	if (object) {
+		g_variant_get (parameters, "(@a{sv})", &properties);
+		_nm_object_process_properties_changed (object, properties);
+		g_variant_unref (properties);
+		g_object_unref (object);
+	}
+}
+
+static void
+snapshot_free (void)
+{
+	if (!snapshot)
+		return;
+
+	if (snapshot->free_id)
+		g_source_remove (snapshot->free_id);
+	g_dbus_connection_signal_unsubscribe (snapshot->connection, snapshot->signal_id);
+	g_object_unref (snapshot->connection);
+	g_hash_table_destroy (snapshot->objects);
+	g_slice_free (Snapshot, snapshot);
+	snapshot = NULL;
+}
+
+static gboolean
+snapshot_free_cb (gpointer user_data)
+{
+	snapshot->free_id = 0;
+	snapshot_free ();
+	return G_SOURCE_REMOVE;
+}
+
+static const char *
+snapshot_bus_name (GDBusConnection *connection)
+{
+	return _nm_dbus_is_connection_private (connection) ? NULL : NM_DBUS_SERVICE;
+}
+
+static void
+snapshot_ref (GDBusConnection *connection)
+{
+	if (snapshot && snapshot->connection != connection && !snapshot->users)
+		snapshot_free ();
+
+	if (!snapshot) {
+		snapshot = g_slice_new0 (Snapshot);
+		snapshot->connection = g_object_ref (connection);
+		snapshot->objects = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                           g_free, (GDestroyNotify) g_hash_table_destroy);
+
+		/* Subscribe before asking for the snapshot, so that no change
+		 * made after it was taken gets lost.  NetworkManager emits
+		 * PropertiesChanged on each object's own interfaces.
+		 */
+		snapshot->signal_id =
+			g_dbus_connection_signal_subscribe (connection,
+			                                    snapshot_bus_name (connection),
+			                                    NULL,
+			                                    "PropertiesChanged",
+			                                    NULL,
+			                                    NULL,
+			                                    G_DBUS_SIGNAL_FLAGS_NONE,
+			                                    snapshot_properties_changed,
+			                                    NULL, NULL);
+	}
+
+	if (snapshot->free_id) {
+		g_source_remove (snapshot->free_id);
+		snapshot->free_id = 0;
+	}
+	snapshot->users++;
+}
+
+static void
+snapshot_fill (GVariant *ret)
+{
+	GVariantIter *objects, *interfaces;
+	const char *path, *interface;
+	GVariant *properties;
+	GHashTable *hash;
+
+	g_variant_get (ret, "(a{oa{sa{sv}}})", &objects);
+	while (g_variant_iter_next (objects, "{&oa{sa{sv}}}", &path, &interfaces)) {
+		hash = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                              g_free, (GDestroyNotify) g_variant_unref);
+		while (g_variant_iter_next (interfaces, "{&s@a{sv}}", &interface, &properties))
+			g_hash_table_insert (hash, g_strdup (interface), properties);
+		g_variant_iter_free (interfaces);
+
+		g_hash_table_insert (snapshot->objects, g_strdup (path), hash);
+	}
+	g_variant_iter_free (objects);
+}
+
+/**
+ * _nm_object_cache_snapshot_load:
+ * @connection: the connection objects are going to be created on
+ * @cancellable: a #GCancellable
+ *
+ * Fetches the properties of all objects NetworkManager exports, for
+ * objects created on @connection to use instead of asking for them one by
+ * one.  Each call must be paired with _nm_object_cache_snapshot_release().
+ * If NetworkManager doesn't support it, objects just fetch their
+ * properties themselves.
+ */
+void
+_nm_object_cache_snapshot_load (GDBusConnection *connection, GCancellable *cancellable)
+{
+	GVariant *ret;
+
+	snapshot_ref (connection);
+	ret = g_dbus_connection_call_sync (connection,
+	                                   snapshot_bus_name (connection),
+	                                   NM_DBUS_PATH_OBJECT_MANAGER,
+	                                   DBUS_INTERFACE_OBJECT_MANAGER,
+	                                   "GetManagedObjects",
+	                                   NULL,
+	                                   G_VARIANT_TYPE ("(a{oa{sa{sv}}})"),
+	                                   G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                                   -1, cancellable, NULL);
+	if (ret) {
+		if (snapshot->connection == connection)
+			snapshot_fill (ret);
+		g_variant_unref (ret);
+	}
+}
+
+typedef struct {
+	GDBusConnection *connection;
+	NMObjectCacheSnapshotFunc callback;
+	gpointer user_data;
+} SnapshotLoadData;
+
+static void
+snapshot_got_objects (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	SnapshotLoadData *data = user_data;
+	GVariant *ret;
+
+	ret = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, NULL);
+	if (ret) {
+		if (snapshot->connection == data->connection)
+			snapshot_fill (ret);
+		g_variant_unref (ret);
+	}
+
+	data->callback (data->user_data);
+	g_object_unref (data->connection);
+	g_slice_free (SnapshotLoadData, data);
+}
+
+void
+_nm_object_cache_snapshot_load_async (GDBusConnection *connection,
+                                      GCancellable *cancellable,
+                                      NMObjectCacheSnapshotFunc callback,
+                                      gpointer user_data)
+{
+	SnapshotLoadData *data;
+
+	data = g_slice_new (SnapshotLoadData);
+	data->connection = g_object_ref (connection);
+	data->callback = callback;
+	data->user_data = user_data;
+
+	snapshot_ref (connection);
+	g_dbus_connection_call (connection,
+	                        snapshot_bus_name (connection),
+	                        NM_DBUS_PATH_OBJECT_MANAGER,
+	                        DBUS_INTERFACE_OBJECT_MANAGER,
+	                        "GetManagedObjects",
+	                        NULL,
+	                        G_VARIANT_TYPE ("(a{oa{sa{sv}}})"),
+	                        G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                        -1, cancellable,
+	                        snapshot_got_objects, data);
+}
+
+void
+_nm_object_cache_snapshot_release (void)
+{
+	g_return_if_fail (snapshot && snapshot->users);
+
+	if (--snapshot->users)
+		return;
+
+	/* Keep watching for changes until signals that are already queued
+	 * have been seen; they may be about objects created from the snapshot.
+	 */
+	g_hash_table_remove_all (snapshot->objects);
+	snapshot->free_id = g_idle_add (snapshot_free_cb, NULL);
+}
+
+static GHashTable *
+snapshot_lookup (GDBusConnection *connection, const char *path)
+{
+	if (!snapshot || snapshot->connection != connection)
+		return NULL;
+
+	return g_hash_table_lookup (snapshot->objects, path);
+}
+
+/* Returns a reference to the value of @property, or %NULL */
+GVariant *
+_nm_object_cache_snapshot_get_property (GDBusConnection *connection,
+                                        const char *path,
+                                        const char *interface,
+                                        const char *property)
+{
+	GHashTable *interfaces;
+	GVariant *properties;
+
+	interfaces = snapshot_lookup (connection, path);
+	if (!interfaces)
+		return NULL;
+
+	properties = g_hash_table_lookup (interfaces, interface);
+	if (!properties)
+		return NULL;
+
+	return g_variant_lookup_value (properties, property, NULL);
+}
+
+/* Returns the properties of @interface and forgets about them; they are
+ * only good for initializing the object once.
+ */
+GVariant *
+_nm_object_cache_snapshot_take (GDBusConnection *connection,
+                                const char *path,
+                                const char *interface)
+{
+	GHashTable *interfaces;
+	GVariant *properties;
+
+	interfaces = snapshot_lookup (connection, path);
+	if (!interfaces)
+		return NULL;
+
+	properties = g_hash_table_lookup (interfaces, interface);
+	if (properties) {
+		g_variant_ref (properties);
+		g_hash_table_remove (interfaces, interface);
+	}
+
+	return properties;
+}
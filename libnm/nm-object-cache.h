@@ -23,6 +23,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <gio/gio.h>
 #include "nm-object.h"
 
 G_BEGIN_DECLS
@@ -32,6 +33,27 @@ NMObject *_nm_object_cache_get (const char *path);
 void _nm_object_cache_add (NMObject *object);
 void _nm_object_cache_clear (void);
 
+/* Properties of all objects from a single GetManagedObjects call, used
+ * instead of a GetAll per object while a client initializes.
+ */
+typedef void (*NMObjectCacheSnapshotFunc) (gpointer user_data);
+
+void      _nm_object_cache_snapshot_load         (GDBusConnection *connection,
+                                                  GCancellable *cancellable);
+void      _nm_object_cache_snapshot_load_async   (GDBusConnection *connection,
+                                                  GCancellable *cancellable,
+                                                  NMObjectCacheSnapshotFunc callback,
+                                                  gpointer user_data);
+void      _nm_object_cache_snapshot_release      (void);
+
+GVariant *_nm_object_cache_snapshot_get_property (GDBusConnection *connection,
+                                                  const char *path,
+                                                  const char *interface,
+                                                  const char *property);
+GVariant *_nm_object_cache_snapshot_take         (GDBusConnection *connection,
+                                                  const char *path,
+                                                  const char *interface);
+
 G_END_DECLS
 
 #endif /* __NM_OBJECT_CACHE_H__ */
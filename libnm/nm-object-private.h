@@ -50,6 +50,8 @@ gboolean _nm_object_reload_properties_finish (NMObject *object,
 
 void _nm_object_queue_notify (NMObject *object, const char *property);
 
+void _nm_object_process_properties_changed (NMObject *object, GVariant *properties);
+
 void _nm_object_suppress_property_updates (NMObject *object, gboolean suppress);
 
 /* DBus property accessors */
@@ -379,34 +379,40 @@ _nm_object_create (GType type, GDBusConnection *connection, const char *path)
 		GDBusProxy *proxy;
 		GVariant *ret, *value;
 
-		proxy = _nm_dbus_new_proxy_for_connection (connection, path,
-		                                           DBUS_INTERFACE_PROPERTIES,
-		                                           NULL, &error);
-		if (!proxy) {
-			g_warning ("Could not create proxy for %s: %s.", path, error->message);
-			g_error_free (error);
-			return NULL;
-		}
+		value = _nm_object_cache_snapshot_get_property (connection, path,
+		                                                type_data->interface,
+		                                                type_data->property);
+		if (!value) {
+			proxy = _nm_dbus_new_proxy_for_connection (connection, path,
+			                                           DBUS_INTERFACE_PROPERTIES,
+			                                           NULL, &error);
+			if (!proxy) {
+				g_warning ("Could not create proxy for %s: %s.", path, error->message);
+				g_error_free (error);
+				return NULL;
+			}
 
-		ret = g_dbus_proxy_call_sync (proxy,
-		                              "Get",
-		                              g_variant_new ("(ss)",
-		                                             type_data->interface,
-		                                             type_data->property),
-		                              G_DBUS_CALL_FLAGS_NONE, -1,
-		                              NULL, &error);
-		g_object_unref (proxy);
-		if (!ret) {
-			dbgmsg ("Could not fetch property '%s' of interface '%s' on %s: %s\n",
-			           type_data->property, type_data->interface, path, error->message);
-			g_error_free (error);
-			return NULL;
+			ret = g_dbus_proxy_call_sync (proxy,
+			                              "Get",
+			                              g_variant_new ("(ss)",
+			                                             type_data->interface,
+			                                             type_data->property),
+			                              G_DBUS_CALL_FLAGS_NONE, -1,
+			                              NULL, &error);
+			g_object_unref (proxy);
+			if (!ret) {
+				dbgmsg ("Could not fetch property '%s' of interface '%s' on %s: %s\n",
+				           type_data->property, type_data->interface, path, error->message);
+				g_error_free (error);
+				return NULL;
+			}
+
+			g_variant_get (ret, "(v)", &value);
+			g_variant_unref (ret);
 		}
 
-		g_variant_get (ret, "(v)", &value);
 		type = type_data->type_func (value);
 		g_variant_unref (value);
-		g_variant_unref (ret);
 	}
 
 	if (type == G_TYPE_INVALID) {
@@ -567,6 +573,18 @@ _nm_object_create_async (GType type, GDBusConnection *connection, const char *pa
 
 	async_data->type_data = g_hash_table_lookup (type_funcs, GSIZE_TO_POINTER (type));
 	if (async_data->type_data) {
+		GVariant *value;
+
+		value = _nm_object_cache_snapshot_get_property (connection, path,
+		                                                async_data->type_data->interface,
+		                                                async_data->type_data->property);
+		if (value) {
+			type = async_data->type_data->type_func (value);
+			g_variant_unref (value);
+			create_async_got_type (async_data, type);
+			return;
+		}
+
 		_nm_dbus_new_proxy_for_connection_async (connection, path,
 		                                         DBUS_INTERFACE_PROPERTIES,
 		                                         NULL,
@@ -958,6 +976,12 @@ process_properties_changed (NMObject *self, GVariant *properties, gboolean synch
 		handle_property_changed (self, name, value, synchronously);
 }
 
+void
+_nm_object_process_properties_changed (NMObject *object, GVariant *properties)
+{
+	process_properties_changed (object, properties, FALSE);
+}
+
 static void
 property_proxy_signal (GDBusProxy *proxy,
                        const char *sender_name,
@@ -1154,21 +1178,25 @@ _nm_object_reload_properties (NMObject *object, GError **error)
 
 	g_hash_table_iter_init (&iter, priv->proxies);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &interface, (gpointer *) &proxy)) {
-		ret = g_dbus_proxy_call_sync (priv->properties_proxy,
-		                              "GetAll",
-		                              g_variant_new ("(s)", interface),
-		                              G_DBUS_CALL_FLAGS_NONE, -1,
-		                              NULL, error);
-		if (!ret) {
-			if (error && *error)
-				g_dbus_error_strip_remote_error (*error);
-			return FALSE;
+		props = _nm_object_cache_snapshot_take (priv->connection, priv->path, interface);
+		if (!props) {
+			ret = g_dbus_proxy_call_sync (priv->properties_proxy,
+			                              "GetAll",
+			                              g_variant_new ("(s)", interface),
+			                              G_DBUS_CALL_FLAGS_NONE, -1,
+			                              NULL, error);
+			if (!ret) {
+				if (error && *error)
+					g_dbus_error_strip_remote_error (*error);
+				return FALSE;
+			}
+
+			g_variant_get (ret, "(@a{sv})", &props);
+			g_variant_unref (ret);
 		}
 
-		g_variant_get (ret, "(@a{sv})", &props);
 		process_properties_changed (object, props, TRUE);
 		g_variant_unref (props);
-		g_variant_unref (ret);
 	}
 
 	if (--priv->reload_remaining == 0)
@@ -1332,6 +1360,7 @@ _nm_object_reload_properties_async (NMObject *object,
 	GHashTableIter iter;
 	const char *interface;
 	GDBusProxy *proxy;
+	GVariant *props;
 
 	simple = g_simple_async_result_new (G_OBJECT (object), callback,
 	                                    user_data, _nm_object_reload_properties_async);
@@ -1351,8 +1380,17 @@ _nm_object_reload_properties_async (NMObject *object,
 	if (priv->reload_results->next)
 		return;
 
+	priv->reload_remaining++;
+
 	g_hash_table_iter_init (&iter, priv->proxies);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &interface, (gpointer *) &proxy)) {
+		props = _nm_object_cache_snapshot_take (priv->connection, priv->path, interface);
+		if (props) {
+			process_properties_changed (object, props, FALSE);
+			g_variant_unref (props);
+			continue;
+		}
+
 		priv->reload_remaining++;
 		g_dbus_proxy_call (priv->properties_proxy,
 		                   "GetAll",
@@ -1361,6 +1399,9 @@ _nm_object_reload_properties_async (NMObject *object,
 		                   cancellable,
 		                   reload_got_properties, object);
 	}
+
+	if (--priv->reload_remaining == 0)
+		reload_complete (object, FALSE);
 }
 
 gboolean
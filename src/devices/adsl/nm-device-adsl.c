@@ -608,6 +608,7 @@ nm_device_adsl_class_init (NMDeviceAdslClass *klass)
 
 	parent_class->get_generic_capabilities = get_generic_capabilities;
 
+	parent_class->compatible_connection_type = NM_SETTING_ADSL_SETTING_NAME;
 	parent_class->check_connection_compatible = check_connection_compatible;
 	parent_class->complete_connection = complete_connection;
 
@@ -1190,6 +1190,7 @@ nm_device_bt_class_init (NMDeviceBtClass *klass)
 	device_class->act_stage2_config = act_stage2_config;
 	device_class->act_stage3_ip4_config_start = act_stage3_ip4_config_start;
 	device_class->act_stage3_ip6_config_start = act_stage3_ip6_config_start;
+	device_class->compatible_connection_type = NM_SETTING_BLUETOOTH_SETTING_NAME;
 	device_class->check_connection_compatible = check_connection_compatible;
 	device_class->check_connection_available = check_connection_available;
 	device_class->complete_connection = complete_connection;
@@ -369,9 +369,9 @@ act_stage1_prepare (NMDevice *dev, NMDeviceStateReason *reason)
 		return ret;
 
 	/* Interface must be down to set bond options */
-	nm_device_take_down (dev, TRUE);
+	nm_device_take_down (dev, FALSE);
 	ret = apply_bonding_config (dev);
-	nm_device_bring_up (dev, TRUE, &no_firmware);
+	nm_device_bring_up (dev, FALSE, &no_firmware);
 
 	return ret;
 }
@@ -389,10 +389,10 @@ enslave_slave (NMDevice *device,
 	nm_device_master_check_slave_physical_port (device, slave, LOGD_BOND);
 
 	if (configure) {
-		nm_device_take_down (slave, TRUE);
+		nm_device_take_down (slave, FALSE);
 		success = nm_platform_link_enslave (nm_device_get_ip_ifindex (device),
 		                                    nm_device_get_ip_ifindex (slave));
-		nm_device_bring_up (slave, TRUE, &no_firmware);
+		nm_device_bring_up (slave, FALSE, &no_firmware);
 
 		if (!success)
 			return FALSE;
@@ -437,7 +437,7 @@ release_slave (NMDevice *device,
 		 * IFF_UP), so we must bring it back up here to ensure carrier changes and
 		 * other state is noticed by the now-released slave.
 		 */
-		if (!nm_device_bring_up (slave, TRUE, &no_firmware))
+		if (!nm_device_bring_up (slave, FALSE, &no_firmware))
 			_LOGW (LOGD_BOND, "released bond slave could not be brought up.");
 	}
 
@@ -494,6 +494,7 @@ nm_device_bond_class_init (NMDeviceBondClass *klass)
 	g_type_class_add_private (object_class, sizeof (NMDeviceBondPrivate));
 
 	parent_class->connection_type = NM_SETTING_BOND_SETTING_NAME;
+	parent_class->compatible_connection_type = NM_SETTING_BOND_SETTING_NAME;
 
 	/* virtual methods */
 	object_class->get_property = get_property;
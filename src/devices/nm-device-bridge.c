@@ -439,6 +439,7 @@ nm_device_bridge_class_init (NMDeviceBridgeClass *klass)
 	g_type_class_add_private (object_class, sizeof (NMDeviceBridgePrivate));
 
 	parent_class->connection_type = NM_SETTING_BRIDGE_SETTING_NAME;
+	parent_class->compatible_connection_type = NM_SETTING_BRIDGE_SETTING_NAME;
 
 	/* virtual methods */
 	object_class->get_property = get_property;
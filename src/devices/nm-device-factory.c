@@ -125,6 +125,25 @@ nm_device_factory_start (NMDeviceFactory *factory)
 		NM_DEVICE_FACTORY_GET_INTERFACE (factory)->start (factory);
 }
 
+gboolean
+nm_device_factory_get_supported_types (NMDeviceFactory *factory,
+                                       const NMLinkType **out_link_types,
+                                       const char ***out_setting_types)
+{
+	const char **setting_types = NULL;
+
+	g_return_val_if_fail (factory != NULL, FALSE);
+	g_return_val_if_fail (out_link_types != NULL, FALSE);
+	g_return_val_if_fail (out_setting_types != NULL, FALSE);
+
+	if (!NM_DEVICE_FACTORY_GET_INTERFACE (factory)->get_supported_types)
+		return FALSE;
+
+	NM_DEVICE_FACTORY_GET_INTERFACE (factory)->get_supported_types (factory, out_link_types, &setting_types);
+	*out_setting_types = setting_types;
+	return TRUE;
+}
+
 NMDevice *
 nm_device_factory_new_link (NMDeviceFactory *factory,
                             NMPlatformLink *plink,
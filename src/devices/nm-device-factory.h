@@ -84,6 +84,23 @@ struct _NMDeviceFactory {
 	 */
 	void (*start)                   (NMDeviceFactory *factory);
 
+	/**
+	 * get_supported_types:
+	 * @factory: the #NMDeviceFactory
+	 * @out_link_types: (out): the link types the factory creates devices for,
+	 *   terminated by %NM_LINK_TYPE_NONE
+	 * @out_setting_types: (out): the connection types the factory creates
+	 *   virtual devices for, %NULL-terminated, or %NULL
+	 *
+	 * Optional.  Factories that only create devices for new links and
+	 * connections of these types, and don't find any on their own in
+	 * start(), should implement this.  Their plugin is then only loaded
+	 * once such a link or connection shows up.
+	 */
+	void (*get_supported_types)     (NMDeviceFactory *factory,
+	                                 const NMLinkType **out_link_types,
+	                                 const char ***out_setting_types);
+
 	/**
 	 * new_link:
 	 * @factory: the #NMDeviceFactory
@@ -155,6 +172,10 @@ NMDeviceType nm_device_factory_get_device_type (NMDeviceFactory *factory);
 
 void       nm_device_factory_start       (NMDeviceFactory *factory);
 
+gboolean   nm_device_factory_get_supported_types (NMDeviceFactory *factory,
+                                                  const NMLinkType **out_link_types,
+                                                  const char ***out_setting_types);
+
 NMDevice * nm_device_factory_new_link    (NMDeviceFactory *factory,
                                           NMPlatformLink *plink,
                                           GError **error);
@@ -177,6 +177,7 @@ nm_device_generic_class_init (NMDeviceGenericClass *klass)
 	g_type_class_add_private (klass, sizeof (NMDeviceGenericPrivate));
 
 	parent_class->connection_type = NM_SETTING_GENERIC_SETTING_NAME;
+	parent_class->compatible_connection_type = NM_SETTING_GENERIC_SETTING_NAME;
 
 	object_class->constructed = constructed;
 	object_class->dispose = dispose;
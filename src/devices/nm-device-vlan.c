@@ -58,6 +58,7 @@ typedef struct {
 
 	NMDevice *parent;
 	guint parent_state_id;
+	gboolean waiting_for_parent;
 
 	int vlan_id;
 } NMDeviceVlanPrivate;
@@ -91,20 +92,6 @@ get_generic_capabilities (NMDevice *dev)
 	return NM_DEVICE_CAP_CARRIER_DETECT;
 }
 
-static gboolean
-bring_up (NMDevice *dev, gboolean *no_firmware)
-{
-	gboolean success = FALSE;
-	guint i = 20;
-
-	while (i-- > 0 && !success) {
-		success = NM_DEVICE_CLASS (nm_device_vlan_parent_class)->bring_up (dev, no_firmware);
-		g_usleep (50);
-	}
-
-	return success;
-}
-
 /******************************************************************/
 
 static gboolean
@@ -317,6 +304,8 @@ update_connection (NMDevice *device, NMConnection *connection)
 static NMActStageReturn
 act_stage1_prepare (NMDevice *dev, NMDeviceStateReason *reason)
 {
+	NMDeviceVlan *self = NM_DEVICE_VLAN (dev);
+	NMDeviceVlanPrivate *priv = NM_DEVICE_VLAN_GET_PRIVATE (self);
 	NMActRequest *req;
 	NMConnection *connection;
 	NMSettingVlan *s_vlan;
@@ -326,6 +315,23 @@ act_stage1_prepare (NMDevice *dev, NMDeviceStateReason *reason)
 
 	g_return_val_if_fail (reason != NULL, NM_ACT_STAGE_RETURN_FAILURE);
 
+	/* The VLAN can't come up before its parent, so if the parent is being
+	 * activated too, wait until its link is configured.
+	 */
+	if (priv->parent) {
+		NMDeviceState parent_state = nm_device_get_state (priv->parent);
+
+		if (   parent_state > NM_DEVICE_STATE_DISCONNECTED
+		    && parent_state < NM_DEVICE_STATE_IP_CONFIG) {
+			_LOGD (LOGD_VLAN, "waiting for parent %s to be configured",
+			       nm_device_get_iface (priv->parent));
+			nm_device_trace_waiting_for (dev, priv->parent);
+			priv->waiting_for_parent = TRUE;
+			return NM_ACT_STAGE_RETURN_POSTPONE;
+		}
+	}
+	priv->waiting_for_parent = FALSE;
+
 	ret = NM_DEVICE_CLASS (nm_device_vlan_parent_class)->act_stage1_prepare (dev, reason);
 	if (ret != NM_ACT_STAGE_RETURN_SUCCESS)
 		return ret;
@@ -389,6 +395,8 @@ deactivate (NMDevice *device)
 	NMDeviceVlan *self = NM_DEVICE_VLAN (device);
 	NMDeviceVlanPrivate *priv = NM_DEVICE_VLAN_GET_PRIVATE (self);
 
+	priv->waiting_for_parent = FALSE;
+
 	/* Reset MAC address back to initial address */
 	if (priv->initial_hw_addr)
 		nm_device_set_hw_addr (device, priv->initial_hw_addr, "reset", LOGD_VLAN);
@@ -404,6 +412,14 @@ parent_state_changed (NMDevice *parent,
                       gpointer user_data)
 {
 	NMDeviceVlan *self = NM_DEVICE_VLAN (user_data);
+	NMDeviceVlanPrivate *priv = NM_DEVICE_VLAN_GET_PRIVATE (self);
+
+	if (   priv->waiting_for_parent
+	    && (new_state >= NM_DEVICE_STATE_IP_CONFIG || new_state <= NM_DEVICE_STATE_DISCONNECTED)) {
+		priv->waiting_for_parent = FALSE;
+		if (nm_device_get_state (NM_DEVICE (self)) == NM_DEVICE_STATE_PREPARE)
+			nm_device_activate_schedule_stage1_device_prepare (NM_DEVICE (self));
+	}
 
 	/* We'll react to our own carrier state notifications. Ignore the parent's. */
 	if (reason == NM_DEVICE_STATE_REASON_CARRIER)
@@ -540,6 +556,7 @@ nm_device_vlan_class_init (NMDeviceVlanClass *klass)
 	NMDeviceClass *parent_class = NM_DEVICE_CLASS (klass);
 
 	parent_class->connection_type = NM_SETTING_VLAN_SETTING_NAME;
+	parent_class->compatible_connection_type = NM_SETTING_VLAN_SETTING_NAME;
 
 	g_type_class_add_private (object_class, sizeof (NMDeviceVlanPrivate));
 
@@ -552,7 +569,6 @@ nm_device_vlan_class_init (NMDeviceVlanClass *klass)
 
 	parent_class->update_initial_hw_address = update_initial_hw_address;
 	parent_class->get_generic_capabilities = get_generic_capabilities;
-	parent_class->bring_up = bring_up;
 	parent_class->act_stage1_prepare = act_stage1_prepare;
 	parent_class->ip4_config_pre_commit = ip4_config_pre_commit;
 	parent_class->deactivate = deactivate;
@@ -67,6 +67,7 @@
 #include "nm-dbus-glib-types.h"
 #include "nm-dispatcher.h"
 #include "nm-config.h"
+#include "nm-trace.h"
 #include "nm-dns-manager.h"
 #include "nm-core-internal.h"
 #include "nm-default-route-manager.h"
@@ -198,6 +199,7 @@ typedef struct {
 	RfKillType    rfkill_type;
 	gboolean      firmware_missing;
 	GHashTable *  available_connections;
+	char *        avail_index_iface;
 	char *        hw_addr;
 	guint         hw_addr_len;
 	char *        physical_port_id;
@@ -214,6 +216,8 @@ typedef struct {
 	gpointer        act_source_func;
 	guint           act_source6_id;
 	gpointer        act_source6_func;
+	gboolean        act_slot;        /* holds an activation slot */
+	GSourceFunc     act_slot_func;   /* stage waiting for a slot */
 	guint           recheck_assume_id;
 	struct {
 		guint               call_id;
@@ -230,6 +234,7 @@ typedef struct {
 	gboolean        ignore_carrier;
 	guint32         mtu;
 	gboolean        up;   /* IFF_UP */
+	gboolean        up_pending;   /* IFF_UP requested but not reported yet */
 
 	/* Generic DHCP stuff */
 	guint32         dhcp_timeout;
@@ -345,6 +350,10 @@ static void _set_state_full (NMDevice *self,
                              gboolean quitting);
 
 static void nm_device_update_hw_address (NMDevice *self);
+static void bring_up_finish (NMDevice *self);
+
+static void avail_index_add_device (NMDevice *self);
+static void avail_index_remove_device (NMDevice *self);
 
 /***********************************************************/
 
@@ -1222,6 +1231,11 @@ device_link_changed (NMDevice *self, NMPlatformLink *info)
 		/* If the device has no explicit ip_iface, then changing iface changes ip_iface too. */
 		ip_ifname_changed = !priv->ip_iface;
 
+		if (priv->con_provider) {
+			avail_index_remove_device (self);
+			avail_index_add_device (self);
+		}
+
 		g_object_notify (G_OBJECT (self), NM_DEVICE_IFACE);
 		if (ip_ifname_changed)
 			g_object_notify (G_OBJECT (self), NM_DEVICE_IP_IFACE);
@@ -1293,6 +1307,12 @@ device_link_changed (NMDevice *self, NMPlatformLink *info)
 			}
 		}
 	}
+
+	if (priv->up_pending && info->up) {
+		priv->up_pending = FALSE;
+		_LOGD (LOGD_HW, "device is up now");
+		bring_up_finish (self);
+	}
 }
 
 static void
@@ -2305,6 +2325,124 @@ activation_source_schedule (NMDevice *self, GSourceFunc func, int family)
 	}
 }
 
+/*
+ * Activation slots
+ *
+ * Stages 1 and 2 do the link-level work of an activation (bringing the link
+ * up, enslaving, setting MAC addresses and sysctls).  To keep a boot with
+ * many devices from running all of that at once, a device needs one of a
+ * limited number of slots to run those stages.  The slot is held until the
+ * device reaches IP_CONFIG or leaves activation, and given back while waiting
+ * for secrets or while stage 1 is postponed, so that a device waiting for its
+ * master or parent doesn't keep the master or parent from getting a slot.
+ * Waiting masters come before devices without a master, which come before
+ * slaves.
+ *
+ * The stages themselves don't wait for the kernel (links are brought up and
+ * taken down without blocking), so the slots are only a safety valve against
+ * a burst of netlink and sysctl work.
+ */
+
+#define ACTIVATION_SLOTS_DEFAULT 16
+
+static guint activation_slots_used;
+static GQueue activation_slot_waiters = G_QUEUE_INIT;
+
+static guint
+activation_slots_max (void)
+{
+	static guint slots_max;
+
+	if (G_UNLIKELY (!slots_max)) {
+		char *value;
+
+		value = nm_config_get_value (nm_config_get (), "main", "activation-slots", NULL);
+		slots_max = nm_utils_ascii_str_to_int64 (value, 10, 1, G_MAXINT32, ACTIVATION_SLOTS_DEFAULT);
+		g_free (value);
+	}
+	return slots_max;
+}
+
+static int
+activation_slot_priority (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (priv->is_master)
+		return 0;
+	if (   priv->act_request
+	    && nm_active_connection_get_master (NM_ACTIVE_CONNECTION (priv->act_request)))
+		return 2;
+	return 1;
+}
+
+static int
+activation_slot_waiter_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	/* Sorts after all waiters of the same priority */
+	return activation_slot_priority ((NMDevice *) a) <= activation_slot_priority ((NMDevice *) b) ? -1 : 1;
+}
+
+static void
+activation_slot_grant (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	GSourceFunc func = priv->act_slot_func;
+
+	priv->act_slot_func = NULL;
+	priv->act_slot = TRUE;
+	activation_slots_used++;
+
+	_LOGD (LOGD_DEVICE, "activation: got an activation slot (%u waiting)",
+	       g_queue_get_length (&activation_slot_waiters));
+	activation_source_schedule (self, func, 0);
+}
+
+static void
+activation_slot_release (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMDevice *next;
+
+	if (priv->act_slot_func) {
+		g_queue_remove (&activation_slot_waiters, self);
+		priv->act_slot_func = NULL;
+	}
+	if (!priv->act_slot)
+		return;
+
+	priv->act_slot = FALSE;
+	activation_slots_used--;
+
+	next = g_queue_pop_head (&activation_slot_waiters);
+	if (next)
+		activation_slot_grant (next);
+}
+
+/* Schedules stage 1 or 2 @func, waiting for an activation slot if needed */
+static void
+activation_slot_schedule (NMDevice *self, GSourceFunc func)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (!priv->act_slot && !priv->act_slot_func) {
+		if (activation_slots_used < activation_slots_max ()) {
+			priv->act_slot = TRUE;
+			activation_slots_used++;
+		} else {
+			_LOGD (LOGD_DEVICE, "activation: waiting for an activation slot (%u in use)",
+			       activation_slots_used);
+			g_queue_insert_sorted (&activation_slot_waiters, self,
+			                       activation_slot_waiter_cmp, NULL);
+		}
+	}
+
+	if (priv->act_slot)
+		activation_source_schedule (self, func, 0);
+	else
+		priv->act_slot_func = func;
+}
+
 static gboolean
 get_ip_config_may_fail (NMDevice *self, int family)
 {
@@ -2331,6 +2469,30 @@ get_ip_config_may_fail (NMDevice *self, int family)
 	return nm_setting_ip_config_get_may_fail (s_ip);
 }
 
+/**
+ * nm_device_trace_waiting_for:
+ * @self: the #NMDevice
+ * @other: (allow-none): the #NMDevice @self waits for
+ *
+ * Records in the activation trace that @self can't continue activating
+ * before @other is far enough, so that the critical path can be followed
+ * from a slave to its master or from a VLAN to its parent.
+ */
+void
+nm_device_trace_waiting_for (NMDevice *self, NMDevice *other)
+{
+	char *name;
+
+	g_return_if_fail (NM_IS_DEVICE (self));
+
+	if (!other || !nm_trace_enabled ())
+		return;
+
+	name = g_strdup_printf ("waiting for %s", nm_device_get_iface (other));
+	nm_trace_instant (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), name);
+	g_free (name);
+}
+
 static void
 master_ready_cb (NMActiveConnection *active,
                  GParamSpec *pspec,
@@ -2391,12 +2553,14 @@ nm_device_activate_stage1_device_prepare (gpointer user_data)
 	g_object_notify (G_OBJECT (self), NM_DEVICE_ACTIVE_CONNECTION);
 
 	_LOGI (LOGD_DEVICE, "Activation: Stage 1 of 5 (Device Prepare) started...");
+	nm_trace_begin (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage1 device prepare");
 	nm_device_state_changed (self, NM_DEVICE_STATE_PREPARE, NM_DEVICE_STATE_REASON_NONE);
 
 	/* Assumed connections were already set up outside NetworkManager */
 	if (!nm_active_connection_get_assumed (active)) {
 		ret = NM_DEVICE_GET_CLASS (self)->act_stage1_prepare (self, &reason);
 		if (ret == NM_ACT_STAGE_RETURN_POSTPONE) {
+			activation_slot_release (self);
 			goto out;
 		} else if (ret == NM_ACT_STAGE_RETURN_FAILURE) {
 			nm_device_state_changed (self, NM_DEVICE_STATE_FAILED, reason);
@@ -2411,6 +2575,9 @@ nm_device_activate_stage1_device_prepare (gpointer user_data)
 			master_ready_cb (active, NULL, self);
 		else {
 			_LOGD (LOGD_DEVICE, "waiting for master connection to become ready");
+			activation_slot_release (self);
+			nm_device_trace_waiting_for (self,
+			                             nm_active_connection_get_device (nm_active_connection_get_master (active)));
 
 			/* Attach a signal handler and wait for the master connection to begin activating */
 			g_assert (priv->master_ready_id == 0);
@@ -2425,6 +2592,7 @@ nm_device_activate_stage1_device_prepare (gpointer user_data)
 
 out:
 	_LOGI (LOGD_DEVICE, "Activation: Stage 1 of 5 (Device Prepare) complete.");
+	nm_trace_end (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage1 device prepare");
 	return FALSE;
 }
 
@@ -2445,7 +2613,7 @@ nm_device_activate_schedule_stage1_device_prepare (NMDevice *self)
 	priv = NM_DEVICE_GET_PRIVATE (self);
 	g_return_if_fail (priv->act_request);
 
-	activation_source_schedule (self, nm_device_activate_stage1_device_prepare, 0);
+	activation_slot_schedule (self, nm_device_activate_stage1_device_prepare);
 
 	_LOGI (LOGD_DEVICE, "Activation: Stage 1 of 5 (Device Prepare) scheduled...");
 }
@@ -2479,6 +2647,7 @@ nm_device_activate_stage2_device_config (gpointer user_data)
 	activation_source_clear (self, FALSE, 0);
 
 	_LOGI (LOGD_DEVICE, "Activation: Stage 2 of 5 (Device Configure) starting...");
+	nm_trace_begin (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage2 device config");
 	nm_device_state_changed (self, NM_DEVICE_STATE_CONFIG, NM_DEVICE_STATE_REASON_NONE);
 
 	/* Assumed connections were already set up outside NetworkManager */
@@ -2519,6 +2688,7 @@ nm_device_activate_stage2_device_config (gpointer user_data)
 
 out:
 	_LOGI (LOGD_DEVICE, "Activation: Stage 2 of 5 (Device Configure) complete.");
+	nm_trace_end (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage2 device config");
 	return FALSE;
 }
 
@@ -2539,7 +2709,7 @@ nm_device_activate_schedule_stage2_device_config (NMDevice *self)
 	priv = NM_DEVICE_GET_PRIVATE (self);
 	g_return_if_fail (priv->act_request);
 
-	activation_source_schedule (self, nm_device_activate_stage2_device_config, 0);
+	activation_slot_schedule (self, nm_device_activate_stage2_device_config);
 
 	_LOGI (LOGD_DEVICE, "Activation: Stage 2 of 5 (Device Configure) scheduled...");
 }
@@ -4693,6 +4863,7 @@ nm_device_activate_stage3_ip_config_start (gpointer user_data)
 	priv->ip4_state = priv->ip6_state = IP_WAIT;
 
 	_LOGI (LOGD_DEVICE, "Activation: Stage 3 of 5 (IP Configure Start) started...");
+	nm_trace_begin (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage3 ip config start");
 	nm_device_state_changed (self, NM_DEVICE_STATE_IP_CONFIG, NM_DEVICE_STATE_REASON_NONE);
 
 	/* Device should be up before we can do anything with it */
@@ -4731,6 +4902,7 @@ nm_device_activate_stage3_ip_config_start (gpointer user_data)
 
 out:
 	_LOGI (LOGD_DEVICE, "Activation: Stage 3 of 5 (IP Configure Start) complete.");
+	nm_trace_end (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage3 ip config start");
 	return FALSE;
 }
 
@@ -4830,6 +5002,7 @@ nm_device_activate_ip4_config_timeout (gpointer user_data)
 
 	_LOGI (LOGD_DEVICE | LOGD_IP4,
 	       "Activation: Stage 4 of 5 (IPv4 Configure Timeout) started...");
+	nm_trace_begin (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage4 ip4 config timeout");
 
 	ret = NM_DEVICE_GET_CLASS (self)->act_stage4_ip4_config_timeout (self, &reason);
 	if (ret == NM_ACT_STAGE_RETURN_POSTPONE)
@@ -4847,6 +5020,7 @@ nm_device_activate_ip4_config_timeout (gpointer user_data)
 out:
 	_LOGI (LOGD_DEVICE | LOGD_IP4,
 	       "Activation: Stage 4 of 5 (IPv4 Configure Timeout) complete.");
+	nm_trace_end (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage4 ip4 config timeout");
 	return FALSE;
 }
 
@@ -4905,6 +5079,7 @@ nm_device_activate_ip6_config_timeout (gpointer user_data)
 
 	_LOGI (LOGD_DEVICE | LOGD_IP6,
 	       "Activation: Stage 4 of 5 (IPv6 Configure Timeout) started...");
+	nm_trace_begin (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage4 ip6 config timeout");
 
 	ret = NM_DEVICE_GET_CLASS (self)->act_stage4_ip6_config_timeout (self, &reason);
 	if (ret == NM_ACT_STAGE_RETURN_POSTPONE)
@@ -4922,6 +5097,7 @@ nm_device_activate_ip6_config_timeout (gpointer user_data)
 out:
 	_LOGI (LOGD_DEVICE | LOGD_IP6,
 	       "Activation: Stage 4 of 5 (IPv6 Configure Timeout) complete.");
+	nm_trace_end (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage4 ip6 config timeout");
 	return FALSE;
 }
 
@@ -5190,6 +5366,7 @@ nm_device_activate_ip4_config_commit (gpointer user_data)
 	activation_source_clear (self, FALSE, AF_INET);
 
 	_LOGI (LOGD_DEVICE, "Activation: Stage 5 of 5 (IPv4 Commit) started...");
+	nm_trace_begin (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage5 ip4 commit");
 
 	req = nm_device_get_act_request (self);
 	g_assert (req);
@@ -5250,6 +5427,7 @@ nm_device_activate_ip4_config_commit (gpointer user_data)
 
 out:
 	_LOGI (LOGD_DEVICE, "Activation: Stage 5 of 5 (IPv4 Commit) complete.");
+	nm_trace_end (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage5 ip4 commit");
 
 	return FALSE;
 }
@@ -5301,6 +5479,7 @@ nm_device_activate_ip6_config_commit (gpointer user_data)
 	activation_source_clear (self, FALSE, AF_INET6);
 
 	_LOG (level, LOGD_DEVICE, "Activation: Stage 5 of 5 (IPv6 Commit) started...");
+	nm_trace_begin (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage5 ip6 commit");
 
 	req = nm_device_get_act_request (self);
 	g_assert (req);
@@ -5346,6 +5525,7 @@ nm_device_activate_ip6_config_commit (gpointer user_data)
 	}
 
 	_LOG (level, LOGD_DEVICE, "Activation: Stage 5 of 5 (IPv6 Commit) complete.");
+	nm_trace_end (NM_TRACE_CAT_STAGE, nm_device_get_iface (self), "stage5 ip6 commit");
 
 	return FALSE;
 }
@@ -6282,13 +6462,27 @@ nm_device_bring_up (NMDevice *self, gboolean block, gboolean *no_firmware)
 	}
 
 	if (!device_is_up) {
-		if (block)
+		if (block) {
 			_LOGW (LOGD_HW, "device not up after timeout!");
-		else
-			_LOGD (LOGD_HW, "device not up immediately");
-		return FALSE;
+			return FALSE;
+		}
+
+		/* The kernel accepted the request; finish when it reports IFF_UP */
+		_LOGD (LOGD_HW, "device not up immediately");
+		priv->up_pending = TRUE;
+		return TRUE;
 	}
 
+	priv->up_pending = FALSE;
+	bring_up_finish (self);
+	return TRUE;
+}
+
+static void
+bring_up_finish (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
 	/* Devices that support carrier detect must be IFF_UP to report carrier
 	 * changes; so after setting the device IFF_UP we must suppress startup
 	 * complete (via a pending action) until either the carrier turns on, or
@@ -6307,7 +6501,6 @@ nm_device_bring_up (NMDevice *self, gboolean block, gboolean *no_firmware)
 	nm_device_update_hw_address (self);
 
 	_update_ip4_address (self);
-	return TRUE;
 }
 
 static void
@@ -6351,6 +6544,8 @@ nm_device_take_down (NMDevice *self, gboolean block)
 
 	_LOGD (LOGD_HW, "taking down device.");
 
+	NM_DEVICE_GET_PRIVATE (self)->up_pending = FALSE;
+
 	if (NM_DEVICE_GET_CLASS (self)->take_down) {
 		if (!NM_DEVICE_GET_CLASS (self)->take_down (self))
 			return;
@@ -6870,6 +7065,235 @@ _del_available_connection (NMDevice *self, NMConnection *connection)
 	return g_hash_table_remove (NM_DEVICE_GET_PRIVATE (self)->available_connections, connection);
 }
 
+/* Index of devices and connections for available-connection updates
+ *
+ * A connection with an interface name can only be compatible with the
+ * device of that name, as all classes chain up to the base class check.
+ * Otherwise it can only be compatible with devices whose class accepts its
+ * type, or that don't say which types they accept.  So when a connection
+ * changes, only those devices are rechecked, and a device with a
+ * compatible_connection_type only rechecks the connections of that type.
+ */
+
+typedef struct {
+	const char *type;   /* interned */
+	char *iface;
+} AvailIndexConnectionKeys;
+
+static struct {
+	NMConnectionProvider *cp;
+	GHashTable *devices_by_iface;     /* iface -> GSList of NMDevice */
+	GHashTable *devices_by_type;      /* connection type -> GSList of NMDevice */
+	GSList *untyped_devices;
+	GHashTable *connection_keys;      /* NMConnection -> AvailIndexConnectionKeys */
+	GHashTable *connections_by_type;  /* connection type -> GSList of NMConnection */
+} avail_index;
+
+static void
+avail_index_list_add (GHashTable *table, const char *key, gpointer item)
+{
+	GSList *list;
+
+	list = g_hash_table_lookup (table, key);
+	if (list)
+		list = g_slist_append (list, item);
+	else
+		g_hash_table_insert (table, g_strdup (key), g_slist_prepend (NULL, item));
+}
+
+static void
+avail_index_list_remove (GHashTable *table, const char *key, gpointer item)
+{
+	gpointer orig_key;
+	GSList *list;
+
+	if (!g_hash_table_lookup_extended (table, key, &orig_key, (gpointer *) &list))
+		return;
+
+	list = g_slist_remove (list, item);
+	if (!list)
+		g_hash_table_remove (table, key);
+	else {
+		g_hash_table_steal (table, key);
+		g_hash_table_insert (table, orig_key, list);
+	}
+}
+
+static void
+avail_index_keys_free (AvailIndexConnectionKeys *keys)
+{
+	g_free (keys->iface);
+	g_slice_free (AvailIndexConnectionKeys, keys);
+}
+
+static void
+avail_index_add_connection (NMConnection *connection)
+{
+	AvailIndexConnectionKeys *keys;
+	const char *type;
+
+	type = nm_connection_get_connection_type (connection);
+
+	keys = g_slice_new0 (AvailIndexConnectionKeys);
+	keys->type = g_intern_string (type ? type : "");
+	keys->iface = g_strdup (nm_connection_get_interface_name (connection));
+	g_hash_table_insert (avail_index.connection_keys, connection, keys);
+	avail_index_list_add (avail_index.connections_by_type, keys->type, connection);
+}
+
+static void
+avail_index_remove_connection (NMConnection *connection)
+{
+	AvailIndexConnectionKeys *keys;
+
+	keys = g_hash_table_lookup (avail_index.connection_keys, connection);
+	if (keys) {
+		avail_index_list_remove (avail_index.connections_by_type, keys->type, connection);
+		g_hash_table_remove (avail_index.connection_keys, connection);
+	}
+}
+
+static GSList *
+avail_index_prepend_devices (GSList *devices, const GSList *list)
+{
+	for (; list; list = list->next) {
+		if (!g_slist_find (devices, list->data))
+			devices = g_slist_prepend (devices, g_object_ref (list->data));
+	}
+	return devices;
+}
+
+/* Adds the devices a connection with @keys could be compatible with */
+static GSList *
+avail_index_get_devices (GSList *devices, const AvailIndexConnectionKeys *keys)
+{
+	if (!keys)
+		return devices;
+
+	if (keys->iface)
+		return avail_index_prepend_devices (devices, g_hash_table_lookup (avail_index.devices_by_iface, keys->iface));
+
+	devices = avail_index_prepend_devices (devices, g_hash_table_lookup (avail_index.devices_by_type, keys->type));
+	return avail_index_prepend_devices (devices, avail_index.untyped_devices);
+}
+
+static void
+avail_index_add_device (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	const char *type = NM_DEVICE_GET_CLASS (self)->compatible_connection_type;
+
+	priv->avail_index_iface = g_strdup (priv->iface);
+	if (priv->avail_index_iface)
+		avail_index_list_add (avail_index.devices_by_iface, priv->avail_index_iface, self);
+
+	if (type)
+		avail_index_list_add (avail_index.devices_by_type, type, self);
+	else
+		avail_index.untyped_devices = g_slist_prepend (avail_index.untyped_devices, self);
+}
+
+static void
+avail_index_remove_device (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	const char *type = NM_DEVICE_GET_CLASS (self)->compatible_connection_type;
+
+	if (priv->avail_index_iface)
+		avail_index_list_remove (avail_index.devices_by_iface, priv->avail_index_iface, self);
+	g_clear_pointer (&priv->avail_index_iface, g_free);
+
+	if (type)
+		avail_index_list_remove (avail_index.devices_by_type, type, self);
+	else
+		avail_index.untyped_devices = g_slist_remove (avail_index.untyped_devices, self);
+}
+
+/* Rechecks @connection on @devices and frees the list */
+static void
+avail_index_recheck_devices (GSList *devices, NMConnection *connection, gboolean removed)
+{
+	GSList *iter;
+
+	for (iter = devices; iter; iter = iter->next) {
+		NMDevice *self = iter->data;
+		gboolean added = FALSE, deleted;
+
+		/* The device may have gone away while signalling another one */
+		if (NM_DEVICE_GET_PRIVATE (self)->con_provider) {
+			deleted = _del_available_connection (self, connection);
+			if (!removed)
+				added = _try_add_available_connection (self, connection);
+
+			/* Only signal if the connection was removed OR added, but not both */
+			if (added != deleted)
+				_signal_available_connections_changed (self);
+		}
+	}
+	g_slist_free_full (devices, g_object_unref);
+}
+
+static void
+cp_connection_added (NMConnectionProvider *cp, NMConnection *connection, gpointer user_data)
+{
+	avail_index_remove_connection (connection);
+	avail_index_add_connection (connection);
+
+	avail_index_recheck_devices (avail_index_get_devices (NULL, g_hash_table_lookup (avail_index.connection_keys, connection)),
+	                             connection, FALSE);
+}
+
+static void
+cp_connection_removed (NMConnectionProvider *cp, NMConnection *connection, gpointer user_data)
+{
+	GSList *devices;
+
+	devices = avail_index_get_devices (NULL, g_hash_table_lookup (avail_index.connection_keys, connection));
+	avail_index_remove_connection (connection);
+
+	avail_index_recheck_devices (devices, connection, TRUE);
+}
+
+static void
+cp_connection_updated (NMConnectionProvider *cp, NMConnection *connection, gpointer user_data)
+{
+	GSList *devices;
+
+	/* Devices that matched the old interface name or type, and the new one */
+	devices = avail_index_get_devices (NULL, g_hash_table_lookup (avail_index.connection_keys, connection));
+	avail_index_remove_connection (connection);
+	avail_index_add_connection (connection);
+	devices = avail_index_get_devices (devices, g_hash_table_lookup (avail_index.connection_keys, connection));
+
+	avail_index_recheck_devices (devices, connection, FALSE);
+}
+
+static void
+avail_index_init (NMConnectionProvider *cp)
+{
+	const GSList *iter;
+
+	if (avail_index.cp)
+		return;
+
+	avail_index.cp = cp;
+	avail_index.devices_by_iface = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	avail_index.devices_by_type = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	avail_index.connection_keys = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                                     NULL, (GDestroyNotify) avail_index_keys_free);
+	avail_index.connections_by_type = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	for (iter = nm_connection_provider_get_connections (cp); iter; iter = iter->next)
+		avail_index_add_connection (iter->data);
+
+	g_signal_connect (cp, NM_CP_SIGNAL_CONNECTION_ADDED,
+	                  G_CALLBACK (cp_connection_added), NULL);
+	g_signal_connect (cp, NM_CP_SIGNAL_CONNECTION_REMOVED,
+	                  G_CALLBACK (cp_connection_removed), NULL);
+	g_signal_connect (cp, NM_CP_SIGNAL_CONNECTION_UPDATED,
+	                  G_CALLBACK (cp_connection_updated), NULL);
+}
+
 static gboolean
 check_connection_available (NMDevice *self,
                             NMConnection *connection,
@@ -6889,6 +7313,7 @@ nm_device_recheck_available_connections (NMDevice *self)
 {
 	NMDevicePrivate *priv;
 	const GSList *connections, *iter;
+	const char *type;
 
 	g_return_if_fail (NM_IS_DEVICE (self));
 
@@ -6897,7 +7322,11 @@ nm_device_recheck_available_connections (NMDevice *self)
 	if (priv->con_provider) {
 		_clear_available_connections (self, FALSE);
 
-		connections = nm_connection_provider_get_connections (priv->con_provider);
+		type = NM_DEVICE_GET_CLASS (self)->compatible_connection_type;
+		if (type)
+			connections = g_hash_table_lookup (avail_index.connections_by_type, type);
+		else
+			connections = nm_connection_provider_get_connections (priv->con_provider);
 		for (iter = connections; iter; iter = g_slist_next (iter))
 			_try_add_available_connection (self, NM_CONNECTION (iter->data));
 
@@ -6941,34 +7370,6 @@ nm_device_get_available_connections (NMDevice *self, const char *specific_object
 	return array;
 }
 
-static void
-cp_connection_added (NMConnectionProvider *cp, NMConnection *connection, gpointer user_data)
-{
-	if (_try_add_available_connection (NM_DEVICE (user_data), connection))
-		_signal_available_connections_changed (NM_DEVICE (user_data));
-}
-
-static void
-cp_connection_removed (NMConnectionProvider *cp, NMConnection *connection, gpointer user_data)
-{
-	if (_del_available_connection (NM_DEVICE (user_data), connection))
-		_signal_available_connections_changed (NM_DEVICE (user_data));
-}
-
-static void
-cp_connection_updated (NMConnectionProvider *cp, NMConnection *connection, gpointer user_data)
-{
-	gboolean added, deleted;
-
-	/* FIXME: don't remove it from the hash if it's just going to get re-added */
-	deleted = _del_available_connection (NM_DEVICE (user_data), connection);
-	added = _try_add_available_connection (NM_DEVICE (user_data), connection);
-
-	/* Only signal if the connection was removed OR added, but not both */
-	if (added != deleted)
-		_signal_available_connections_changed (NM_DEVICE (user_data));
-}
-
 gboolean
 nm_device_supports_vlans (NMDevice *self)
 {
@@ -7017,6 +7418,7 @@ nm_device_add_pending_action (NMDevice *self, const char *action, gboolean asser
 	count++;
 
 	_LOGD (LOGD_DEVICE, "add_pending_action (%d): '%s'", count, action);
+	nm_trace_begin (NM_TRACE_CAT_PENDING, nm_device_get_iface (self), action);
 
 	if (count == 1)
 		g_object_notify (G_OBJECT (self), NM_DEVICE_HAS_PENDING_ACTION);
@@ -7050,6 +7452,7 @@ nm_device_remove_pending_action (NMDevice *self, const char *action, gboolean as
 			_LOGD (LOGD_DEVICE, "remove_pending_action (%d): '%s'",
 			       count + g_slist_length (iter->next), /* length excluding 'iter' */
 			       action);
+			nm_trace_end (NM_TRACE_CAT_PENDING, nm_device_get_iface (self), action);
 			g_free (iter->data);
 			priv->pending_actions = g_slist_delete_link (priv->pending_actions, iter);
 			if (priv->pending_actions == NULL)
@@ -7461,6 +7864,9 @@ _set_state_full (NMDevice *self,
 	priv->state = state;
 	priv->state_reason = reason;
 
+	nm_trace_end (NM_TRACE_CAT_STATE, nm_device_get_iface (self), state_to_string (old_state));
+	nm_trace_begin (NM_TRACE_CAT_STATE, nm_device_get_iface (self), state_to_string (state));
+
 	_LOGI (LOGD_DEVICE, "device state change: %s -> %s (reason '%s') [%d %d %d]",
 	       state_to_string (old_state),
 	       state_to_string (state),
@@ -7477,6 +7883,14 @@ _set_state_full (NMDevice *self,
 	/* Cache the activation request for the dispatcher */
 	req = priv->act_request ? g_object_ref (priv->act_request) : NULL;
 
+	/* Link-level activation is done, the device waits for secrets, or
+	 * it stopped activating.
+	 */
+	if (   state >= NM_DEVICE_STATE_IP_CONFIG
+	    || state == NM_DEVICE_STATE_NEED_AUTH
+	    || state < NM_DEVICE_STATE_PREPARE)
+		activation_slot_release (self);
+
 	if (state <= NM_DEVICE_STATE_UNAVAILABLE) {
 		_clear_available_connections (self, TRUE);
 		g_clear_object (&priv->queued_act_request);
@@ -7511,7 +7925,7 @@ _set_state_full (NMDevice *self,
 
 		if (reason != NM_DEVICE_STATE_REASON_CONNECTION_ASSUMED) {
 			if (old_state == NM_DEVICE_STATE_UNMANAGED || priv->firmware_missing) {
-				if (!nm_device_bring_up (self, TRUE, &no_firmware) && no_firmware)
+				if (!nm_device_bring_up (self, FALSE, &no_firmware) && no_firmware)
 					_LOGW (LOGD_HW, "firmware may be missing.");
 				nm_device_set_firmware_missing (self, no_firmware ? TRUE : FALSE);
 			}
@@ -7890,7 +8304,7 @@ nm_device_set_hw_addr (NMDevice *self, const char *addr,
 		_LOGW (LOGD_DEVICE | hw_log_domain, "failed to %s MAC address to %s",
 		       detail, addr);
 	}
-	nm_device_bring_up (self, TRUE, NULL);
+	nm_device_bring_up (self, FALSE, NULL);
 
 	return success;
 }
@@ -8116,20 +8530,8 @@ constructed (GObject *object)
 
 	priv->con_provider = nm_connection_provider_get ();
 	g_assert (priv->con_provider);
-	g_signal_connect (priv->con_provider,
-	                  NM_CP_SIGNAL_CONNECTION_ADDED,
-	                  G_CALLBACK (cp_connection_added),
-	                  self);
-
-	g_signal_connect (priv->con_provider,
-	                  NM_CP_SIGNAL_CONNECTION_REMOVED,
-	                  G_CALLBACK (cp_connection_removed),
-	                  self);
-
-	g_signal_connect (priv->con_provider,
-	                  NM_CP_SIGNAL_CONNECTION_UPDATED,
-	                  G_CALLBACK (cp_connection_updated),
-	                  self);
+	avail_index_init (priv->con_provider);
+	avail_index_add_device (self);
 
 	/* Update default-unmanaged device available connections immediately,
 	 * since they don't transition from UNMANAGED (and thus the state handler
@@ -8153,6 +8555,7 @@ dispose (GObject *object)
 	_LOGD (LOGD_DEVICE, "dispose(): %s", G_OBJECT_TYPE_NAME (self));
 
 	dispatcher_cleanup (self);
+	activation_slot_release (self);
 
 	_cleanup_generic_pre (self, FALSE);
 
@@ -8174,9 +8577,7 @@ dispose (GObject *object)
 	link_disconnect_action_cancel (self);
 
 	if (priv->con_provider) {
-		g_signal_handlers_disconnect_by_func (priv->con_provider, cp_connection_added, self);
-		g_signal_handlers_disconnect_by_func (priv->con_provider, cp_connection_removed, self);
-		g_signal_handlers_disconnect_by_func (priv->con_provider, cp_connection_updated, self);
+		avail_index_remove_device (self);
 		priv->con_provider = NULL;
 	}
 
@@ -94,6 +94,11 @@ typedef struct {
 
 	const char *connection_type;
 
+	/* If set, check_connection_compatible() only accepts connections of
+	 * this type, and only those are rechecked for the device.
+	 */
+	const char *compatible_connection_type;
+
 	void (*state_changed) (NMDevice *device,
 	                       NMDeviceState new_state,
 	                       NMDeviceState old_state,
@@ -351,6 +356,8 @@ gboolean nm_device_get_firmware_missing (NMDevice *self);
 
 void nm_device_queue_activation (NMDevice *device, NMActRequest *req);
 
+void nm_device_trace_waiting_for (NMDevice *self, NMDevice *other);
+
 gboolean nm_device_supports_vlans (NMDevice *device);
 
 gboolean nm_device_add_pending_action    (NMDevice *device, const char *action, gboolean assert_not_yet_pending);
@@ -566,7 +566,7 @@ enslave_slave (NMDevice *device,
 	nm_device_master_check_slave_physical_port (device, slave, LOGD_TEAM);
 
 	if (configure) {
-		nm_device_take_down (slave, TRUE);
+		nm_device_take_down (slave, FALSE);
 
 		s_team_port = nm_connection_get_setting_team_port (connection);
 		if (s_team_port) {
@@ -593,7 +593,7 @@ enslave_slave (NMDevice *device,
 		}
 		success = nm_platform_link_enslave (nm_device_get_ip_ifindex (device),
 		                                    nm_device_get_ip_ifindex (slave));
-		nm_device_bring_up (slave, TRUE, &no_firmware);
+		nm_device_bring_up (slave, FALSE, &no_firmware);
 
 		if (!success)
 			return FALSE;
@@ -634,7 +634,7 @@ release_slave (NMDevice *device,
 		 * IFF_UP), so we must bring it back up here to ensure carrier changes and
 		 * other state is noticed by the now-released port.
 		 */
-		if (!nm_device_bring_up (slave, TRUE, &no_firmware))
+		if (!nm_device_bring_up (slave, FALSE, &no_firmware))
 			_LOGW (LOGD_TEAM, "released team port %s could not be brought up",
 			       nm_device_get_ip_iface (slave));
 	}
@@ -744,6 +744,7 @@ nm_device_team_class_init (NMDeviceTeamClass *klass)
 	g_type_class_add_private (object_class, sizeof (NMDeviceTeamPrivate));
 
 	parent_class->connection_type = NM_SETTING_TEAM_SETTING_NAME;
+	parent_class->compatible_connection_type = NM_SETTING_TEAM_SETTING_NAME;
 
 	/* virtual methods */
 	object_class->get_property = get_property;
@@ -72,6 +72,18 @@ get_device_type (NMDeviceFactory *factory)
 	return NM_DEVICE_TYPE_TEAM;
 }
 
+static void
+get_supported_types (NMDeviceFactory *factory,
+                     const NMLinkType **out_link_types,
+                     const char ***out_setting_types)
+{
+	static const NMLinkType link_types[] = { NM_LINK_TYPE_TEAM, NM_LINK_TYPE_NONE };
+	static const char *setting_types[] = { NM_SETTING_TEAM_SETTING_NAME, NULL };
+
+	*out_link_types = link_types;
+	*out_setting_types = setting_types;
+}
+
 /************************************************************************/
 
 static void
@@ -85,6 +97,7 @@ device_factory_interface_init (NMDeviceFactory *factory_iface)
 	factory_iface->new_link = new_link;
 	factory_iface->create_virtual_device_for_connection = create_virtual_device_for_connection;
 	factory_iface->get_device_type = get_device_type;
+	factory_iface->get_supported_types = get_supported_types;
 }
 
 static void
@@ -526,6 +526,7 @@ nm_device_olpc_mesh_class_init (NMDeviceOlpcMeshClass *klass)
 	object_class->set_property = set_property;
 	object_class->dispose = dispose;
 
+	parent_class->compatible_connection_type = NM_SETTING_OLPC_MESH_SETTING_NAME;
 	parent_class->check_connection_compatible = check_connection_compatible;
 	parent_class->can_auto_connect = can_auto_connect;
 	parent_class->complete_connection = complete_connection;
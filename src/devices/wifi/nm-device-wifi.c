@@ -61,6 +61,9 @@
 #include "nm-dbus-glib-types.h"
 #include "nm-wifi-enum-types.h"
 #include "nm-connection-provider.h"
+#include "nm-config.h"
+#include "nm-wifi-scan-policy.h"
+#include "nm-wifi-bss-cache.h"
 
 
 static gboolean impl_device_get_access_points (NMDeviceWifi *device,
@@ -80,11 +83,6 @@ static void impl_device_request_scan (NMDeviceWifi *device,
 #include "nm-device-logging.h"
 _LOG_DECLARE_SELF(NMDeviceWifi);
 
-/* All of these are in seconds */
-#define SCAN_INTERVAL_MIN 3
-#define SCAN_INTERVAL_STEP 20
-#define SCAN_INTERVAL_MAX 120
-
 #define WIRELESS_SECRETS_TRIES "wireless-secrets-tries"
 
 G_DEFINE_TYPE (NMDeviceWifi, nm_device_wifi, NM_TYPE_DEVICE)
@@ -108,6 +106,7 @@ enum {
 enum {
 	ACCESS_POINT_ADDED,
 	ACCESS_POINT_REMOVED,
+	ACCESS_POINTS_CHANGED,
 	SCANNING_ALLOWED,
 
 	LAST_SIGNAL
@@ -124,16 +123,35 @@ struct _NMDeviceWifiPrivate {
 	gint8             invalid_strength_counter;
 
 	GSList *          ap_list;
+	GHashTable *      ap_index;         /* NMAccessPoint -> ApIndexEntry */
+	GHashTable *      aps_by_dbus_path; /* char * -> NMAccessPoint */
+	GHashTable *      aps_by_sup_path;  /* char * -> NMAccessPoint */
+	GHashTable *      aps_by_bssid;     /* guint8[ETH_ALEN] -> GPtrArray of NMAccessPoint */
+	GHashTable *      aps_by_ssid;      /* ApSsidKey -> GPtrArray of NMAccessPoint */
 	NMAccessPoint *   current_ap;
 	guint32           rate;
 	gboolean          enabled; /* rfkilled or not */
 
+	gboolean          ap_export_lazy;   /* export APs only once a client asks */
+	gboolean          ap_export_all;    /* a client asked for the AP list */
+	gboolean          aps_changed;      /* since the last AccessPointsChanged */
+	GPtrArray *       aps_added;        /* D-Bus paths for AccessPointsChanged */
+	GPtrArray *       aps_removed;
+
 	gint32            scheduled_scan_time;
-	guint8            scan_interval; /* seconds */
+	NMWifiScanPolicy *scan_policy;
+	NMWifiScanType    scan_type;           /* type of the scan in progress */
+	gboolean          scan_full_requested; /* next scan must not be partial */
+	gint32            last_scan_time;
+	guint             scan_churn;          /* APs added or removed since the last scan */
 	guint             pending_scan_id;
 	guint             scanlist_cull_id;
 	gboolean          requested_scan;
 
+	GPtrArray *       bss_cache;        /* NMWifiBssCacheEntry */
+	char *            bss_cache_file;
+	gboolean          bss_cache_dirty;
+
 	NMSupplicantManager   *sup_mgr;
 	NMSupplicantInterface *sup_iface;
 	guint                  sup_timeout_id; /* supplicant association timeout */
@@ -143,6 +161,8 @@ struct _NMDeviceWifiPrivate {
 
 	guint32           failed_link_count;
 	guint             periodic_source_id;
+	gboolean          link_events;      /* driver reports link changes */
+	gboolean          link_bss_changed; /* association changed since last update */
 	guint             link_timeout_id;
 
 	NMDeviceWifiCapabilities capabilities;
@@ -154,6 +174,11 @@ static void schedule_scan (NMDeviceWifi *self, gboolean backoff);
 
 static void cancel_pending_scan (NMDeviceWifi *self);
 
+static void wifi_link_event_cb (NMPlatform *platform,
+                                int ifindex,
+                                gboolean bss_changed,
+                                NMDeviceWifi *self);
+
 static void cleanup_association_attempt (NMDeviceWifi * self,
                                          gboolean disconnect);
 
@@ -163,14 +188,13 @@ static void supplicant_iface_state_cb (NMSupplicantInterface *iface,
                                        int disconnect_reason,
                                        gpointer user_data);
 
-static void supplicant_iface_new_bss_cb (NMSupplicantInterface * iface,
-                                         const char *object_path,
-                                         GHashTable *properties,
-                                         NMDeviceWifi * self);
+static void supplicant_iface_new_bsses_cb (NMSupplicantInterface *iface,
+                                           GPtrArray *paths,
+                                           GPtrArray *props,
+                                           NMDeviceWifi *self);
 
 static void supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
                                              const char *object_path,
-                                             GHashTable *properties,
                                              NMDeviceWifi *self);
 
 static void supplicant_iface_bss_removed_cb (NMSupplicantInterface *iface,
@@ -227,6 +251,9 @@ constructor (GType type,
 	priv->sup_mgr = nm_supplicant_manager_get ();
 	g_assert (priv->sup_mgr);
 
+	g_signal_connect (nm_platform_get (), NM_PLATFORM_SIGNAL_WIFI_LINK_EVENT,
+	                  G_CALLBACK (wifi_link_event_cb), self);
+
 	return object;
 }
 
@@ -255,8 +282,8 @@ supplicant_interface_acquire (NMDeviceWifi *self)
 	                  G_CALLBACK (supplicant_iface_state_cb),
 	                  self);
 	g_signal_connect (priv->sup_iface,
-	                  NM_SUPPLICANT_INTERFACE_NEW_BSS,
-	                  G_CALLBACK (supplicant_iface_new_bss_cb),
+	                  NM_SUPPLICANT_INTERFACE_NEW_BSSES,
+	                  G_CALLBACK (supplicant_iface_new_bsses_cb),
 	                  self);
 	g_signal_connect (priv->sup_iface,
 	                  NM_SUPPLICANT_INTERFACE_BSS_UPDATED,
@@ -290,9 +317,9 @@ supplicant_interface_release (NMDeviceWifi *self)
 	cancel_pending_scan (self);
 
 	/* Reset the scan interval to be pretty frequent when disconnected */
-	priv->scan_interval = SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP;
+	nm_wifi_scan_policy_reset (priv->scan_policy, SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP);
 	_LOGD (LOGD_WIFI_SCAN, "reset scanning interval to %d seconds",
-	       priv->scan_interval);
+	       SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP);
 
 	if (priv->scanlist_cull_id) {
 		g_source_remove (priv->scanlist_cull_id);
@@ -313,38 +340,344 @@ supplicant_interface_release (NMDeviceWifi *self)
 	}
 }
 
-static NMAccessPoint *
-get_ap_by_path (NMDeviceWifi *self, const char *path)
+/*****************************************************************************/
+/* AP list indexes
+ *
+ * Scan results are matched against the AP list once per BSS the supplicant
+ * reports, so the lookups must not walk the list.  Besides ap_list every AP
+ * is filed under its D-Bus path, its supplicant path, its BSSID and its
+ * SSID + mode + band.  APs without a valid BSSID are filed under the
+ * all-zero BSSID.  The BSSID and SSID keys are buckets (GPtrArray) since
+ * several APs can share them.
+ */
+
+typedef struct {
+	guint8 ssid[32];
+	guint8 ssid_len;
+	guint8 mode;
+	guint8 band;
+} ApSsidKey;
+
+/* The keys an AP is currently filed under, so it can be removed again */
+typedef struct {
+	guint8 bssid[ETH_ALEN];
+	ApSsidKey ssid_key;
+	char *sup_path;
+	char *dbus_path;
+} ApIndexEntry;
+
+static const guint8 no_bssid[ETH_ALEN] = { 0 };
+
+static guint
+bssid_hash (gconstpointer key)
+{
+	const guint8 *a = key;
+
+	/* The vendor OUI is the same for many APs; hash the NIC-specific part */
+	return (a[2] << 24) | (a[3] << 16) | (a[4] << 8) | a[5];
+}
+
+static gboolean
+bssid_equal (gconstpointer a, gconstpointer b)
+{
+	return memcmp (a, b, ETH_ALEN) == 0;
+}
+
+static guint
+ssid_key_hash (gconstpointer key)
+{
+	const ApSsidKey *k = key;
+	guint h = 5381 + k->mode * 33 + k->band;
+	guint i;
+
+	for (i = 0; i < k->ssid_len; i++)
+		h = (h << 5) + h + k->ssid[i];
+	return h;
+}
+
+static gboolean
+ssid_key_equal (gconstpointer a, gconstpointer b)
+{
+	return memcmp (a, b, sizeof (ApSsidKey)) == 0;
+}
+
+static void
+ssid_key_init (ApSsidKey *key, NMAccessPoint *ap)
+{
+	const GByteArray *ssid = nm_ap_get_ssid (ap);
+	guint32 freq = nm_ap_get_freq (ap);
+
+	memset (key, 0, sizeof (*key));
+	if (ssid) {
+		key->ssid_len = MIN (ssid->len, sizeof (key->ssid));
+		memcpy (key->ssid, ssid->data, key->ssid_len);
+		/* nm_ap_match() ignores a trailing NUL, so the key must too */
+		if (key->ssid_len && key->ssid[key->ssid_len - 1] == '\0')
+			key->ssid[--key->ssid_len] = '\0';
+	}
+	key->mode = nm_ap_get_mode (ap);
+	/* nm_ap_match() wants the exact frequency; the band is a cheap superset */
+	if (freq > 4000)
+		key->band = 2;
+	else if (freq > 2000)
+		key->band = 1;
+}
+
+static void
+ap_bucket_add (GHashTable *table, gconstpointer key, gsize key_len, NMAccessPoint *ap)
+{
+	GPtrArray *bucket;
+
+	bucket = g_hash_table_lookup (table, key);
+	if (!bucket) {
+		bucket = g_ptr_array_new ();
+		g_hash_table_insert (table, g_memdup (key, key_len), bucket);
+	}
+	g_ptr_array_add (bucket, ap);
+}
+
+static void
+ap_bucket_remove (GHashTable *table, gconstpointer key, NMAccessPoint *ap)
+{
+	GPtrArray *bucket;
+
+	bucket = g_hash_table_lookup (table, key);
+	if (bucket) {
+		g_ptr_array_remove (bucket, ap);
+		if (bucket->len == 0)
+			g_hash_table_remove (table, key);
+	}
+}
+
+static void
+ap_index_entry_free (ApIndexEntry *entry)
+{
+	g_free (entry->sup_path);
+	g_free (entry->dbus_path);
+	g_slice_free (ApIndexEntry, entry);
+}
+
+static void
+ap_index_add (NMDeviceWifi *self, NMAccessPoint *ap)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	GSList *iter;
+	ApIndexEntry *entry;
+	const guint8 *bssid;
 
-	if (!path)
-		return NULL;
+	entry = g_slice_new0 (ApIndexEntry);
+
+	bssid = nm_ap_get_address_bin (ap);
+	if (bssid && nm_ethernet_address_is_valid (bssid, ETH_ALEN))
+		memcpy (entry->bssid, bssid, ETH_ALEN);
+	ap_bucket_add (priv->aps_by_bssid, entry->bssid, ETH_ALEN, ap);
+
+	ssid_key_init (&entry->ssid_key, ap);
+	ap_bucket_add (priv->aps_by_ssid, &entry->ssid_key, sizeof (ApSsidKey), ap);
+
+	entry->sup_path = g_strdup (nm_ap_get_supplicant_path (ap));
+	if (entry->sup_path)
+		g_hash_table_insert (priv->aps_by_sup_path, g_strdup (entry->sup_path), ap);
+
+	entry->dbus_path = g_strdup (nm_ap_get_dbus_path (ap));
+	if (entry->dbus_path)
+		g_hash_table_insert (priv->aps_by_dbus_path, g_strdup (entry->dbus_path), ap);
+
+	g_hash_table_insert (priv->ap_index, ap, entry);
+}
+
+static void
+ap_index_remove (NMDeviceWifi *self, NMAccessPoint *ap)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	ApIndexEntry *entry;
+
+	entry = g_hash_table_lookup (priv->ap_index, ap);
+	if (!entry)
+		return;
+
+	ap_bucket_remove (priv->aps_by_bssid, entry->bssid, ap);
+	ap_bucket_remove (priv->aps_by_ssid, &entry->ssid_key, ap);
+	if (   entry->sup_path
+	    && g_hash_table_lookup (priv->aps_by_sup_path, entry->sup_path) == ap)
+		g_hash_table_remove (priv->aps_by_sup_path, entry->sup_path);
+	if (   entry->dbus_path
+	    && g_hash_table_lookup (priv->aps_by_dbus_path, entry->dbus_path) == ap)
+		g_hash_table_remove (priv->aps_by_dbus_path, entry->dbus_path);
+
+	g_hash_table_remove (priv->ap_index, ap);
+}
+
+static void
+ap_index_changed_cb (NMAccessPoint *ap, GParamSpec *pspec, NMDeviceWifi *self)
+{
+	if (   strcmp (pspec->name, NM_AP_SSID)
+	    && strcmp (pspec->name, NM_AP_HW_ADDRESS)
+	    && strcmp (pspec->name, NM_AP_MODE)
+	    && strcmp (pspec->name, NM_AP_FREQUENCY))
+		return;
+
+	ap_index_remove (self, ap);
+	ap_index_add (self, ap);
+}
+
+static void
+ap_set_supplicant_path (NMDeviceWifi *self, NMAccessPoint *ap, const char *path)
+{
+	if (g_strcmp0 (path, nm_ap_get_supplicant_path (ap)) == 0)
+		return;
+
+	ap_index_remove (self, ap);
+	nm_ap_set_supplicant_path (ap, path);
+	ap_index_add (self, ap);
+}
+
+/* Takes ownership of @ap */
+static void
+ap_list_add (NMDeviceWifi *self, NMAccessPoint *ap)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (!priv->ap_export_lazy || priv->ap_export_all)
+		nm_ap_export_to_dbus (ap);
+	priv->ap_list = g_slist_prepend (priv->ap_list, ap);
+	ap_index_add (self, ap);
+	g_signal_connect (ap, "notify", G_CALLBACK (ap_index_changed_cb), self);
+}
+
+/* Makes sure @ap has a D-Bus path, e.g. because it is about to be
+ * referenced by an active connection.
+ */
+static void
+ap_export (NMDeviceWifi *self, NMAccessPoint *ap)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (nm_ap_get_dbus_path (ap))
+		return;
+
+	/* The D-Bus path is part of the index */
+	if (g_hash_table_lookup (priv->ap_index, ap)) {
+		ap_index_remove (self, ap);
+		nm_ap_export_to_dbus (ap);
+		ap_index_add (self, ap);
+	} else
+		nm_ap_export_to_dbus (ap);
+}
+
+static void
+ap_list_remove (NMDeviceWifi *self, NMAccessPoint *ap)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	g_signal_handlers_disconnect_by_func (ap, G_CALLBACK (ap_index_changed_cb), self);
+	ap_index_remove (self, ap);
+	priv->ap_list = g_slist_remove (priv->ap_list, ap);
+}
+
+static NMAccessPoint *
+ap_bucket_match (GPtrArray *bucket, NMAccessPoint *find_ap, gboolean strict_match)
+{
+	guint i;
 
-	for (iter = priv->ap_list; iter; iter = g_slist_next (iter)) {
-		if (g_strcmp0 (path, nm_ap_get_dbus_path (NM_AP (iter->data))) == 0)
-			return NM_AP (iter->data);
+	for (i = 0; bucket && i < bucket->len; i++) {
+		if (nm_ap_match (bucket->pdata[i], find_ap, strict_match))
+			return bucket->pdata[i];
 	}
 	return NULL;
 }
 
+/* Indexed equivalent of nm_ap_match_in_list (find_ap, priv->ap_list, strict_match) */
 static NMAccessPoint *
-get_ap_by_supplicant_path (NMDeviceWifi *self, const char *path)
+find_matching_ap (NMDeviceWifi *self, NMAccessPoint *find_ap, gboolean strict_match)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	const guint8 *bssid = nm_ap_get_address_bin (find_ap);
+	NMAccessPoint *ap;
+	ApSsidKey key;
+
+	if (bssid && nm_ethernet_address_is_valid (bssid, ETH_ALEN)) {
+		/* Only APs with the same BSSID or without a valid one can match */
+		ap = ap_bucket_match (g_hash_table_lookup (priv->aps_by_bssid, bssid), find_ap, strict_match);
+		if (!ap)
+			ap = ap_bucket_match (g_hash_table_lookup (priv->aps_by_bssid, no_bssid), find_ap, strict_match);
+		return ap;
+	}
+
+	ssid_key_init (&key, find_ap);
+	return ap_bucket_match (g_hash_table_lookup (priv->aps_by_ssid, &key), find_ap, strict_match);
+}
+
+/* Returns an AP from the scan list that nm_ap_check_compatible() accepts
+ * for @connection.  Only the SSID buckets the connection's SSID and mode
+ * can be filed under are looked at.
+ */
+static NMAccessPoint *
+find_compatible_ap (NMDeviceWifi *self, NMConnection *connection)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	static const NM80211Mode all_modes[] = { NM_802_11_MODE_INFRA, NM_802_11_MODE_ADHOC, NM_802_11_MODE_UNKNOWN };
+	NMApMatchKey *match_key;
+	const guint8 *ssid;
+	gsize ssid_len;
+	NM80211Mode mode;
+	ApSsidKey key;
 	GSList *iter;
+	guint m, i;
 
-	if (!path)
+	match_key = nm_ap_match_key_get (connection);
+	if (!match_key)
 		return NULL;
 
-	for (iter = priv->ap_list; iter; iter = g_slist_next (iter)) {
-		if (g_strcmp0 (path, nm_ap_get_supplicant_path (NM_AP (iter->data))) == 0)
-			return NM_AP (iter->data);
+	ssid = nm_ap_match_key_get_ssid (match_key, &ssid_len);
+	if (!ssid || ssid_len > sizeof (key.ssid)) {
+		for (iter = priv->ap_list; iter; iter = g_slist_next (iter)) {
+			if (nm_ap_match_key_check (match_key, iter->data))
+				return iter->data;
+		}
+		return NULL;
+	}
+
+	memset (&key, 0, sizeof (key));
+	memcpy (key.ssid, ssid, ssid_len);
+	key.ssid_len = ssid_len;
+
+	mode = nm_ap_match_key_get_ap_mode (match_key);
+	for (m = 0; m < G_N_ELEMENTS (all_modes); m++) {
+		if (mode != NM_802_11_MODE_UNKNOWN && mode != all_modes[m])
+			continue;
+		key.mode = all_modes[m];
+		for (key.band = 0; key.band <= 2; key.band++) {
+			GPtrArray *bucket = g_hash_table_lookup (priv->aps_by_ssid, &key);
+
+			for (i = 0; bucket && i < bucket->len; i++) {
+				if (nm_ap_match_key_check (match_key, bucket->pdata[i]))
+					return bucket->pdata[i];
+			}
+		}
 	}
 	return NULL;
 }
 
+/*****************************************************************************/
+
+static NMAccessPoint *
+get_ap_by_path (NMDeviceWifi *self, const char *path)
+{
+	if (!path)
+		return NULL;
+
+	return g_hash_table_lookup (NM_DEVICE_WIFI_GET_PRIVATE (self)->aps_by_dbus_path, path);
+}
+
+static NMAccessPoint *
+get_ap_by_supplicant_path (NMDeviceWifi *self, const char *path)
+{
+	if (!path)
+		return NULL;
+
+	return g_hash_table_lookup (NM_DEVICE_WIFI_GET_PRIVATE (self)->aps_by_sup_path, path);
+}
+
 static NMAccessPoint *
 find_active_ap (NMDeviceWifi *self,
                 NMAccessPoint *ignore_ap,
@@ -354,7 +687,8 @@ find_active_ap (NMDeviceWifi *self,
 	int ifindex = nm_device_get_ifindex (NM_DEVICE (self));
 	guint8 bssid[ETH_ALEN];
 	GByteArray *ssid;
-	GSList *iter;
+	GPtrArray *candidates;
+	guint j;
 	int i = 0;
 	NMAccessPoint *match_nofreq = NULL, *active_ap = NULL;
 	gboolean found_a_band = FALSE;
@@ -378,6 +712,9 @@ find_active_ap (NMDeviceWifi *self,
 	devmode = nm_platform_wifi_get_mode (ifindex);
 	devfreq = nm_platform_wifi_get_frequency (ifindex);
 
+	/* Only APs with this BSSID can match */
+	candidates = g_hash_table_lookup (priv->aps_by_bssid, bssid);
+
 	/* When matching hidden APs, do a second pass that ignores the SSID check,
 	 * because NM might not yet know the SSID of the hidden AP in the scan list
 	 * and therefore it won't get matched the first time around.
@@ -386,8 +723,8 @@ find_active_ap (NMDeviceWifi *self,
 		_LOGD (LOGD_WIFI, "  Pass #%d %s", i, i > 1 ? "(ignoring SSID)" : "");
 
 		/* Find this SSID + BSSID in the device's AP list */
-		for (iter = priv->ap_list; iter; iter = g_slist_next (iter)) {
-			NMAccessPoint *ap = NM_AP (iter->data);
+		for (j = 0; candidates && j < candidates->len; j++) {
+			NMAccessPoint *ap = NM_AP (candidates->pdata[j]);
 			const char *ap_bssid = nm_ap_get_address (ap);
 			const GByteArray *ap_ssid = nm_ap_get_ssid (ap);
 			NM80211Mode apmode;
@@ -404,11 +741,6 @@ find_active_ap (NMDeviceWifi *self,
 				continue;
 			}
 
-			if (!nm_utils_hwaddr_matches (bssid, ETH_ALEN, ap_bssid, -1)) {
-				_LOGD (LOGD_WIFI, "      BSSID mismatch");
-				continue;
-			}
-
 			if (i == 0) {
 				if (   (ssid && !ap_ssid)
 				    || (ap_ssid && !ssid)
@@ -520,6 +852,7 @@ set_current_ap (NMDeviceWifi *self, NMAccessPoint *new_ap, gboolean recheck_avai
 		return;
 
 	if (new_ap) {
+		ap_export (self, new_ap);
 		priv->current_ap = g_object_ref (new_ap);
 
 		/* Move the current AP to the front of the scan list.  Since we
@@ -554,6 +887,8 @@ periodic_update (NMDeviceWifi *self, NMAccessPoint *ignore_ap)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	int ifindex = nm_device_get_ifindex (NM_DEVICE (self));
 	NMAccessPoint *new_ap;
+	guint8 bssid[ETH_ALEN];
+	const guint8 *cur_bssid;
 	guint32 new_rate;
 	int percent;
 	NMDeviceState state;
@@ -580,6 +915,14 @@ periodic_update (NMDeviceWifi *self, NMAccessPoint *ignore_ap)
 	if (priv->mode == NM_802_11_MODE_AP)
 		return;
 
+	/* BSSID, strength and bitrate all come from a single query; if it
+	 * fails, keep the current values until the next update.
+	 */
+	if (!nm_platform_wifi_get_link_info (ifindex, bssid, &percent, &new_rate)) {
+		_LOGD (LOGD_WIFI, "failed to read link info");
+		return;
+	}
+
 	/* In IBSS mode, most newer firmware/drivers do "BSS coalescing" where
 	 * multiple IBSS stations using the same SSID will eventually switch to
 	 * using the same BSSID to avoid network segmentation.  When this happens,
@@ -589,31 +932,44 @@ periodic_update (NMDeviceWifi *self, NMAccessPoint *ignore_ap)
 	 * current AP with it, if the current AP is adhoc.
 	 */
 	if (priv->current_ap && (nm_ap_get_mode (priv->current_ap) == NM_802_11_MODE_ADHOC)) {
-		guint8 bssid[ETH_ALEN] = { 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
-
-		nm_platform_wifi_get_bssid (ifindex, bssid);
 		/* 0x02 means "locally administered" and should be OR-ed into
 		 * the first byte of IBSS BSSIDs.
 		 */
-		if ((bssid[0] & 0x02) && nm_ethernet_address_is_valid (bssid, ETH_ALEN)) {
-			char *bssid_str = nm_utils_hwaddr_ntoa (bssid, ETH_ALEN);
-			nm_ap_set_address (priv->current_ap, bssid_str);
-			g_free (bssid_str);
-		}
+		if ((bssid[0] & 0x02) && nm_ethernet_address_is_valid (bssid, ETH_ALEN))
+			nm_ap_set_address_bin (priv->current_ap, bssid);
+	}
+
+	/* Unless the driver reported a new association the current AP stays
+	 * active as long as the BSSID is unchanged, which saves the several
+	 * driver queries a full match against the scan list needs.
+	 */
+	cur_bssid = priv->current_ap ? nm_ap_get_address_bin (priv->current_ap) : NULL;
+	if (   !priv->link_bss_changed
+	    && !ignore_ap
+	    && cur_bssid
+	    && memcmp (cur_bssid, bssid, ETH_ALEN) == 0)
+		new_ap = priv->current_ap;
+	else {
+		new_ap = find_active_ap (self, ignore_ap, FALSE);
+		priv->link_bss_changed = FALSE;
 	}
 
-	new_ap = find_active_ap (self, ignore_ap, FALSE);
 	if (new_ap) {
 		/* Try to smooth out the strength.  Atmel cards, for example, will give no strength
 		 * one second and normal strength the next.
 		 */
-		percent = nm_platform_wifi_get_quality (ifindex);
 		if (percent >= 0 || ++priv->invalid_strength_counter > 3) {
 			nm_ap_set_strength (new_ap, (gint8) percent);
 			priv->invalid_strength_counter = 0;
 		}
 	}
 
+	/* The scan policy may want to scan sooner, or again at all, if the
+	 * signal got weaker.
+	 */
+	if (!priv->requested_scan)
+		schedule_scan (self, FALSE);
+
 	if (new_ap != priv->current_ap) {
 		const char *new_bssid = NULL;
 		const GByteArray *new_ssid = NULL;
@@ -639,7 +995,6 @@ periodic_update (NMDeviceWifi *self, NMAccessPoint *ignore_ap)
 		set_current_ap (self, new_ap, TRUE, FALSE);
 	}
 
-	new_rate = nm_platform_wifi_get_rate (ifindex);
 	if (new_rate != priv->rate) {
 		priv->rate = new_rate;
 		g_object_notify (G_OBJECT (self), NM_DEVICE_WIFI_BITRATE);
@@ -653,6 +1008,78 @@ periodic_update_cb (gpointer user_data)
 	return TRUE;
 }
 
+/* Poll interval when the driver can't report link changes, and the much
+ * longer one used only as a safety net when it can.
+ */
+#define PERIODIC_UPDATE_INTERVAL           6
+#define PERIODIC_UPDATE_FALLBACK_INTERVAL 60
+
+static void
+periodic_update_schedule (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (priv->periodic_source_id)
+		g_source_remove (priv->periodic_source_id);
+	priv->periodic_source_id = g_timeout_add_seconds (priv->link_events ?
+	                                                  PERIODIC_UPDATE_FALLBACK_INTERVAL :
+	                                                  PERIODIC_UPDATE_INTERVAL,
+	                                                  periodic_update_cb, self);
+}
+
+static void
+periodic_update_start (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (priv->periodic_source_id)
+		return;
+
+	priv->link_events = nm_platform_wifi_monitor_link (nm_device_get_ifindex (NM_DEVICE (self)), TRUE);
+	priv->link_bss_changed = TRUE;
+	_LOGD (LOGD_WIFI, "link monitoring via %s", priv->link_events ? "driver events" : "polling");
+
+	periodic_update_schedule (self);
+}
+
+static void
+periodic_update_stop (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	int ifindex = nm_device_get_ifindex (NM_DEVICE (self));
+
+	if (priv->periodic_source_id) {
+		g_source_remove (priv->periodic_source_id);
+		priv->periodic_source_id = 0;
+	}
+
+	if (priv->link_events) {
+		if (ifindex > 0)
+			nm_platform_wifi_monitor_link (ifindex, FALSE);
+		priv->link_events = FALSE;
+	}
+}
+
+static void
+wifi_link_event_cb (NMPlatform *platform,
+                    int ifindex,
+                    gboolean bss_changed,
+                    NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (!priv->link_events || ifindex != nm_device_get_ifindex (NM_DEVICE (self)))
+		return;
+
+	if (bss_changed)
+		priv->link_bss_changed = TRUE;
+	periodic_update (self, NULL);
+
+	/* Only poll again if the driver stays quiet */
+	if (priv->periodic_source_id)
+		periodic_update_schedule (self);
+}
+
 static gboolean
 bring_up (NMDevice *device, gboolean *no_firmware)
 {
@@ -662,14 +1089,50 @@ bring_up (NMDevice *device, gboolean *no_firmware)
 	return NM_DEVICE_CLASS (nm_device_wifi_parent_class)->bring_up (device, no_firmware);
 }
 
+static void
+notify_ap_added_removed (NMDeviceWifi *self, guint signum, NMAccessPoint *ap)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	const char *path = nm_ap_get_dbus_path (ap);
+
+	priv->aps_changed = TRUE;
+	if (path) {
+		g_ptr_array_add (signum == ACCESS_POINT_ADDED ? priv->aps_added : priv->aps_removed,
+		                 g_strdup (path));
+	}
+
+	/* With lazy export clients only get AccessPointsChanged */
+	if (!priv->ap_export_lazy) {
+		g_signal_emit (self, signals[signum], 0, ap);
+		g_object_notify (G_OBJECT (self), NM_DEVICE_WIFI_ACCESS_POINTS);
+	}
+}
+
+/* Summarizes the AP list changes of a scan in one signal */
+static void
+emit_access_points_changed (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (!priv->aps_changed)
+		return;
+	priv->aps_changed = FALSE;
+
+	if (priv->ap_export_lazy && (priv->aps_added->len || priv->aps_removed->len))
+		g_object_notify (G_OBJECT (self), NM_DEVICE_WIFI_ACCESS_POINTS);
+	g_signal_emit (self, signals[ACCESS_POINTS_CHANGED], 0, priv->aps_added, priv->aps_removed);
+
+	g_ptr_array_set_size (priv->aps_added, 0);
+	g_ptr_array_set_size (priv->aps_removed, 0);
+}
+
 static void
 emit_ap_added_removed (NMDeviceWifi *self,
                        guint signum,
                        NMAccessPoint *ap,
                        gboolean recheck_available_connections)
 {
-	g_signal_emit (self, signals[signum], 0, ap);
-	g_object_notify (G_OBJECT (self), NM_DEVICE_WIFI_ACCESS_POINTS);
+	notify_ap_added_removed (self, signum, ap);
 	nm_device_emit_recheck_auto_activate (NM_DEVICE (self));
 	if (recheck_available_connections)
 		nm_device_recheck_available_connections (NM_DEVICE (self));
@@ -684,9 +1147,9 @@ remove_access_point (NMDeviceWifi *device,
 
 	g_return_if_fail (ap);
 	g_return_if_fail (ap != priv->current_ap);
-	g_return_if_fail (g_slist_find (priv->ap_list, ap));
+	g_return_if_fail (g_hash_table_lookup (priv->ap_index, ap));
 
-	priv->ap_list = g_slist_remove (priv->ap_list, ap);
+	ap_list_remove (self, ap);
 	emit_ap_added_removed (self, ACCESS_POINT_REMOVED, ap, FALSE);
 	g_object_unref (ap);
 }
@@ -703,6 +1166,7 @@ remove_all_aps (NMDeviceWifi *self)
 			remove_access_point (self, NM_AP (priv->ap_list->data));
 
 		nm_device_recheck_available_connections (NM_DEVICE (self));
+		emit_access_points_changed (self);
 	}
 }
 
@@ -721,10 +1185,7 @@ deactivate (NMDevice *device)
 		g_object_set_data (G_OBJECT (connection), WIRELESS_SECRETS_TRIES, NULL);
 	}
 
-	if (priv->periodic_source_id) {
-		g_source_remove (priv->periodic_source_id);
-		priv->periodic_source_id = 0;
-	}
+	periodic_update_stop (self);
 
 	cleanup_association_attempt (self, TRUE);
 
@@ -761,6 +1222,7 @@ deactivate (NMDevice *device)
 	/* Ensure we trigger a scan after deactivating a Hotspot */
 	if (old_mode == NM_802_11_MODE_AP) {
 		cancel_pending_scan (self);
+		priv->scan_full_requested = TRUE;
 		request_wireless_scan (self);
 	}
 }
@@ -868,10 +1330,8 @@ _internal_check_connection_available (NMDevice *device,
                                       const char *specific_object,
                                       gboolean ignore_ap_list)
 {
-	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (device);
 	NMSettingWireless *s_wifi;
 	const char *mode;
-	GSList *ap_iter = NULL;
 
 	s_wifi = nm_connection_get_setting_wireless (connection);
 	g_return_val_if_fail (s_wifi, FALSE);
@@ -896,12 +1356,7 @@ _internal_check_connection_available (NMDevice *device,
 		return TRUE;
 
 	/* check if its visible */
-	for (ap_iter = priv->ap_list; ap_iter; ap_iter = g_slist_next (ap_iter)) {
-		if (nm_ap_check_compatible (NM_AP (ap_iter->data), connection))
-			return TRUE;
-	}
-
-	return FALSE;
+	return find_compatible_ap (NM_DEVICE_WIFI (device), connection) != NULL;
 }
 
 static gboolean
@@ -966,7 +1421,6 @@ complete_connection (NMDevice *device,
                      GError **error)
 {
 	NMDeviceWifi *self = NM_DEVICE_WIFI (device);
-	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	NMSettingWireless *s_wifi;
 	NMSettingWirelessSecurity *s_wsec;
 	NMSetting8021x *s_8021x;
@@ -976,7 +1430,6 @@ complete_connection (NMDevice *device,
 	const GByteArray *ssid = NULL;
 	GByteArray *tmp_ssid = NULL;
 	GBytes *setting_ssid = NULL;
-	GSList *iter;
 	gboolean hidden = FALSE;
 
 	s_wifi = nm_connection_get_setting_wireless (connection);
@@ -1003,12 +1456,7 @@ complete_connection (NMDevice *device,
 		}
 
 		/* Find a compatible AP in the scan list */
-		for (iter = priv->ap_list; iter; iter = g_slist_next (iter)) {
-			if (nm_ap_check_compatible (NM_AP (iter->data), connection)) {
-				ap = NM_AP (iter->data);
-				break;
-			}
-		}
+		ap = find_compatible_ap (self, connection);
 
 		/* If we still don't have an AP, then the WiFI settings needs to be
 		 * fully specified by the client.  Might not be able to find an AP
@@ -1174,9 +1622,7 @@ can_auto_connect (NMDevice *device,
                   NMConnection *connection,
                   char **specific_object)
 {
-	NMDeviceWifi *self = NM_DEVICE_WIFI (device);
-	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	GSList *ap_iter;
+	NMAccessPoint *ap;
 	const char *method = NULL;
 	guint64 timestamp = 0;
 
@@ -1197,14 +1643,11 @@ can_auto_connect (NMDevice *device,
 	if (!strcmp (method, NM_SETTING_IP4_CONFIG_METHOD_SHARED))
 		return TRUE;
 
-	for (ap_iter = priv->ap_list; ap_iter; ap_iter = g_slist_next (ap_iter)) {
-		NMAccessPoint *ap = NM_AP (ap_iter->data);
-
-		if (nm_ap_check_compatible (ap, connection)) {
-			/* All good; connection is usable */
-			*specific_object = (char *) nm_ap_get_dbus_path (ap);
-			return TRUE;
-		}
+	ap = find_compatible_ap (NM_DEVICE_WIFI (device), connection);
+	if (ap) {
+		/* All good; connection is usable */
+		*specific_object = (char *) nm_ap_get_dbus_path (ap);
+		return TRUE;
 	}
 
 	return FALSE;
@@ -1227,6 +1670,25 @@ ap_list_dump (NMDeviceWifi *self)
 	_LOGD (LOGD_WIFI_SCAN, "Current AP list: done");
 }
 
+/* A client is interested in the APs; export them from now on */
+static void
+export_all_aps (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	GSList *elt;
+
+	if (priv->ap_export_all)
+		return;
+	priv->ap_export_all = TRUE;
+
+	if (priv->ap_export_lazy) {
+		_LOGD (LOGD_WIFI_SCAN, "exporting access points on request");
+		for (elt = priv->ap_list; elt; elt = g_slist_next (elt))
+			ap_export (self, elt->data);
+		g_object_notify (G_OBJECT (self), NM_DEVICE_WIFI_ACCESS_POINTS);
+	}
+}
+
 static gboolean
 impl_device_get_access_points (NMDeviceWifi *self,
                                GPtrArray **aps,
@@ -1235,6 +1697,8 @@ impl_device_get_access_points (NMDeviceWifi *self,
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	GSList *elt;
 
+	export_all_aps (self);
+
 	*aps = g_ptr_array_new ();
 	for (elt = priv->ap_list; elt; elt = g_slist_next (elt)) {
 		NMAccessPoint *ap = NM_AP (elt->data);
@@ -1253,6 +1717,8 @@ impl_device_get_all_access_points (NMDeviceWifi *self,
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	GSList *elt;
 
+	export_all_aps (self);
+
 	*aps = g_ptr_array_new ();
 	for (elt = priv->ap_list; elt; elt = g_slist_next (elt))
 		g_ptr_array_add (*aps, g_strdup (nm_ap_get_dbus_path (NM_AP (elt->data))));
@@ -1283,6 +1749,7 @@ request_scan_cb (NMDevice *device,
 	}
 
 	cancel_pending_scan (self);
+	priv->scan_full_requested = TRUE;
 	request_wireless_scan (self);
 	dbus_g_method_return (context);
 }
@@ -1496,6 +1963,90 @@ build_hidden_probe_list (NMDeviceWifi *self)
 	return ssids;
 }
 
+static GPtrArray *
+build_partial_probe_list (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMConnection *connection;
+	NMSettingWireless *s_wifi;
+	GBytes *ssid;
+	GPtrArray *ssids;
+	GByteArray *ssid_array;
+
+	/* Partial scans look for the current network only, which only needs
+	 * probing if it is hidden.
+	 */
+	connection = nm_device_get_connection (NM_DEVICE (self));
+	if (!connection)
+		return NULL;
+	s_wifi = nm_connection_get_setting_wireless (connection);
+	if (!s_wifi || !nm_setting_wireless_get_hidden (s_wifi))
+		return NULL;
+	if (nm_supplicant_interface_get_max_scan_ssids (priv->sup_iface) < 2)
+		return NULL;
+
+	ssids = g_ptr_array_new_full (2, (GDestroyNotify) g_byte_array_unref);
+	g_ptr_array_add (ssids, g_byte_array_new ());  /* Add wildcard SSID */
+
+	ssid = nm_setting_wireless_get_ssid (s_wifi);
+	ssid_array = g_byte_array_new ();
+	g_byte_array_append (ssid_array,
+	                     g_bytes_get_data (ssid, NULL),
+	                     g_bytes_get_size (ssid));
+	g_ptr_array_add (ssids, ssid_array);
+
+	return ssids;
+}
+
+/* Collects what the scan policy bases its decisions on.  If @freqs is given
+ * it receives the channels the current network was seen on.
+ */
+static void
+scan_info_fill (NMDeviceWifi *self, NMWifiScanInfo *info, GArray *freqs)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMDeviceState state = nm_device_get_state (NM_DEVICE (self));
+	ApSsidKey key;
+	guint band, i, j;
+
+	memset (info, 0, sizeof (*info));
+	info->connected = nm_device_is_activating (NM_DEVICE (self)) || state == NM_DEVICE_STATE_ACTIVATED;
+	info->strength = -1;
+	info->scan_age = priv->last_scan_time ? nm_utils_get_monotonic_timestamp_s () - priv->last_scan_time : -1;
+
+	if (state != NM_DEVICE_STATE_ACTIVATED || !priv->current_ap)
+		return;
+	info->strength = nm_ap_get_strength (priv->current_ap);
+
+	/* Roaming candidates are the BSSes of the current SSID in any band */
+	ssid_key_init (&key, priv->current_ap);
+	for (band = 0; band <= 2; band++) {
+		GPtrArray *bucket;
+
+		key.band = band;
+		bucket = g_hash_table_lookup (priv->aps_by_ssid, &key);
+		for (i = 0; bucket && i < bucket->len; i++) {
+			NMAccessPoint *ap = bucket->pdata[i];
+			guint32 freq = nm_ap_get_freq (ap);
+
+			if (ap != priv->current_ap)
+				info->roam_candidates++;
+			if (!freq)
+				continue;
+			info->known_channels = TRUE;
+
+			if (freqs) {
+				for (j = 0; j < freqs->len; j++) {
+					if (g_array_index (freqs, guint32, j) == freq)
+						break;
+				}
+				if (j == freqs->len)
+					g_array_append_val (freqs, freq);
+			}
+		}
+	}
+}
+
 static gboolean
 request_wireless_scan (gpointer user_data)
 {
@@ -1503,6 +2054,9 @@ request_wireless_scan (gpointer user_data)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	gboolean backoff = FALSE;
 	GPtrArray *ssids = NULL;
+	GArray *freqs = NULL;
+	NMWifiScanInfo info;
+	NMWifiScanType type;
 
 	if (priv->requested_scan) {
 		/* There's already a scan in progress */
@@ -1510,36 +2064,66 @@ request_wireless_scan (gpointer user_data)
 	}
 
 	if (check_scanning_allowed (self)) {
-		_LOGD (LOGD_WIFI_SCAN, "scanning requested");
-
-		ssids = build_hidden_probe_list (self);
+		if (priv->scan_full_requested)
+			type = NM_WIFI_SCAN_FULL;
+		else {
+			freqs = g_array_new (FALSE, FALSE, sizeof (guint32));
+			scan_info_fill (self, &info, freqs);
+			type = nm_wifi_scan_policy_get_scan_type (priv->scan_policy, &info);
+		}
+		priv->scan_full_requested = FALSE;
 
-		if (nm_logging_enabled (LOGL_DEBUG, LOGD_WIFI_SCAN)) {
-			if (ssids) {
-				const GByteArray *ssid;
-				guint i;
-				char *foo;
-
-				for (i = 0; i < ssids->len; i++) {
-					ssid = g_ptr_array_index (ssids, i);
-					foo = nm_utils_ssid_to_utf8 (ssid->data, ssid->len);
-					_LOGD (LOGD_WIFI_SCAN, "(%d) probe scanning SSID '%s'",
-					            i, foo ? foo : "<hidden>");
-					g_free (foo);
+		if (type == NM_WIFI_SCAN_NONE)
+			_LOGD (LOGD_WIFI_SCAN, "scan not needed, link is strong and stable");
+		else {
+			_LOGD (LOGD_WIFI_SCAN, "%s scan requested",
+			       type == NM_WIFI_SCAN_PARTIAL ? "partial" : "full");
+
+			if (type == NM_WIFI_SCAN_PARTIAL)
+				ssids = build_partial_probe_list (self);
+			else
+				ssids = build_hidden_probe_list (self);
+
+			if (nm_logging_enabled (LOGL_DEBUG, LOGD_WIFI_SCAN)) {
+				if (ssids) {
+					const GByteArray *ssid;
+					guint i;
+					char *foo;
+
+					for (i = 0; i < ssids->len; i++) {
+						ssid = g_ptr_array_index (ssids, i);
+						foo = nm_utils_ssid_to_utf8 (ssid->data, ssid->len);
+						_LOGD (LOGD_WIFI_SCAN, "(%d) probe scanning SSID '%s'",
+						            i, foo ? foo : "<hidden>");
+						g_free (foo);
+					}
+				} else
+					_LOGD (LOGD_WIFI_SCAN, "no SSIDs to probe scan");
+
+				if (type == NM_WIFI_SCAN_PARTIAL) {
+					guint i;
+
+					for (i = 0; i < freqs->len; i++)
+						_LOGD (LOGD_WIFI_SCAN, "(%d) scanning %u MHz",
+						       i, g_array_index (freqs, guint32, i));
 				}
-			} else
-				_LOGD (LOGD_WIFI_SCAN, "no SSIDs to probe scan");
-		}
+			}
 
-		if (nm_supplicant_interface_request_scan (priv->sup_iface, ssids)) {
-			/* success */
-			backoff = TRUE;
-			priv->requested_scan = TRUE;
-			nm_device_add_pending_action (NM_DEVICE (self), "scan", TRUE);
+			if (nm_supplicant_interface_request_scan (priv->sup_iface, ssids,
+			                                          type == NM_WIFI_SCAN_PARTIAL ? freqs : NULL)) {
+				/* success */
+				backoff = TRUE;
+				priv->requested_scan = TRUE;
+				priv->scan_type = type;
+				nm_device_add_pending_action (NM_DEVICE (self), "scan", TRUE);
+			}
+
+			if (ssids)
+				g_ptr_array_unref (ssids);
 		}
 
-		if (ssids)
-			g_ptr_array_unref (ssids);
+		if (freqs)
+			g_array_unref (freqs);
 	} else
 		_LOGD (LOGD_WIFI_SCAN, "scan requested but not allowed at this time");
 
@@ -1560,40 +2144,31 @@ schedule_scan (NMDeviceWifi *self, gboolean backoff)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	gint32 now = nm_utils_get_monotonic_timestamp_s ();
+	NMWifiScanInfo info;
+	guint next_scan;
+
+	scan_info_fill (self, &info, NULL);
 
-	/* Cancel the pending scan if it would happen later than (now + the scan_interval) */
+	/* Cancel the pending scan if it would happen later than the policy wants */
 	if (priv->pending_scan_id) {
-		if (now + priv->scan_interval < priv->scheduled_scan_time)
+		next_scan = nm_wifi_scan_policy_get_interval (priv->scan_policy, &info, FALSE);
+		if (next_scan && now + next_scan < priv->scheduled_scan_time)
 			cancel_pending_scan (self);
 	}
 
 	if (!priv->pending_scan_id) {
-		guint factor = 2, next_scan = priv->scan_interval;
-
-		if (    nm_device_is_activating (NM_DEVICE (self))
-		    || (nm_device_get_state (NM_DEVICE (self)) == NM_DEVICE_STATE_ACTIVATED))
-			factor = 1;
+		next_scan = nm_wifi_scan_policy_get_interval (priv->scan_policy, &info, backoff);
+		if (!next_scan) {
+			_LOGD (LOGD_WIFI_SCAN, "no periodic scan scheduled");
+			return;
+		}
 
 		priv->pending_scan_id = g_timeout_add_seconds (next_scan,
 		                                               request_wireless_scan,
 		                                               self);
+		priv->scheduled_scan_time = now + next_scan;
 
-		priv->scheduled_scan_time = now + priv->scan_interval;
-		if (backoff && (priv->scan_interval < (SCAN_INTERVAL_MAX / factor))) {
-				priv->scan_interval += (SCAN_INTERVAL_STEP / factor);
-				/* Ensure the scan interval will never be less than 20s... */
-				priv->scan_interval = MAX(priv->scan_interval, SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP);
-				/* ... or more than 120s */
-				priv->scan_interval = MIN(priv->scan_interval, SCAN_INTERVAL_MAX);
-		} else if (!backoff && (priv->scan_interval == 0)) {
-			/* Invalid combination; would cause continual rescheduling of
-			 * the scan and hog CPU.  Reset to something minimally sane.
-			 */
-			priv->scan_interval = 5;
-		}
-
-		_LOGD (LOGD_WIFI_SCAN, "scheduled scan in %d seconds (interval now %d seconds)",
-		       next_scan, priv->scan_interval);
+		_LOGD (LOGD_WIFI_SCAN, "scheduled scan in %d seconds", next_scan);
 	}
 }
 
@@ -1609,6 +2184,138 @@ cancel_pending_scan (NMDeviceWifi *self)
 	}
 }
 
+/*****************************************************************************/
+/* The BSSes of the networks the device connects to are remembered across
+ * restarts and suspend, so that the first scan after startup or resume can
+ * look at only the few channels these networks were found on before.
+ */
+
+#define CACHED_SCAN_FREQS_MAX 3
+
+static gint64
+bss_cache_now (void)
+{
+	return g_get_real_time () / G_USEC_PER_SEC;
+}
+
+/* Loaded on first use, since the permanent MAC address is only known
+ * once the device has been constructed.
+ */
+static GPtrArray *
+bss_cache_get (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	const char *key;
+
+	if (!priv->bss_cache) {
+		key = priv->perm_hw_addr ? priv->perm_hw_addr : nm_device_get_iface (NM_DEVICE (self));
+		priv->bss_cache_file = g_strdup_printf (NM_WIFI_BSS_CACHE_FILE_FMT, key);
+		priv->bss_cache = nm_wifi_bss_cache_load (priv->bss_cache_file, bss_cache_now ());
+	}
+	return priv->bss_cache;
+}
+
+static void
+bss_cache_remember (NMDeviceWifi *self, gboolean last_good)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	GPtrArray *cache = bss_cache_get (self);
+	gint64 now = bss_cache_now ();
+	ApSsidKey key;
+	guint band, i;
+
+	if (!priv->current_ap || nm_ap_get_fake (priv->current_ap))
+		return;
+	if (nm_ap_get_mode (priv->current_ap) != NM_802_11_MODE_INFRA)
+		return;
+
+	/* Remember the roaming candidates, too */
+	ssid_key_init (&key, priv->current_ap);
+	for (band = 0; band <= 2; band++) {
+		GPtrArray *bucket;
+
+		key.band = band;
+		bucket = g_hash_table_lookup (priv->aps_by_ssid, &key);
+		for (i = 0; bucket && i < bucket->len; i++) {
+			if (bucket->pdata[i] != priv->current_ap)
+				nm_wifi_bss_cache_add (cache, bucket->pdata[i], now, FALSE);
+		}
+	}
+	nm_wifi_bss_cache_add (cache, priv->current_ap, now, last_good);
+	priv->bss_cache_dirty = TRUE;
+}
+
+static void
+bss_cache_flush (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	GError *error = NULL;
+
+	if (!priv->bss_cache_dirty)
+		return;
+	priv->bss_cache_dirty = FALSE;
+
+	nm_wifi_bss_cache_prune (priv->bss_cache, bss_cache_now ());
+	if (!nm_wifi_bss_cache_save (priv->bss_cache, priv->bss_cache_file, &error)) {
+		_LOGW (LOGD_WIFI, "error saving BSS cache to '%s': %s",
+		       priv->bss_cache_file, error->message);
+		g_error_free (error);
+	}
+}
+
+static gboolean
+request_cached_scan (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	GPtrArray *ssids;
+	GArray *freqs;
+	gboolean success = FALSE;
+
+	if (priv->requested_scan || !check_scanning_allowed (self))
+		return FALSE;
+
+	freqs = nm_wifi_bss_cache_get_freqs (bss_cache_get (self), CACHED_SCAN_FREQS_MAX);
+	if (freqs->len) {
+		_LOGD (LOGD_WIFI_SCAN, "scanning %u previously used channel(s) first", freqs->len);
+
+		ssids = build_hidden_probe_list (self);
+		if (nm_supplicant_interface_request_scan (priv->sup_iface, ssids, freqs)) {
+			priv->requested_scan = TRUE;
+			priv->scan_type = NM_WIFI_SCAN_PARTIAL;
+			nm_device_add_pending_action (NM_DEVICE (self), "scan", TRUE);
+			success = TRUE;
+		}
+		if (ssids)
+			g_ptr_array_unref (ssids);
+	}
+	g_array_unref (freqs);
+
+	return success;
+}
+
+/* Scan right away, e.g. because the device just became usable */
+static void
+request_initial_scan (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (priv->requested_scan) {
+		/* There's already a scan in progress */
+		return;
+	}
+
+	cancel_pending_scan (self);
+	priv->scan_full_requested = TRUE;
+
+	/* Without any APs, find the known networks quickly first and look at
+	 * all channels soon after.
+	 */
+	if (!priv->ap_list && request_cached_scan (self))
+		schedule_scan (self, FALSE);
+	else
+		request_wireless_scan (self);
+}
+
 static void
 supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
                                gboolean success,
@@ -1618,6 +2325,17 @@ supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
 
 	_LOGD (LOGD_WIFI_SCAN, "scan %s", success ? "successful" : "failed");
 
+	nm_wifi_scan_policy_scan_done (priv->scan_policy, priv->scan_type, success,
+	                               priv->scan_churn, g_hash_table_size (priv->ap_index));
+	priv->scan_churn = 0;
+	/* Scans we didn't ask for are full ones */
+	priv->scan_type = NM_WIFI_SCAN_FULL;
+	if (success) {
+		priv->last_scan_time = nm_utils_get_monotonic_timestamp_s ();
+		if (nm_device_get_state (NM_DEVICE (self)) == NM_DEVICE_STATE_ACTIVATED)
+			bss_cache_remember (self, FALSE);
+	}
+
 	schedule_scan (self, success);
 
 	/* Ensure that old APs get removed, which otherwise only
@@ -1625,6 +2343,8 @@ supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
 	 */
 	schedule_scanlist_cull (self);
 
+	emit_access_points_changed (self);
+
 	if (priv->requested_scan) {
 		priv->requested_scan = FALSE;
 		nm_device_remove_pending_action (NM_DEVICE (self), "scan", TRUE);
@@ -1673,14 +2393,15 @@ try_fill_ssid_for_hidden_ap (NMAccessPoint *ap)
  *
  * If there is already an entry that matches the BSSID and ESSID of the
  * AP to merge, replace that entry with the scanned AP.  Otherwise, add
- * the scanned AP to the list.
+ * the scanned AP to the list and return TRUE; the caller is responsible
+ * for rechecking available connections afterwards.
  *
  * TODO: possibly need to differentiate entries based on security too; i.e. if
  * there are two scan results with the same BSSID and SSID but different
  * security options?
  *
  */
-static void
+static gboolean
 merge_scanned_ap (NMDeviceWifi *self,
                   NMAccessPoint *merge_ap)
 {
@@ -1721,7 +2442,7 @@ merge_scanned_ap (NMDeviceWifi *self,
 
 	found_ap = get_ap_by_supplicant_path (self, nm_ap_get_supplicant_path (merge_ap));
 	if (!found_ap)
-		found_ap = nm_ap_match_in_list (merge_ap, priv->ap_list, strict_match);
+		found_ap = find_matching_ap (self, merge_ap, strict_match);
 	if (found_ap) {
 		_LOGD (LOGD_WIFI_SCAN, "merging AP '%s' %s (%p) with existing (%p)",
 		            ssid ? nm_utils_escape_ssid (ssid->data, ssid->len) : "(none)",
@@ -1729,7 +2450,7 @@ merge_scanned_ap (NMDeviceWifi *self,
 		            merge_ap,
 		            found_ap);
 
-		nm_ap_set_supplicant_path (found_ap, nm_ap_get_supplicant_path (merge_ap));
+		ap_set_supplicant_path (self, found_ap, nm_ap_get_supplicant_path (merge_ap));
 		nm_ap_set_flags (found_ap, nm_ap_get_flags (merge_ap));
 		nm_ap_set_wpa_flags (found_ap, nm_ap_get_wpa_flags (merge_ap));
 		nm_ap_set_rsn_flags (found_ap, nm_ap_get_rsn_flags (merge_ap));
@@ -1743,16 +2464,16 @@ merge_scanned_ap (NMDeviceWifi *self,
 		 * fake, since it clearly exists somewhere.
 		 */
 		nm_ap_set_fake (found_ap, FALSE);
+		return FALSE;
 	} else {
 		/* New entry in the list */
 		_LOGD (LOGD_WIFI_SCAN, "adding new AP '%s' %s (%p)",
 		       ssid ? nm_utils_escape_ssid (ssid->data, ssid->len) : "(none)",
 		       str_if_set (bssid, "(none)"), merge_ap);
 
-		g_object_ref (merge_ap);
-		priv->ap_list = g_slist_prepend (priv->ap_list, merge_ap);
-		nm_ap_export_to_dbus (merge_ap);
-		emit_ap_added_removed (self, ACCESS_POINT_ADDED, merge_ap, TRUE);
+		ap_list_add (self, g_object_ref (merge_ap));
+		notify_ap_added_removed (self, ACCESS_POINT_ADDED, merge_ap);
+		return TRUE;
 	}
 }
 
@@ -1825,6 +2546,7 @@ cull_scan_list (NMDeviceWifi *self)
 
 	if(removed > 0)
 	    nm_device_recheck_available_connections (NM_DEVICE (self));
+	emit_access_points_changed (self);
 
 	return FALSE;
 }
@@ -1841,17 +2563,19 @@ schedule_scanlist_cull (NMDeviceWifi *self)
 }
 
 static void
-supplicant_iface_new_bss_cb (NMSupplicantInterface *iface,
-                             const char *object_path,
-                             GHashTable *properties,
-                             NMDeviceWifi *self)
+supplicant_iface_new_bsses_cb (NMSupplicantInterface *iface,
+                               GPtrArray *paths,
+                               GPtrArray *props,
+                               NMDeviceWifi *self)
 {
 	NMDeviceState state;
 	NMAccessPoint *ap;
+	guint i, added = 0;
 
 	g_return_if_fail (self != NULL);
-	g_return_if_fail (properties != NULL);
-	g_return_if_fail (iface != NULL);
+	g_return_if_fail (paths != NULL);
+	g_return_if_fail (props != NULL);
+	g_return_if_fail (paths->len == props->len);
 
 	/* Ignore new APs when unavailable, unmanaged, or in AP mode */
 	state = nm_device_get_state (NM_DEVICE (self));
@@ -1860,15 +2584,27 @@ supplicant_iface_new_bss_cb (NMSupplicantInterface *iface,
 	if (NM_DEVICE_WIFI_GET_PRIVATE (self)->mode == NM_802_11_MODE_AP)
 		return;
 
-	ap = nm_ap_new_from_properties (object_path, properties);
-	if (ap) {
-		nm_ap_dump (ap, "New AP: ");
+	/* Merge the whole scan before telling anyone about the new APs */
+	g_object_freeze_notify (G_OBJECT (self));
+	for (i = 0; i < paths->len; i++) {
+		ap = nm_ap_new_from_properties (paths->pdata[i], props->pdata[i]);
+		if (ap) {
+			nm_ap_dump (ap, "New AP: ");
+
+			/* Add the AP to the device's AP list */
+			if (merge_scanned_ap (self, ap))
+				added++;
+			g_object_unref (ap);
+		} else
+			_LOGW (LOGD_WIFI_SCAN, "invalid AP properties received");
+	}
+	g_object_thaw_notify (G_OBJECT (self));
 
-		/* Add the AP to the device's AP list */
-		merge_scanned_ap (self, ap);
-		g_object_unref (ap);
-	} else
-		_LOGW (LOGD_WIFI_SCAN, "invalid AP properties received");
+	NM_DEVICE_WIFI_GET_PRIVATE (self)->scan_churn += added;
+	if (added) {
+		nm_device_emit_recheck_auto_activate (NM_DEVICE (self));
+		nm_device_recheck_available_connections (NM_DEVICE (self));
+	}
 
 	/* Remove outdated access points */
 	schedule_scanlist_cull (self);
@@ -1877,7 +2613,6 @@ supplicant_iface_new_bss_cb (NMSupplicantInterface *iface,
 static void
 supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
                                  const char *object_path,
-                                 GHashTable *properties,
                                  NMDeviceWifi *self)
 {
 	NMDeviceState state;
@@ -1885,7 +2620,6 @@ supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
 
 	g_return_if_fail (self != NULL);
 	g_return_if_fail (object_path != NULL);
-	g_return_if_fail (properties != NULL);
 
 	/* Ignore new APs when unavailable or unamnaged */
 	state = nm_device_get_state (NM_DEVICE (self));
@@ -1912,8 +2646,10 @@ supplicant_iface_bss_removed_cb (NMSupplicantInterface *iface,
 	g_return_if_fail (object_path != NULL);
 
 	ap = get_ap_by_supplicant_path (self, object_path);
-	if (ap)
+	if (ap) {
 		g_object_set_data (G_OBJECT (ap), WPAS_REMOVED_TAG, GUINT_TO_POINTER (TRUE));
+		NM_DEVICE_WIFI_GET_PRIVATE (self)->scan_churn++;
+	}
 }
 
 static void
@@ -2164,7 +2900,7 @@ supplicant_iface_state_cb (NMSupplicantInterface *iface,
 
 	switch (new_state) {
 	case NM_SUPPLICANT_INTERFACE_STATE_READY:
-		priv->scan_interval = SCAN_INTERVAL_MIN;
+		nm_wifi_scan_policy_reset (priv->scan_policy, SCAN_INTERVAL_MIN);
 
 		/* If the interface can now be activated because the supplicant is now
 		 * available, transition to DISCONNECTED.
@@ -2178,8 +2914,7 @@ supplicant_iface_state_cb (NMSupplicantInterface *iface,
 		_LOGD (LOGD_WIFI_SCAN, "supplicant ready, requesting initial scan");
 
 		/* Request a scan to get latest results */
-		cancel_pending_scan (self);
-		request_wireless_scan (self);
+		request_initial_scan (self);
 
 		if (old_state < NM_SUPPLICANT_INTERFACE_STATE_READY)
 			nm_device_remove_pending_action (device, "waiting for supplicant", TRUE);
@@ -2571,7 +3306,6 @@ act_stage1_prepare (NMDevice *device, NMDeviceStateReason *reason)
 	NMConnection *connection;
 	NMSettingWireless *s_wireless;
 	const char *cloned_mac;
-	GSList *iter;
 	const char *mode;
 	const char *ap_path;
 
@@ -2625,17 +3359,11 @@ act_stage1_prepare (NMDevice *device, NMDeviceStateReason *reason)
 			goto done;
 
 		/* Find a compatible AP in the scan list */
-		for (iter = priv->ap_list; iter; iter = g_slist_next (iter)) {
-			NMAccessPoint *candidate = NM_AP (iter->data);
-
-			if (nm_ap_check_compatible (candidate, connection)) {
-				ap = candidate;
-				break;
-			}
-		}
+		ap = find_compatible_ap (self, connection);
 	}
 
 	if (ap) {
+		ap_export (self, ap);
 		nm_active_connection_set_specific_object (NM_ACTIVE_CONNECTION (req), nm_ap_get_dbus_path (ap));
 		goto done;
 	}
@@ -2654,11 +3382,11 @@ act_stage1_prepare (NMDevice *device, NMDeviceStateReason *reason)
 	else if (nm_ap_is_hotspot (ap))
 		nm_ap_set_address (ap, nm_device_get_hw_address (device));
 
-	priv->ap_list = g_slist_prepend (priv->ap_list, ap);
-	nm_ap_export_to_dbus (ap);
+	ap_list_add (self, ap);
 	g_object_freeze_notify (G_OBJECT (self));
 	set_current_ap (self, ap, FALSE, FALSE);
 	emit_ap_added_removed (self, ACCESS_POINT_ADDED, ap, TRUE);
+	emit_access_points_changed (self);
 	g_object_thaw_notify (G_OBJECT (self));
 	nm_active_connection_set_specific_object (NM_ACTIVE_CONNECTION (req), nm_ap_get_dbus_path (ap));
 	return NM_ACT_STAGE_RETURN_SUCCESS;
@@ -2784,8 +3512,7 @@ act_stage2_config (NMDevice *device, NMDeviceStateReason *reason)
 	/* Set up a timeout on the association attempt to fail after 25 seconds */
 	priv->sup_timeout_id = g_timeout_add_seconds (25, supplicant_connection_timeout_cb, self);
 
-	if (!priv->periodic_source_id)
-		priv->periodic_source_id = g_timeout_add_seconds (6, periodic_update_cb, self);
+	periodic_update_start (self);
 
 	/* We'll get stage3 started when the supplicant connects */
 	ret = NM_ACT_STAGE_RETURN_POSTPONE;
@@ -3015,11 +3742,8 @@ activation_success_handler (NMDevice *device)
 	 * the BSSID off the card and fill in the BSSID of the activation AP.
 	 */
 	nm_platform_wifi_get_bssid (ifindex, bssid);
-	if (!nm_ap_get_address (ap)) {
-		char *bssid_str = nm_utils_hwaddr_ntoa (bssid, ETH_ALEN);
-		nm_ap_set_address (ap, bssid_str);
-		g_free (bssid_str);
-	}
+	if (!nm_ap_get_address_bin (ap))
+		nm_ap_set_address_bin (ap, bssid);
 	if (!nm_ap_get_freq (ap))
 		nm_ap_set_freq (ap, nm_platform_wifi_get_frequency (ifindex));
 	if (!nm_ap_get_max_bitrate (ap))
@@ -3039,6 +3763,7 @@ activation_success_handler (NMDevice *device)
 			nm_ap_set_ssid (tmp_ap, ssid->data, ssid->len);
 		}
 
+		ap_export (self, tmp_ap);
 		nm_active_connection_set_specific_object (NM_ACTIVE_CONNECTION (req),
 		                                          nm_ap_get_dbus_path (tmp_ap));
 	}
@@ -3057,8 +3782,11 @@ done:
 
 	/* No need to update seen BSSIDs cache, that is done by set_current_ap() already */
 
+	bss_cache_remember (self, TRUE);
+	bss_cache_flush (self);
+
 	/* Reset scan interval to something reasonable */
-	priv->scan_interval = SCAN_INTERVAL_MIN + (SCAN_INTERVAL_STEP * 2);
+	nm_wifi_scan_policy_reset (priv->scan_policy, SCAN_INTERVAL_MIN + (SCAN_INTERVAL_STEP * 2));
 }
 
 static void
@@ -3087,16 +3815,16 @@ device_state_changed (NMDevice *device,
 	gboolean clear_aps = FALSE;
 
 	if (new_state <= NM_DEVICE_STATE_UNAVAILABLE) {
+		/* Going to sleep or away; keep what we know for coming back */
+		bss_cache_flush (self);
+
 		/* Clean up the supplicant interface because in these states the
 		 * device cannot be used.
 		 */
 		if (priv->sup_iface)
 			supplicant_interface_release (self);
 
-		if (priv->periodic_source_id) {
-			g_source_remove (priv->periodic_source_id);
-			priv->periodic_source_id = 0;
-		}
+		periodic_update_stop (self);
 
 		cleanup_association_attempt (self, TRUE);
 		remove_all_aps (self);
@@ -3133,9 +3861,8 @@ device_state_changed (NMDevice *device,
 		break;
 	case NM_DEVICE_STATE_DISCONNECTED:
 		/* Kick off a scan to get latest results */
-		priv->scan_interval = SCAN_INTERVAL_MIN;
-		cancel_pending_scan (self);
-		request_wireless_scan (self);
+		nm_wifi_scan_policy_reset (priv->scan_policy, SCAN_INTERVAL_MIN);
+		request_initial_scan (self);
 		break;
 	default:
 		break;
@@ -3216,7 +3943,30 @@ nm_device_wifi_new (NMPlatformLink *platform_device)
 static void
 nm_device_wifi_init (NMDeviceWifi *self)
 {
-	NM_DEVICE_WIFI_GET_PRIVATE (self)->mode = NM_802_11_MODE_INFRA;
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	char *policy, *export;
+
+	priv->mode = NM_802_11_MODE_INFRA;
+
+	policy = nm_config_get_value (nm_config_get (), "main", "wifi-scan-policy", NULL);
+	priv->scan_policy = nm_wifi_scan_policy_new (policy);
+	priv->scan_type = NM_WIFI_SCAN_FULL;
+	g_free (policy);
+
+	export = nm_config_get_value (nm_config_get (), "main", "wifi-ap-export", NULL);
+	priv->ap_export_lazy = !g_strcmp0 (export, "on-demand");
+	priv->aps_added = g_ptr_array_new_with_free_func (g_free);
+	priv->aps_removed = g_ptr_array_new_with_free_func (g_free);
+	g_free (export);
+
+	priv->ap_index = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+	                                        (GDestroyNotify) ap_index_entry_free);
+	priv->aps_by_dbus_path = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->aps_by_sup_path = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->aps_by_bssid = g_hash_table_new_full (bssid_hash, bssid_equal, g_free,
+	                                            (GDestroyNotify) g_ptr_array_unref);
+	priv->aps_by_ssid = g_hash_table_new_full (ssid_key_hash, ssid_key_equal, g_free,
+	                                           (GDestroyNotify) g_ptr_array_unref);
 }
 
 static void
@@ -3232,16 +3982,16 @@ dispose (GObject *object)
 
 	priv->disposed = TRUE;
 
-	if (priv->periodic_source_id) {
-		g_source_remove (priv->periodic_source_id);
-		priv->periodic_source_id = 0;
-	}
+	periodic_update_stop (self);
+	g_signal_handlers_disconnect_by_func (nm_platform_get (), G_CALLBACK (wifi_link_event_cb), self);
 
 	cleanup_association_attempt (self, TRUE);
 	supplicant_interface_release (self);
 
 	g_clear_object (&priv->sup_mgr);
 
+	bss_cache_flush (self);
+
 	remove_all_aps (self);
 
 	G_OBJECT_CLASS (nm_device_wifi_parent_class)->dispose (object);
@@ -3256,6 +4006,19 @@ finalize (GObject *object)
 	g_free (priv->perm_hw_addr);
 	g_free (priv->initial_hw_addr);
 
+	g_hash_table_destroy (priv->ap_index);
+	g_hash_table_destroy (priv->aps_by_dbus_path);
+	g_hash_table_destroy (priv->aps_by_sup_path);
+	g_hash_table_destroy (priv->aps_by_bssid);
+	g_hash_table_destroy (priv->aps_by_ssid);
+
+	nm_wifi_scan_policy_free (priv->scan_policy);
+	g_ptr_array_unref (priv->aps_added);
+	g_ptr_array_unref (priv->aps_removed);
+	if (priv->bss_cache)
+		g_ptr_array_unref (priv->bss_cache);
+	g_free (priv->bss_cache_file);
+
 	G_OBJECT_CLASS (nm_device_wifi_parent_class)->finalize (object);
 }
 
@@ -3283,8 +4046,13 @@ get_property (GObject *object, guint prop_id,
 		break;
 	case PROP_ACCESS_POINTS:
 		array = g_ptr_array_sized_new (4);
-		for (iter = priv->ap_list; iter; iter = g_slist_next (iter))
-			g_ptr_array_add (array, g_strdup (nm_ap_get_dbus_path (NM_AP (iter->data))));
+		for (iter = priv->ap_list; iter; iter = g_slist_next (iter)) {
+			const char *path = nm_ap_get_dbus_path (NM_AP (iter->data));
+
+			/* Not all APs are exported with lazy export */
+			if (path)
+				g_ptr_array_add (array, g_strdup (path));
+		}
 		g_value_take_boxed (value, array);
 		break;
 	case PROP_ACTIVE_ACCESS_POINT:
@@ -3333,6 +4101,7 @@ nm_device_wifi_class_init (NMDeviceWifiClass *klass)
 	parent_class->update_initial_hw_address = update_initial_hw_address;
 	parent_class->can_auto_connect = can_auto_connect;
 	parent_class->is_available = is_available;
+	parent_class->compatible_connection_type = NM_SETTING_WIRELESS_SETTING_NAME;
 	parent_class->check_connection_compatible = check_connection_compatible;
 	parent_class->check_connection_available = check_connection_available;
 	parent_class->check_connection_available_wifi_hidden = check_connection_available_wifi_hidden;
@@ -3423,6 +4192,16 @@ nm_device_wifi_class_init (NMDeviceWifiClass *klass)
 		              G_TYPE_NONE, 1,
 		              G_TYPE_OBJECT);
 
+	signals[ACCESS_POINTS_CHANGED] =
+		g_signal_new ("access-points-changed",
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_FIRST,
+		              0,
+		              NULL, NULL, NULL,
+		              G_TYPE_NONE, 2,
+		              DBUS_TYPE_G_ARRAY_OF_OBJECT_PATH,
+		              DBUS_TYPE_G_ARRAY_OF_OBJECT_PATH);
+
 	signals[SCANNING_ALLOWED] =
 		g_signal_new ("scanning-allowed",
 		              G_OBJECT_CLASS_TYPE (object_class),
@@ -46,7 +46,8 @@ typedef struct
 
 	/* Scanned or cached values */
 	GByteArray *	ssid;
-	char *          address;
+	guint8          address[ETH_ALEN]; /* BSSID, valid if address_str is set */
+	char *          address_str;       /* printable form of address */
 	NM80211Mode		mode;
 	gint8			strength;
 	guint32			freq;		/* Frequency in MHz; ie 2412 (== 2.412 GHz) */
@@ -103,7 +104,7 @@ finalize (GObject *object)
 	g_free (priv->supplicant_path);
 	if (priv->ssid)
 		g_byte_array_free (priv->ssid, TRUE);
-	g_free (priv->address);
+	g_free (priv->address_str);
 
 	G_OBJECT_CLASS (nm_ap_parent_class)->finalize (object);
 }
@@ -183,7 +184,7 @@ get_property (GObject *object, guint prop_id,
 		g_value_set_uint (value, priv->freq);
 		break;
 	case PROP_HW_ADDRESS:
-		g_value_set_string (value, priv->address);
+		g_value_set_string (value, priv->address_str);
 		break;
 	case PROP_MODE:
 		g_value_set_uint (value, priv->mode);
@@ -411,13 +412,9 @@ foreach_property_cb (gpointer key, gpointer value, gpointer user_data)
 
 			nm_ap_set_ssid (ap, (const guint8 *) array->data, len);
 		} else if (!strcmp (key, "BSSID")) {
-			char *addr;
-
 			if (array->len != ETH_ALEN)
 				return;
-			addr = nm_utils_hwaddr_ntoa (array->data, array->len);
-			nm_ap_set_address (ap, addr);
-			g_free (addr);
+			nm_ap_set_address_bin (ap, (const guint8 *) array->data);
 		} else if (!strcmp (key, "Rates")) {
 			guint32 maxrate = 0;
 			int i;
@@ -477,7 +474,7 @@ NMAccessPoint *
 nm_ap_new_from_properties (const char *supplicant_path, GHashTable *properties)
 {
 	NMAccessPoint *ap;
-	const char *addr;
+	const guint8 *addr;
 	const char bad_bssid1[ETH_ALEN] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
 	const char bad_bssid2[ETH_ALEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
 
@@ -491,9 +488,10 @@ nm_ap_new_from_properties (const char *supplicant_path, GHashTable *properties)
 	nm_ap_set_supplicant_path (ap, supplicant_path);
 
 	/* ignore APs with invalid BSSIDs */
-	addr = nm_ap_get_address (ap);
-	if (   nm_utils_hwaddr_matches (addr, -1, bad_bssid1, ETH_ALEN)
-	    || nm_utils_hwaddr_matches (addr, -1, bad_bssid2, ETH_ALEN)) {
+	addr = nm_ap_get_address_bin (ap);
+	if (   addr
+	    && (   memcmp (addr, bad_bssid1, ETH_ALEN) == 0
+	        || memcmp (addr, bad_bssid2, ETH_ALEN) == 0)) {
 		g_object_unref (ap);
 		return NULL;
 	}
@@ -727,7 +725,7 @@ nm_ap_dump (NMAccessPoint *ap, const char *prefix)
 	            prefix,
 	            priv->ssid ? nm_utils_escape_ssid (priv->ssid->data, priv->ssid->len) : "(none)",
 	            ap);
-	nm_log_dbg (LOGD_WIFI_SCAN, "    BSSID     %s", str_if_set (priv->address, "(none)"));
+	nm_log_dbg (LOGD_WIFI_SCAN, "    BSSID     %s", str_if_set (priv->address_str, "(none)"));
 	nm_log_dbg (LOGD_WIFI_SCAN, "    mode      %d", priv->mode);
 	nm_log_dbg (LOGD_WIFI_SCAN, "    flags     0x%X", priv->flags);
 	nm_log_dbg (LOGD_WIFI_SCAN, "    wpa flags 0x%X", priv->wpa_flags);
@@ -884,23 +882,48 @@ nm_ap_get_address (const NMAccessPoint *ap)
 {
 	g_return_val_if_fail (NM_IS_AP (ap), NULL);
 
-	return NM_AP_GET_PRIVATE (ap)->address;
+	return NM_AP_GET_PRIVATE (ap)->address_str;
+}
+
+/* Returns the ETH_ALEN bytes of the BSSID, or %NULL if it is not known */
+const guint8 *
+nm_ap_get_address_bin (const NMAccessPoint *ap)
+{
+	NMAccessPointPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_AP (ap), NULL);
+
+	priv = NM_AP_GET_PRIVATE (ap);
+	return priv->address_str ? priv->address : NULL;
 }
 
 void
 nm_ap_set_address (NMAccessPoint *ap, const char *addr)
 {
-	NMAccessPointPrivate *priv;
+	guint8 addr_bin[ETH_ALEN];
 
 	g_return_if_fail (NM_IS_AP (ap));
 	g_return_if_fail (addr != NULL);
 	g_return_if_fail (nm_utils_hwaddr_valid (addr, ETH_ALEN));
 
+	nm_utils_hwaddr_aton (addr, addr_bin, ETH_ALEN);
+	nm_ap_set_address_bin (ap, addr_bin);
+}
+
+void
+nm_ap_set_address_bin (NMAccessPoint *ap, const guint8 *addr)
+{
+	NMAccessPointPrivate *priv;
+
+	g_return_if_fail (NM_IS_AP (ap));
+	g_return_if_fail (addr != NULL);
+
 	priv = NM_AP_GET_PRIVATE (ap);
 
-	if (!priv->address || !nm_utils_hwaddr_matches (addr, -1, priv->address, -1)) {
-		g_free (priv->address);
-		priv->address = g_strdup (addr);
+	if (!priv->address_str || memcmp (addr, priv->address, ETH_ALEN) != 0) {
+		memcpy (priv->address, addr, ETH_ALEN);
+		g_free (priv->address_str);
+		priv->address_str = nm_utils_hwaddr_ntoa (addr, ETH_ALEN);
 		g_object_notify (G_OBJECT (ap), NM_AP_HW_ADDRESS);
 	}
 }
@@ -1097,81 +1120,269 @@ nm_ap_set_last_seen (NMAccessPoint *ap, gint32 last_seen)
 	NM_AP_GET_PRIVATE (ap)->last_seen = last_seen;
 }
 
-gboolean
-nm_ap_check_compatible (NMAccessPoint *self,
-                        NMConnection *connection)
+/*
+ * Matching APs against connections
+ *
+ * Every scan re-checks all Wi-Fi connections against all APs, so what a
+ * connection requires of an AP is extracted once into an NMApMatchKey and
+ * kept on the connection until its settings change.  Security compatibility
+ * only depends on the AP's flags and mode, which few APs differ in, so its
+ * verdicts are remembered per combination.
+ */
+
+#define MATCH_KEY_TAG "nm-ap-match-key"
+
+typedef enum {
+	MATCH_MODE_ANY = 0,
+	MATCH_MODE_INFRA,
+	MATCH_MODE_ADHOC,
+	MATCH_MODE_AP,
+} MatchMode;
+
+typedef struct {
+	NM80211ApFlags flags;
+	NM80211ApSecurityFlags wpa_flags;
+	NM80211ApSecurityFlags rsn_flags;
+	NM80211Mode mode;
+	gboolean compatible;
+} SecurityVerdict;
+
+struct _NMApMatchKey {
+	NMConnection *connection;      /* not owned; the key lives on it */
+	gulong changed_id;
+
+	guint8 *ssid;                  /* without trailing NUL; NULL if unset */
+	gsize ssid_len;
+	gboolean has_bssid;
+	guint8 bssid[ETH_ALEN];
+	MatchMode mode;
+	guint32 freq_min, freq_max;    /* 0 if any band will do */
+	guint32 channel;
+	gboolean never;                /* no AP can satisfy the settings */
+
+	GArray *security;              /* SecurityVerdict */
+};
+
+static void
+match_key_free (gpointer data)
 {
-	NMAccessPointPrivate *priv;
+	NMApMatchKey *key = data;
+
+	if (g_signal_handler_is_connected (key->connection, key->changed_id))
+		g_signal_handler_disconnect (key->connection, key->changed_id);
+	g_free (key->ssid);
+	g_array_unref (key->security);
+	g_slice_free (NMApMatchKey, key);
+}
+
+static void
+match_key_connection_changed (NMConnection *connection, gpointer user_data)
+{
+	g_object_set_data (G_OBJECT (connection), MATCH_KEY_TAG, NULL);
+}
+
+/**
+ * nm_ap_match_key_get:
+ * @connection: a connection
+ *
+ * Returns: (transfer none): the match key of @connection, or %NULL if it is
+ * not a Wi-Fi connection.  The key stays valid until @connection changes.
+ */
+NMApMatchKey *
+nm_ap_match_key_get (NMConnection *connection)
+{
+	NMApMatchKey *key;
 	NMSettingWireless *s_wireless;
-	NMSettingWirelessSecurity *s_wireless_sec;
 	GBytes *ssid;
-	const char *mode;
-	const char *band;
-	const char *bssid;
-	guint32 channel;
+	const char *str;
 
-	g_return_val_if_fail (NM_IS_AP (self), FALSE);
-	g_return_val_if_fail (NM_IS_CONNECTION (connection), FALSE);
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
 
-	priv = NM_AP_GET_PRIVATE (self);
+	key = g_object_get_data (G_OBJECT (connection), MATCH_KEY_TAG);
+	if (key)
+		return key;
 
 	s_wireless = nm_connection_get_setting_wireless (connection);
 	if (s_wireless == NULL)
-		return FALSE;
-	
+		return NULL;
+
+	key = g_slice_new0 (NMApMatchKey);
+	key->connection = connection;
+	key->security = g_array_new (FALSE, FALSE, sizeof (SecurityVerdict));
+
 	ssid = nm_setting_wireless_get_ssid (s_wireless);
-	if (   (ssid && !priv->ssid)
-	    || (priv->ssid && !ssid))
+	if (ssid) {
+		key->ssid = g_memdup (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid));
+		key->ssid_len = g_bytes_get_size (ssid);
+		/* as nm_utils_same_ssid (..., TRUE) does */
+		if (key->ssid_len && key->ssid[key->ssid_len - 1] == '\0')
+			key->ssid_len--;
+		if (!key->ssid)
+			key->ssid = g_malloc0 (1);
+	}
+
+	str = nm_setting_wireless_get_bssid (s_wireless);
+	if (str) {
+		key->has_bssid = TRUE;
+		if (!nm_utils_hwaddr_aton (str, key->bssid, ETH_ALEN))
+			key->never = TRUE;
+	}
+
+	str = nm_setting_wireless_get_mode (s_wireless);
+	if (!g_strcmp0 (str, "infrastructure"))
+		key->mode = MATCH_MODE_INFRA;
+	else if (!g_strcmp0 (str, "adhoc"))
+		key->mode = MATCH_MODE_ADHOC;
+	else if (!g_strcmp0 (str, "ap"))
+		key->mode = MATCH_MODE_AP;
+
+	str = nm_setting_wireless_get_band (s_wireless);
+	if (!g_strcmp0 (str, "a")) {
+		key->freq_min = 4915;
+		key->freq_max = 5825;
+	} else if (!g_strcmp0 (str, "bg")) {
+		key->freq_min = 2412;
+		key->freq_max = 2484;
+	}
+
+	key->channel = nm_setting_wireless_get_channel (s_wireless);
+
+	key->changed_id = g_signal_connect (connection, NM_CONNECTION_CHANGED,
+	                                    G_CALLBACK (match_key_connection_changed), NULL);
+	g_object_set_data_full (G_OBJECT (connection), MATCH_KEY_TAG, key, match_key_free);
+	return key;
+}
+
+/**
+ * nm_ap_match_key_get_ssid:
+ * @key: a match key
+ * @out_len: (out): length of the SSID
+ *
+ * Returns: the SSID the connection wants without a trailing NUL, or %NULL
+ * if it has none.
+ */
+const guint8 *
+nm_ap_match_key_get_ssid (NMApMatchKey *key, gsize *out_len)
+{
+	g_return_val_if_fail (key != NULL, NULL);
+
+	if (out_len)
+		*out_len = key->ssid_len;
+	return key->ssid;
+}
+
+/* The mode compatible APs have, or NM_802_11_MODE_UNKNOWN for any */
+NM80211Mode
+nm_ap_match_key_get_ap_mode (NMApMatchKey *key)
+{
+	g_return_val_if_fail (key != NULL, NM_802_11_MODE_UNKNOWN);
+
+	switch (key->mode) {
+	case MATCH_MODE_INFRA:
+	case MATCH_MODE_AP:
+		return NM_802_11_MODE_INFRA;
+	case MATCH_MODE_ADHOC:
+		return NM_802_11_MODE_ADHOC;
+	default:
+		return NM_802_11_MODE_UNKNOWN;
+	}
+}
+
+static gboolean
+match_key_check_security (NMApMatchKey *key, NMAccessPointPrivate *priv)
+{
+	SecurityVerdict verdict;
+	guint i;
+
+	for (i = 0; i < key->security->len; i++) {
+		SecurityVerdict *v = &g_array_index (key->security, SecurityVerdict, i);
+
+		if (   v->flags == priv->flags
+		    && v->wpa_flags == priv->wpa_flags
+		    && v->rsn_flags == priv->rsn_flags
+		    && v->mode == priv->mode)
+			return v->compatible;
+	}
+
+	verdict.flags = priv->flags;
+	verdict.wpa_flags = priv->wpa_flags;
+	verdict.rsn_flags = priv->rsn_flags;
+	verdict.mode = priv->mode;
+	verdict.compatible = nm_setting_wireless_ap_security_compatible (nm_connection_get_setting_wireless (key->connection),
+	                                                                 nm_connection_get_setting_wireless_security (key->connection),
+	                                                                 priv->flags,
+	                                                                 priv->wpa_flags,
+	                                                                 priv->rsn_flags,
+	                                                                 priv->mode);
+	g_array_append_val (key->security, verdict);
+	return verdict.compatible;
+}
+
+gboolean
+nm_ap_match_key_check (NMApMatchKey *key, NMAccessPoint *self)
+{
+	NMAccessPointPrivate *priv;
+	gsize ssid_len;
+
+	g_return_val_if_fail (key != NULL, FALSE);
+	g_return_val_if_fail (NM_IS_AP (self), FALSE);
+
+	priv = NM_AP_GET_PRIVATE (self);
+
+	if (key->never)
 		return FALSE;
 
-	if (   ssid && priv->ssid &&
-	    !nm_utils_same_ssid (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid),
-	                         priv->ssid->data, priv->ssid->len,
-	                         TRUE))
+	if (!key->ssid != !priv->ssid)
 		return FALSE;
+	if (key->ssid) {
+		ssid_len = priv->ssid->len;
+		if (ssid_len && priv->ssid->data[ssid_len - 1] == '\0')
+			ssid_len--;
+		if (   ssid_len != key->ssid_len
+		    || memcmp (key->ssid, priv->ssid->data, ssid_len) != 0)
+			return FALSE;
+	}
 
-	bssid = nm_setting_wireless_get_bssid (s_wireless);
-	if (bssid && (!priv->address || !nm_utils_hwaddr_matches (bssid, -1, priv->address, -1)))
+	if (key->has_bssid && (!priv->address_str || memcmp (key->bssid, priv->address, ETH_ALEN)))
 		return FALSE;
 
-	mode = nm_setting_wireless_get_mode (s_wireless);
-	if (mode) {
-		if (!strcmp (mode, "infrastructure") && (priv->mode != NM_802_11_MODE_INFRA))
+	switch (key->mode) {
+	case MATCH_MODE_INFRA:
+		if (priv->mode != NM_802_11_MODE_INFRA)
 			return FALSE;
-		if (!strcmp (mode, "adhoc") && (priv->mode != NM_802_11_MODE_ADHOC))
+		break;
+	case MATCH_MODE_ADHOC:
+		if (priv->mode != NM_802_11_MODE_ADHOC)
 			return FALSE;
-		if (   !strcmp (mode, "ap")
-		    && (priv->mode != NM_802_11_MODE_INFRA || priv->hotspot != TRUE))
+		break;
+	case MATCH_MODE_AP:
+		if (priv->mode != NM_802_11_MODE_INFRA || priv->hotspot != TRUE)
 			return FALSE;
+		break;
+	default:
+		break;
 	}
 
-	band = nm_setting_wireless_get_band (s_wireless);
-	if (band) {
-		if (!strcmp (band, "a")) {
-			if (priv->freq < 4915 || priv->freq > 5825)
-				return FALSE;
-		} else if (!strcmp (band, "bg")) {
-			if (priv->freq < 2412 || priv->freq > 2484)
-				return FALSE;
-		}
-	}
+	if (key->freq_max && (priv->freq < key->freq_min || priv->freq > key->freq_max))
+		return FALSE;
 
-	channel = nm_setting_wireless_get_channel (s_wireless);
-	if (channel) {
-		guint32 ap_chan = nm_utils_wifi_freq_to_channel (priv->freq);
+	if (key->channel && key->channel != nm_utils_wifi_freq_to_channel (priv->freq))
+		return FALSE;
 
-		if (channel != ap_chan)
-			return FALSE;
-	}
+	return match_key_check_security (key, priv);
+}
 
-	s_wireless_sec = nm_connection_get_setting_wireless_security (connection);
+gboolean
+nm_ap_check_compatible (NMAccessPoint *self,
+                        NMConnection *connection)
+{
+	NMApMatchKey *key;
+
+	g_return_val_if_fail (NM_IS_AP (self), FALSE);
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), FALSE);
 
-	return nm_setting_wireless_ap_security_compatible (s_wireless,
-	                                                   s_wireless_sec,
-	                                                   nm_ap_get_flags (self),
-	                                                   nm_ap_get_wpa_flags (self),
-	                                                   nm_ap_get_rsn_flags (self),
-	                                                   nm_ap_get_mode (self));
+	key = nm_ap_match_key_get (connection);
+	return key ? nm_ap_match_key_check (key, self) : FALSE;
 }
 
 gboolean
@@ -1185,7 +1396,7 @@ nm_ap_complete_connection (NMAccessPoint *self,
 	g_return_val_if_fail (connection != NULL, FALSE);
 
 	return nm_ap_utils_complete_connection (priv->ssid,
-	                                        priv->address,
+	                                        priv->address_str,
 	                                        priv->mode,
 	                                        priv->flags,
 	                                        priv->wpa_flags,
@@ -1216,6 +1427,84 @@ capabilities_compatible (NM80211ApSecurityFlags a_flags, NM80211ApSecurityFlags
 	return TRUE;
 }
 
+static gboolean
+address_is_valid (const guint8 *addr)
+{
+	return addr && nm_ethernet_address_is_valid (addr, ETH_ALEN);
+}
+
+/**
+ * nm_ap_match:
+ * @list_ap: an AP from the device's scan list
+ * @find_ap: the AP to look for
+ * @strict_match: whether the security capabilities must be the same, or only
+ *   compatible
+ *
+ * Returns: %TRUE if @find_ap describes the same network as @list_ap
+ */
+gboolean
+nm_ap_match (NMAccessPoint *list_ap,
+             NMAccessPoint *find_ap,
+             gboolean strict_match)
+{
+	NMAccessPointPrivate *list_priv, *find_priv;
+	const guint8 *list_addr, *find_addr;
+
+	g_return_val_if_fail (NM_IS_AP (list_ap), FALSE);
+	g_return_val_if_fail (NM_IS_AP (find_ap), FALSE);
+
+	list_priv = NM_AP_GET_PRIVATE (list_ap);
+	find_priv = NM_AP_GET_PRIVATE (find_ap);
+
+	/* SSID match; if both APs are hiding their SSIDs,
+	 * let matching continue on BSSID and other properties
+	 */
+	if (   (!list_priv->ssid && find_priv->ssid)
+	    || (list_priv->ssid && !find_priv->ssid))
+		return FALSE;
+	if (   list_priv->ssid
+	    && find_priv->ssid
+	    && !nm_utils_same_ssid (list_priv->ssid->data, list_priv->ssid->len,
+	                            find_priv->ssid->data, find_priv->ssid->len,
+	                            TRUE))
+		return FALSE;
+
+	/* BSSID match */
+	list_addr = nm_ap_get_address_bin (list_ap);
+	find_addr = nm_ap_get_address_bin (find_ap);
+	if (   (strict_match || address_is_valid (find_addr))
+	    && address_is_valid (list_addr)
+	    && (!find_addr || memcmp (list_addr, find_addr, ETH_ALEN) != 0))
+		return FALSE;
+
+	/* mode match */
+	if (list_priv->mode != find_priv->mode)
+		return FALSE;
+
+	/* Frequency match */
+	if (list_priv->freq != find_priv->freq)
+		return FALSE;
+
+	/* AP flags */
+	if (list_priv->flags != find_priv->flags)
+		return FALSE;
+
+	if (strict_match) {
+		if (list_priv->wpa_flags != find_priv->wpa_flags)
+			return FALSE;
+
+		if (list_priv->rsn_flags != find_priv->rsn_flags)
+			return FALSE;
+	} else {
+		/* Just ensure that there is overlap in the capabilities */
+		if (   !capabilities_compatible (list_priv->wpa_flags, find_priv->wpa_flags)
+		    && !capabilities_compatible (list_priv->rsn_flags, find_priv->rsn_flags))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
 NMAccessPoint *
 nm_ap_match_in_list (NMAccessPoint *find_ap,
                      GSList *ap_list,
@@ -1226,65 +1515,9 @@ nm_ap_match_in_list (NMAccessPoint *find_ap,
 	g_return_val_if_fail (find_ap != NULL, NULL);
 
 	for (iter = ap_list; iter; iter = g_slist_next (iter)) {
-		NMAccessPoint * list_ap = NM_AP (iter->data);
-		const GByteArray * list_ssid = nm_ap_get_ssid (list_ap);
-		const char * list_addr = nm_ap_get_address (list_ap);
-
-		const GByteArray * find_ssid = nm_ap_get_ssid (find_ap);
-		const char * find_addr = nm_ap_get_address (find_ap);
-
-		/* SSID match; if both APs are hiding their SSIDs,
-		 * let matching continue on BSSID and other properties
-		 */
-		if (   (!list_ssid && find_ssid)
-		    || (list_ssid && !find_ssid))
-			continue;
-		if (   list_ssid
-		    && find_ssid
-		    && !nm_utils_same_ssid (list_ssid->data, list_ssid->len,
-		                            find_ssid->data, find_ssid->len,
-		                            TRUE))
-			continue;
-
-		/* BSSID match */
-		if (   (strict_match || nm_ethernet_address_is_valid (find_addr, -1))
-		    && nm_ethernet_address_is_valid (list_addr, -1)
-		    && !nm_utils_hwaddr_matches (list_addr, -1, find_addr, -1))
-			continue;
-
-		/* mode match */
-		if (nm_ap_get_mode (list_ap) != nm_ap_get_mode (find_ap))
-			continue;
-
-		/* Frequency match */
-		if (nm_ap_get_freq (list_ap) != nm_ap_get_freq (find_ap))
-			continue;
-
-		/* AP flags */
-		if (nm_ap_get_flags (list_ap) != nm_ap_get_flags (find_ap))
-			continue;
-
-		if (strict_match) {
-			if (nm_ap_get_wpa_flags (list_ap) != nm_ap_get_wpa_flags (find_ap))
-				continue;
-
-			if (nm_ap_get_rsn_flags (list_ap) != nm_ap_get_rsn_flags (find_ap))
-				continue;
-		} else {
-			NM80211ApSecurityFlags list_wpa_flags = nm_ap_get_wpa_flags (list_ap);
-			NM80211ApSecurityFlags find_wpa_flags = nm_ap_get_wpa_flags (find_ap);
-			NM80211ApSecurityFlags list_rsn_flags = nm_ap_get_rsn_flags (list_ap);
-			NM80211ApSecurityFlags find_rsn_flags = nm_ap_get_rsn_flags (find_ap);
-
-			/* Just ensure that there is overlap in the capabilities */
-			if (   !capabilities_compatible (list_wpa_flags, find_wpa_flags)
-			    && !capabilities_compatible (list_rsn_flags, find_rsn_flags))
-				continue;
-		}
-
-		return list_ap;
+		if (nm_ap_match (NM_AP (iter->data), find_ap, strict_match))
+			return NM_AP (iter->data);
 	}
 
 	return NULL;
 }
-
@@ -81,6 +81,9 @@ void                   nm_ap_set_rsn_flags (NMAccessPoint *ap, NM80211ApSecurity
 const char *nm_ap_get_address (const NMAccessPoint *ap);
 void        nm_ap_set_address (NMAccessPoint *ap, const char *addr);
 
+const guint8 *nm_ap_get_address_bin (const NMAccessPoint *ap);
+void          nm_ap_set_address_bin (NMAccessPoint *ap, const guint8 *addr);
+
 NM80211Mode nm_ap_get_mode (NMAccessPoint *ap);
 void        nm_ap_set_mode (NMAccessPoint *ap, const NM80211Mode mode);
 
@@ -104,6 +107,13 @@ void     nm_ap_set_broadcast (NMAccessPoint *ap, gboolean broadcast);
 gint32   nm_ap_get_last_seen (const NMAccessPoint *ap);
 void     nm_ap_set_last_seen (NMAccessPoint *ap, gint32 last_seen);
 
+typedef struct _NMApMatchKey NMApMatchKey;
+
+NMApMatchKey *nm_ap_match_key_get         (NMConnection *connection);
+const guint8 *nm_ap_match_key_get_ssid    (NMApMatchKey *key, gsize *out_len);
+NM80211Mode   nm_ap_match_key_get_ap_mode (NMApMatchKey *key);
+gboolean      nm_ap_match_key_check       (NMApMatchKey *key, NMAccessPoint *ap);
+
 gboolean nm_ap_check_compatible (NMAccessPoint *self,
                                  NMConnection *connection);
 
@@ -112,6 +122,10 @@ gboolean nm_ap_complete_connection (NMAccessPoint *self,
                                     gboolean lock_bssid,
                                     GError **error);
 
+gboolean            nm_ap_match (NMAccessPoint *list_ap,
+                                 NMAccessPoint *find_ap,
+                                 gboolean strict_match);
+
 NMAccessPoint *     nm_ap_match_in_list (NMAccessPoint *find_ap,
                                          GSList *ap_list,
                                          gboolean strict_match);
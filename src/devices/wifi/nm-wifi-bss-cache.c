@@ -0,0 +1,330 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "nm-wifi-bss-cache.h"
+#include "nm-utils.h"
+#include "NetworkManagerUtils.h"
+#include "nm-logging.h"
+
+/* The cache is a keyfile with one group per BSSID:
+ *
+ *   [00:11:22:33:44:55]
+ *   ssid=686f6d65
+ *   frequency=2437
+ *   mode=2
+ *   flags=1
+ *   wpa-flags=0
+ *   rsn-flags=392
+ *   last-seen=1429013231
+ *   last-good=true
+ *
+ * It is small and only written when a connection succeeds and when the
+ * device goes down, so it is simply rewritten as a whole.
+ */
+
+static void
+entry_free (NMWifiBssCacheEntry *entry)
+{
+	if (entry->ssid)
+		g_byte_array_unref (entry->ssid);
+	g_slice_free (NMWifiBssCacheEntry, entry);
+}
+
+static GPtrArray *
+cache_new (void)
+{
+	return g_ptr_array_new_with_free_func ((GDestroyNotify) entry_free);
+}
+
+static NMWifiBssCacheEntry *
+entry_from_keyfile (GKeyFile *keyfile, const char *group)
+{
+	NMWifiBssCacheEntry *entry;
+	char *ssid_hex;
+	GBytes *ssid;
+	GError *error = NULL;
+
+	entry = g_slice_new0 (NMWifiBssCacheEntry);
+	if (!nm_utils_hwaddr_aton (group, entry->bssid, ETH_ALEN))
+		goto error;
+
+	ssid_hex = g_key_file_get_string (keyfile, group, "ssid", NULL);
+	ssid = ssid_hex ? nm_utils_hexstr2bin (ssid_hex) : NULL;
+	g_free (ssid_hex);
+	if (!ssid || !g_bytes_get_size (ssid) || g_bytes_get_size (ssid) > 32) {
+		if (ssid)
+			g_bytes_unref (ssid);
+		goto error;
+	}
+	entry->ssid = g_byte_array_new ();
+	g_byte_array_append (entry->ssid, g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid));
+	g_bytes_unref (ssid);
+
+	entry->last_seen = g_key_file_get_int64 (keyfile, group, "last-seen", &error);
+	if (error)
+		goto error;
+
+	entry->freq = g_key_file_get_integer (keyfile, group, "frequency", NULL);
+	entry->mode = g_key_file_get_integer (keyfile, group, "mode", NULL);
+	entry->flags = g_key_file_get_integer (keyfile, group, "flags", NULL);
+	entry->wpa_flags = g_key_file_get_integer (keyfile, group, "wpa-flags", NULL);
+	entry->rsn_flags = g_key_file_get_integer (keyfile, group, "rsn-flags", NULL);
+	entry->last_good = g_key_file_get_boolean (keyfile, group, "last-good", NULL);
+	return entry;
+
+error:
+	g_clear_error (&error);
+	entry_free (entry);
+	return NULL;
+}
+
+/**
+ * nm_wifi_bss_cache_load:
+ * @filename: the cache file
+ * @now: the current wall-clock time, in seconds
+ *
+ * Reads the BSS cache, dropping invalid and expired entries.
+ *
+ * Returns: the cache entries, newest first and the last good BSS before all
+ * others.  A missing or unreadable file results in an empty array.
+ */
+GPtrArray *
+nm_wifi_bss_cache_load (const char *filename, gint64 now)
+{
+	GPtrArray *cache = cache_new ();
+	GKeyFile *keyfile;
+	GError *error = NULL;
+	char **groups;
+	guint i;
+
+	g_return_val_if_fail (filename != NULL, cache);
+
+	keyfile = g_key_file_new ();
+	if (!g_key_file_load_from_file (keyfile, filename, G_KEY_FILE_NONE, &error)) {
+		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+			nm_log_warn (LOGD_WIFI, "error reading Wi-Fi BSS cache '%s': %s",
+			             filename, error->message);
+		}
+		g_error_free (error);
+		g_key_file_free (keyfile);
+		return cache;
+	}
+
+	groups = g_key_file_get_groups (keyfile, NULL);
+	for (i = 0; groups[i]; i++) {
+		NMWifiBssCacheEntry *entry = entry_from_keyfile (keyfile, groups[i]);
+
+		if (entry)
+			g_ptr_array_add (cache, entry);
+		else
+			nm_log_dbg (LOGD_WIFI, "ignoring invalid Wi-Fi BSS cache entry '%s'", groups[i]);
+	}
+	g_strfreev (groups);
+	g_key_file_free (keyfile);
+
+	nm_wifi_bss_cache_prune (cache, now);
+	return cache;
+}
+
+/**
+ * nm_wifi_bss_cache_save:
+ * @cache: the cache entries
+ * @filename: the cache file
+ * @error: location to store the error on failure
+ *
+ * Replaces @filename with the contents of @cache.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+nm_wifi_bss_cache_save (GPtrArray *cache, const char *filename, GError **error)
+{
+	GKeyFile *keyfile;
+	char *data;
+	gsize len;
+	gboolean success = FALSE;
+	guint i;
+
+	g_return_val_if_fail (cache != NULL, FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	keyfile = g_key_file_new ();
+	for (i = 0; i < cache->len; i++) {
+		NMWifiBssCacheEntry *entry = cache->pdata[i];
+		char *group, *ssid_hex;
+
+		group = nm_utils_hwaddr_ntoa (entry->bssid, ETH_ALEN);
+		ssid_hex = nm_utils_bin2hexstr (entry->ssid->data, entry->ssid->len, -1);
+		g_key_file_set_string (keyfile, group, "ssid", ssid_hex);
+		g_key_file_set_integer (keyfile, group, "frequency", entry->freq);
+		g_key_file_set_integer (keyfile, group, "mode", entry->mode);
+		g_key_file_set_integer (keyfile, group, "flags", entry->flags);
+		g_key_file_set_integer (keyfile, group, "wpa-flags", entry->wpa_flags);
+		g_key_file_set_integer (keyfile, group, "rsn-flags", entry->rsn_flags);
+		g_key_file_set_int64 (keyfile, group, "last-seen", entry->last_seen);
+		if (entry->last_good)
+			g_key_file_set_boolean (keyfile, group, "last-good", TRUE);
+		g_free (ssid_hex);
+		g_free (group);
+	}
+
+	data = g_key_file_to_data (keyfile, &len, error);
+	if (data) {
+		success = g_file_set_contents (filename, data, len, error);
+		g_free (data);
+	}
+	g_key_file_free (keyfile);
+	return success;
+}
+
+/**
+ * nm_wifi_bss_cache_add:
+ * @cache: the cache entries
+ * @ap: the access point to remember
+ * @now: the current wall-clock time, in seconds
+ * @last_good: whether a connection just succeeded using @ap
+ *
+ * Adds @ap to @cache, or refreshes its existing entry.  Access points
+ * without a BSSID or SSID are ignored.
+ */
+void
+nm_wifi_bss_cache_add (GPtrArray *cache, NMAccessPoint *ap, gint64 now, gboolean last_good)
+{
+	NMWifiBssCacheEntry *entry = NULL;
+	const guint8 *bssid = nm_ap_get_address_bin (ap);
+	const GByteArray *ssid = nm_ap_get_ssid (ap);
+	guint i;
+
+	g_return_if_fail (cache != NULL);
+
+	if (!bssid || !nm_ethernet_address_is_valid (bssid, ETH_ALEN))
+		return;
+	if (!ssid || !ssid->len || nm_utils_is_empty_ssid (ssid->data, ssid->len))
+		return;
+
+	for (i = 0; i < cache->len; i++) {
+		NMWifiBssCacheEntry *e = cache->pdata[i];
+
+		if (memcmp (e->bssid, bssid, ETH_ALEN) == 0)
+			entry = e;
+		else if (last_good)
+			e->last_good = FALSE;
+	}
+
+	if (!entry) {
+		entry = g_slice_new0 (NMWifiBssCacheEntry);
+		memcpy (entry->bssid, bssid, ETH_ALEN);
+		g_ptr_array_add (cache, entry);
+	}
+
+	if (entry->ssid)
+		g_byte_array_unref (entry->ssid);
+	entry->ssid = g_byte_array_new ();
+	g_byte_array_append (entry->ssid, ssid->data, ssid->len);
+	entry->freq = nm_ap_get_freq (ap);
+	entry->mode = nm_ap_get_mode (ap);
+	entry->flags = nm_ap_get_flags (ap);
+	entry->wpa_flags = nm_ap_get_wpa_flags (ap);
+	entry->rsn_flags = nm_ap_get_rsn_flags (ap);
+	entry->last_seen = now;
+	if (last_good)
+		entry->last_good = TRUE;
+}
+
+static int
+entry_cmp (gconstpointer a, gconstpointer b)
+{
+	const NMWifiBssCacheEntry *ea = *(const NMWifiBssCacheEntry **) a;
+	const NMWifiBssCacheEntry *eb = *(const NMWifiBssCacheEntry **) b;
+
+	if (ea->last_good != eb->last_good)
+		return ea->last_good ? -1 : 1;
+	if (ea->last_seen != eb->last_seen)
+		return ea->last_seen > eb->last_seen ? -1 : 1;
+	return 0;
+}
+
+/**
+ * nm_wifi_bss_cache_prune:
+ * @cache: the cache entries
+ * @now: the current wall-clock time, in seconds
+ *
+ * Sorts @cache like nm_wifi_bss_cache_load() does and drops expired
+ * entries and those beyond %NM_WIFI_BSS_CACHE_MAX_ENTRIES.  Entries from
+ * the future (the clock was set back) are treated as just seen.
+ */
+void
+nm_wifi_bss_cache_prune (GPtrArray *cache, gint64 now)
+{
+	guint i;
+
+	g_return_if_fail (cache != NULL);
+
+	for (i = 0; i < cache->len; ) {
+		NMWifiBssCacheEntry *entry = cache->pdata[i];
+
+		if (entry->last_seen > now)
+			entry->last_seen = now;
+		if (entry->last_seen + NM_WIFI_BSS_CACHE_MAX_AGE < now)
+			g_ptr_array_remove_index_fast (cache, i);
+		else
+			i++;
+	}
+
+	g_ptr_array_sort (cache, entry_cmp);
+	if (cache->len > NM_WIFI_BSS_CACHE_MAX_ENTRIES)
+		g_ptr_array_set_size (cache, NM_WIFI_BSS_CACHE_MAX_ENTRIES);
+}
+
+/**
+ * nm_wifi_bss_cache_get_freqs:
+ * @cache: the cache entries, as sorted by nm_wifi_bss_cache_prune()
+ * @max_freqs: the maximum number of frequencies to return
+ *
+ * Returns: the frequencies (#guint32, in MHz) the most recently used BSSes
+ * are on, the last good BSS's first.
+ */
+GArray *
+nm_wifi_bss_cache_get_freqs (GPtrArray *cache, guint max_freqs)
+{
+	GArray *freqs;
+	guint i, j;
+
+	g_return_val_if_fail (cache != NULL, NULL);
+
+	freqs = g_array_new (FALSE, FALSE, sizeof (guint32));
+	for (i = 0; i < cache->len && freqs->len < max_freqs; i++) {
+		NMWifiBssCacheEntry *entry = cache->pdata[i];
+
+		if (!entry->freq)
+			continue;
+		for (j = 0; j < freqs->len; j++) {
+			if (g_array_index (freqs, guint32, j) == entry->freq)
+				break;
+		}
+		if (j == freqs->len)
+			g_array_append_val (freqs, entry->freq);
+	}
+	return freqs;
+}
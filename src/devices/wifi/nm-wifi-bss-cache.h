@@ -0,0 +1,66 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ */
+
+
+#ifndef __NETWORKMANAGER_WIFI_BSS_CACHE_H__
+#define __NETWORKMANAGER_WIFI_BSS_CACHE_H__
+
+#include <glib.h>
+#include <net/ethernet.h>
+
+#include "nm-wifi-ap.h"
+
+/* Per device, keyed by the permanent MAC address */
+#define NM_WIFI_BSS_CACHE_FILE_FMT     NMSTATEDIR "/wifi-bss-cache-%s"
+
+#define NM_WIFI_BSS_CACHE_MAX_ENTRIES  32
+#define NM_WIFI_BSS_CACHE_MAX_AGE      (14 * 24 * 60 * 60)   /* seconds */
+
+/* A BSS of a network we were connected to, remembered across restarts and
+ * suspend so the device knows where to look first.
+ */
+typedef struct {
+	guint8 bssid[ETH_ALEN];
+	GByteArray *ssid;
+	guint32 freq;
+	NM80211Mode mode;
+	NM80211ApFlags flags;
+	NM80211ApSecurityFlags wpa_flags;
+	NM80211ApSecurityFlags rsn_flags;
+	gint64 last_seen;       /* wall-clock time, in seconds */
+	gboolean last_good;     /* the BSS the last successful connection used */
+} NMWifiBssCacheEntry;
+
+GPtrArray *nm_wifi_bss_cache_load  (const char *filename, gint64 now);
+
+gboolean   nm_wifi_bss_cache_save  (GPtrArray *cache,
+                                    const char *filename,
+                                    GError **error);
+
+void       nm_wifi_bss_cache_add   (GPtrArray *cache,
+                                    NMAccessPoint *ap,
+                                    gint64 now,
+                                    gboolean last_good);
+
+void       nm_wifi_bss_cache_prune (GPtrArray *cache, gint64 now);
+
+GArray    *nm_wifi_bss_cache_get_freqs (GPtrArray *cache, guint max_freqs);
+
+#endif /* __NETWORKMANAGER_WIFI_BSS_CACHE_H__ */
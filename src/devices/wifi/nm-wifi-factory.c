@@ -72,11 +72,23 @@ get_device_type (NMDeviceFactory *factory)
 	return NM_DEVICE_TYPE_WIFI;
 }
 
+static void
+get_supported_types (NMDeviceFactory *factory,
+                     const NMLinkType **out_link_types,
+                     const char ***out_setting_types)
+{
+	static const NMLinkType link_types[] = { NM_LINK_TYPE_WIFI, NM_LINK_TYPE_OLPC_MESH, NM_LINK_TYPE_NONE };
+
+	*out_link_types = link_types;
+	*out_setting_types = NULL;
+}
+
 static void
 device_factory_interface_init (NMDeviceFactory *factory_iface)
 {
 	factory_iface->new_link = new_link;
 	factory_iface->get_device_type = get_device_type;
+	factory_iface->get_supported_types = get_supported_types;
 }
 
 static void
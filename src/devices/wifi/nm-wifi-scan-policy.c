@@ -0,0 +1,271 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "nm-wifi-scan-policy.h"
+
+/* A scan policy decides when the device scans in the background and what
+ * kind of scan it asks the supplicant for.  Scans the user requests and
+ * the initial scans after state changes are always full scans and don't
+ * go through the policy.
+ */
+typedef struct {
+	const char *name;
+	guint (*get_interval) (NMWifiScanPolicy *policy, const NMWifiScanInfo *info, gboolean backoff);
+	NMWifiScanType (*get_scan_type) (NMWifiScanPolicy *policy, const NMWifiScanInfo *info);
+	void (*scan_done) (NMWifiScanPolicy *policy, NMWifiScanType type, gboolean success, guint churn, guint total);
+} ScanPolicyClass;
+
+struct _NMWifiScanPolicy {
+	const ScanPolicyClass *klass;
+
+	guint interval;          /* seconds; the next backed-off interval */
+
+	/* Fraction of the scan list that changed per scan, as a moving
+	 * average.  High when the device moves around, 0 when it doesn't.
+	 */
+	double churn;
+
+	guint partial_scans;     /* partial scans since the last full one */
+};
+
+/*****************************************************************************/
+/* "backoff": scan everything, linearly backing off up to SCAN_INTERVAL_MAX
+ * (half of that when not connected).
+ */
+
+static guint
+backoff_get_interval (NMWifiScanPolicy *policy, const NMWifiScanInfo *info, gboolean backoff)
+{
+	guint factor = info->connected ? 1 : 2;
+	guint next_scan = policy->interval;
+
+	if (backoff && (policy->interval < (SCAN_INTERVAL_MAX / factor))) {
+		policy->interval += (SCAN_INTERVAL_STEP / factor);
+		/* Ensure the scan interval will never be less than 20s... */
+		policy->interval = MAX (policy->interval, SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP);
+		/* ... or more than 120s */
+		policy->interval = MIN (policy->interval, SCAN_INTERVAL_MAX);
+	} else if (!backoff && (policy->interval == 0)) {
+		/* Invalid combination; would cause continual rescheduling of
+		 * the scan and hog CPU.  Reset to something minimally sane.
+		 */
+		policy->interval = 5;
+	}
+
+	return next_scan ? next_scan : 5;
+}
+
+static NMWifiScanType
+backoff_get_scan_type (NMWifiScanPolicy *policy, const NMWifiScanInfo *info)
+{
+	return NM_WIFI_SCAN_FULL;
+}
+
+static const ScanPolicyClass backoff_class = {
+	.name = "backoff",
+	.get_interval = backoff_get_interval,
+	.get_scan_type = backoff_get_scan_type,
+};
+
+/*****************************************************************************/
+/* "adaptive": like "backoff" while looking for a network.  Once connected,
+ * scan only as often as signal strength and motion warrant, mostly on the
+ * channels the current network was seen on, and not at all while the link
+ * is strong and the surroundings don't change.
+ */
+
+#define STRENGTH_STRONG    70     /* percent */
+#define STRENGTH_WEAK      40     /* percent */
+#define CHURN_STABLE       0.1
+#define PARTIAL_SCANS_MAX  3      /* full scan after this many partial ones */
+
+static gboolean
+adaptive_link_stable (NMWifiScanPolicy *policy, const NMWifiScanInfo *info)
+{
+	return    info->strength >= STRENGTH_STRONG
+	       && policy->churn < CHURN_STABLE
+	       && info->scan_age >= 0;
+}
+
+static guint
+adaptive_get_interval (NMWifiScanPolicy *policy, const NMWifiScanInfo *info, gboolean backoff)
+{
+	guint interval;
+
+	if (!info->connected || info->strength < 0)
+		return backoff_get_interval (policy, info, backoff);
+
+	/* Nothing to roam to would be better; wait for the signal to drop */
+	if (adaptive_link_stable (policy, info))
+		return 0;
+
+	/* A weak link needs fresh roaming candidates, and needs them sooner
+	 * when none are known at all.
+	 */
+	if (info->strength < STRENGTH_WEAK)
+		interval = info->roam_candidates ? SCAN_INTERVAL_STEP : SCAN_INTERVAL_STEP / 2;
+	else
+		interval = SCAN_INTERVAL_MAX;
+
+	/* The faster the surroundings change, the sooner results go stale */
+	interval = (guint) (interval / (1.0 + 4.0 * policy->churn));
+
+	return CLAMP (interval, SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP / 2, SCAN_INTERVAL_MAX);
+}
+
+static NMWifiScanType
+adaptive_get_scan_type (NMWifiScanPolicy *policy, const NMWifiScanInfo *info)
+{
+	if (!info->connected || info->strength < 0)
+		return NM_WIFI_SCAN_FULL;
+
+	if (adaptive_link_stable (policy, info))
+		return NM_WIFI_SCAN_NONE;
+
+	/* Look at the whole band every now and then so that BSSes on channels
+	 * we haven't seen the network on yet are found, too.
+	 */
+	if (   !info->known_channels
+	    || !info->roam_candidates
+	    || policy->partial_scans >= PARTIAL_SCANS_MAX)
+		return NM_WIFI_SCAN_FULL;
+
+	return NM_WIFI_SCAN_PARTIAL;
+}
+
+static void
+adaptive_scan_done (NMWifiScanPolicy *policy, NMWifiScanType type, gboolean success, guint churn, guint total)
+{
+	if (!success)
+		return;
+
+	if (type == NM_WIFI_SCAN_PARTIAL)
+		policy->partial_scans++;
+	else
+		policy->partial_scans = 0;
+
+	if (total)
+		policy->churn = (policy->churn + (double) MIN (churn, total) / total) / 2;
+}
+
+static const ScanPolicyClass adaptive_class = {
+	.name = "adaptive",
+	.get_interval = adaptive_get_interval,
+	.get_scan_type = adaptive_get_scan_type,
+	.scan_done = adaptive_scan_done,
+};
+
+/*****************************************************************************/
+
+static const ScanPolicyClass *policy_classes[] = {
+	&adaptive_class,
+	&backoff_class,
+};
+
+/**
+ * nm_wifi_scan_policy_new:
+ * @name: name of the policy, or %NULL for the default one
+ *
+ * Returns: a new scan policy; an unknown @name results in the default
+ * policy.
+ */
+NMWifiScanPolicy *
+nm_wifi_scan_policy_new (const char *name)
+{
+	NMWifiScanPolicy *policy;
+	guint i;
+
+	policy = g_slice_new0 (NMWifiScanPolicy);
+	policy->klass = policy_classes[0];
+	for (i = 0; name && i < G_N_ELEMENTS (policy_classes); i++) {
+		if (!strcmp (name, policy_classes[i]->name)) {
+			policy->klass = policy_classes[i];
+			break;
+		}
+	}
+
+	nm_wifi_scan_policy_reset (policy, SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP);
+	return policy;
+}
+
+void
+nm_wifi_scan_policy_free (NMWifiScanPolicy *policy)
+{
+	g_return_if_fail (policy != NULL);
+
+	g_slice_free (NMWifiScanPolicy, policy);
+}
+
+const char *
+nm_wifi_scan_policy_get_name (NMWifiScanPolicy *policy)
+{
+	g_return_val_if_fail (policy != NULL, NULL);
+
+	return policy->klass->name;
+}
+
+void
+nm_wifi_scan_policy_reset (NMWifiScanPolicy *policy, guint interval)
+{
+	g_return_if_fail (policy != NULL);
+
+	policy->interval = interval;
+	/* Whatever we knew about the surroundings may no longer apply */
+	policy->churn = 1.0;
+	policy->partial_scans = 0;
+}
+
+void
+nm_wifi_scan_policy_scan_done (NMWifiScanPolicy *policy,
+                               NMWifiScanType type,
+                               gboolean success,
+                               guint churn,
+                               guint total)
+{
+	g_return_if_fail (policy != NULL);
+
+	if (policy->klass->scan_done)
+		policy->klass->scan_done (policy, type, success, churn, total);
+}
+
+guint
+nm_wifi_scan_policy_get_interval (NMWifiScanPolicy *policy,
+                                  const NMWifiScanInfo *info,
+                                  gboolean backoff)
+{
+	g_return_val_if_fail (policy != NULL, SCAN_INTERVAL_MAX);
+	g_return_val_if_fail (info != NULL, SCAN_INTERVAL_MAX);
+
+	return policy->klass->get_interval (policy, info, backoff);
+}
+
+NMWifiScanType
+nm_wifi_scan_policy_get_scan_type (NMWifiScanPolicy *policy,
+                                   const NMWifiScanInfo *info)
+{
+	g_return_val_if_fail (policy != NULL, NM_WIFI_SCAN_FULL);
+	g_return_val_if_fail (info != NULL, NM_WIFI_SCAN_FULL);
+
+	return policy->klass->get_scan_type (policy, info);
+}
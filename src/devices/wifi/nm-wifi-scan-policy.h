@@ -0,0 +1,71 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_WIFI_SCAN_POLICY_H__
+#define __NETWORKMANAGER_WIFI_SCAN_POLICY_H__
+
+#include <glib.h>
+
+/* Minimum, increment and maximum of the periodic scan interval, in seconds */
+#define SCAN_INTERVAL_MIN 3
+#define SCAN_INTERVAL_STEP 20
+#define SCAN_INTERVAL_MAX 120
+
+typedef enum {
+	NM_WIFI_SCAN_NONE = 0,   /* skip this scan */
+	NM_WIFI_SCAN_PARTIAL,    /* only channels the known SSIDs were seen on */
+	NM_WIFI_SCAN_FULL,       /* all channels, probing hidden SSIDs */
+} NMWifiScanType;
+
+/* What the device knows about its surroundings when a scan is due */
+typedef struct {
+	gboolean connected;         /* activating or activated */
+	int      strength;          /* current AP strength in percent, or -1 */
+	guint    roam_candidates;   /* other BSSes advertising the current SSID */
+	gint32   scan_age;          /* seconds since the last completed scan, or -1 */
+	gboolean known_channels;    /* a partial scan has channels to look at */
+} NMWifiScanInfo;
+
+typedef struct _NMWifiScanPolicy NMWifiScanPolicy;
+
+NMWifiScanPolicy *nm_wifi_scan_policy_new      (const char *name);
+void              nm_wifi_scan_policy_free     (NMWifiScanPolicy *policy);
+const char *      nm_wifi_scan_policy_get_name (NMWifiScanPolicy *policy);
+
+/* Next scan in @interval seconds, backing off again from there */
+void              nm_wifi_scan_policy_reset    (NMWifiScanPolicy *policy,
+                                                guint interval);
+
+/* @churn BSSes appeared or vanished with the scan, @total are known now */
+void              nm_wifi_scan_policy_scan_done (NMWifiScanPolicy *policy,
+                                                 NMWifiScanType type,
+                                                 gboolean success,
+                                                 guint churn,
+                                                 guint total);
+
+/* Seconds until the next scan, or 0 to not scan until something changes */
+guint             nm_wifi_scan_policy_get_interval (NMWifiScanPolicy *policy,
+                                                    const NMWifiScanInfo *info,
+                                                    gboolean backoff);
+
+NMWifiScanType    nm_wifi_scan_policy_get_scan_type (NMWifiScanPolicy *policy,
+                                                     const NMWifiScanInfo *info);
+
+#endif /* __NETWORKMANAGER_WIFI_SCAN_POLICY_H__ */
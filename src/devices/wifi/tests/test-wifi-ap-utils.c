@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include "nm-wifi-ap-utils.h"
+#include "nm-wifi-ap.h"
 #include "nm-dbus-glib-types.h"
 
 #include "nm-core-internal.h"
@@ -1333,6 +1334,79 @@ test_strength_wext (void)
 
 /*******************************************/
 
+static void
+set_ssid (NMSettingWireless *s_wifi, const char *ssid, gsize len)
+{
+	GBytes *bytes = g_bytes_new (ssid, len);
+
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_SSID, bytes, NULL);
+	g_bytes_unref (bytes);
+}
+
+static void
+test_check_compatible (void)
+{
+	NMConnection *connection;
+	NMSettingWireless *s_wifi;
+	NMSettingWirelessSecurity *s_wsec;
+	NMAccessPoint *ap;
+
+	ap = g_object_new (NM_TYPE_AP, NULL);
+	nm_ap_set_address (ap, "00:11:22:33:44:55");
+	nm_ap_set_ssid (ap, (const guint8 *) "blahblah", 8);
+	nm_ap_set_freq (ap, 2437);
+	nm_ap_set_mode (ap, NM_802_11_MODE_INFRA);
+	nm_ap_set_flags (ap, NM_802_11_AP_FLAGS_PRIVACY);
+	nm_ap_set_rsn_flags (ap, NM_802_11_AP_SEC_KEY_MGMT_PSK | NM_802_11_AP_SEC_PAIR_CCMP | NM_802_11_AP_SEC_GROUP_CCMP);
+
+	connection = nm_simple_connection_new ();
+	s_wifi = (NMSettingWireless *) nm_setting_wireless_new ();
+	nm_connection_add_setting (connection, NM_SETTING (s_wifi));
+	s_wsec = (NMSettingWirelessSecurity *) nm_setting_wireless_security_new ();
+	g_object_set (s_wsec, NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "wpa-psk", NULL);
+	nm_connection_add_setting (connection, NM_SETTING (s_wsec));
+
+	set_ssid (s_wifi, "blahblah", 8);
+	g_assert (nm_ap_check_compatible (ap, connection));
+
+	/* The match key must follow changes to the connection */
+	set_ssid (s_wifi, "foobar", 6);
+	g_assert (!nm_ap_check_compatible (ap, connection));
+
+	/* A trailing NUL doesn't make a difference */
+	set_ssid (s_wifi, "blahblah", 9);
+	g_assert (nm_ap_check_compatible (ap, connection));
+
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_BAND, "a", NULL);
+	g_assert (!nm_ap_check_compatible (ap, connection));
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_BAND, "bg", NULL);
+	g_assert (nm_ap_check_compatible (ap, connection));
+
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_BSSID, "00:11:22:33:44:66", NULL);
+	g_assert (!nm_ap_check_compatible (ap, connection));
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_BSSID, "00:11:22:33:44:55", NULL);
+	g_assert (nm_ap_check_compatible (ap, connection));
+
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_MODE, NM_SETTING_WIRELESS_MODE_ADHOC, NULL);
+	g_assert (!nm_ap_check_compatible (ap, connection));
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_MODE, NM_SETTING_WIRELESS_MODE_INFRA, NULL);
+	g_assert (nm_ap_check_compatible (ap, connection));
+
+	/* Security verdicts are remembered per AP flags, and forgotten along
+	 * with the key.
+	 */
+	nm_connection_remove_setting (connection, NM_TYPE_SETTING_WIRELESS_SECURITY);
+	g_assert (!nm_ap_check_compatible (ap, connection));
+	nm_ap_set_flags (ap, NM_802_11_AP_FLAGS_NONE);
+	nm_ap_set_rsn_flags (ap, NM_802_11_AP_SEC_NONE);
+	g_assert (nm_ap_check_compatible (ap, connection));
+
+	g_object_unref (connection);
+	g_object_unref (ap);
+}
+
+/*******************************************/
+
 int
 main (int argc, char **argv)
 {
@@ -1544,5 +1618,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/wifi/strength/wext",
 	                 test_strength_wext);
 
+	g_test_add_func ("/wifi/ap/check_compatible",
+	                 test_check_compatible);
+
 	return g_test_run ();
 }
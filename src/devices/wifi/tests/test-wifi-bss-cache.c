@@ -0,0 +1,204 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nm-wifi-bss-cache.h"
+#include "nm-utils.h"
+
+/*******************************************/
+
+#define NOW 1400000000
+
+static NMAccessPoint *
+make_ap (const char *bssid, const char *ssid, guint32 freq)
+{
+	NMAccessPoint *ap;
+
+	ap = g_object_new (NM_TYPE_AP, NULL);
+	nm_ap_set_address (ap, bssid);
+	nm_ap_set_ssid (ap, (const guint8 *) ssid, strlen (ssid));
+	nm_ap_set_freq (ap, freq);
+	nm_ap_set_mode (ap, NM_802_11_MODE_INFRA);
+	nm_ap_set_flags (ap, NM_802_11_AP_FLAGS_PRIVACY);
+	nm_ap_set_rsn_flags (ap, NM_802_11_AP_SEC_KEY_MGMT_PSK | NM_802_11_AP_SEC_PAIR_CCMP);
+	return ap;
+}
+
+static void
+add_ap (GPtrArray *cache, const char *bssid, const char *ssid, guint32 freq, gint64 now, gboolean last_good)
+{
+	NMAccessPoint *ap = make_ap (bssid, ssid, freq);
+
+	nm_wifi_bss_cache_add (cache, ap, now, last_good);
+	g_object_unref (ap);
+}
+
+static GPtrArray *
+empty_cache (void)
+{
+	return nm_wifi_bss_cache_load ("/nonexistent/wifi-bss-cache", NOW);
+}
+
+static void
+test_roundtrip (void)
+{
+	char *filename;
+	GPtrArray *cache, *loaded;
+	NMWifiBssCacheEntry *entry;
+	GError *error = NULL;
+	char *str;
+	int fd;
+
+	fd = g_file_open_tmp ("test-wifi-bss-cache-XXXXXX", &filename, &error);
+	g_assert_no_error (error);
+	close (fd);
+
+	cache = empty_cache ();
+	g_assert_cmpint (cache->len, ==, 0);
+	add_ap (cache, "00:11:22:33:44:55", "home", 2437, NOW - 10, TRUE);
+	add_ap (cache, "00:11:22:33:44:66", "home", 5180, NOW - 5, FALSE);
+	g_assert (nm_wifi_bss_cache_save (cache, filename, &error));
+	g_assert_no_error (error);
+
+	loaded = nm_wifi_bss_cache_load (filename, NOW);
+	g_assert_cmpint (loaded->len, ==, 2);
+
+	/* The last good BSS comes first, even though it's older */
+	entry = loaded->pdata[0];
+	g_assert (entry->last_good);
+	str = nm_utils_hwaddr_ntoa (entry->bssid, ETH_ALEN);
+	g_assert_cmpstr (str, ==, "00:11:22:33:44:55");
+	g_free (str);
+	g_assert_cmpint (entry->ssid->len, ==, 4);
+	g_assert (memcmp (entry->ssid->data, "home", 4) == 0);
+	g_assert_cmpint (entry->freq, ==, 2437);
+	g_assert_cmpint (entry->mode, ==, NM_802_11_MODE_INFRA);
+	g_assert_cmpint (entry->flags, ==, NM_802_11_AP_FLAGS_PRIVACY);
+	g_assert_cmpint (entry->rsn_flags, ==, NM_802_11_AP_SEC_KEY_MGMT_PSK | NM_802_11_AP_SEC_PAIR_CCMP);
+	g_assert_cmpint (entry->last_seen, ==, NOW - 10);
+
+	entry = loaded->pdata[1];
+	g_assert (!entry->last_good);
+	g_assert_cmpint (entry->freq, ==, 5180);
+
+	g_ptr_array_unref (loaded);
+	g_ptr_array_unref (cache);
+	g_unlink (filename);
+	g_free (filename);
+}
+
+static void
+test_last_good (void)
+{
+	GPtrArray *cache = empty_cache ();
+	NMWifiBssCacheEntry *entry;
+
+	add_ap (cache, "00:11:22:33:44:55", "home", 2437, NOW - 10, TRUE);
+	add_ap (cache, "00:11:22:33:44:66", "work", 2412, NOW, TRUE);
+	add_ap (cache, "00:11:22:33:44:55", "home", 2462, NOW, FALSE);
+	g_assert_cmpint (cache->len, ==, 2);
+	nm_wifi_bss_cache_prune (cache, NOW);
+
+	/* Only one BSS is the last good one; refreshing an entry updates it */
+	entry = cache->pdata[0];
+	g_assert (entry->last_good);
+	g_assert_cmpint (entry->freq, ==, 2412);
+	entry = cache->pdata[1];
+	g_assert (!entry->last_good);
+	g_assert_cmpint (entry->freq, ==, 2462);
+
+	g_ptr_array_unref (cache);
+}
+
+static void
+test_prune (void)
+{
+	GPtrArray *cache = empty_cache ();
+	char bssid[20];
+	guint i;
+
+	add_ap (cache, "00:11:22:33:44:55", "old", 2412, NOW - NM_WIFI_BSS_CACHE_MAX_AGE - 1, FALSE);
+	add_ap (cache, "00:11:22:33:44:66", "future", 2412, NOW + 1000, FALSE);
+	nm_wifi_bss_cache_prune (cache, NOW);
+	g_assert_cmpint (cache->len, ==, 1);
+	g_assert_cmpint (((NMWifiBssCacheEntry *) cache->pdata[0])->last_seen, ==, NOW);
+
+	for (i = 0; i < NM_WIFI_BSS_CACHE_MAX_ENTRIES + 10; i++) {
+		g_snprintf (bssid, sizeof (bssid), "00:11:22:33:55:%02x", i);
+		add_ap (cache, bssid, "many", 2412, NOW - 100 + i, FALSE);
+	}
+	nm_wifi_bss_cache_prune (cache, NOW);
+	g_assert_cmpint (cache->len, ==, NM_WIFI_BSS_CACHE_MAX_ENTRIES);
+
+	/* Unusable APs aren't cached */
+	add_ap (cache, "00:00:00:00:00:00", "nobssid", 2412, NOW, FALSE);
+	add_ap (cache, "00:11:22:33:66:00", "", 2412, NOW, FALSE);
+	g_assert_cmpint (cache->len, ==, NM_WIFI_BSS_CACHE_MAX_ENTRIES);
+
+	g_ptr_array_unref (cache);
+}
+
+static void
+test_freqs (void)
+{
+	GPtrArray *cache = empty_cache ();
+	GArray *freqs;
+
+	add_ap (cache, "00:11:22:33:44:01", "a", 2412, NOW - 1, FALSE);
+	add_ap (cache, "00:11:22:33:44:02", "a", 2412, NOW - 2, FALSE);
+	add_ap (cache, "00:11:22:33:44:03", "b", 5180, NOW - 3, FALSE);
+	add_ap (cache, "00:11:22:33:44:04", "c", 2437, NOW - 20, TRUE);
+	add_ap (cache, "00:11:22:33:44:05", "d", 2462, NOW - 4, FALSE);
+	nm_wifi_bss_cache_prune (cache, NOW);
+
+	freqs = nm_wifi_bss_cache_get_freqs (cache, 3);
+	g_assert_cmpint (freqs->len, ==, 3);
+	g_assert_cmpint (g_array_index (freqs, guint32, 0), ==, 2437);
+	g_assert_cmpint (g_array_index (freqs, guint32, 1), ==, 2412);
+	g_assert_cmpint (g_array_index (freqs, guint32, 2), ==, 5180);
+	g_array_unref (freqs);
+
+	g_ptr_array_unref (cache);
+}
+
+/*******************************************/
+
+int
+main (int argc, char **argv)
+{
+#if !GLIB_CHECK_VERSION (2, 35, 0)
+	g_type_init ();
+#endif
+
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/wifi/bss-cache/roundtrip", test_roundtrip);
+	g_test_add_func ("/wifi/bss-cache/last-good", test_last_good);
+	g_test_add_func ("/wifi/bss-cache/prune", test_prune);
+	g_test_add_func ("/wifi/bss-cache/freqs", test_freqs);
+
+	return g_test_run ();
+}
@@ -0,0 +1,182 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "nm-wifi-scan-policy.h"
+
+/*******************************************/
+
+static void
+test_policy_names (void)
+{
+	NMWifiScanPolicy *policy;
+
+	policy = nm_wifi_scan_policy_new (NULL);
+	g_assert_cmpstr (nm_wifi_scan_policy_get_name (policy), ==, "adaptive");
+	nm_wifi_scan_policy_free (policy);
+
+	policy = nm_wifi_scan_policy_new ("backoff");
+	g_assert_cmpstr (nm_wifi_scan_policy_get_name (policy), ==, "backoff");
+	nm_wifi_scan_policy_free (policy);
+
+	policy = nm_wifi_scan_policy_new ("no-such-policy");
+	g_assert_cmpstr (nm_wifi_scan_policy_get_name (policy), ==, "adaptive");
+	nm_wifi_scan_policy_free (policy);
+}
+
+static void
+test_backoff (void)
+{
+	NMWifiScanPolicy *policy;
+	NMWifiScanInfo info = { .connected = TRUE, .strength = 90, .scan_age = 10 };
+	guint i, interval = 0;
+
+	policy = nm_wifi_scan_policy_new ("backoff");
+
+	/* Same sequence the device always used: 23, 43, ... up to 120 */
+	g_assert_cmpint (nm_wifi_scan_policy_get_interval (policy, &info, TRUE), ==, 23);
+	g_assert_cmpint (nm_wifi_scan_policy_get_interval (policy, &info, TRUE), ==, 43);
+	for (i = 0; i < 10; i++)
+		interval = nm_wifi_scan_policy_get_interval (policy, &info, TRUE);
+	g_assert_cmpint (interval, ==, SCAN_INTERVAL_MAX);
+	g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), ==, NM_WIFI_SCAN_FULL);
+
+	nm_wifi_scan_policy_reset (policy, SCAN_INTERVAL_MIN);
+	g_assert_cmpint (nm_wifi_scan_policy_get_interval (policy, &info, FALSE), ==, SCAN_INTERVAL_MIN);
+
+	nm_wifi_scan_policy_free (policy);
+}
+
+static void
+test_adaptive_disconnected (void)
+{
+	NMWifiScanPolicy *policy;
+	NMWifiScanInfo info = { .connected = FALSE, .strength = -1, .scan_age = -1 };
+
+	policy = nm_wifi_scan_policy_new ("adaptive");
+	g_assert_cmpint (nm_wifi_scan_policy_get_interval (policy, &info, TRUE), ==, 23);
+	g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), ==, NM_WIFI_SCAN_FULL);
+	nm_wifi_scan_policy_free (policy);
+}
+
+static void
+test_adaptive_stable (void)
+{
+	NMWifiScanPolicy *policy;
+	NMWifiScanInfo info = { .connected = TRUE, .strength = 85, .roam_candidates = 1,
+	                        .scan_age = 30, .known_channels = TRUE };
+	guint i;
+
+	policy = nm_wifi_scan_policy_new ("adaptive");
+
+	/* Right after connecting nothing is known about the surroundings */
+	g_assert_cmpint (nm_wifi_scan_policy_get_interval (policy, &info, TRUE), >, 0);
+	g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), !=, NM_WIFI_SCAN_NONE);
+
+	/* Scans that find nothing new settle the churn */
+	for (i = 0; i < 6; i++)
+		nm_wifi_scan_policy_scan_done (policy, NM_WIFI_SCAN_FULL, TRUE, 0, 10);
+	g_assert_cmpint (nm_wifi_scan_policy_get_interval (policy, &info, TRUE), ==, 0);
+	g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), ==, NM_WIFI_SCAN_NONE);
+
+	/* A weakening signal starts scanning again */
+	info.strength = 30;
+	g_assert_cmpint (nm_wifi_scan_policy_get_interval (policy, &info, TRUE), >, 0);
+	g_assert_cmpint (nm_wifi_scan_policy_get_interval (policy, &info, TRUE), <=, SCAN_INTERVAL_STEP);
+	g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), ==, NM_WIFI_SCAN_PARTIAL);
+
+	nm_wifi_scan_policy_free (policy);
+}
+
+static void
+test_adaptive_partial (void)
+{
+	NMWifiScanPolicy *policy;
+	NMWifiScanInfo info = { .connected = TRUE, .strength = 50, .roam_candidates = 2,
+	                        .scan_age = 30, .known_channels = TRUE };
+	guint i;
+
+	policy = nm_wifi_scan_policy_new ("adaptive");
+
+	/* Every few partial scans a full one is due */
+	for (i = 0; i < 3; i++) {
+		g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), ==, NM_WIFI_SCAN_PARTIAL);
+		nm_wifi_scan_policy_scan_done (policy, NM_WIFI_SCAN_PARTIAL, TRUE, 0, 10);
+	}
+	g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), ==, NM_WIFI_SCAN_FULL);
+	nm_wifi_scan_policy_scan_done (policy, NM_WIFI_SCAN_FULL, TRUE, 0, 10);
+	g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), ==, NM_WIFI_SCAN_PARTIAL);
+
+	/* Nothing to roam to, or nowhere to look, means a full scan */
+	info.roam_candidates = 0;
+	g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), ==, NM_WIFI_SCAN_FULL);
+	info.roam_candidates = 2;
+	info.known_channels = FALSE;
+	g_assert_cmpint (nm_wifi_scan_policy_get_scan_type (policy, &info), ==, NM_WIFI_SCAN_FULL);
+
+	nm_wifi_scan_policy_free (policy);
+}
+
+static void
+test_adaptive_churn (void)
+{
+	NMWifiScanPolicy *policy;
+	NMWifiScanInfo info = { .connected = TRUE, .strength = 50, .roam_candidates = 2,
+	                        .scan_age = 30, .known_channels = TRUE };
+	guint quiet, busy, i;
+
+	policy = nm_wifi_scan_policy_new ("adaptive");
+
+	for (i = 0; i < 6; i++)
+		nm_wifi_scan_policy_scan_done (policy, NM_WIFI_SCAN_FULL, TRUE, 0, 10);
+	quiet = nm_wifi_scan_policy_get_interval (policy, &info, TRUE);
+
+	for (i = 0; i < 6; i++)
+		nm_wifi_scan_policy_scan_done (policy, NM_WIFI_SCAN_FULL, TRUE, 8, 10);
+	busy = nm_wifi_scan_policy_get_interval (policy, &info, TRUE);
+
+	/* Moving around means scanning more often, but never too often */
+	g_assert_cmpint (busy, <, quiet);
+	g_assert_cmpint (busy, >=, SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP / 2);
+	g_assert_cmpint (quiet, <=, SCAN_INTERVAL_MAX);
+
+	nm_wifi_scan_policy_free (policy);
+}
+
+/*******************************************/
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/wifi/scan-policy/names", test_policy_names);
+	g_test_add_func ("/wifi/scan-policy/backoff", test_backoff);
+	g_test_add_func ("/wifi/scan-policy/adaptive/disconnected", test_adaptive_disconnected);
+	g_test_add_func ("/wifi/scan-policy/adaptive/stable", test_adaptive_stable);
+	g_test_add_func ("/wifi/scan-policy/adaptive/partial", test_adaptive_partial);
+	g_test_add_func ("/wifi/scan-policy/adaptive/churn", test_adaptive_churn);
+
+	return g_test_run ();
+}
@@ -0,0 +1,480 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* wifi-scan-bench.c - scan ingestion benchmark
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ */
+
+/* Drives NMSupplicantInterface against tools/test-wpa-supplicant-service.py
+ * and reports how long it takes to turn a scan into access points, how much
+ * memory the AP list takes, how many D-Bus messages NM's bus connection
+ * receives for it (signals and method replies), and how fast a dropping
+ * signal turns into a roaming scan.
+ *
+ * Run it on a private session bus; the supplicant manager is pointed at that
+ * bus through DBUS_SYSTEM_BUS_ADDRESS:
+ *
+ *   dbus-launch ./wifi-scan-bench --bsses 500 --iterations 5 --churn 50
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <malloc.h>
+#include <syslog.h>
+#include <dbus/dbus.h>
+#include <dbus/dbus-glib.h>
+
+#include "nm-supplicant-manager.h"
+#include "nm-supplicant-interface.h"
+#include "nm-dbus-manager.h"
+#include "nm-logging.h"
+#include "nm-wifi-ap.h"
+#include "nm-wifi-ap-utils.h"
+#include "nm-wifi-scan-policy.h"
+
+#define WPAS_DBUS_SERVICE  "fi.w1.wpa_supplicant1"
+#define WPAS_DBUS_PATH     "/fi/w1/wpa_supplicant1"
+#define WPAS_TEST_IFACE    "org.freedesktop.NetworkManager.TestSupplicant"
+
+#define BENCH_TIMEOUT      30     /* seconds */
+
+typedef struct {
+	GMainLoop *loop;
+	NMSupplicantInterface *sup_iface;
+	GHashTable *aps;              /* supplicant path -> NMAccessPoint */
+	gboolean export;
+
+	guint messages;               /* D-Bus messages received */
+	char *watch_path;             /* BSS whose update we're waiting for */
+	gboolean timed_out;
+} Bench;
+
+static DBusHandlerResult
+message_filter (DBusConnection *connection, DBusMessage *message, void *user_data)
+{
+	Bench *bench = user_data;
+
+	bench->messages++;
+	return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static gboolean
+timeout_cb (gpointer user_data)
+{
+	Bench *bench = user_data;
+
+	bench->timed_out = TRUE;
+	g_main_loop_quit (bench->loop);
+	return FALSE;
+}
+
+static gboolean
+run_loop (Bench *bench)
+{
+	guint id;
+
+	bench->timed_out = FALSE;
+	id = g_timeout_add_seconds (BENCH_TIMEOUT, timeout_cb, bench);
+	g_main_loop_run (bench->loop);
+	if (!bench->timed_out)
+		g_source_remove (id);
+	return !bench->timed_out;
+}
+
+static void
+state_cb (NMSupplicantInterface *iface,
+          guint32 new_state,
+          guint32 old_state,
+          int disconnect_reason,
+          Bench *bench)
+{
+	if (new_state == NM_SUPPLICANT_INTERFACE_STATE_READY)
+		g_main_loop_quit (bench->loop);
+}
+
+static void
+new_bsses_cb (NMSupplicantInterface *iface,
+              GPtrArray *paths,
+              GPtrArray *props,
+              Bench *bench)
+{
+	NMAccessPoint *ap;
+	guint i;
+
+	for (i = 0; i < paths->len; i++) {
+		if (g_hash_table_contains (bench->aps, paths->pdata[i]))
+			continue;
+		ap = nm_ap_new_from_properties (paths->pdata[i], props->pdata[i]);
+		if (!ap)
+			continue;
+		if (bench->export)
+			nm_ap_export_to_dbus (ap);
+		g_hash_table_insert (bench->aps, g_strdup (paths->pdata[i]), ap);
+	}
+}
+
+static void
+bss_updated_cb (NMSupplicantInterface *iface,
+                const char *object_path,
+                Bench *bench)
+{
+	if (g_strcmp0 (object_path, bench->watch_path) == 0)
+		g_main_loop_quit (bench->loop);
+}
+
+static void
+bss_removed_cb (NMSupplicantInterface *iface,
+                const char *object_path,
+                Bench *bench)
+{
+	g_hash_table_remove (bench->aps, object_path);
+}
+
+static void
+scan_done_cb (NMSupplicantInterface *iface,
+              gboolean success,
+              Bench *bench)
+{
+	if (!bench->watch_path)
+		g_main_loop_quit (bench->loop);
+}
+
+static GPid
+spawn_service (const char *replay, guint bsses, int *keepalive_fd)
+{
+	char *args[] = { TEST_WPAS_SERVICE, NULL, NULL, NULL };
+	char *num = NULL;
+	GError *error = NULL;
+	GPid pid;
+
+	if (replay) {
+		args[1] = "--replay";
+		args[2] = (char *) replay;
+	} else {
+		num = g_strdup_printf ("%u", bsses);
+		args[1] = "--bsses";
+		args[2] = num;
+	}
+
+	/* The service exits when the pipe to its stdin closes */
+	if (!g_spawn_async_with_pipes (NULL, args, NULL, 0, NULL, NULL,
+	                               &pid, keepalive_fd, NULL, NULL, &error)) {
+		g_printerr ("Failed to start %s: %s\n", TEST_WPAS_SERVICE, error->message);
+		g_clear_error (&error);
+		pid = 0;
+	}
+
+	g_free (num);
+	return pid;
+}
+
+static gboolean
+wait_for_service (DBusConnection *connection)
+{
+	int i;
+
+	for (i = 100; i > 0; i--) {
+		if (dbus_bus_name_has_owner (connection, WPAS_DBUS_SERVICE, NULL))
+			return TRUE;
+		g_usleep (G_USEC_PER_SEC / 20);
+	}
+	return FALSE;
+}
+
+static void
+print_service_stats (DBusGProxy *proxy)
+{
+	GHashTable *stats = NULL;
+	GHashTableIter iter;
+	gpointer key, value;
+	GError *error = NULL;
+
+	if (!dbus_g_proxy_call (proxy, "GetStats", &error,
+	                        G_TYPE_INVALID,
+	                        dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_UINT), &stats,
+	                        G_TYPE_INVALID)) {
+		g_printerr ("GetStats failed: %s\n", error->message);
+		g_clear_error (&error);
+		return;
+	}
+
+	g_hash_table_iter_init (&iter, stats);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_print ("  service %-36s %u\n", (const char *) key, GPOINTER_TO_UINT (value));
+	g_hash_table_unref (stats);
+
+	dbus_g_proxy_call (proxy, "ResetStats", NULL, G_TYPE_INVALID, G_TYPE_INVALID);
+}
+
+/* Bytes of heap in use */
+static gssize
+heap_in_use (void)
+{
+#if HAVE_MALLINFO2
+	return mallinfo2 ().uordblks;
+#else
+	return mallinfo ().uordblks;
+#endif
+}
+
+static gboolean
+bench_scan (Bench *bench, guint iteration)
+{
+	gssize before, after;
+	gint64 start, end;
+	guint messages;
+
+	before = heap_in_use ();
+	messages = bench->messages;
+	start = g_get_monotonic_time ();
+
+	if (!nm_supplicant_interface_request_scan (bench->sup_iface, NULL, NULL)) {
+		g_printerr ("Scan request failed\n");
+		return FALSE;
+	}
+	if (!run_loop (bench)) {
+		g_printerr ("Timed out waiting for the scan to finish\n");
+		return FALSE;
+	}
+
+	end = g_get_monotonic_time ();
+	after = heap_in_use ();
+
+	g_print ("scan %u: %u APs in %.2f ms, %" G_GSSIZE_FORMAT " bytes heap delta, %u D-Bus messages received\n",
+	         iteration,
+	         g_hash_table_size (bench->aps),
+	         (end - start) / 1000.0,
+	         after - before,
+	         bench->messages - messages);
+	return TRUE;
+}
+
+static guint
+count_roam_candidates (Bench *bench, NMAccessPoint *current)
+{
+	const GByteArray *ssid = nm_ap_get_ssid (current), *other;
+	GHashTableIter iter;
+	gpointer value;
+	guint n = 0;
+
+	g_hash_table_iter_init (&iter, bench->aps);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		if (value == current)
+			continue;
+		other = nm_ap_get_ssid (value);
+		if (   ssid && other
+		    && ssid->len == other->len
+		    && !memcmp (ssid->data, other->data, ssid->len))
+			n++;
+	}
+	return n;
+}
+
+/* Weaken the signal of one BSS as if we were associated to it and moving
+ * away, and see how long it takes until the scan policy knows.
+ */
+static gboolean
+bench_roam (Bench *bench, DBusGProxy *proxy, int dbm)
+{
+	NMWifiScanPolicy *policy;
+	NMWifiScanInfo info = { 0 };
+	NMAccessPoint *current = NULL;
+	GHashTableIter iter;
+	gpointer key, value;
+	GError *error = NULL;
+	gint64 start, end;
+	guint interval;
+	gboolean success = FALSE;
+
+	g_hash_table_iter_init (&iter, bench->aps);
+	if (g_hash_table_iter_next (&iter, &key, &value)) {
+		bench->watch_path = key;
+		current = value;
+	}
+	if (!current) {
+		g_printerr ("No access point to roam from\n");
+		return FALSE;
+	}
+
+	policy = nm_wifi_scan_policy_new (NULL);
+
+	start = g_get_monotonic_time ();
+	if (!dbus_g_proxy_call (proxy, "SetSignal", &error,
+	                        G_TYPE_STRING, nm_ap_get_address (current),
+	                        G_TYPE_INT, dbm,
+	                        G_TYPE_INVALID,
+	                        G_TYPE_INVALID)) {
+		g_printerr ("SetSignal failed: %s\n", error->message);
+		g_clear_error (&error);
+		goto out;
+	}
+	if (!run_loop (bench)) {
+		g_printerr ("Timed out waiting for the BSS update\n");
+		goto out;
+	}
+
+	info.connected = TRUE;
+	info.strength = nm_ap_utils_level_to_quality (dbm);
+	info.roam_candidates = count_roam_candidates (bench, current);
+	info.scan_age = 0;
+	info.known_channels = TRUE;
+	interval = nm_wifi_scan_policy_get_interval (policy, &info, FALSE);
+	end = g_get_monotonic_time ();
+
+	g_print ("roam: %d dBm on %s seen after %.2f ms, %u candidates, next %s scan in %u s\n",
+	         dbm, nm_ap_get_address (current),
+	         (end - start) / 1000.0,
+	         info.roam_candidates,
+	         nm_wifi_scan_policy_get_scan_type (policy, &info) == NM_WIFI_SCAN_PARTIAL ? "partial" : "full",
+	         interval);
+	success = TRUE;
+
+out:
+	bench->watch_path = NULL;
+	nm_wifi_scan_policy_free (policy);
+	return success;
+}
+
+int
+main (int argc, char **argv)
+{
+	Bench bench = { 0 };
+	NMSupplicantManager *mgr;
+	DBusConnection *connection;
+	DBusGProxy *proxy;
+	GOptionContext *opt_ctx;
+	GError *error = NULL;
+	const char *address;
+	int keepalive_fd = -1;
+	GPid pid;
+	guint i;
+	int ret = EXIT_FAILURE;
+
+	char *ifname = "wlan0";
+	char *replay = NULL;
+	int bsses = 300;
+	int iterations = 3;
+	int churn = 0;
+	int roam_dbm = -82;
+	gboolean debug = FALSE;
+
+	GOptionEntry options[] = {
+		{ "ifname", 'i', 0, G_OPTION_ARG_STRING, &ifname, "Interface name to ask the supplicant for", "IFNAME" },
+		{ "bsses", 'n', 0, G_OPTION_ARG_INT, &bsses, "Number of BSSes the mock supplicant finds", "N" },
+		{ "replay", 'r', 0, G_OPTION_ARG_FILENAME, &replay, "Replay recorded scan results from FILE", "FILE" },
+		{ "iterations", 'c', 0, G_OPTION_ARG_INT, &iterations, "Number of scans", "N" },
+		{ "churn", 0, 0, G_OPTION_ARG_INT, &churn, "BSSes replaced between scans", "N" },
+		{ "roam-signal", 0, 0, G_OPTION_ARG_INT, &roam_dbm, "Signal to drop to for the roaming test", "DBM" },
+		{ "export", 'e', 0, G_OPTION_ARG_NONE, &bench.export, "Export every AP on D-Bus", NULL },
+		{ "debug", 'd', 0, G_OPTION_ARG_NONE, &debug, "Log supplicant debug messages", NULL },
+		{ NULL }
+	};
+
+#if !GLIB_CHECK_VERSION (2, 35, 0)
+	g_type_init ();
+#endif
+
+	opt_ctx = g_option_context_new (NULL);
+	g_option_context_set_summary (opt_ctx, "Benchmark Wi-Fi scan handling against a mock wpa_supplicant.");
+	g_option_context_add_main_entries (opt_ctx, options, NULL);
+	if (!g_option_context_parse (opt_ctx, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_clear_error (&error);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free (opt_ctx);
+
+	/* NMDBusManager talks to the system bus; send it to our private one */
+	address = g_getenv ("DBUS_SESSION_BUS_ADDRESS");
+	if (!address) {
+		g_printerr ("No session bus; run this under dbus-launch\n");
+		return EXIT_FAILURE;
+	}
+	g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+
+	nm_logging_setup (debug ? "debug" : "warn", "SUPPLICANT,WIFI_SCAN", NULL, NULL);
+	openlog (G_LOG_DOMAIN, LOG_CONS | LOG_PERROR, LOG_DAEMON);
+
+	pid = spawn_service (replay, MAX (bsses, 0), &keepalive_fd);
+	if (!pid)
+		return EXIT_FAILURE;
+
+	bench.loop = g_main_loop_new (NULL, FALSE);
+	bench.aps = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+
+	connection = nm_dbus_manager_get_dbus_connection (nm_dbus_manager_get ());
+	if (!connection || !wait_for_service (connection)) {
+		g_printerr ("Mock supplicant did not show up on the bus\n");
+		goto out;
+	}
+	dbus_connection_add_filter (connection, message_filter, &bench, NULL);
+
+	proxy = dbus_g_proxy_new_for_name (nm_dbus_manager_get_connection (nm_dbus_manager_get ()),
+	                                   WPAS_DBUS_SERVICE,
+	                                   WPAS_DBUS_PATH,
+	                                   WPAS_TEST_IFACE);
+
+	mgr = nm_supplicant_manager_get ();
+	bench.sup_iface = nm_supplicant_manager_iface_get (mgr, ifname, TRUE);
+	if (!bench.sup_iface) {
+		g_printerr ("Could not get a supplicant interface for %s\n", ifname);
+		goto out_proxy;
+	}
+
+	g_signal_connect (bench.sup_iface, NM_SUPPLICANT_INTERFACE_STATE, G_CALLBACK (state_cb), &bench);
+	g_signal_connect (bench.sup_iface, NM_SUPPLICANT_INTERFACE_NEW_BSSES, G_CALLBACK (new_bsses_cb), &bench);
+	g_signal_connect (bench.sup_iface, NM_SUPPLICANT_INTERFACE_BSS_UPDATED, G_CALLBACK (bss_updated_cb), &bench);
+	g_signal_connect (bench.sup_iface, NM_SUPPLICANT_INTERFACE_BSS_REMOVED, G_CALLBACK (bss_removed_cb), &bench);
+	g_signal_connect (bench.sup_iface, NM_SUPPLICANT_INTERFACE_SCAN_DONE, G_CALLBACK (scan_done_cb), &bench);
+
+	if (   nm_supplicant_interface_get_state (bench.sup_iface) < NM_SUPPLICANT_INTERFACE_STATE_READY
+	    && !run_loop (&bench)) {
+		g_printerr ("Timed out waiting for the supplicant interface\n");
+		goto out_iface;
+	}
+	print_service_stats (proxy);
+
+	for (i = 1; i <= MAX (iterations, 1); i++) {
+		if (i > 1 && churn > 0)
+			dbus_g_proxy_call (proxy, "Churn", NULL, G_TYPE_UINT, (guint) churn, G_TYPE_INVALID, G_TYPE_INVALID);
+		if (!bench_scan (&bench, i))
+			goto out_iface;
+		print_service_stats (proxy);
+	}
+
+	if (!bench_roam (&bench, proxy, roam_dbm))
+		goto out_iface;
+	print_service_stats (proxy);
+
+	ret = EXIT_SUCCESS;
+
+out_iface:
+	g_signal_handlers_disconnect_by_data (bench.sup_iface, &bench);
+	nm_supplicant_manager_iface_release (mgr, bench.sup_iface);
+out_proxy:
+	g_object_unref (proxy);
+	dbus_connection_remove_filter (connection, message_filter, &bench);
+out:
+	g_hash_table_unref (bench.aps);
+	g_main_loop_unref (bench.loop);
+	close (keepalive_fd);
+	kill (pid, SIGTERM);
+	return ret;
+}
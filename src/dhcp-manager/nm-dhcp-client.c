@@ -32,6 +32,7 @@
 #include "NetworkManagerUtils.h"
 #include "nm-utils.h"
 #include "nm-logging.h"
+#include "nm-trace.h"
 #include "nm-dbus-glib-types.h"
 #include "nm-dhcp-client.h"
 #include "nm-dhcp-utils.h"
@@ -284,6 +285,7 @@ nm_dhcp_client_set_state (NMDhcpClient *self,
                           GHashTable *options)
 {
 	NMDhcpClientPrivate *priv = NM_DHCP_CLIENT_GET_PRIVATE (self);
+	char *trace_name;
 
 	if (new_state >= NM_DHCP_STATE_BOUND)
 		timeout_cleanup (self);
@@ -315,6 +317,12 @@ nm_dhcp_client_set_state (NMDhcpClient *self,
 	             state_to_string (priv->state),
 	             state_to_string (new_state));
 
+	if (nm_trace_enabled ()) {
+		trace_name = g_strdup_printf ("dhcp%c %s", priv->ipv6 ? '6' : '4', state_to_string (new_state));
+		nm_trace_instant (NM_TRACE_CAT_DHCP, priv->iface, trace_name);
+		g_free (trace_name);
+	}
+
 	priv->state = new_state;
 	g_signal_emit (G_OBJECT (self),
 	               signals[SIGNAL_STATE_CHANGED], 0,
@@ -24,13 +24,92 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include <gio/gio.h>
 
 #define NM_DHCP_CLIENT_DBUS_IFACE   "org.freedesktop.nm_dhcp_client"
 
+/* Keep in sync with nm-dhcp-listener.c */
+#define NM_DHCP_EVENT_SOCK_PATH     NMRUNDIR "/private-dhcp-event"
+#define NM_DHCP_EVENT_MAGIC         "NMDHCP1"
+#define NM_DHCP_EVENT_MAX_SIZE      65535
+
 static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
 
+static gboolean
+is_ignored (const char *name)
+{
+	char **p;
+
+	/* Ignore non-DCHP-related environment variables */
+	for (p = (char **) ignore; *p; p++) {
+		if (strncmp (name, *p, strlen (*p)) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* Sends the environment as one datagram to NetworkManager's event socket,
+ * which is much cheaper for both sides than a D-Bus connection.  Each
+ * option is the name and value lengths as guint16, then the name and the
+ * value.
+ */
+static gboolean
+send_event_datagram (void)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	GByteArray *buf;
+	char **item;
+	gboolean success = FALSE;
+	int fd;
+
+	buf = g_byte_array_sized_new (4096);
+	g_byte_array_append (buf, (const guint8 *) NM_DHCP_EVENT_MAGIC, sizeof (NM_DHCP_EVENT_MAGIC));
+
+	for (item = environ; *item; item++) {
+		const char *val;
+		gsize name_len, val_len;
+		guint16 len;
+
+		val = strchr (*item, '=');
+		if (!val || val == *item)
+			continue;
+		name_len = val - *item;
+		val++;
+		val_len = strlen (val);
+
+		if (is_ignored (*item))
+			continue;
+
+		if (name_len > G_MAXUINT16 || val_len > G_MAXUINT16)
+			goto out;
+
+		len = name_len;
+		g_byte_array_append (buf, (const guint8 *) &len, sizeof (len));
+		len = val_len;
+		g_byte_array_append (buf, (const guint8 *) &len, sizeof (len));
+		g_byte_array_append (buf, (const guint8 *) *item, name_len);
+		g_byte_array_append (buf, (const guint8 *) val, val_len);
+
+		if (buf->len > NM_DHCP_EVENT_MAX_SIZE)
+			goto out;
+	}
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		goto out;
+
+	g_strlcpy (addr.sun_path, NM_DHCP_EVENT_SOCK_PATH, sizeof (addr.sun_path));
+	success = sendto (fd, buf->data, buf->len, 0, (struct sockaddr *) &addr, sizeof (addr)) == buf->len;
+	close (fd);
+
+out:
+	g_byte_array_free (buf, TRUE);
+	return success;
+}
+
 static GVariant *
 build_signal_parameters (void)
 {
@@ -41,7 +120,7 @@ build_signal_parameters (void)
 
 	/* List environment and format for dbus dict */
 	for (item = environ; *item; item++) {
-		char *name, *val, **p;
+		char *name, *val;
 
 		/* Split on the = */
 		name = g_strdup (*item);
@@ -50,11 +129,8 @@ build_signal_parameters (void)
 			goto next;
 		*val++ = '\0';
 
-		/* Ignore non-DCHP-related environment variables */
-		for (p = (char **) ignore; *p; p++) {
-			if (strncmp (name, *p, strlen (*p)) == 0)
-				goto next;
-		}
+		if (is_ignored (name))
+			goto next;
 
 		/* Value passed as a byte array rather than a string, because there are
 		 * no character encoding guarantees with DHCP, and D-Bus requires
@@ -160,6 +236,10 @@ main (int argc, char *argv[])
 	GDBusConnection *connection;
 	GError *error = NULL;
 
+	if (send_event_datagram ())
+		return 0;
+
+	/* Fall back to D-Bus if the daemon has no event socket */
 	connection = g_dbus_connection_new_for_address_sync ("unix:path=" NMRUNDIR "/private-dhcp",
 	                                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
 	                                                     NULL, NULL, &error);
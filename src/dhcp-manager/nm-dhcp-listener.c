@@ -23,6 +23,8 @@
 #include <glib/gi18n.h>
 #include <dbus/dbus.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <string.h>
@@ -41,12 +43,27 @@
 #define PRIV_SOCK_PATH            NMRUNDIR "/private-dhcp"
 #define PRIV_SOCK_TAG             "dhcp"
 
+/* nm-dhcp-helper sends events as one datagram to EVENT_SOCK_PATH, and only
+ * falls back to D-Bus if that fails.  The datagram is EVENT_MAGIC followed
+ * by one record per option: the name length and the value length as
+ * native-endian guint16, then the name and the value, unterminated.
+ * Keep in sync with nm-dhcp-helper.c.
+ */
+#define EVENT_SOCK_PATH           NMRUNDIR "/private-dhcp-event"
+#define EVENT_MAGIC               "NMDHCP1"
+#define EVENT_MAX_SIZE            65535
+
 typedef struct {
 	NMDBusManager *     dbus_mgr;
 	guint               new_conn_id;
 	guint               dis_conn_id;
 	GHashTable *        proxies;
 	DBusGProxy *        proxy;
+
+	int                 event_fd;
+	GIOChannel *        event_channel;
+	guint               event_id;
+	guint8 *            event_buf;
 } NMDhcpListenerPrivate;
 
 #define NM_DHCP_LISTENER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DHCP_LISTENER, NMDhcpListenerPrivate))
@@ -113,6 +130,25 @@ get_option (GHashTable *hash, const char *key)
 	return garray_to_string ((GArray *) g_value_get_boxed (value), key);
 }
 
+static void
+emit_event (NMDhcpListener *self,
+            const char *iface,
+            gint pid,
+            GHashTable *options,
+            const char *reason)
+{
+	gboolean handled = FALSE;
+
+	g_signal_emit (self, signals[EVENT], 0, iface, pid, options, reason, &handled);
+	if (!handled) {
+		if (g_ascii_strcasecmp (reason, "RELEASE") == 0) {
+			/* Ignore event when the dhcp client gets killed and we receive its last message */
+			nm_log_dbg (LOGD_DHCP, "(pid %d) unhandled RELEASE DHCP event for interface %s", pid, iface);
+		} else
+			nm_log_warn (LOGD_DHCP, "(pid %d) unhandled DHCP event for interface %s", pid, iface);
+	}
+}
+
 static void
 handle_event (DBusGProxy *proxy,
               GHashTable *options,
@@ -123,7 +159,6 @@ handle_event (DBusGProxy *proxy,
 	char *pid_str = NULL;
 	char *reason = NULL;
 	gint pid;
-	gboolean handled = FALSE;
 
 	iface = get_option (options, "interface");
 	if (iface == NULL) {
@@ -144,14 +179,7 @@ handle_event (DBusGProxy *proxy,
 		goto out;
 	}
 
-	g_signal_emit (self, signals[EVENT], 0, iface, pid, options, reason, &handled);
-	if (!handled) {
-		if (g_ascii_strcasecmp (reason, "RELEASE") == 0) {
-			/* Ignore event when the dhcp client gets killed and we receive its last message */
-			nm_log_dbg (LOGD_DHCP, "(pid %d) unhandled RELEASE DHCP event for interface %s", pid, iface);
-		} else
-			nm_log_warn (LOGD_DHCP, "(pid %d) unhandled DHCP event for interface %s", pid, iface);
-	}
+	emit_event (self, iface, pid, options, reason);
 
 out:
 	g_free (iface);
@@ -159,6 +187,217 @@ out:
 	g_free (reason);
 }
 
+/***************************************************/
+
+static void
+value_destroy (gpointer data)
+{
+	GValue *value = data;
+
+	g_value_unset (value);
+	g_slice_free (GValue, value);
+}
+
+/* Like garray_to_string(), for the few options needed to route the event */
+static char *
+event_value_to_string (const guint8 *data, guint16 len)
+{
+	char *str;
+	guint16 i;
+
+	str = g_malloc (len + 1);
+	for (i = 0; i < len; i++) {
+		if (data[i] == '\0')
+			str[i] = ' ';
+		else if (data[i] > 127)
+			str[i] = '?';
+		else
+			str[i] = data[i];
+	}
+	str[len] = '\0';
+	return str;
+}
+
+/* Parses an event datagram in one pass into the same options table as the
+ * D-Bus signal carries, picking out the interface, PID and reason on the way.
+ */
+static GHashTable *
+parse_event (const guint8 *buf, gsize len, char **out_iface, gint *out_pid, char **out_reason)
+{
+	GHashTable *options;
+	const guint8 *end = buf + len;
+	gint64 pid = -1;
+
+	if (len < sizeof (EVENT_MAGIC) || memcmp (buf, EVENT_MAGIC, sizeof (EVENT_MAGIC)))
+		return NULL;
+	buf += sizeof (EVENT_MAGIC);
+
+	options = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, value_destroy);
+	*out_iface = NULL;
+	*out_reason = NULL;
+
+	while (buf < end) {
+		guint16 name_len, value_len;
+		const guint8 *name, *data;
+		GValue *value;
+		GArray *array;
+		guint16 i;
+
+		if (end - buf < 4)
+			goto error;
+		memcpy (&name_len, buf, 2);
+		memcpy (&value_len, buf + 2, 2);
+		buf += 4;
+		if (!name_len || end - buf < (gssize) name_len + value_len)
+			goto error;
+		name = buf;
+		data = buf + name_len;
+		buf += name_len + value_len;
+
+		if (name_len == 3 && !memcmp (name, "pid", 3)) {
+			pid = 0;
+			for (i = 0; i < value_len && pid >= 0; i++) {
+				if (!g_ascii_isdigit (data[i]) || pid > G_MAXINT32 / 10)
+					pid = -1;
+				else
+					pid = pid * 10 + (data[i] - '0');
+			}
+			if (!value_len || pid > G_MAXINT32)
+				pid = -1;
+		} else if (name_len == 9 && !memcmp (name, "interface", 9)) {
+			g_free (*out_iface);
+			*out_iface = event_value_to_string (data, value_len);
+		} else if (name_len == 6 && !memcmp (name, "reason", 6)) {
+			g_free (*out_reason);
+			*out_reason = event_value_to_string (data, value_len);
+		}
+
+		array = g_array_sized_new (FALSE, FALSE, 1, value_len);
+		g_array_append_vals (array, data, value_len);
+		value = g_slice_new0 (GValue);
+		g_value_init (value, DBUS_TYPE_G_UCHAR_ARRAY);
+		g_value_take_boxed (value, array);
+		g_hash_table_replace (options, g_strndup ((const char *) name, name_len), value);
+	}
+
+	*out_pid = pid;
+	return options;
+
+error:
+	g_clear_pointer (out_iface, g_free);
+	g_clear_pointer (out_reason, g_free);
+	g_hash_table_destroy (options);
+	return NULL;
+}
+
+/* Only root may send events, like on the private D-Bus socket */
+static gboolean
+event_sender_is_root (struct msghdr *msg)
+{
+	struct cmsghdr *cmsg;
+
+	for (cmsg = CMSG_FIRSTHDR (msg); cmsg; cmsg = CMSG_NXTHDR (msg, cmsg)) {
+		if (   cmsg->cmsg_level == SOL_SOCKET
+		    && cmsg->cmsg_type == SCM_CREDENTIALS
+		    && cmsg->cmsg_len >= CMSG_LEN (sizeof (struct ucred))) {
+			struct ucred cred;
+
+			memcpy (&cred, CMSG_DATA (cmsg), sizeof (cred));
+			return cred.uid == 0;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+event_socket_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	guint8 cmsgbuf[CMSG_SPACE (sizeof (struct ucred))];
+	struct iovec iov = {
+		.iov_base = priv->event_buf,
+		.iov_len = EVENT_MAX_SIZE,
+	};
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = cmsgbuf,
+		.msg_controllen = sizeof (cmsgbuf),
+	};
+	GHashTable *options;
+	char *iface, *reason;
+	gint pid;
+	ssize_t len;
+
+	/* Handle everything that is queued, e.g. after a DHCP server restart
+	 * renewed all leases at once.
+	 */
+	while ((len = recvmsg (priv->event_fd, &msg, MSG_DONTWAIT)) >= 0) {
+		if (!event_sender_is_root (&msg))
+			nm_log_warn (LOGD_DHCP, "DHCP event: ignoring message from unprivileged sender");
+		else if (msg.msg_flags & MSG_TRUNC)
+			nm_log_warn (LOGD_DHCP, "DHCP event: message too large");
+		else {
+			options = parse_event (priv->event_buf, len, &iface, &pid, &reason);
+			if (!options)
+				nm_log_warn (LOGD_DHCP, "DHCP event: malformed message");
+			else {
+				if (!iface)
+					nm_log_warn (LOGD_DHCP, "DHCP event: didn't have associated interface.");
+				else if (pid == -1)
+					nm_log_warn (LOGD_DHCP, "DHCP event: couldn't convert PID to an integer");
+				else if (!reason)
+					nm_log_warn (LOGD_DHCP, "(pid %d) DHCP event didn't have a reason", pid);
+				else
+					emit_event (self, iface, pid, options, reason);
+
+				g_free (iface);
+				g_free (reason);
+				g_hash_table_destroy (options);
+			}
+		}
+
+		msg.msg_controllen = sizeof (cmsgbuf);
+		msg.msg_flags = 0;
+	}
+
+	if (errno != EAGAIN && errno != EINTR)
+		nm_log_warn (LOGD_DHCP, "DHCP event: failed to receive message: %s", g_strerror (errno));
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+event_socket_open (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd, on = 1;
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0) {
+		nm_log_warn (LOGD_DHCP, "could not create DHCP event socket: %s", g_strerror (errno));
+		return;
+	}
+
+	g_strlcpy (addr.sun_path, EVENT_SOCK_PATH, sizeof (addr.sun_path));
+	unlink (EVENT_SOCK_PATH);
+	if (   setsockopt (fd, SOL_SOCKET, SO_PASSCRED, &on, sizeof (on)) < 0
+	    || bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0
+	    || chmod (EVENT_SOCK_PATH, 0600) < 0) {
+		nm_log_warn (LOGD_DHCP, "could not set up DHCP event socket %s: %s",
+		             EVENT_SOCK_PATH, g_strerror (errno));
+		close (fd);
+		return;
+	}
+
+	priv->event_fd = fd;
+	priv->event_buf = g_malloc (EVENT_MAX_SIZE);
+	priv->event_channel = g_io_channel_unix_new (fd);
+	priv->event_id = g_io_add_watch (priv->event_channel, G_IO_IN, event_socket_cb, self);
+}
+
 #if HAVE_DBUS_GLIB_100
 static void
 new_connection_cb (NMDBusManager *mgr,
@@ -215,6 +454,9 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	/* Maps DBusGConnection :: DBusGProxy */
 	priv->proxies = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_object_unref);
 
+	priv->event_fd = -1;
+	event_socket_open (self);
+
 	priv->dbus_mgr = nm_dbus_manager_get ();
 
 #if HAVE_DBUS_GLIB_100
@@ -261,6 +503,18 @@ dispose (GObject *object)
 	}
 	g_clear_object (&priv->proxy);
 
+	if (priv->event_id) {
+		g_source_remove (priv->event_id);
+		priv->event_id = 0;
+	}
+	g_clear_pointer (&priv->event_channel, g_io_channel_unref);
+	if (priv->event_fd >= 0) {
+		close (priv->event_fd);
+		unlink (EVENT_SOCK_PATH);
+		priv->event_fd = -1;
+	}
+	g_clear_pointer (&priv->event_buf, g_free);
+
 	G_OBJECT_CLASS (nm_dhcp_listener_parent_class)->dispose (object);
 }
 
@@ -38,12 +38,14 @@
 #include "NetworkManagerUtils.h"
 #include "gsystem-local-alloc.h"
 #include "nm-platform.h"
+#include "nm-config.h"
 
 #include "nm-sd-adapt.h"
 
 #include "sd-dhcp-client.h"
 #include "sd-dhcp6-client.h"
 #include "dhcp-protocol.h"
+#include "dhcp-internal.h"
 #include "dhcp-lease-internal.h"
 #include "dhcp6-protocol.h"
 #include "dhcp6-lease-internal.h"
@@ -826,9 +828,18 @@ nm_dhcp_systemd_class_init (NMDhcpSystemdClass *sdhcp_class)
 {
 	NMDhcpClientClass *client_class = NM_DHCP_CLIENT_CLASS (sdhcp_class);
 	GObjectClass *object_class = G_OBJECT_CLASS (sdhcp_class);
+	char *sockets;
 
 	g_type_class_add_private (sdhcp_class, sizeof (NMDhcpSystemdPrivate));
 
+	/* With many interfaces, let all DHCPv4 clients share one packet socket */
+	sockets = nm_config_get_value (nm_config_get (), "main", "dhcp-internal-sockets", NULL);
+	if (!g_strcmp0 (sockets, "shared")) {
+		nm_log_info (LOGD_DHCP4, "internal DHCP clients share one receive socket");
+		dhcp_network_set_shared_raw_socket (TRUE);
+	}
+	g_free (sockets);
+
 	/* virtual methods */
 	object_class->dispose = dispose;
 
@@ -21,10 +21,15 @@
 #include <glib.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
 
+#include "nm-sd-adapt.h"
 #include "sd-event.h"
 #include "time-util.h"
 
+typedef struct _DemuxGroup DemuxGroup;
+
 struct sd_event_source {
 	guint refcount;
 	guint id;
@@ -33,10 +38,23 @@ struct sd_event_source {
 	GIOChannel *channel;
 	sd_event_io_handler_t io_cb;
 
+	/* IO source on a shared socket, dispatched by its group */
+	int fd;
+	DemuxGroup *demux;
+	guint64 demux_key;
+
 	uint64_t usec;
 	sd_event_time_handler_t time_cb;
+
+	/* Time source waiting in the timer queue */
+	gint64 deadline;
+	gint64 latest;
+	GSequenceIter *queued;
 };
 
+static void timer_queue_remove (struct sd_event_source *source);
+static void demux_group_remove (struct sd_event_source *source);
+
 int
 sd_event_source_set_priority (sd_event_source *s, int64_t priority)
 {
@@ -56,6 +74,10 @@ sd_event_source_unref (sd_event_source *s)
 	if (s->refcount == 0) {
 		if (s->id)
 			g_source_remove (s->id);
+		if (s->queued)
+			timer_queue_remove (s);
+		if (s->demux)
+			demux_group_remove (s);
 		if (s->channel) {
 			/* Don't shut down the channel since systemd will soon close
 			 * the file descriptor itself, which would cause -EBADF.
@@ -73,7 +95,8 @@ sd_event_source_set_description(sd_event_source *s, const char *description)
 	if (!s)
 		return -EINVAL;
 
-	g_source_set_name_by_id (s->id, description);
+	if (s->id)
+		g_source_set_name_by_id (s->id, description);
 	return 0;
 }
 
@@ -102,21 +125,208 @@ io_ready (GIOChannel *channel, GIOCondition condition, struct sd_event_source *s
 	return G_SOURCE_CONTINUE;
 }
 
+/*****************************************************************************/
+
+/* Several clients can receive on one shared socket, each through its own dup()
+ * of it.  Only one watch is kept on the socket; for each datagram, the
+ * group's peek function returns the key of the client it is meant for,
+ * without consuming it, and only that client's callback is run.  Datagrams
+ * that no client wants are dropped.
+ */
+
+struct _DemuxGroup {
+	dev_t dev;
+	ino_t ino;
+	int fd;
+	NMSdDemuxPeekFunc peek;
+	GIOChannel *channel;
+	guint id;
+	GHashTable *sources;  /* key -> sd_event_source */
+};
+
+typedef struct {
+	DemuxGroup *group;
+	guint64 key;
+} DemuxPending;
+
+static GSList *demux_groups;
+static GHashTable *demux_pending;  /* fd -> DemuxPending */
+
+static gboolean
+demux_ready (GIOChannel *channel, GIOCondition condition, DemuxGroup *group)
+{
+	struct sd_event_source *source;
+	guint64 key;
+	int r;
+
+	if (group->peek (group->fd, &key) < 0)
+		return G_SOURCE_CONTINUE;
+
+	source = g_hash_table_lookup (group->sources, &key);
+	if (!source) {
+		/* Nobody is waiting for it; drop it */
+		recv (group->fd, NULL, 0, MSG_DONTWAIT);
+		return G_SOURCE_CONTINUE;
+	}
+
+	source->refcount++;
+	r = source->io_cb (source, source->fd, EPOLLIN, source->user_data);
+	if (r < 0 && source->demux)
+		demux_group_remove (source);
+	sd_event_source_unref (source);
+
+	return G_SOURCE_CONTINUE;
+}
+
+/**
+ * nm_sd_event_demux_fd:
+ * @shared_fd: the shared socket
+ * @fd: a dup() of @shared_fd
+ * @key: the key of the datagrams meant for @fd
+ * @peek: returns the key of the next datagram on @shared_fd
+ *
+ * Makes the next IO source added for @fd part of the group of @shared_fd,
+ * so that it is only dispatched for datagrams with @key.  Adding that source
+ * fails rather than falling back to a plain watch, which would see every
+ * datagram on the shared socket.
+ *
+ * Returns: 0 on success, or a negative errno
+ */
+int
+nm_sd_event_demux_fd (int shared_fd, int fd, guint64 key, NMSdDemuxPeekFunc peek)
+{
+	DemuxGroup *group = NULL;
+	DemuxPending *pending;
+	struct stat st;
+	GSList *iter;
+
+	if (fstat (shared_fd, &st) < 0)
+		return -errno;
+
+	for (iter = demux_groups; iter; iter = iter->next) {
+		DemuxGroup *candidate = iter->data;
+
+		if (candidate->dev == st.st_dev && candidate->ino == st.st_ino) {
+			group = candidate;
+			break;
+		}
+	}
+
+	if (!group) {
+		group = g_slice_new0 (DemuxGroup);
+		group->dev = st.st_dev;
+		group->ino = st.st_ino;
+		group->fd = shared_fd;
+		group->peek = peek;
+		group->sources = g_hash_table_new (g_int64_hash, g_int64_equal);
+		demux_groups = g_slist_prepend (demux_groups, group);
+	}
+
+	if (!demux_pending)
+		demux_pending = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+
+	pending = g_new (DemuxPending, 1);
+	pending->group = group;
+	pending->key = key;
+	g_hash_table_replace (demux_pending, GINT_TO_POINTER (fd), pending);
+	return 0;
+}
+
+/* Returns 1 if @source was added to the group @fd was registered for, 0 if
+ * @fd isn't a registered dup of a shared socket, or a negative errno.
+ */
+static int
+demux_group_add (struct sd_event_source *source, int fd, uint32_t events)
+{
+	DemuxPending *pending;
+	struct stat st;
+	int r = 0;
+
+	if (!demux_pending)
+		return 0;
+
+	pending = g_hash_table_lookup (demux_pending, GINT_TO_POINTER (fd));
+	if (!pending)
+		return 0;
+
+	/* The fd could have been closed and reused since it was registered */
+	if (fstat (fd, &st) < 0)
+		r = -errno;
+	else if (st.st_dev != pending->group->dev || st.st_ino != pending->group->ino)
+		r = 0;
+	else if (events != EPOLLIN)
+		r = -EINVAL;
+	else if (g_hash_table_contains (pending->group->sources, &pending->key))
+		r = -EEXIST;
+	else
+		r = 1;
+
+	if (r <= 0) {
+		g_hash_table_remove (demux_pending, GINT_TO_POINTER (fd));
+		return r;
+	}
+
+	source->fd = fd;
+	source->demux = pending->group;
+	source->demux_key = pending->key;
+	g_hash_table_remove (demux_pending, GINT_TO_POINTER (fd));
+
+	g_hash_table_insert (source->demux->sources, &source->demux_key, source);
+	if (!source->demux->id) {
+		source->demux->channel = g_io_channel_unix_new (source->demux->fd);
+		g_io_channel_set_encoding (source->demux->channel, NULL, NULL);
+		g_io_channel_set_buffered (source->demux->channel, FALSE);
+		source->demux->id = g_io_add_watch (source->demux->channel, G_IO_IN,
+		                                    (GIOFunc) demux_ready, source->demux);
+	}
+	return 1;
+}
+
+static void
+demux_group_remove (struct sd_event_source *source)
+{
+	DemuxGroup *group = source->demux;
+
+	g_hash_table_remove (group->sources, &source->demux_key);
+	source->demux = NULL;
+
+	/* The shared socket stays open, but isn't watched while nobody uses it */
+	if (!g_hash_table_size (group->sources) && group->id) {
+		g_source_remove (group->id);
+		group->id = 0;
+		g_clear_pointer (&group->channel, g_io_channel_unref);
+	}
+}
+
+/*****************************************************************************/
+
 int
 sd_event_add_io (sd_event *e, sd_event_source **s, int fd, uint32_t events, sd_event_io_handler_t callback, void *userdata)
 {
 	struct sd_event_source *source;
 	GIOChannel *channel;
 	GIOCondition condition = 0;
-
-	channel = g_io_channel_unix_new (fd);
-	if (!channel)
-		return -EINVAL;
+	int r;
 
 	source = g_new0 (struct sd_event_source, 1);
 	source->refcount = 1;
 	source->io_cb = callback;
 	source->user_data = userdata;
+
+	r = demux_group_add (source, fd, events);
+	if (r < 0) {
+		g_free (source);
+		return r;
+	} else if (r > 0) {
+		*s = source;
+		return 0;
+	}
+
+	channel = g_io_channel_unix_new (fd);
+	if (!channel) {
+		g_free (source);
+		return -EINVAL;
+	}
 	source->channel = channel;
 
 	if (events & EPOLLIN)
@@ -138,18 +348,111 @@ sd_event_add_io (sd_event *e, sd_event_source **s, int fd, uint32_t events, sd_e
 	return 0;
 }
 
+/*****************************************************************************/
+
+/* All time sources wait in one queue, ordered by deadline, with a single
+ * GLib timeout.  A source may fire up to its accuracy late, so the timeout
+ * is set for the end of the earliest window and runs every source that is
+ * due by then; the retransmission timers of many clients thus share
+ * wakeups.  Like in systemd, time sources fire once.
+ */
+
+static GSequence *timer_queue;
+static guint timer_id;
+static gint64 timer_expiry;
+
+static gint
+timer_queue_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const struct sd_event_source *sa = a, *sb = b;
+
+	if (sa->deadline != sb->deadline)
+		return sa->deadline < sb->deadline ? -1 : 1;
+	return 0;
+}
+
+static void timer_schedule (void);
+
 static gboolean
-time_ready (struct sd_event_source *source)
+timer_ready (gpointer user_data)
 {
-	int r;
+	GSList *due = NULL, *iter;
+	GSequenceIter *first;
+	gint64 now;
+
+	timer_id = 0;
+	now = g_get_monotonic_time ();
+
+	while ((first = g_sequence_get_begin_iter (timer_queue)) && !g_sequence_iter_is_end (first)) {
+		struct sd_event_source *source = g_sequence_get (first);
+
+		if (source->deadline > now)
+			break;
+		g_sequence_remove (first);
+		source->queued = NULL;
+		source->refcount++;
+		due = g_slist_prepend (due, source);
+	}
 
-	r = source->time_cb (source, source->usec, source->user_data);
-	if (r < 0) {
-		source->id = 0;
-		return G_SOURCE_REMOVE;
+	for (iter = g_slist_reverse (due); iter; iter = iter->next) {
+		struct sd_event_source *source = iter->data;
+
+		/* An earlier callback may have dropped it */
+		if (source->refcount > 1)
+			source->time_cb (source, source->usec, source->user_data);
+		sd_event_source_unref (source);
 	}
+	g_slist_free (due);
 
-	return G_SOURCE_CONTINUE;
+	timer_schedule ();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+timer_schedule (void)
+{
+	GSequenceIter *iter;
+	struct sd_event_source *source;
+	gint64 now, expiry = G_MAXINT64;
+
+	iter = g_sequence_get_begin_iter (timer_queue);
+	if (g_sequence_iter_is_end (iter)) {
+		if (timer_id) {
+			g_source_remove (timer_id);
+			timer_id = 0;
+		}
+		return;
+	}
+
+	/* Wake up when the first window closes; only sources with an earlier
+	 * deadline can have an earlier end.
+	 */
+	for (; !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+		source = g_sequence_get (iter);
+		if (source->deadline >= expiry)
+			break;
+		expiry = MIN (expiry, source->latest);
+	}
+
+	if (timer_id && timer_expiry <= expiry)
+		return;
+
+	if (timer_id)
+		g_source_remove (timer_id);
+
+	now = g_get_monotonic_time ();
+	timer_expiry = expiry;
+	timer_id = g_timeout_add (expiry > now ? (expiry - now + 999) / 1000 : 0,
+	                          timer_ready, NULL);
+}
+
+static void
+timer_queue_remove (struct sd_event_source *source)
+{
+	g_sequence_remove (source->queued);
+	source->queued = NULL;
+
+	/* The timeout is left alone; if it fires early, it is just set again */
 }
 
 int
@@ -164,9 +467,13 @@ sd_event_add_time(sd_event *e, sd_event_source **s, clockid_t clock, uint64_t us
 	source->user_data = userdata;
 	source->usec = usec;
 
-	if (usec > 1000)
-		usec = n < usec - 1000 ? usec - n : 1000;
-	source->id = g_timeout_add (usec / 1000, (GSourceFunc) time_ready, source);
+	source->deadline = g_get_monotonic_time () + (usec > n ? usec - n : 0);
+	source->latest = source->deadline + (accuracy ? accuracy : 250 * USEC_PER_MSEC);
+
+	if (!timer_queue)
+		timer_queue = g_sequence_new (NULL);
+	source->queued = g_sequence_insert_sorted (timer_queue, source, timer_queue_cmp, NULL);
+	timer_schedule ();
 
 	*s = source;
 	return 0;
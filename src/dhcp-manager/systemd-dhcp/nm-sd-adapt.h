@@ -105,5 +105,12 @@ static inline pid_t gettid(void) {
         return (pid_t) syscall(SYS_gettid);
 }
 
+/* Returns the demultiplexing key of the next datagram on @fd without
+ * consuming it, or a negative errno.
+ */
+typedef int (*NMSdDemuxPeekFunc) (int fd, guint64 *key);
+
+int nm_sd_event_demux_fd (int shared_fd, int fd, guint64 key, NMSdDemuxPeekFunc peek);
+
 #endif /* NM_SD_ADAPT_H */
 
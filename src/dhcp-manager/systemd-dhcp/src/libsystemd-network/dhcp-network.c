@@ -31,6 +31,7 @@
 #include <net/if_arp.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <linux/filter.h>
 
 #include "socket-util.h"
@@ -129,6 +130,141 @@ static int _bind_raw_socket(int ifindex, union sockaddr_union *link,
         return r;
 }
 
+/* NM: in shared mode, all clients receive on one packet socket that isn't
+ * bound to an interface and only filters for DHCP replies.  Each client
+ * gets a dup() of it for sending, and nm-sd-adapt hands it the replies
+ * for its interface and xid.
+ */
+static bool shared_raw_socket_enabled;
+static int shared_raw_socket = -1;
+
+void dhcp_network_set_shared_raw_socket(bool enabled) {
+        shared_raw_socket_enabled = enabled;
+}
+
+static int _peek_raw_socket(int fd, guint64 *key) {
+        DHCPPacket packet;
+        union sockaddr_union from = {};
+        struct iovec iov = {
+                .iov_base = &packet,
+                .iov_len = sizeof(packet),
+        };
+        struct msghdr msg = {
+                .msg_name = &from,
+                .msg_namelen = sizeof(from),
+                .msg_iov = &iov,
+                .msg_iovlen = 1,
+        };
+        ssize_t len;
+
+        len = recvmsg(fd, &msg, MSG_PEEK | MSG_DONTWAIT);
+        if (len < 0)
+                return -errno;
+
+        /* No client uses ifindex 0, so short packets are dropped */
+        if ((size_t) len < sizeof(DHCPPacket))
+                *key = 0;
+        else
+                *key = ((guint64) from.ll.sll_ifindex << 32) | be32toh(packet.dhcp.xid);
+
+        return 0;
+}
+
+static int _open_shared_raw_socket(void) {
+        struct sock_filter filter[] = {
+                BPF_STMT(BPF_LD + BPF_W + BPF_LEN, 0),                                 /* A <- packet length */
+                BPF_JUMP(BPF_JMP + BPF_JGE + BPF_K, sizeof(DHCPPacket), 1, 0),         /* packet >= DHCPPacket ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_B + BPF_ABS, offsetof(DHCPPacket, ip.protocol)), /* A <- IP protocol */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, IPPROTO_UDP, 1, 0),                /* IP protocol == UDP ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_H + BPF_ABS, offsetof(DHCPPacket, ip.frag_off)), /* A <- Flags + Fragment offset */
+                BPF_STMT(BPF_ALU + BPF_AND + BPF_K, 0x3fff),                           /* A <- A & 0x3fff (More Fragments bit + Fragment offset) */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, 0, 1, 0),                          /* A == 0 ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_H + BPF_ABS, offsetof(DHCPPacket, udp.dest)),    /* A <- UDP destination port */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, DHCP_PORT_CLIENT, 1, 0),           /* UDP destination port == DHCP client port ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_B + BPF_ABS, offsetof(DHCPPacket, dhcp.op)),     /* A <- DHCP op */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, BOOTREPLY, 1, 0),                  /* op == BOOTREPLY ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_LD + BPF_W + BPF_ABS, offsetof(DHCPPacket, dhcp.magic)),  /* A <- DHCP magic cookie */
+                BPF_JUMP(BPF_JMP + BPF_JEQ + BPF_K, DHCP_MAGIC_COOKIE, 1, 0),          /* cookie == DHCP magic cookie ? */
+                BPF_STMT(BPF_RET + BPF_K, 0),                                          /* ignore */
+                BPF_STMT(BPF_RET + BPF_K, 65535),                                      /* return all */
+        };
+        struct sock_fprog fprog = {
+                .len = ELEMENTSOF(filter),
+                .filter = filter
+        };
+        union sockaddr_union any = {
+                .ll.sll_family = AF_PACKET,
+                .ll.sll_protocol = htons(ETH_P_IP),
+        };
+        _cleanup_close_ int s = -1;
+        int r, on = 1;
+
+        s = socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (s < 0)
+                return -errno;
+
+        r = setsockopt(s, SOL_PACKET, PACKET_AUXDATA, &on, sizeof(on));
+        if (r < 0)
+                return -errno;
+
+        r = setsockopt(s, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog));
+        if (r < 0)
+                return -errno;
+
+        /* Interface index 0 means all interfaces */
+        r = bind(s, &any.sa, sizeof(any.ll));
+        if (r < 0)
+                return -errno;
+
+        r = s;
+        s = -1;
+
+        return r;
+}
+
+static int _bind_shared_raw_socket(int ifindex, union sockaddr_union *link,
+                                   uint32_t xid, size_t mac_addr_len,
+                                   const uint8_t *bcast_addr, uint16_t arp_type) {
+        _cleanup_close_ int s = -1;
+        int r;
+
+        assert(ifindex > 0);
+        assert(link);
+
+        if (shared_raw_socket < 0) {
+                r = _open_shared_raw_socket();
+                if (r < 0)
+                        return r;
+                shared_raw_socket = r;
+        }
+
+        /* Sending goes straight to the interface in @link */
+        link->ll.sll_family = AF_PACKET;
+        link->ll.sll_protocol = htons(ETH_P_IP);
+        link->ll.sll_ifindex = ifindex;
+        link->ll.sll_hatype = htons(arp_type);
+        link->ll.sll_halen = mac_addr_len;
+        memcpy(link->ll.sll_addr, bcast_addr, mac_addr_len);
+
+        s = fcntl(shared_raw_socket, F_DUPFD_CLOEXEC, 3);
+        if (s < 0)
+                return -errno;
+
+        r = nm_sd_event_demux_fd(shared_raw_socket, s, ((guint64) ifindex << 32) | xid, _peek_raw_socket);
+        if (r < 0)
+                return r;
+
+        r = s;
+        s = -1;
+
+        return r;
+}
+
 int dhcp_network_bind_raw_socket(int ifindex, union sockaddr_union *link,
                                  uint32_t xid, const uint8_t *mac_addr,
                                  size_t mac_addr_len, uint16_t arp_type) {
@@ -156,6 +292,10 @@ int dhcp_network_bind_raw_socket(int ifindex, union sockaddr_union *link,
         } else
                 return -EINVAL;
 
+        if (shared_raw_socket_enabled)
+                return _bind_shared_raw_socket(ifindex, link, xid, mac_addr_len,
+                                               bcast_addr, arp_type);
+
         return _bind_raw_socket(ifindex, link, xid, mac_addr, mac_addr_len,
                                 bcast_addr, &eth_mac, arp_type, dhcp_hlen);
 }
@@ -0,0 +1,284 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "nm-sd-adapt.h"
+#include "sd-event.h"
+#include "time-util.h"
+
+#include "nm-test-utils.h"
+
+/*******************************************/
+
+static gboolean
+loop_timeout (gpointer user_data)
+{
+	g_assert_not_reached ();
+	return G_SOURCE_REMOVE;
+}
+
+/* Runs the main loop until @done is set */
+static void
+run_until (gboolean *done)
+{
+	guint id;
+
+	id = g_timeout_add_seconds (5, loop_timeout, NULL);
+	while (!*done)
+		g_main_context_iteration (NULL, TRUE);
+	g_source_remove (id);
+}
+
+/*******************************************/
+
+typedef struct {
+	GString *fired;
+	gboolean idle_ran;
+	gboolean idle_ran_before_b;
+	guint remaining;
+	gboolean done;
+} TimerData;
+
+typedef struct {
+	TimerData *data;
+	char name;
+	sd_event_source *source;
+} Timer;
+
+static gboolean
+timer_idle (gpointer user_data)
+{
+	TimerData *data = user_data;
+
+	data->idle_ran = TRUE;
+	return G_SOURCE_REMOVE;
+}
+
+static int
+timer_cb (sd_event_source *s, uint64_t usec, void *userdata)
+{
+	Timer *timer = userdata;
+	TimerData *data = timer->data;
+
+	g_assert (s == timer->source);
+	g_string_append_c (data->fired, timer->name);
+
+	if (timer->name == 'a')
+		g_idle_add (timer_idle, data);
+	else if (timer->name == 'b')
+		data->idle_ran_before_b = data->idle_ran;
+
+	if (--data->remaining == 0)
+		data->done = TRUE;
+	return 0;
+}
+
+static void
+add_timer (Timer *timer, guint delay_ms, guint accuracy_ms)
+{
+	int r;
+
+	r = sd_event_add_time (NULL, &timer->source, CLOCK_MONOTONIC,
+	                       now (CLOCK_MONOTONIC) + delay_ms * USEC_PER_MSEC,
+	                       accuracy_ms * USEC_PER_MSEC,
+	                       timer_cb, timer);
+	g_assert_cmpint (r, ==, 0);
+	g_assert (timer->source);
+}
+
+static void
+test_timer_queue (void)
+{
+	TimerData data = { 0 };
+	Timer a = { &data, 'a' }, b = { &data, 'b' }, c = { &data, 'c' }, d = { &data, 'd' };
+
+	data.fired = g_string_new (NULL);
+	data.remaining = 3;
+
+	/* Added out of order; "d" is dropped before it is due */
+	add_timer (&c, 300, 10);
+	add_timer (&b, 30, 50);
+	add_timer (&d, 20, 10);
+	add_timer (&a, 10, 50);
+	d.source = sd_event_source_unref (d.source);
+
+	run_until (&data.done);
+
+	/* Fired by deadline, each once */
+	g_assert_cmpstr (data.fired->str, ==, "abc");
+
+	/* "b" was due before the window of "a" closed, so they shared a wakeup
+	 * and the idle added by "a" couldn't run in between.
+	 */
+	g_assert (!data.idle_ran_before_b);
+
+	sd_event_source_unref (a.source);
+	sd_event_source_unref (b.source);
+	sd_event_source_unref (c.source);
+	g_string_free (data.fired, TRUE);
+}
+
+/*******************************************/
+
+typedef struct {
+	guint64 expected;
+	guint received;
+	gboolean *done;
+} DemuxClient;
+
+static int
+demux_peek (int fd, guint64 *key)
+{
+	ssize_t len;
+
+	len = recv (fd, key, sizeof (*key), MSG_PEEK | MSG_DONTWAIT);
+	if (len < 0)
+		return -errno;
+	if (len != sizeof (*key))
+		*key = 0;
+	return 0;
+}
+
+static int
+demux_io_cb (sd_event_source *s, int fd, uint32_t revents, void *userdata)
+{
+	DemuxClient *client = userdata;
+	guint64 key = 0;
+	ssize_t len;
+
+	g_assert_cmpint (revents, ==, EPOLLIN);
+
+	len = recv (fd, &key, sizeof (key), MSG_DONTWAIT);
+	g_assert_cmpint (len, ==, sizeof (key));
+	g_assert_cmpuint (key, ==, client->expected);
+
+	client->received++;
+	*client->done = TRUE;
+	return 0;
+}
+
+static void
+demux_send (int fd, guint64 key)
+{
+	g_assert_cmpint (send (fd, &key, sizeof (key), 0), ==, sizeof (key));
+}
+
+static int
+demux_add_client (int shared_fd, DemuxClient *client, sd_event_source **s)
+{
+	int fd, r;
+
+	fd = dup (shared_fd);
+	g_assert_cmpint (fd, >=, 0);
+
+	r = nm_sd_event_demux_fd (shared_fd, fd, client->expected, demux_peek);
+	g_assert_cmpint (r, ==, 0);
+
+	r = sd_event_add_io (NULL, s, fd, EPOLLIN, demux_io_cb, client);
+	if (r < 0)
+		close (fd);
+	return r;
+}
+
+static void
+test_demux (void)
+{
+	int sv[2], shared_fd;
+	DemuxClient one = { 1 }, two = { 2 }, dup_one = { 1 };
+	sd_event_source *s1 = NULL, *s2 = NULL, *s3 = NULL;
+	gboolean done = FALSE;
+	guint64 key;
+
+	g_assert_cmpint (socketpair (AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0, sv), ==, 0);
+	shared_fd = sv[0];
+	one.done = two.done = dup_one.done = &done;
+
+	g_assert_cmpint (demux_add_client (shared_fd, &one, &s1), ==, 0);
+	g_assert_cmpint (demux_add_client (shared_fd, &two, &s2), ==, 0);
+
+	/* A second client for the same key must not fall back to a plain
+	 * watch that would see everybody's datagrams.
+	 */
+	g_assert_cmpint (demux_add_client (shared_fd, &dup_one, &s3), ==, -EEXIST);
+	g_assert (!s3);
+
+	/* Nobody waits for key 3, so it is dropped on the way */
+	demux_send (sv[1], 2);
+	demux_send (sv[1], 3);
+	demux_send (sv[1], 1);
+
+	while (one.received + two.received < 2) {
+		done = FALSE;
+		run_until (&done);
+	}
+	g_assert_cmpuint (one.received, ==, 1);
+	g_assert_cmpuint (two.received, ==, 1);
+	g_assert_cmpuint (dup_one.received, ==, 0);
+	g_assert_cmpint (recv (shared_fd, &key, sizeof (key), MSG_DONTWAIT), ==, -1);
+	g_assert_cmpint (errno, ==, EAGAIN);
+
+	/* Once its source is gone, a client's datagrams are dropped too */
+	s2 = sd_event_source_unref (s2);
+	demux_send (sv[1], 2);
+	demux_send (sv[1], 1);
+	done = FALSE;
+	run_until (&done);
+	g_assert_cmpuint (one.received, ==, 2);
+	g_assert_cmpuint (two.received, ==, 1);
+
+	sd_event_source_unref (s1);
+	close (sv[0]);
+	close (sv[1]);
+}
+
+static void
+test_demux_bad_fd (void)
+{
+	int sv[2];
+
+	g_assert_cmpint (socketpair (AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0, sv), ==, 0);
+	close (sv[0]);
+
+	/* A shared socket that can't be looked at isn't registered at all */
+	g_assert_cmpint (nm_sd_event_demux_fd (sv[0], sv[1], 1, demux_peek), ==, -EBADF);
+	close (sv[1]);
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv);
+
+	g_test_add_func ("/dhcp/sd-event/timer-queue", test_timer_queue);
+	g_test_add_func ("/dhcp/sd-event/demux", test_demux);
+	g_test_add_func ("/dhcp/sd-event/demux-bad-fd", test_demux_bad_fd);
+
+	return g_test_run ();
+}
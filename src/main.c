@@ -58,6 +58,7 @@
 #include "nm-session-monitor.h"
 #include "nm-dispatcher.h"
 #include "nm-settings.h"
+#include "nm-trace.h"
 #include "nm-auth-manager.h"
 #include "nm-core-internal.h"
 
@@ -354,6 +355,8 @@ main (int argc, char *argv[])
 
 	_init_nm_debug (nm_config_get_debug (config));
 
+	nm_trace_set_enabled (nm_config_get_trace (config));
+
 	/* Set up unix signal handling - before creating threads, but after daemonizing! */
 	if (!nm_main_utils_setup_signals (main_loop, &quit_early))
 		exit (1);
@@ -29,6 +29,14 @@
 #define POLKIT_OBJECT_PATH                  "/org/freedesktop/PolicyKit1/Authority"
 #define POLKIT_INTERFACE                    "org.freedesktop.PolicyKit1.Authority"
 
+/* Authorization results are cached per subject and action.  The cache is
+ * flushed when polkit signals that authorizations changed and entries of a
+ * subject are dropped when its bus name disappears.  Entries also expire,
+ * as polkit does not signal the expiry of temporary authorizations.
+ */
+#define CACHE_ENTRY_LIFETIME_MS             (10 * 1000)
+#define CACHE_MAX_ENTRIES                   1024
+
 
 #define _LOG_DEFAULT_DOMAIN  LOGD_CORE
 
@@ -73,6 +81,10 @@ typedef struct {
 	GCancellable *new_proxy_cancellable;
 	GSList *queued_calls;
 	GDBusProxy *proxy;
+	guint name_owner_changed_id;
+
+	GHashTable *cache;
+	guint cache_generation;
 #endif
 } NMAuthManagerPrivate;
 
@@ -108,8 +120,22 @@ typedef struct {
 	gchar *cancellation_id;
 	GVariant *dbus_parameters;
 	GCancellable *cancellable;
+	char *cache_key;
+	char *dbus_sender;
+	guint cache_generation;
 } CheckAuthData;
 
+typedef struct {
+	gboolean is_authorized;
+	gboolean is_challenge;
+} CheckAuthorizationResult;
+
+typedef struct {
+	CheckAuthorizationResult result;
+	char *dbus_sender;
+	gint64 expires_at;
+} CacheEntry;
+
 static void
 _check_auth_data_free (CheckAuthData *data)
 {
@@ -119,9 +145,125 @@ _check_auth_data_free (CheckAuthData *data)
 	g_object_unref (data->simple);
 	g_clear_object (&data->cancellable);
 	g_free (data->cancellation_id);
+	g_free (data->cache_key);
+	g_free (data->dbus_sender);
 	g_free (data);
 }
 
+/*****************************************************************************/
+
+static void
+_cache_entry_free (gpointer data)
+{
+	CacheEntry *entry = data;
+
+	g_free (entry->dbus_sender);
+	g_slice_free (CacheEntry, entry);
+}
+
+static char *
+_cache_key (NMAuthSubject *subject, const char *action_id)
+{
+	/* The process is identified by pid and start time, like polkit does;
+	 * each of its bus connections gets its own entries.
+	 */
+	return g_strdup_printf ("%s:%lu:%llu:%lu:%s",
+	                        nm_auth_subject_get_unix_process_dbus_sender (subject),
+	                        nm_auth_subject_get_unix_process_pid (subject),
+	                        (long long unsigned) nm_auth_subject_get_unix_process_start_time (subject),
+	                        nm_auth_subject_get_unix_process_uid (subject),
+	                        action_id);
+}
+
+static void
+_cache_clear (NMAuthManager *self)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+
+	/* Results of checks in flight are stale too */
+	priv->cache_generation++;
+
+	if (g_hash_table_size (priv->cache)) {
+		_LOGD ("cache: flush %u entries", g_hash_table_size (priv->cache));
+		g_hash_table_remove_all (priv->cache);
+	}
+}
+
+static void
+_cache_remove_sender (NMAuthManager *self, const char *dbus_sender)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	CacheEntry *entry;
+
+	g_hash_table_iter_init (&iter, priv->cache);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &entry)) {
+		if (g_strcmp0 (entry->dbus_sender, dbus_sender) == 0)
+			g_hash_table_iter_remove (&iter);
+	}
+}
+
+static void
+_cache_prune (NMAuthManager *self, gint64 now)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	CacheEntry *entry;
+
+	g_hash_table_iter_init (&iter, priv->cache);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &entry)) {
+		if (entry->expires_at <= now)
+			g_hash_table_iter_remove (&iter);
+	}
+
+	if (g_hash_table_size (priv->cache) >= CACHE_MAX_ENTRIES)
+		g_hash_table_remove_all (priv->cache);
+}
+
+static const CheckAuthorizationResult *
+_cache_lookup (NMAuthManager *self, const char *key)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	CacheEntry *entry;
+
+	entry = g_hash_table_lookup (priv->cache, key);
+	if (!entry)
+		return NULL;
+	if (entry->expires_at <= g_get_monotonic_time ()) {
+		g_hash_table_remove (priv->cache, key);
+		return NULL;
+	}
+	return &entry->result;
+}
+
+static void
+_cache_add (NMAuthManager *self,
+            CheckAuthData *data,
+            const CheckAuthorizationResult *result)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	CacheEntry *entry;
+	gint64 now;
+
+	/* A challenge depends on the user's answer, don't remember it */
+	if (!data->cache_key || result->is_challenge)
+		return;
+
+	/* Authorizations changed while the check was in flight */
+	if (data->cache_generation != priv->cache_generation)
+		return;
+
+	now = g_get_monotonic_time ();
+	if (g_hash_table_size (priv->cache) >= CACHE_MAX_ENTRIES)
+		_cache_prune (self, now);
+
+	entry = g_slice_new0 (CacheEntry);
+	entry->result = *result;
+	entry->dbus_sender = g_strdup (data->dbus_sender);
+	entry->expires_at = now + CACHE_ENTRY_LIFETIME_MS * 1000;
+	g_hash_table_replace (priv->cache, g_strdup (data->cache_key), entry);
+}
+
 static void
 _call_check_authorization_complete_with_error (CheckAuthData *data,
                                                const char *error_message)
@@ -159,11 +301,6 @@ cancel_check_authorization_cb (GDBusProxy *proxy,
 	g_object_unref (self);
 }
 
-typedef struct {
-	gboolean is_authorized;
-	gboolean is_challenge;
-} CheckAuthorizationResult;
-
 static void
 check_authorization_cb (GDBusProxy *proxy,
                         GAsyncResult *res,
@@ -214,6 +351,7 @@ check_authorization_cb (GDBusProxy *proxy,
 		g_variant_unref (value);
 
 		_LOGD ("call[%u]: CheckAuthorization succeeded: (is_authorized=%d, is_challenge=%d)", data->call_id, result->is_authorized, result->is_challenge);
+		_cache_add (self, data, result);
 		g_simple_async_result_set_op_res_gpointer (data->simple, result, g_free);
 	}
 
@@ -255,6 +393,8 @@ nm_auth_manager_polkit_authority_check_authorization (NMAuthManager *self,
 	GVariant *subject_value;
 	GVariant *details_value;
 	CheckAuthData *data;
+	const CheckAuthorizationResult *cached;
+	char *cache_key = NULL;
 
 	g_return_if_fail (NM_IS_AUTH_MANAGER (self));
 	g_return_if_fail (NM_IS_AUTH_SUBJECT (subject));
@@ -266,6 +406,34 @@ nm_auth_manager_polkit_authority_check_authorization (NMAuthManager *self,
 
 	g_return_if_fail (priv->polkit_enabled);
 
+	/* Subjects without a start time can't be told apart from a later
+	 * process reusing the pid, so they are never cached.  Neither are
+	 * interactive checks: polkit may have authorized them after the user
+	 * authenticated for just this one request.
+	 */
+	if (   !allow_user_interaction
+	    && nm_auth_subject_get_unix_process_start_time (subject))
+		cache_key = _cache_key (subject, action_id);
+
+	cached = cache_key ? _cache_lookup (self, cache_key) : NULL;
+	if (cached) {
+		GSimpleAsyncResult *simple;
+
+		_LOGD ("CheckAuthorization(%s), subject=%s (cached: is_authorized=%d)", action_id, nm_auth_subject_to_string (subject, subject_buf, sizeof (subject_buf)), cached->is_authorized);
+
+		simple = g_simple_async_result_new (G_OBJECT (self),
+		                                    callback,
+		                                    user_data,
+		                                    nm_auth_manager_polkit_authority_check_authorization);
+		g_simple_async_result_set_op_res_gpointer (simple,
+		                                           g_memdup (cached, sizeof (*cached)),
+		                                           g_free);
+		g_simple_async_result_complete_in_idle (simple);
+		g_object_unref (simple);
+		g_free (cache_key);
+		return;
+	}
+
 	flags = allow_user_interaction
 	    ? POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION
 	    : POLKIT_CHECK_AUTHORIZATION_FLAGS_NONE;
@@ -288,6 +456,9 @@ nm_auth_manager_polkit_authority_check_authorization (NMAuthManager *self,
 		data->cancellation_id = g_strdup_printf ("cancellation-id-%u", data->call_id);
 		data->cancellable = g_object_ref (cancellable);
 	}
+	data->cache_key = cache_key;
+	data->dbus_sender = g_strdup (nm_auth_subject_get_unix_process_dbus_sender (subject));
+	data->cache_generation = priv->cache_generation;
 
 	data->dbus_parameters = g_variant_new ("(@(sa{sv})s@a{ss}us)",
 	                                       subject_value,
@@ -348,10 +519,34 @@ nm_auth_manager_polkit_authority_check_authorization_finish (NMAuthManager *self
 static void
 _emit_changed_signal (NMAuthManager *self)
 {
+	_cache_clear (self);
+
 	_LOGD ("emit changed signal");
 	g_signal_emit_by_name (self, NM_AUTH_MANAGER_SIGNAL_CHANGED);
 }
 
+static void
+_dbus_on_name_owner_changed_cb (GDBusConnection *connection,
+                                const gchar *sender_name,
+                                const gchar *object_path,
+                                const gchar *interface_name,
+                                const gchar *signal_name,
+                                GVariant *parameters,
+                                gpointer user_data)
+{
+	NMAuthManager *self = user_data;
+	const char *name, *old_owner, *new_owner;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sss)")))
+		return;
+
+	g_variant_get (parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+
+	/* A unique name went away; its cached results must not be reused */
+	if (name[0] == ':' && !*new_owner)
+		_cache_remove_sender (self, name);
+}
+
 static void
 _log_name_owner (NMAuthManager *self, char **out_name_owner)
 {
@@ -466,6 +661,17 @@ _dbus_new_proxy_cb (GObject *source_object,
 	                  "g-signal",
 	                  G_CALLBACK (_dbus_on_g_signal_cb),
 	                  self);
+	priv->name_owner_changed_id =
+	    g_dbus_connection_signal_subscribe (g_dbus_proxy_get_connection (priv->proxy),
+	                                        "org.freedesktop.DBus",
+	                                        "org.freedesktop.DBus",
+	                                        "NameOwnerChanged",
+	                                        "/org/freedesktop/DBus",
+	                                        NULL,
+	                                        G_DBUS_SIGNAL_FLAGS_NONE,
+	                                        _dbus_on_name_owner_changed_cb,
+	                                        self,
+	                                        NULL);
 
 	_log_name_owner (self, NULL);
 
@@ -541,6 +747,11 @@ set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *p
 static void
 nm_auth_manager_init (NMAuthManager *self)
 {
+#if WITH_POLKIT
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+
+	priv->cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _cache_entry_free);
+#endif
 }
 
 static void
@@ -600,6 +811,11 @@ dispose (GObject *object)
 	}
 
 	if (priv->proxy) {
+		if (priv->name_owner_changed_id) {
+			g_dbus_connection_signal_unsubscribe (g_dbus_proxy_get_connection (priv->proxy),
+			                                      priv->name_owner_changed_id);
+			priv->name_owner_changed_id = 0;
+		}
 		g_signal_handlers_disconnect_by_func (priv->proxy, _dbus_on_name_owner_notify_cb, self);
 		g_signal_handlers_disconnect_by_func (priv->proxy, _dbus_on_g_signal_cb, self);
 		g_clear_object (&priv->proxy);
@@ -613,6 +829,11 @@ static void
 finalize (GObject *object)
 {
 	NMAuthManager* self = NM_AUTH_MANAGER (object);
+#if WITH_POLKIT
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+
+	g_hash_table_destroy (priv->cache);
+#endif
 
 	G_OBJECT_CLASS (nm_auth_manager_parent_class)->finalize (object);
 
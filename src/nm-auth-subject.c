@@ -157,6 +157,14 @@ nm_auth_subject_get_unix_process_uid (NMAuthSubject *subject)
 	return priv->unix_process.uid;
 }
 
+guint64
+nm_auth_subject_get_unix_process_start_time (NMAuthSubject *subject)
+{
+	CHECK_SUBJECT_TYPED (subject, NM_AUTH_SUBJECT_TYPE_UNIX_PROCESS, 0);
+
+	return priv->unix_process.start_time;
+}
+
 const char *
 nm_auth_subject_get_unix_process_dbus_sender (NMAuthSubject *subject)
 {
@@ -198,6 +206,27 @@ _new_unix_process (DBusGMethodInvocation *context,
 	if (!success)
 		return NULL;
 
+	self = nm_auth_subject_new_unix_process (dbus_sender, pid, uid);
+	g_free (dbus_sender);
+	return self;
+}
+
+/**
+ * nm_auth_subject_new_unix_process():
+ * @dbus_sender: the unique bus name of the process
+ * @pid: its process ID
+ * @uid: its user ID
+ *
+ * Creates a new auth subject for a process whose credentials were already
+ * looked up, e.g. with nm_dbus_manager_get_caller_info_async().
+ *
+ * Returns: the new #NMAuthSubject, or %NULL if the process is gone
+ */
+NMAuthSubject *
+nm_auth_subject_new_unix_process (const char *dbus_sender, gulong pid, gulong uid)
+{
+	NMAuthSubject *self;
+
 	g_return_val_if_fail (dbus_sender && *dbus_sender, NULL);
 	/* polkit glib library stores uid and pid as gint. There might be some
 	 * pitfalls if the id ever happens to be larger then that. Just assert against
@@ -59,6 +59,8 @@ GType nm_auth_subject_get_type (void);
 
 NMAuthSubject *nm_auth_subject_new_internal (void);
 
+NMAuthSubject *nm_auth_subject_new_unix_process (const char *dbus_sender, gulong pid, gulong uid);
+
 NMAuthSubject *nm_auth_subject_new_unix_process_from_context (DBusGMethodInvocation *context);
 
 NMAuthSubject *nm_auth_subject_new_unix_process_from_message (DBusConnection *connection, DBusMessage *message);
@@ -79,6 +81,8 @@ const char *nm_auth_subject_get_unix_process_dbus_sender (NMAuthSubject *subject
 
 gulong nm_auth_subject_get_unix_process_uid (NMAuthSubject *subject);
 
+guint64 nm_auth_subject_get_unix_process_start_time (NMAuthSubject *subject);
+
 
 const char *nm_auth_subject_to_string (NMAuthSubject *self, char *buf, gsize buf_len);
 
@@ -41,6 +41,10 @@ struct NMAuthChain {
 	NMAuthSubject *subject;
 	GError *error;
 
+	/* Calls added while the caller's credentials are still being looked up */
+	gboolean subject_pending;
+	GSList *deferred_calls;
+
 	guint idle_id;
 
 	NMAuthChainResultFunc done_func;
@@ -59,6 +63,11 @@ typedef struct {
 	GDestroyNotify destroy;
 } ChainData;
 
+typedef struct {
+	char *permission;
+	gboolean allow_interaction;
+} DeferredCall;
+
 static void
 free_data (gpointer data)
 {
@@ -84,27 +93,93 @@ auth_chain_finish (gpointer user_data)
 	return FALSE;
 }
 
-/* Creates the NMAuthSubject automatically */
+static NMAuthChain *
+auth_chain_new (NMAuthSubject *subject,
+                DBusGMethodInvocation *context,
+                NMAuthChainResultFunc done_func,
+                gpointer user_data)
+{
+	NMAuthChain *self;
+
+	self = g_malloc0 (sizeof (NMAuthChain));
+	self->refcount = 1;
+	self->data = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, free_data);
+	self->done_func = done_func;
+	self->user_data = user_data;
+	self->context = context;
+	if (subject)
+		self->subject = g_object_ref (subject);
+
+	return self;
+}
+
+static void
+caller_info_cb (NMDBusManager *dbus_mgr,
+                const char *sender,
+                gulong uid,
+                gulong pid,
+                gpointer user_data)
+{
+	NMAuthChain *self = user_data;
+	GSList *deferred, *iter;
+
+	self->subject_pending = FALSE;
+	deferred = self->deferred_calls;
+	self->deferred_calls = NULL;
+
+	/* Only our own reference is left if the owner gave up on the chain */
+	if (self->refcount > 1) {
+		if (sender)
+			self->subject = nm_auth_subject_new_unix_process (sender, pid, uid);
+
+		if (self->subject) {
+			for (iter = deferred; iter; iter = iter->next) {
+				DeferredCall *call = iter->data;
+
+				nm_auth_chain_add_call (self, call->permission, call->allow_interaction);
+			}
+		} else {
+			self->error = g_error_new_literal (DBUS_GERROR,
+			                                   DBUS_GERROR_FAILED,
+			                                   "Unable to determine UID of request");
+			self->idle_id = g_idle_add (auth_chain_finish, self);
+		}
+	}
+
+	for (iter = deferred; iter; iter = iter->next) {
+		DeferredCall *call = iter->data;
+
+		g_free (call->permission);
+		g_slice_free (DeferredCall, call);
+	}
+	g_slist_free (deferred);
+
+	nm_auth_chain_unref (self);
+}
+
+/* Looks up the caller's credentials without blocking; calls added before
+ * they are known are started once they are.  If the lookup fails, the
+ * chain finishes with an error.
+ */
 NMAuthChain *
 nm_auth_chain_new_context (DBusGMethodInvocation *context,
                            NMAuthChainResultFunc done_func,
                            gpointer user_data)
 {
-	NMAuthSubject *subject;
-	NMAuthChain *chain;
+	NMAuthChain *self;
 
 	g_return_val_if_fail (context != NULL, NULL);
 
-	subject = nm_auth_subject_new_unix_process_from_context (context);
-	if (!subject)
-		return NULL;
+	self = auth_chain_new (NULL, context, done_func, user_data);
+	self->subject_pending = TRUE;
 
-	chain = nm_auth_chain_new_subject (subject,
-	                                   context,
-	                                   done_func,
-	                                   user_data);
-	g_object_unref (subject);
-	return chain;
+	/* Keep the chain alive until the lookup returns */
+	self->refcount++;
+	nm_dbus_manager_get_caller_info_async (nm_dbus_manager_get (),
+	                                       context,
+	                                       caller_info_cb,
+	                                       self);
+	return self;
 }
 
 /* Requires an NMAuthSubject */
@@ -114,20 +189,10 @@ nm_auth_chain_new_subject (NMAuthSubject *subject,
                            NMAuthChainResultFunc done_func,
                            gpointer user_data)
 {
-	NMAuthChain *self;
-
 	g_return_val_if_fail (NM_IS_AUTH_SUBJECT (subject), NULL);
 	g_return_val_if_fail (nm_auth_subject_is_unix_process (subject) || nm_auth_subject_is_internal (subject), NULL);
 
-	self = g_malloc0 (sizeof (NMAuthChain));
-	self->refcount = 1;
-	self->data = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, free_data);
-	self->done_func = done_func;
-	self->user_data = user_data;
-	self->context = context;
-	self->subject = g_object_ref (subject);
-
-	return self;
+	return auth_chain_new (subject, context, done_func, user_data);
 }
 
 gpointer
@@ -359,6 +424,17 @@ nm_auth_chain_add_call (NMAuthChain *self,
 
 	g_return_if_fail (self != NULL);
 	g_return_if_fail (permission && *permission);
+
+	if (self->subject_pending) {
+		DeferredCall *deferred;
+
+		deferred = g_slice_new (DeferredCall);
+		deferred->permission = g_strdup (permission);
+		deferred->allow_interaction = allow_interaction;
+		self->deferred_calls = g_slist_append (self->deferred_calls, deferred);
+		return;
+	}
+
 	g_return_if_fail (self->subject);
 	g_return_if_fail (nm_auth_subject_is_unix_process (self->subject) || nm_auth_subject_is_internal (self->subject));
 
@@ -404,7 +480,7 @@ nm_auth_chain_unref (NMAuthChain *self)
 	if (self->idle_id)
 		g_source_remove (self->idle_id);
 
-	g_object_unref (self->subject);
+	g_clear_object (&self->subject);
 
 	g_slist_free_full (self->calls, auth_call_cancel);
 
@@ -62,8 +62,10 @@ typedef struct {
 
 	char **no_auto_default;
 	char **ignore_carrier;
+	char **unmanaged_links;
 
 	gboolean configure_and_quit;
+	gboolean trace;
 } NMConfigPrivate;
 
 static NMConfig *singleton = NULL;
@@ -222,6 +224,12 @@ nm_config_get_configure_and_quit (NMConfig *config)
 	return NM_CONFIG_GET_PRIVATE (config)->configure_and_quit;
 }
 
+gboolean
+nm_config_get_trace (NMConfig *config)
+{
+	return NM_CONFIG_GET_PRIVATE (config)->trace;
+}
+
 char *
 nm_config_get_value (NMConfig *config, const char *group, const char *key, GError **error)
 {
@@ -230,6 +238,14 @@ nm_config_get_value (NMConfig *config, const char *group, const char *key, GErro
 	return g_key_file_get_string (priv->keyfile, group, key, error);
 }
 
+const char **
+nm_config_get_unmanaged_links (NMConfig *config)
+{
+	g_return_val_if_fail (config != NULL, NULL);
+
+	return (const char **) NM_CONFIG_GET_PRIVATE (config)->unmanaged_links;
+}
+
 gboolean
 nm_config_get_ignore_carrier (NMConfig *config, NMDevice *device)
 {
@@ -611,9 +627,14 @@ nm_config_new (GError **error)
 	priv->connectivity_response = g_key_file_get_value (priv->keyfile, "connectivity", "response", NULL);
 
 	priv->ignore_carrier = g_key_file_get_string_list (priv->keyfile, "main", "ignore-carrier", NULL, NULL);
+	priv->unmanaged_links = g_key_file_get_string_list (priv->keyfile, "main", "unmanaged-links", NULL, NULL);
 
 	priv->configure_and_quit = _get_bool_value (priv->keyfile, "main", "configure-and-quit", FALSE);
 
+	/* A trace file is no use without a trace */
+	priv->trace =    _get_bool_value (priv->keyfile, "main", "trace", FALSE)
+	              || g_key_file_has_key (priv->keyfile, "main", "trace-file", NULL);
+
 	return singleton;
 }
 
@@ -650,6 +671,7 @@ finalize (GObject *gobject)
 	g_free (priv->connectivity_response);
 	g_strfreev (priv->no_auto_default);
 	g_strfreev (priv->ignore_carrier);
+	g_strfreev (priv->unmanaged_links);
 
 	singleton = NULL;
 
@@ -62,11 +62,13 @@ const char *nm_config_get_connectivity_uri (NMConfig *config);
 guint nm_config_get_connectivity_interval (NMConfig *config);
 const char *nm_config_get_connectivity_response (NMConfig *config);
 gboolean nm_config_get_configure_and_quit (NMConfig *config);
+gboolean nm_config_get_trace (NMConfig *config);
 
 gboolean nm_config_get_ethernet_can_auto_default (NMConfig *config, NMDevice *device);
 void     nm_config_set_ethernet_no_auto_default  (NMConfig *config, NMDevice *device);
 
 gboolean nm_config_get_ignore_carrier (NMConfig *config, NMDevice *device);
+const char **nm_config_get_unmanaged_links (NMConfig *config);
 
 char *nm_config_get_value (NMConfig *config, const char *group, const char *key, GError **error);
 
@@ -36,6 +36,7 @@
 #include <dbus/dbus-glib-lowlevel.h>
 #include <string.h>
 #include "nm-logging.h"
+#include "nm-dbus-glib-types.h"
 
 #define PRIV_SOCK_PATH NMRUNDIR "/private"
 #define PRIV_SOCK_TAG  "private"
@@ -45,6 +46,8 @@ enum {
 	NAME_OWNER_CHANGED,
 	PRIVATE_CONNECTION_NEW,
 	PRIVATE_CONNECTION_DISCONNECTED,
+	INTERFACES_ADDED,
+	INTERFACES_REMOVED,
 	NUMBER_OF_SIGNALS
 };
 
@@ -62,6 +65,7 @@ typedef struct {
 	DBusConnection *connection;
 	DBusGConnection *g_connection;
 	GHashTable *exported;
+	GHashTable *exported_properties;   /* GType -> GArray of ExportedProperty */
 	gboolean started;
 
 	GSList *private_servers;
@@ -70,6 +74,10 @@ typedef struct {
 	DBusGProxy *proxy;
 	guint proxy_destroy_id;
 
+	GHashTable *caller_info;           /* unique bus name -> CallerInfo */
+	GHashTable *caller_info_lookups;   /* unique bus name -> CallerInfoLookup */
+	gboolean no_connection_credentials;
+
 	guint reconnect_id;
 } NMDBusManagerPrivate;
 
@@ -78,6 +86,12 @@ static void nm_dbus_manager_cleanup (NMDBusManager *self, gboolean dispose);
 static void start_reconnection_timeout (NMDBusManager *self);
 static void object_destroyed (NMDBusManager *self, gpointer object);
 
+static gboolean impl_dbus_manager_get_managed_objects (NMDBusManager *self,
+                                                       GHashTable **objects,
+                                                       GError **error);
+
+#include "nm-object-manager-glue.h"
+
 NMDBusManager *
 nm_dbus_manager_get (void)
 {
@@ -89,6 +103,7 @@ nm_dbus_manager_get (void)
 		g_assert (singleton);
 		if (!nm_dbus_manager_init_bus (singleton))
 			start_reconnection_timeout (singleton);
+		nm_dbus_manager_register_object (singleton, NM_DBUS_PATH_OBJECT_MANAGER, singleton);
 		g_once_init_leave (&once, 1);
 	}
 	return singleton;
@@ -271,6 +286,15 @@ private_server_get_connection_owner (PrivateServer *s, DBusGConnection *connecti
 
 /**************************************************************/
 
+/* Credentials of bus clients, by unique name.  Unique names are never
+ * reused, so an entry stays valid until NameOwnerChanged says the client
+ * left the bus.
+ */
+typedef struct {
+	gulong uid;
+	gulong pid;    /* G_MAXULONG if unknown */
+} CallerInfo;
+
 static gboolean
 _bus_get_unix_pid (NMDBusManager *self,
                    const char *sender,
@@ -292,6 +316,96 @@ _bus_get_unix_pid (NMDBusManager *self,
 	return TRUE;
 }
 
+static gboolean
+_caller_info_from_credentials (GHashTable *creds, CallerInfo *info)
+{
+	GValue *value;
+
+	value = g_hash_table_lookup (creds, "UnixUserID");
+	info->uid = (value && G_VALUE_HOLDS_UINT (value)) ? g_value_get_uint (value) : G_MAXULONG;
+	value = g_hash_table_lookup (creds, "ProcessID");
+	info->pid = (value && G_VALUE_HOLDS_UINT (value)) ? g_value_get_uint (value) : G_MAXULONG;
+	return info->uid != G_MAXULONG;
+}
+
+/* Asks the bus for the UID and PID of @sender in one round trip.  Bus
+ * daemons older than 1.7.2 lack GetConnectionCredentials; with those, fall
+ * back to asking separately.
+ */
+static gboolean
+_bus_get_credentials (NMDBusManager *self,
+                      const char *sender,
+                      CallerInfo *info)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	GHashTable *creds = NULL;
+	GError *error = NULL;
+	DBusError derror;
+	gboolean success;
+
+	if (!priv->proxy)
+		return FALSE;
+
+	if (!priv->no_connection_credentials) {
+		if (dbus_g_proxy_call_with_timeout (priv->proxy,
+		                                    "GetConnectionCredentials", 2000, &error,
+		                                    G_TYPE_STRING, sender,
+		                                    G_TYPE_INVALID,
+		                                    DBUS_TYPE_G_MAP_OF_VARIANT, &creds,
+		                                    G_TYPE_INVALID)) {
+			success = _caller_info_from_credentials (creds, info);
+			g_hash_table_unref (creds);
+			return success;
+		}
+
+		if (!g_error_matches (error, DBUS_GERROR, DBUS_GERROR_UNKNOWN_METHOD)) {
+			g_error_free (error);
+			return FALSE;
+		}
+		g_clear_error (&error);
+		nm_log_dbg (LOGD_CORE, "bus has no GetConnectionCredentials; asking for UID and PID separately");
+		priv->no_connection_credentials = TRUE;
+	}
+
+	dbus_error_init (&derror);
+	info->uid = dbus_bus_get_unix_user (priv->connection, sender, &derror);
+	if (dbus_error_is_set (&derror)) {
+		dbus_error_free (&derror);
+		return FALSE;
+	}
+
+	if (!_bus_get_unix_pid (self, sender, &info->pid, NULL))
+		info->pid = G_MAXULONG;
+	return TRUE;
+}
+
+static gboolean
+_bus_get_caller_info (NMDBusManager *self, const char *sender, CallerInfo *out_info)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	CallerInfo *info;
+
+	info = g_hash_table_lookup (priv->caller_info, sender);
+	if (info) {
+		*out_info = *info;
+		return TRUE;
+	}
+
+	if (!_bus_get_credentials (self, sender, out_info))
+		return FALSE;
+
+	/* A missing PID might be a timeout; ask again next time */
+	if (out_info->pid != G_MAXULONG)
+		g_hash_table_insert (priv->caller_info, g_strdup (sender), g_slice_dup (CallerInfo, out_info));
+	return TRUE;
+}
+
+static void
+caller_info_free (gpointer data)
+{
+	g_slice_free (CallerInfo, data);
+}
+
 /**
  * _get_caller_info_from_context():
  *
@@ -311,7 +425,7 @@ _get_caller_info (NMDBusManager *self,
 	DBusGConnection *gconn;
 	char *sender;
 	const char *priv_sender;
-	DBusError error;
+	CallerInfo info;
 	GSList *iter;
 
 	if (context) {
@@ -350,23 +464,20 @@ _get_caller_info (NMDBusManager *self,
 
 	/* Bus connections always have a sender */
 	g_assert (sender);
-	if (out_uid) {
-		dbus_error_init (&error);
-		*out_uid = dbus_bus_get_unix_user (connection, sender, &error);
-		if (dbus_error_is_set (&error)) {
-			dbus_error_free (&error);
-			*out_uid = G_MAXULONG;
-			g_free (sender);
-			return FALSE;
-		}
-	}
-
-	if (out_pid) {
-		if (!_bus_get_unix_pid (self, sender, out_pid, NULL)) {
-			*out_pid = G_MAXULONG;
+	if (out_uid || out_pid) {
+		if (   !_bus_get_caller_info (self, sender, &info)
+		    || (out_pid && info.pid == G_MAXULONG)) {
+			if (out_uid)
+				*out_uid = G_MAXULONG;
+			if (out_pid)
+				*out_pid = G_MAXULONG;
 			g_free (sender);
 			return FALSE;
 		}
+		if (out_uid)
+			*out_uid = info.uid;
+		if (out_pid)
+			*out_pid = info.pid;
 	}
 
 	if (out_sender)
@@ -397,14 +508,163 @@ nm_dbus_manager_get_caller_info_from_message (NMDBusManager *self,
 	return _get_caller_info (self, NULL, connection, message, out_sender, out_uid, out_pid);
 }
 
+/* An asynchronous GetConnectionCredentials call; concurrent requests for
+ * the same sender share it.
+ */
+typedef struct {
+	NMDBusManagerCallerInfoFunc callback;
+	gpointer user_data;
+} CallerInfoWaiter;
+
+typedef struct {
+	NMDBusManager *self;
+	char *sender;
+	GSList *waiters;
+	gboolean gone;    /* the sender left the bus meanwhile */
+	gboolean done;
+} CallerInfoLookup;
+
+static void
+caller_info_lookup_complete (CallerInfoLookup *lookup, const CallerInfo *info)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (lookup->self);
+	GSList *waiters, *iter;
+
+	lookup->done = TRUE;
+	if (   priv->caller_info_lookups
+	    && g_hash_table_lookup (priv->caller_info_lookups, lookup->sender) == lookup)
+		g_hash_table_remove (priv->caller_info_lookups, lookup->sender);
+
+	waiters = lookup->waiters;
+	lookup->waiters = NULL;
+	for (iter = waiters; iter; iter = iter->next) {
+		CallerInfoWaiter *waiter = iter->data;
+
+		if (info)
+			waiter->callback (lookup->self, lookup->sender, info->uid, info->pid, waiter->user_data);
+		else
+			waiter->callback (lookup->self, NULL, G_MAXULONG, G_MAXULONG, waiter->user_data);
+		g_slice_free (CallerInfoWaiter, waiter);
+	}
+	g_slist_free (waiters);
+}
+
+static void
+caller_info_lookup_free (gpointer data)
+{
+	CallerInfoLookup *lookup = data;
+
+	/* The call was dropped without a reply, e.g. because the bus went away */
+	if (!lookup->done)
+		caller_info_lookup_complete (lookup, NULL);
+
+	g_free (lookup->sender);
+	g_slice_free (CallerInfoLookup, lookup);
+}
+
+static void
+caller_info_lookup_cb (DBusGProxy *proxy, DBusGProxyCall *call, gpointer user_data)
+{
+	CallerInfoLookup *lookup = user_data;
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (lookup->self);
+	GHashTable *creds = NULL;
+	GError *error = NULL;
+	CallerInfo info;
+	gboolean success;
+
+	if (dbus_g_proxy_end_call (proxy, call, &error,
+	                           DBUS_TYPE_G_MAP_OF_VARIANT, &creds,
+	                           G_TYPE_INVALID)) {
+		success = _caller_info_from_credentials (creds, &info);
+		g_hash_table_unref (creds);
+	} else if (g_error_matches (error, DBUS_GERROR, DBUS_GERROR_UNKNOWN_METHOD)) {
+		/* Old bus daemon; only the synchronous fallback is left */
+		nm_log_dbg (LOGD_CORE, "bus has no GetConnectionCredentials; asking for UID and PID separately");
+		priv->no_connection_credentials = TRUE;
+		success = _bus_get_credentials (lookup->self, lookup->sender, &info);
+	} else
+		success = FALSE;
+	g_clear_error (&error);
+
+	if (success && info.pid == G_MAXULONG)
+		success = FALSE;
+	if (success && !lookup->gone)
+		g_hash_table_insert (priv->caller_info, g_strdup (lookup->sender), g_slice_dup (CallerInfo, &info));
+
+	caller_info_lookup_complete (lookup, success ? &info : NULL);
+}
+
+/**
+ * nm_dbus_manager_get_caller_info_async:
+ * @self: the #NMDBusManager
+ * @context: the method invocation of the caller
+ * @callback: called with the sender, UID and PID of the caller, or with a
+ *   %NULL sender if they could not be determined
+ * @user_data: data for @callback
+ *
+ * Like nm_dbus_manager_get_caller_info(), but doesn't block on the bus
+ * daemon.  Callers on private connections and callers whose credentials
+ * are already known are answered before this function returns.
+ */
+void
+nm_dbus_manager_get_caller_info_async (NMDBusManager *self,
+                                       DBusGMethodInvocation *context,
+                                       NMDBusManagerCallerInfoFunc callback,
+                                       gpointer user_data)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	CallerInfoLookup *lookup;
+	CallerInfoWaiter *waiter;
+	char *sender;
+	gulong uid, pid;
+
+	g_return_if_fail (context != NULL);
+	g_return_if_fail (callback != NULL);
+
+	sender = dbus_g_method_get_sender (context);
+	if (   !sender
+	    || !priv->proxy
+	    || priv->no_connection_credentials
+	    || g_hash_table_lookup (priv->caller_info, sender)) {
+		g_free (sender);
+		if (nm_dbus_manager_get_caller_info (self, context, &sender, &uid, &pid))
+			callback (self, sender, uid, pid, user_data);
+		else
+			callback (self, NULL, G_MAXULONG, G_MAXULONG, user_data);
+		g_free (sender);
+		return;
+	}
+
+	waiter = g_slice_new (CallerInfoWaiter);
+	waiter->callback = callback;
+	waiter->user_data = user_data;
+
+	lookup = g_hash_table_lookup (priv->caller_info_lookups, sender);
+	if (!lookup) {
+		lookup = g_slice_new0 (CallerInfoLookup);
+		lookup->self = self;
+		lookup->sender = g_strdup (sender);
+		g_hash_table_insert (priv->caller_info_lookups, lookup->sender, lookup);
+
+		dbus_g_proxy_begin_call_with_timeout (priv->proxy, "GetConnectionCredentials",
+		                                      caller_info_lookup_cb,
+		                                      lookup, caller_info_lookup_free,
+		                                      2000,
+		                                      G_TYPE_STRING, sender,
+		                                      G_TYPE_INVALID);
+	}
+	lookup->waiters = g_slist_append (lookup->waiters, waiter);
+	g_free (sender);
+}
+
 gboolean
 nm_dbus_manager_get_unix_user (NMDBusManager *self,
                                const char *sender,
                                gulong *out_uid)
 {
 	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	CallerInfo info;
 	GSList *iter;
-	DBusError error;
 
 	g_return_val_if_fail (sender != NULL, FALSE);
 	g_return_val_if_fail (out_uid != NULL, FALSE);
@@ -425,14 +685,12 @@ nm_dbus_manager_get_unix_user (NMDBusManager *self,
 	}
 
 	/* Otherwise, a bus connection */
-	dbus_error_init (&error);
-	*out_uid = dbus_bus_get_unix_user (priv->connection, sender, &error);
-	if (dbus_error_is_set (&error)) {
-		nm_log_warn (LOGD_CORE, "Failed to get unix user for dbus sender '%s': %s",
-		             sender, error.message);
+	if (!_bus_get_caller_info (self, sender, &info)) {
+		nm_log_warn (LOGD_CORE, "Failed to get unix user for dbus sender '%s'", sender);
 		return FALSE;
 	}
 
+	*out_uid = info.uid;
 	return TRUE;
 }
 
@@ -506,6 +764,10 @@ nm_dbus_manager_init (NMDBusManager *self)
 	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 
 	priv->exported = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+	priv->exported_properties = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                                   NULL, (GDestroyNotify) g_array_unref);
+	priv->caller_info = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, caller_info_free);
+	priv->caller_info_lookups = g_hash_table_new (g_str_hash, g_str_equal);
 
 #if HAVE_DBUS_GLIB_100
 	private_server_setup (self);
@@ -535,6 +797,21 @@ nm_dbus_manager_dispose (GObject *object)
 
 	nm_dbus_manager_cleanup (self, TRUE);
 
+	if (priv->caller_info) {
+		g_hash_table_destroy (priv->caller_info);
+		priv->caller_info = NULL;
+	}
+
+	if (priv->caller_info_lookups) {
+		g_hash_table_destroy (priv->caller_info_lookups);
+		priv->caller_info_lookups = NULL;
+	}
+
+	if (priv->exported_properties) {
+		g_hash_table_destroy (priv->exported_properties);
+		priv->exported_properties = NULL;
+	}
+
 	if (priv->reconnect_id) {
 		g_source_remove (priv->reconnect_id);
 		priv->reconnect_id = 0;
@@ -583,6 +860,24 @@ nm_dbus_manager_class_init (NMDBusManagerClass *klass)
 		              G_STRUCT_OFFSET (NMDBusManagerClass, private_connection_disconnected),
 		              NULL, NULL, NULL,
 		              G_TYPE_NONE, 1, G_TYPE_POINTER);
+
+	/* org.freedesktop.DBus.ObjectManager signals */
+	signals[INTERFACES_ADDED] =
+		g_signal_new ("interfaces-added",
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_LAST,
+		              0, NULL, NULL, NULL,
+		              G_TYPE_NONE, 2, DBUS_TYPE_G_OBJECT_PATH, DBUS_TYPE_G_MAP_OF_MAP_OF_VARIANT);
+
+	signals[INTERFACES_REMOVED] =
+		g_signal_new ("interfaces-removed",
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_LAST,
+		              0, NULL, NULL, NULL,
+		              G_TYPE_NONE, 2, DBUS_TYPE_G_OBJECT_PATH, G_TYPE_STRV);
+
+	dbus_g_object_type_install_info (G_TYPE_FROM_CLASS (klass),
+	                                 &dbus_glib_nm_object_manager_object_info);
 }
 
 
@@ -607,6 +902,10 @@ nm_dbus_manager_cleanup (NMDBusManager *self, gboolean dispose)
 		priv->connection = NULL;
 	}
 
+	/* A new bus means new clients */
+	if (priv->caller_info)
+		g_hash_table_remove_all (priv->caller_info);
+
 	priv->started = FALSE;
 }
 
@@ -706,6 +1005,22 @@ proxy_name_owner_changed (DBusGProxy *proxy,
 					 const char *new_owner,
 					 gpointer user_data)
 {
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (user_data);
+
+	/* A client left the bus */
+	if (name[0] == ':' && (!new_owner || !new_owner[0])) {
+		CallerInfoLookup *lookup;
+
+		g_hash_table_remove (priv->caller_info, name);
+
+		/* Don't cache what an outstanding lookup returns for it */
+		lookup = g_hash_table_lookup (priv->caller_info_lookups, name);
+		if (lookup) {
+			lookup->gone = TRUE;
+			g_hash_table_remove (priv->caller_info_lookups, name);
+		}
+	}
+
 	g_signal_emit (G_OBJECT (user_data), signals[NAME_OWNER_CHANGED],
 	               0, name, old_owner, new_owner);
 }
@@ -832,10 +1147,168 @@ nm_dbus_manager_get_connection (NMDBusManager *self)
 	return NM_DBUS_MANAGER_GET_PRIVATE (self)->g_connection;
 }
 
+
+/**************************************************************/
+/* org.freedesktop.DBus.ObjectManager */
+
+typedef struct {
+	const char *interface;
+	const char *dbus_name;
+	const char *gobject_name;
+} ExportedProperty;
+
+static void
+gvalue_destroy (gpointer data)
+{
+	GValue *value = data;
+
+	g_value_unset (value);
+	g_slice_free (GValue, value);
+}
+
+/* Returns a hash of interface name -> (property name -> GValue) for
+ * everything @object exports through a type registered with
+ * nm_dbus_manager_register_exported_type(); the same values a GetAll
+ * call on each interface would return.
+ */
+static GHashTable *
+get_object_interfaces (NMDBusManager *self, GObject *object)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	GHashTable *interfaces, *properties;
+	GObjectClass *object_class = G_OBJECT_GET_CLASS (object);
+	GType type;
+	GArray *exported;
+	guint i;
+
+	interfaces = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                    NULL, (GDestroyNotify) g_hash_table_destroy);
+
+	for (type = G_OBJECT_TYPE (object); type != G_TYPE_OBJECT; type = g_type_parent (type)) {
+		exported = g_hash_table_lookup (priv->exported_properties, GSIZE_TO_POINTER (type));
+		if (!exported)
+			continue;
+
+		for (i = 0; i < exported->len; i++) {
+			ExportedProperty *prop = &g_array_index (exported, ExportedProperty, i);
+			GParamSpec *pspec;
+			GValue *value;
+
+			properties = g_hash_table_lookup (interfaces, prop->interface);
+			if (!properties) {
+				properties = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, gvalue_destroy);
+				g_hash_table_insert (interfaces, (char *) prop->interface, properties);
+			}
+
+			pspec = g_object_class_find_property (object_class, prop->gobject_name);
+			if (!pspec || !(pspec->flags & G_PARAM_READABLE))
+				continue;
+
+			value = g_slice_new0 (GValue);
+			g_value_init (value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+			g_object_get_property (object, prop->gobject_name, value);
+			g_hash_table_insert (properties, (char *) prop->dbus_name, value);
+		}
+	}
+
+	return interfaces;
+}
+
+static gboolean
+impl_dbus_manager_get_managed_objects (NMDBusManager *self,
+                                       GHashTable **objects,
+                                       GError **error)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	GObject *object;
+	const char *path;
+
+	*objects = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                  g_free, (GDestroyNotify) g_hash_table_destroy);
+
+	g_hash_table_iter_init (&iter, priv->exported);
+	while (g_hash_table_iter_next (&iter, (gpointer) &object, (gpointer) &path)) {
+		if (object == (GObject *) self)
+			continue;
+		g_hash_table_insert (*objects, g_strdup (path), get_object_interfaces (self, object));
+	}
+
+	return TRUE;
+}
+
+/* Nobody can be listening for ObjectManager signals before there is a
+ * connection to send them on; objects exported until then are part of
+ * the first GetManagedObjects reply anyway.
+ */
+static gboolean
+has_listeners (NMDBusManager *self)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	return    priv->g_connection
+	       || (priv->priv_server && g_hash_table_size (priv->priv_server->connections));
+}
+
+static void
+emit_interfaces_added (NMDBusManager *self, const char *path, GObject *object)
+{
+	GHashTable *interfaces;
+
+	if (object == (GObject *) self || !has_listeners (self))
+		return;
+
+	interfaces = get_object_interfaces (self, object);
+	g_signal_emit (self, signals[INTERFACES_ADDED], 0, path, interfaces);
+	g_hash_table_destroy (interfaces);
+}
+
+static void
+emit_interfaces_removed (NMDBusManager *self, const char *path, GObject *object)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	GPtrArray *names;
+	GType type;
+	GArray *exported;
+	guint i;
+
+	if (object == (GObject *) self || !has_listeners (self))
+		return;
+
+	names = g_ptr_array_new ();
+	for (type = G_OBJECT_TYPE (object); type != G_TYPE_OBJECT; type = g_type_parent (type)) {
+		exported = g_hash_table_lookup (priv->exported_properties, GSIZE_TO_POINTER (type));
+		for (i = 0; exported && i < exported->len; i++) {
+			const char *interface = g_array_index (exported, ExportedProperty, i).interface;
+			guint j;
+
+			for (j = 0; j < names->len; j++) {
+				if (!strcmp (names->pdata[j], interface))
+					break;
+			}
+			if (j == names->len)
+				g_ptr_array_add (names, (char *) interface);
+		}
+	}
+	g_ptr_array_add (names, NULL);
+
+	g_signal_emit (self, signals[INTERFACES_REMOVED], 0, path, names->pdata);
+	g_ptr_array_free (names, TRUE);
+}
+
+/**************************************************************/
+
 static void
 object_destroyed (NMDBusManager *self, gpointer object)
 {
-	g_hash_table_remove (NM_DBUS_MANAGER_GET_PRIVATE (self)->exported, object);
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	const char *path;
+
+	path = g_hash_table_lookup (priv->exported, object);
+	if (path)
+		emit_interfaces_removed (self, path, object);
+
+	g_hash_table_remove (priv->exported, object);
 }
 
 void
@@ -843,15 +1316,21 @@ nm_dbus_manager_register_exported_type (NMDBusManager         *self,
                                         GType                  object_type,
                                         const DBusGObjectInfo *info)
 {
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 	const char *properties_info, *dbus_name, *gobject_name, *tmp_access;
+	ExportedProperty prop;
+	GArray *exported;
 
 	dbus_g_object_type_install_info (object_type, info);
 	if (!info->exported_properties)
 		return;
 
+	exported = g_array_new (FALSE, FALSE, sizeof (ExportedProperty));
+
 	properties_info = info->exported_properties;
 	while (*properties_info) {
 		/* The format is: "interface\0DBusPropertyName\0gobject_property_name\0access\0" */
+		prop.interface = properties_info;
 		dbus_name = strchr (properties_info, '\0') + 1;
 		gobject_name = strchr (dbus_name, '\0') + 1;
 		tmp_access = strchr (gobject_name, '\0') + 1;
@@ -862,7 +1341,16 @@ nm_dbus_manager_register_exported_type (NMDBusManager         *self,
 		 * ever be freed.
 		 */
 		nm_properties_changed_signal_add_property (object_type, dbus_name, gobject_name);
+
+		/* ... and so does GetManagedObjects */
+		if (strstr (tmp_access, "read")) {
+			prop.dbus_name = dbus_name;
+			prop.gobject_name = gobject_name;
+			g_array_append_val (exported, prop);
+		}
 	}
+
+	g_hash_table_insert (priv->exported_properties, GSIZE_TO_POINTER (object_type), exported);
 }
 
 void
@@ -892,6 +1380,8 @@ nm_dbus_manager_register_object (NMDBusManager *self,
 	}
 
 	g_object_weak_ref (G_OBJECT (object), (GWeakNotify) object_destroyed, self);
+
+	emit_interfaces_added (self, path, G_OBJECT (object));
 }
 
 void
@@ -900,9 +1390,14 @@ nm_dbus_manager_unregister_object (NMDBusManager *self, gpointer object)
 	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 	GHashTableIter iter;
 	DBusConnection *connection;
+	const char *path;
 
 	g_assert (G_IS_OBJECT (object));
 
+	path = g_hash_table_lookup (priv->exported, G_OBJECT (object));
+	if (path)
+		emit_interfaces_removed (self, path, G_OBJECT (object));
+
 	g_hash_table_remove (NM_DBUS_MANAGER_GET_PRIVATE (self)->exported, G_OBJECT (object));
 	g_object_weak_unref (G_OBJECT (object), (GWeakNotify) object_destroyed, self);
 
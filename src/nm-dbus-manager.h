@@ -92,6 +92,17 @@ gboolean nm_dbus_manager_get_caller_info (NMDBusManager *self,
                                           gulong *out_uid,
                                           gulong *out_pid);
 
+typedef void (*NMDBusManagerCallerInfoFunc) (NMDBusManager *self,
+                                             const char *sender,
+                                             gulong uid,
+                                             gulong pid,
+                                             gpointer user_data);
+
+void nm_dbus_manager_get_caller_info_async (NMDBusManager *self,
+                                            DBusGMethodInvocation *context,
+                                            NMDBusManagerCallerInfoFunc callback,
+                                            gpointer user_data);
+
 gboolean nm_dbus_manager_get_unix_user (NMDBusManager *self,
                                         const char *sender,
                                         gulong *out_uid);
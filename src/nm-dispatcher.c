@@ -37,6 +37,7 @@
 #include "nm-dhcp6-config.h"
 #include "nm-dbus-glib-types.h"
 #include "nm-glib-compat.h"
+#include "nm-trace.h"
 
 #define CALL_TIMEOUT (1000 * 60 * 10)  /* 10 minutes for all scripts */
 
@@ -182,6 +183,7 @@ typedef struct {
 	DispatcherFunc callback;
 	gpointer user_data;
 	guint idle_id;
+	const char *iface;    /* interned */
 } DispatchInfo;
 
 static void
@@ -239,7 +241,8 @@ validate_element (guint request_id, GValue *val, GType expected_type, guint idx,
 }
 
 static void
-dispatcher_results_process (guint request_id, DispatcherAction action, GPtrArray *results)
+dispatcher_results_process (guint request_id, DispatcherAction action,
+                            const char *iface, GPtrArray *results)
 {
 	guint i;
 	const Monitor *monitor = _get_monitor_by_action (action);
@@ -258,6 +261,7 @@ dispatcher_results_process (guint request_id, DispatcherAction action, GPtrArray
 		const char *script, *err;
 		DispatchResult result;
 		const char *script_validation_msg = "";
+		char *trace_name;
 
 		if (item->n_values != 3) {
 			nm_log_dbg (LOGD_DISPATCH, "(%u) unexpected number of items in "
@@ -296,6 +300,11 @@ dispatcher_results_process (guint request_id, DispatcherAction action, GPtrArray
 			continue;
 		err = g_value_get_string (tmp);
 
+		if (nm_trace_enabled ()) {
+			trace_name = g_strdup_printf ("%s %s", script, dispatch_result_to_string (result));
+			nm_trace_instant (NM_TRACE_CAT_DISPATCHER, iface, trace_name);
+			g_free (trace_name);
+		}
 
 		if (result == DISPATCH_RESULT_SUCCESS) {
 			nm_log_dbg (LOGD_DISPATCH, "(%u) %s succeeded%s",
@@ -319,6 +328,8 @@ free_results (GPtrArray *results)
 	g_ptr_array_free (results, TRUE);
 }
 
+static const char *action_to_string (DispatcherAction action);
+
 static void
 dispatcher_done_cb (DBusGProxy *proxy, DBusGProxyCall *call, gpointer user_data)
 {
@@ -329,7 +340,7 @@ dispatcher_done_cb (DBusGProxy *proxy, DBusGProxyCall *call, gpointer user_data)
 	if (dbus_g_proxy_end_call (proxy, call, &error,
 	                           DISPATCHER_TYPE_RESULT_ARRAY, &results,
 	                           G_TYPE_INVALID)) {
-		dispatcher_results_process (info->request_id, info->action, results);
+		dispatcher_results_process (info->request_id, info->action, info->iface, results);
 		free_results (results);
 	} else {
 		g_assert (error);
@@ -347,6 +358,8 @@ dispatcher_done_cb (DBusGProxy *proxy, DBusGProxyCall *call, gpointer user_data)
 		}
 	}
 
+	nm_trace_end (NM_TRACE_CAT_DISPATCHER, info->iface, action_to_string (info->action));
+
 	if (info->callback)
 		info->callback (info->request_id, info->user_data);
 
@@ -415,6 +428,7 @@ _dispatcher_call (DispatcherAction action,
 	GError *error = NULL;
 	static guint request_counter = 0;
 	guint reqid = ++request_counter;
+	const char *iface = NULL;
 
 	/* Wrapping protection */
 	if (G_UNLIKELY (!reqid))
@@ -434,6 +448,7 @@ _dispatcher_call (DispatcherAction action,
 	} else {
 		g_return_val_if_fail (NM_IS_DEVICE (device), FALSE);
 
+		iface = g_intern_string (vpn_iface ? vpn_iface : nm_device_get_iface (device));
 		nm_log_dbg (LOGD_DISPATCH, "(%u) (%s) dispatching action '%s'%s",
 		            reqid,
 		            vpn_iface ? vpn_iface : nm_device_get_iface (device),
@@ -509,6 +524,7 @@ _dispatcher_call (DispatcherAction action,
 	}
 
 	/* Send the action to the dispatcher */
+	nm_trace_begin (NM_TRACE_CAT_DISPATCHER, iface, action_to_string (action));
 	if (blocking) {
 		GPtrArray *results = NULL;
 
@@ -531,18 +547,20 @@ _dispatcher_call (DispatcherAction action,
 		                                          DISPATCHER_TYPE_RESULT_ARRAY, &results,
 		                                          G_TYPE_INVALID);
 		if (success) {
-			dispatcher_results_process (reqid, action, results);
+			dispatcher_results_process (reqid, action, iface, results);
 			free_results (results);
 		} else {
 			nm_log_warn (LOGD_DISPATCH, "(%u) failed: (%d) %s", reqid, error->code, error->message);
 			g_error_free (error);
 		}
+		nm_trace_end (NM_TRACE_CAT_DISPATCHER, iface, action_to_string (action));
 	} else {
 		info = g_malloc0 (sizeof (*info));
 		info->action = action;
 		info->request_id = reqid;
 		info->callback = callback;
 		info->user_data = user_data;
+		info->iface = iface;
 		dbus_g_proxy_begin_call_with_timeout (proxy, "Action",
 		                                      dispatcher_done_cb,
 		                                      info,
@@ -60,6 +60,8 @@
 #include "nm-activation-request.h"
 #include "nm-core-internal.h"
 #include "nm-config.h"
+#include "nm-trace.h"
+#include "nm-properties-changed-signal.h"
 
 #define NM_AUTOIP_DBUS_SERVICE "org.freedesktop.nm_avahi_autoipd"
 #define NM_AUTOIP_DBUS_IFACE   "org.freedesktop.nm_avahi_autoipd"
@@ -113,6 +115,15 @@ static void impl_manager_get_logging (NMManager *manager,
                                       char **level,
                                       char **domains);
 
+static void impl_manager_get_trace (NMManager *manager,
+                                    char **trace);
+
+static void impl_manager_get_properties_changed_stats (NMManager *manager,
+                                                       guint64 *signals_sent,
+                                                       guint64 *signals_suppressed,
+                                                       guint64 *values_suppressed,
+                                                       guint64 *throttled);
+
 static void impl_manager_check_connectivity (NMManager *manager,
                                              DBusGMethodInvocation *context);
 
@@ -131,6 +142,12 @@ static void policy_activating_device_changed (GObject *object, GParamSpec *pspec
 
 static NMDevice *find_device_by_ip_iface (NMManager *self, const gchar *iface);
 
+static void unmanaged_links_recheck (NMManager *self, NMConnection *connection);
+
+static void load_deferred_device_factories (NMManager *self,
+                                           NMLinkType link_type,
+                                           const char *setting_type);
+
 static void rfkill_change (const char *desc, RfKillType rtype, gboolean enabled);
 
 static gboolean find_master (NMManager *self,
@@ -157,6 +174,17 @@ typedef struct {
 	const char *hw_prop;
 } RadioState;
 
+/* Device lookup indexes, see device_index_update() */
+typedef enum {
+	DEVICE_INDEX_IFINDEX,
+	DEVICE_INDEX_UDI,
+	DEVICE_INDEX_PATH,
+	DEVICE_INDEX_IFACE,
+	DEVICE_INDEX_IP_IFACE,
+	DEVICE_INDEX_HW_ADDRESS,
+	DEVICE_INDEX_LAST
+} DeviceIndex;
+
 typedef struct {
 	char *state_file;
 
@@ -166,6 +194,9 @@ typedef struct {
 	NMActiveConnection *activating_connection;
 
 	GSList *devices;
+	GHashTable *device_index[DEVICE_INDEX_LAST];
+	GHashTable *device_keys;
+	GHashTable *unmanaged_links;       /* ifindex -> UnmanagedLink */
 	NMState state;
 	NMConnectivity *connectivity;
 
@@ -179,6 +210,8 @@ typedef struct {
 
 	/* List of NMDeviceFactoryFunc pointers sorted in priority order */
 	GSList *factories;
+	GSList *deferred_factories;
+	gboolean factories_started;
 
 	NMSettings *settings;
 	char *hostname;
@@ -463,47 +496,205 @@ active_connection_get_by_path (NMManager *manager, const char *path)
 
 /************************************************************************/
 
-static NMDevice *
-nm_manager_get_device_by_udi (NMManager *manager, const char *udi)
+/* Lookups by ifindex, UDI, D-Bus path, interface name and hardware address
+ * happen for every platform and udev event, so they use hash tables instead
+ * of walking priv->devices.  Each table maps a key to the devices having it,
+ * in the order they were indexed, so the first one is what walking the list
+ * would have found.  priv->device_keys remembers the keys each device was
+ * indexed under, to drop them again when the device changes or goes away.
+ */
+
+typedef struct {
+	/* GINT_TO_POINTER() for DEVICE_INDEX_IFINDEX, strings otherwise */
+	gpointer keys[DEVICE_INDEX_LAST];
+} DeviceKeys;
+
+static void
+device_keys_free (DeviceKeys *keys)
 {
-	GSList *iter;
+	guint i;
 
-	g_return_val_if_fail (udi != NULL, NULL);
+	for (i = DEVICE_INDEX_IFINDEX + 1; i < DEVICE_INDEX_LAST; i++)
+		g_free (keys->keys[i]);
+	g_slice_free (DeviceKeys, keys);
+}
+
+/* Hardware addresses are indexed in canonical form so that the lookup
+ * matches like nm_utils_hwaddr_matches(), which only compares the last
+ * 8 bytes of InfiniBand addresses.
+ */
+static char *
+hwaddr_index_key (const char *hwaddr)
+{
+	char *key, *tmp;
+
+	if (!hwaddr)
+		return NULL;
 
-	for (iter = NM_MANAGER_GET_PRIVATE (manager)->devices; iter; iter = iter->next) {
-		if (!strcmp (nm_device_get_udi (NM_DEVICE (iter->data)), udi))
-			return NM_DEVICE (iter->data);
+	key = nm_utils_hwaddr_canonical (hwaddr, -1);
+	if (key && strlen (key) == INFINIBAND_ALEN * 3 - 1) {
+		tmp = key;
+		key = g_strdup (tmp + (INFINIBAND_ALEN - 8) * 3);
+		g_free (tmp);
 	}
-	return NULL;
+	return key;
 }
 
-static NMDevice *
-nm_manager_get_device_by_path (NMManager *manager, const char *path)
+static gpointer
+device_index_get_key (NMDevice *device, DeviceIndex idx)
 {
-	GSList *iter;
+	switch (idx) {
+	case DEVICE_INDEX_IFINDEX:
+		return GINT_TO_POINTER (nm_device_get_ifindex (device));
+	case DEVICE_INDEX_UDI:
+		return g_strdup (nm_device_get_udi (device));
+	case DEVICE_INDEX_PATH:
+		return g_strdup (nm_device_get_path (device));
+	case DEVICE_INDEX_IFACE:
+		return g_strdup (nm_device_get_iface (device));
+	case DEVICE_INDEX_IP_IFACE:
+		return g_strdup (nm_device_get_ip_iface (device));
+	case DEVICE_INDEX_HW_ADDRESS:
+		return hwaddr_index_key (nm_device_get_hw_address (device));
+	default:
+		g_assert_not_reached ();
+	}
+}
 
-	g_return_val_if_fail (path != NULL, NULL);
+static void
+device_index_add (NMManager *self, DeviceIndex idx, gpointer key, NMDevice *device)
+{
+	GHashTable *table = NM_MANAGER_GET_PRIVATE (self)->device_index[idx];
+	GSList *list;
 
-	for (iter = NM_MANAGER_GET_PRIVATE (manager)->devices; iter; iter = iter->next) {
-		if (!strcmp (nm_device_get_path (NM_DEVICE (iter->data)), path))
-			return NM_DEVICE (iter->data);
+	/* Every device has an ifindex, even if it is 0 */
+	if (!key && idx != DEVICE_INDEX_IFINDEX)
+		return;
+
+	list = g_hash_table_lookup (table, key);
+	if (list)
+		list = g_slist_append (list, device);
+	else {
+		g_hash_table_insert (table,
+		                     idx == DEVICE_INDEX_IFINDEX ? key : g_strdup (key),
+		                     g_slist_prepend (NULL, device));
 	}
-	return NULL;
 }
 
-NMDevice *
-nm_manager_get_device_by_ifindex (NMManager *manager, int ifindex)
+static void
+device_index_remove (NMManager *self, DeviceIndex idx, gpointer key, NMDevice *device)
 {
-	GSList *iter;
+	GHashTable *table = NM_MANAGER_GET_PRIVATE (self)->device_index[idx];
+	gpointer orig_key;
+	GSList *list;
 
-	for (iter = NM_MANAGER_GET_PRIVATE (manager)->devices; iter; iter = iter->next) {
-		NMDevice *device = NM_DEVICE (iter->data);
+	if (!key && idx != DEVICE_INDEX_IFINDEX)
+		return;
 
-		if (nm_device_get_ifindex (device) == ifindex)
-			return device;
+	if (!g_hash_table_lookup_extended (table, key, &orig_key, (gpointer *) &list))
+		return;
+
+	list = g_slist_remove (list, device);
+	if (!list)
+		g_hash_table_remove (table, key);
+	else {
+		/* The head may have changed; keep the key */
+		g_hash_table_steal (table, key);
+		g_hash_table_insert (table, orig_key, list);
 	}
+}
 
-	return NULL;
+static NMDevice *
+device_index_lookup (NMManager *self, DeviceIndex idx, gconstpointer key)
+{
+	GSList *list;
+
+	if (!key && idx != DEVICE_INDEX_IFINDEX)
+		return NULL;
+
+	list = g_hash_table_lookup (NM_MANAGER_GET_PRIVATE (self)->device_index[idx], key);
+	return list ? list->data : NULL;
+}
+
+/* (Re)indexes @device under its current keys */
+static void
+device_index_update (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	DeviceKeys *keys;
+	gboolean is_new = FALSE;
+	guint i;
+
+	keys = g_hash_table_lookup (priv->device_keys, device);
+	if (!keys) {
+		keys = g_slice_new0 (DeviceKeys);
+		g_hash_table_insert (priv->device_keys, device, keys);
+		is_new = TRUE;
+	}
+
+	for (i = 0; i < DEVICE_INDEX_LAST; i++) {
+		gpointer key = device_index_get_key (device, i);
+
+		if (!is_new) {
+			if (  i == DEVICE_INDEX_IFINDEX
+			    ? key == keys->keys[i]
+			    : g_strcmp0 (key, keys->keys[i]) == 0) {
+				if (i != DEVICE_INDEX_IFINDEX)
+					g_free (key);
+				continue;
+			}
+			device_index_remove (self, i, keys->keys[i], device);
+		}
+
+		device_index_add (self, i, key, device);
+		if (i != DEVICE_INDEX_IFINDEX)
+			g_free (keys->keys[i]);
+		keys->keys[i] = key;
+	}
+}
+
+static void
+device_index_clear (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	DeviceKeys *keys;
+	guint i;
+
+	keys = g_hash_table_lookup (priv->device_keys, device);
+	if (!keys)
+		return;
+
+	for (i = 0; i < DEVICE_INDEX_LAST; i++)
+		device_index_remove (self, i, keys->keys[i], device);
+	g_hash_table_remove (priv->device_keys, device);
+}
+
+static void
+device_index_changed (NMDevice *device, GParamSpec *pspec, NMManager *self)
+{
+	device_index_update (self, device);
+}
+
+static NMDevice *
+nm_manager_get_device_by_udi (NMManager *manager, const char *udi)
+{
+	g_return_val_if_fail (udi != NULL, NULL);
+
+	return device_index_lookup (manager, DEVICE_INDEX_UDI, udi);
+}
+
+static NMDevice *
+nm_manager_get_device_by_path (NMManager *manager, const char *path)
+{
+	g_return_val_if_fail (path != NULL, NULL);
+
+	return device_index_lookup (manager, DEVICE_INDEX_PATH, path);
+}
+
+NMDevice *
+nm_manager_get_device_by_ifindex (NMManager *manager, int ifindex)
+{
+	return device_index_lookup (manager, DEVICE_INDEX_IFINDEX, GINT_TO_POINTER (ifindex));
 }
 
 static gboolean
@@ -683,6 +874,7 @@ check_if_startup_complete (NMManager *self)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	GSList *iter;
+	char *trace_file;
 
 	if (!priv->startup)
 		return;
@@ -698,6 +890,19 @@ check_if_startup_complete (NMManager *self)
 	}
 
 	nm_log_info (LOGD_CORE, "startup complete");
+	nm_trace_instant (NM_TRACE_CAT_MANAGER, NULL, "startup complete");
+
+	trace_file = nm_config_get_value (nm_config_get (), "main", "trace-file", NULL);
+	if (trace_file) {
+		GError *error = NULL;
+
+		if (!nm_trace_write_file (trace_file, &error)) {
+			nm_log_warn (LOGD_CORE, "couldn't write activation trace to %s: %s",
+			             trace_file, error->message);
+			g_error_free (error);
+		}
+		g_free (trace_file);
+	}
 
 	priv->startup = FALSE;
 	g_object_notify (G_OBJECT (self), "startup");
@@ -762,6 +967,7 @@ remove_device (NMManager *manager,
 
 	nm_settings_device_removed (priv->settings, device, quitting);
 	priv->devices = g_slist_remove (priv->devices, device);
+	device_index_clear (manager, device);
 
 	g_signal_emit (manager, signals[DEVICE_REMOVED], 0, device);
 	g_object_notify (G_OBJECT (manager), NM_MANAGER_DEVICES);
@@ -787,9 +993,7 @@ aipd_handle_event (DBusGProxy *proxy,
                    gpointer user_data)
 {
 	NMManager *manager = NM_MANAGER (user_data);
-	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (manager);
-	GSList *iter;
-	gboolean handled = FALSE;
+	NMDevice *device;
 
 	if (!event || !iface) {
 		nm_log_warn (LOGD_AUTOIP4, "incomplete message received from avahi-autoipd");
@@ -804,17 +1008,10 @@ aipd_handle_event (DBusGProxy *proxy,
 		return;
 	}
 
-	for (iter = priv->devices; iter; iter = g_slist_next (iter)) {
-		NMDevice *candidate = NM_DEVICE (iter->data);
-
-		if (!strcmp (nm_device_get_iface (candidate), iface)) {
-			nm_device_handle_autoip4_event (candidate, event, address);
-			handled = TRUE;
-			break;
-		}
-	}
-
-	if (!handled)
+	device = device_index_lookup (manager, DEVICE_INDEX_IFACE, iface);
+	if (device)
+		nm_device_handle_autoip4_event (device, event, address);
+	else
 		nm_log_warn (LOGD_AUTOIP4, "(%s): unhandled avahi-autoipd event", iface);
 }
 
@@ -833,23 +1030,16 @@ nm_manager_get_state (NMManager *manager)
 static NMDevice *
 get_device_from_hwaddr (NMManager *self, const char *setting_mac)
 {
-	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
-	const char *device_mac;
-	GSList *iter;
+	NMDevice *device;
+	char *key;
 
 	if (!setting_mac)
 		return NULL;
 
-	for (iter = priv->devices; iter; iter = g_slist_next (iter)) {
-		NMDevice *device = iter->data;
-
-		device_mac = nm_device_get_hw_address (iter->data);
-		if (!device_mac)
-			continue;
-		if (nm_utils_hwaddr_matches (setting_mac, -1, device_mac, -1))
-			return device;
-	}
-	return NULL;
+	key = hwaddr_index_key (setting_mac);
+	device = device_index_lookup (self, DEVICE_INDEX_HW_ADDRESS, key);
+	g_free (key);
+	return device;
 }
 
 static NMDevice *
@@ -1060,6 +1250,8 @@ system_create_virtual_device (NMManager *self, NMConnection *connection)
 
 	nm_owned = !nm_platform_link_exists (iface);
 
+	load_deferred_device_factories (self, NM_LINK_TYPE_NONE, nm_connection_get_connection_type (connection));
+
 	for (iter = priv->factories; iter; iter = iter->next) {
 		device = nm_device_factory_create_virtual_device_for_connection (NM_DEVICE_FACTORY (iter->data),
 		                                                                 connection,
@@ -1130,6 +1322,8 @@ connection_added (NMSettings *settings,
 		if (nm_setting_connection_get_autoconnect (s_con))
 			system_create_virtual_device (manager, connection);
 	}
+
+	unmanaged_links_recheck (manager, connection);
 }
 
 static void
@@ -1138,6 +1332,8 @@ connection_changed (NMSettings *settings,
                     NMManager *manager)
 {
 	/* FIXME: Some virtual devices may need to be updated in the future. */
+
+	unmanaged_links_recheck (manager, NM_CONNECTION (connection));
 }
 
 static void
@@ -1172,6 +1368,8 @@ system_unmanaged_devices_changed_cb (NMSettings *settings,
 		                         unmanaged ? NM_DEVICE_STATE_REASON_NOW_UNMANAGED :
 		                                     NM_DEVICE_STATE_REASON_NOW_MANAGED);
 	}
+
+	unmanaged_links_recheck (self, NULL);
 }
 
 static void
@@ -1712,18 +1910,21 @@ device_ip_iface_changed (NMDevice *device,
                          NMManager *self)
 {
 	const char *ip_iface = nm_device_get_ip_iface (device);
-	GSList *iter;
+	GSList *list, *iter;
 
 	/* Remove NMDevice objects that are actually child devices of others,
 	 * when the other device finally knows its IP interface name.  For example,
 	 * remove the PPP interface that's a child of a WWAN device, since it's
 	 * not really a standalone NMDevice.
 	 */
-	for (iter = NM_MANAGER_GET_PRIVATE (self)->devices; iter; iter = iter->next) {
+	if (!ip_iface)
+		return;
+
+	list = g_hash_table_lookup (NM_MANAGER_GET_PRIVATE (self)->device_index[DEVICE_INDEX_IFACE], ip_iface);
+	for (iter = list; iter; iter = iter->next) {
 		NMDevice *candidate = NM_DEVICE (iter->data);
 
-		if (   candidate != device
-		    && g_strcmp0 (nm_device_get_iface (candidate), ip_iface) == 0) {
+		if (candidate != device) {
 			remove_device (self, candidate, FALSE, FALSE);
 			break;
 		}
@@ -1772,6 +1973,21 @@ add_device (NMManager *self, NMDevice *device, gboolean try_assume)
 	g_slist_free (remove);
 
 	priv->devices = g_slist_append (priv->devices, g_object_ref (device));
+	device_index_update (self, device);
+
+	/* Keep the indexes up to date before anything else looks at the change */
+	g_signal_connect (device, "notify::" NM_DEVICE_UDI,
+	                  G_CALLBACK (device_index_changed),
+	                  self);
+	g_signal_connect (device, "notify::" NM_DEVICE_IFACE,
+	                  G_CALLBACK (device_index_changed),
+	                  self);
+	g_signal_connect (device, "notify::" NM_DEVICE_IP_IFACE,
+	                  G_CALLBACK (device_index_changed),
+	                  self);
+	g_signal_connect (device, "notify::" NM_DEVICE_HW_ADDRESS,
+	                  G_CALLBACK (device_index_changed),
+	                  self);
 
 	g_signal_connect (device, "state-changed",
 	                  G_CALLBACK (manager_device_state_changed),
@@ -1825,6 +2041,7 @@ add_device (NMManager *self, NMDevice *device, gboolean try_assume)
 	nm_device_set_initial_unmanaged_flag (device, NM_UNMANAGED_INTERNAL, sleeping);
 
 	nm_device_dbus_export (device);
+	device_index_update (self, device);
 	nm_device_finish_init (device);
 
 	if (try_assume) {
@@ -1852,16 +2069,7 @@ add_device (NMManager *self, NMDevice *device, gboolean try_assume)
 static NMDevice *
 find_device_by_ip_iface (NMManager *self, const gchar *iface)
 {
-	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
-	GSList *iter;
-
-	for (iter = priv->devices; iter; iter = g_slist_next (iter)) {
-		NMDevice *candidate = iter->data;
-
-		if (g_strcmp0 (nm_device_get_ip_iface (candidate), iface) == 0)
-			return candidate;
-	}
-	return NULL;
+	return device_index_lookup (self, DEVICE_INDEX_IP_IFACE, iface);
 }
 
 /*******************************************************************/
@@ -2021,13 +2229,163 @@ _register_device_factory (NMManager *self,
 	return TRUE;
 }
 
+/* Which link and connection types each device plugin supports, so that
+ * plugins which can't create a device for any present link are only loaded
+ * when needed.  A plugin's entry is only used while its mtime matches.
+ */
+#define DEVICE_PLUGINS_STATE_FILE NMSTATEDIR "/device-plugins.state"
+
+typedef struct {
+	char *path;
+	int *link_types;
+	gsize n_link_types;
+	char **setting_types;
+} DeferredFactory;
+
+static void
+deferred_factory_free (DeferredFactory *deferred)
+{
+	g_free (deferred->path);
+	g_free (deferred->link_types);
+	g_strfreev (deferred->setting_types);
+	g_slice_free (DeferredFactory, deferred);
+}
+
+static NMDeviceFactory *
+load_device_factory (NMManager *self, const char *path)
+{
+	NMDeviceFactory *factory;
+	GModule *plugin;
+	NMDeviceFactoryCreateFunc create_func;
+	const char *item;
+	GError *error = NULL;
+
+	item = strrchr (path, '/');
+	g_assert (item);
+
+	plugin = g_module_open (path, G_MODULE_BIND_LOCAL);
+
+	if (!plugin) {
+		nm_log_warn (LOGD_HW, "(%s): failed to load plugin: %s", item, g_module_error ());
+		return NULL;
+	}
+
+	if (!g_module_symbol (plugin, "nm_device_factory_create", (gpointer) &create_func)) {
+		nm_log_warn (LOGD_HW, "(%s): failed to find device factory creator: %s", item, g_module_error ());
+		g_module_close (plugin);
+		return NULL;
+	}
+
+	factory = create_func (&error);
+	if (!factory) {
+		nm_log_warn (LOGD_HW, "(%s): failed to initialize device factory: %s",
+		             item, error ? error->message : "unknown");
+		g_clear_error (&error);
+		g_module_close (plugin);
+		return NULL;
+	}
+	g_clear_error (&error);
+
+	if (_register_device_factory (self, factory, TRUE, g_module_name (plugin), &error)) {
+		nm_log_info (LOGD_HW, "Loaded device plugin: %s", g_module_name (plugin));
+		g_module_make_resident (plugin);
+	} else {
+		nm_log_warn (LOGD_HW, "Loading device plugin failed: %s", error->message);
+		g_object_unref (factory);
+		g_module_close (plugin);
+		g_clear_error (&error);
+		return NULL;
+	}
+
+	return factory;
+}
+
+/* Returns the plugin's entry from @cache if it may be loaded later */
+static DeferredFactory *
+device_plugin_get_deferred (GKeyFile *cache,
+                            const char *path,
+                            const struct stat *st,
+                            GHashTable *present_link_types)
+{
+	const char *group = strrchr (path, '/') + 1;
+	DeferredFactory *deferred;
+	gsize i;
+
+	if (g_key_file_get_int64 (cache, group, "mtime", NULL) != MAX (st->st_mtime, st->st_ctime))
+		return NULL;
+	if (!g_key_file_has_key (cache, group, "link-types", NULL))
+		return NULL;
+
+	deferred = g_slice_new0 (DeferredFactory);
+	deferred->link_types = g_key_file_get_integer_list (cache, group, "link-types",
+	                                                    &deferred->n_link_types, NULL);
+	for (i = 0; i < deferred->n_link_types; i++) {
+		if (g_hash_table_contains (present_link_types, GINT_TO_POINTER (deferred->link_types[i]))) {
+			deferred_factory_free (deferred);
+			return NULL;
+		}
+	}
+	deferred->setting_types = g_key_file_get_string_list (cache, group, "setting-types", NULL, NULL);
+	deferred->path = g_strdup (path);
+	return deferred;
+}
+
+static void
+device_plugin_set_cache (GKeyFile *cache,
+                         const char *path,
+                         const struct stat *st,
+                         NMDeviceFactory *factory,
+                         DeferredFactory *deferred)
+{
+	const char *group = strrchr (path, '/') + 1;
+	const NMLinkType *link_types;
+	const char **setting_types;
+	GArray *types;
+
+	g_key_file_set_int64 (cache, group, "mtime", MAX (st->st_mtime, st->st_ctime));
+
+	if (deferred) {
+		g_key_file_set_integer_list (cache, group, "link-types",
+		                             deferred->link_types, deferred->n_link_types);
+		if (deferred->setting_types) {
+			g_key_file_set_string_list (cache, group, "setting-types",
+			                            (const char **) deferred->setting_types,
+			                            g_strv_length (deferred->setting_types));
+		}
+		return;
+	}
+
+	if (!nm_device_factory_get_supported_types (factory, &link_types, &setting_types))
+		return;
+
+	types = g_array_new (FALSE, FALSE, sizeof (int));
+	for (; link_types && *link_types != NM_LINK_TYPE_NONE; link_types++) {
+		int t = *link_types;
+
+		g_array_append_val (types, t);
+	}
+	g_key_file_set_integer_list (cache, group, "link-types", (int *) types->data, types->len);
+	g_array_free (types, TRUE);
+
+	if (setting_types) {
+		g_key_file_set_string_list (cache, group, "setting-types",
+		                            setting_types, g_strv_length ((char **) setting_types));
+	}
+}
+
 static void
 load_device_factories (NMManager *self)
 {
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	NMDeviceFactory *factory;
 	const GSList *iter;
 	GError *error = NULL;
 	char **path, **paths;
+	GKeyFile *cache, *new_cache;
+	GHashTable *present_link_types;
+	GArray *links;
+	char *old_data, *new_data;
+	guint i;
 
 	/* Register internal factories first */
 	for (iter = nm_device_factory_get_internal_factory_types (); iter; iter = iter->next) {
@@ -2048,52 +2406,307 @@ load_device_factories (NMManager *self)
 	if (!paths)
 		return;
 
-	for (path = paths; *path; path++) {
-		GModule *plugin;
-		NMDeviceFactoryCreateFunc create_func;
-		const char *item;
+	cache = g_key_file_new ();
+	g_key_file_load_from_file (cache, DEVICE_PLUGINS_STATE_FILE, G_KEY_FILE_NONE, NULL);
+	new_cache = g_key_file_new ();
 
-		item = strrchr (*path, '/');
-		g_assert (item);
+	present_link_types = g_hash_table_new (g_direct_hash, g_direct_equal);
+	links = nm_platform_link_get_all ();
+	for (i = 0; i < links->len; i++)
+		g_hash_table_add (present_link_types, GINT_TO_POINTER (g_array_index (links, NMPlatformLink, i).type));
+	g_array_unref (links);
 
-		plugin = g_module_open (*path, G_MODULE_BIND_LOCAL);
+	for (path = paths; *path; path++) {
+		DeferredFactory *deferred;
+		struct stat st;
 
-		if (!plugin) {
-			nm_log_warn (LOGD_HW, "(%s): failed to load plugin: %s", item, g_module_error ());
+		if (stat (*path, &st) != 0)
 			continue;
-		}
 
-		if (!g_module_symbol (plugin, "nm_device_factory_create", (gpointer) &create_func)) {
-			nm_log_warn (LOGD_HW, "(%s): failed to find device factory creator: %s", item, g_module_error ());
-			g_module_close (plugin);
+		deferred = device_plugin_get_deferred (cache, *path, &st, present_link_types);
+		if (deferred) {
+			nm_log_dbg (LOGD_HW, "(%s): not loading device plugin until needed", *path);
+			priv->deferred_factories = g_slist_append (priv->deferred_factories, deferred);
+			device_plugin_set_cache (new_cache, *path, &st, NULL, deferred);
 			continue;
 		}
 
-		factory = create_func (&error);
-		if (!factory) {
-			nm_log_warn (LOGD_HW, "(%s): failed to initialize device factory: %s",
-			             item, error ? error->message : "unknown");
-			g_clear_error (&error);
-			g_module_close (plugin);
-			continue;
-		}
+		factory = load_device_factory (self, *path);
+		if (factory)
+			device_plugin_set_cache (new_cache, *path, &st, factory, NULL);
+	}
+	g_strfreev (paths);
+	g_hash_table_destroy (present_link_types);
+
+	old_data = g_key_file_to_data (cache, NULL, NULL);
+	new_data = g_key_file_to_data (new_cache, NULL, NULL);
+	if (   g_strcmp0 (old_data, new_data) != 0
+	    && !g_file_set_contents (DEVICE_PLUGINS_STATE_FILE, new_data, -1, &error)) {
+		nm_log_dbg (LOGD_HW, "failed to write %s: %s", DEVICE_PLUGINS_STATE_FILE, error->message);
 		g_clear_error (&error);
+	}
+	g_free (old_data);
+	g_free (new_data);
+	g_key_file_free (cache);
+	g_key_file_free (new_cache);
+}
 
-		if (_register_device_factory (self, factory, TRUE, g_module_name (plugin), &error)) {
-			nm_log_info (LOGD_HW, "Loaded device plugin: %s", g_module_name (plugin));
-			g_module_make_resident (plugin);
-		} else {
-			nm_log_warn (LOGD_HW, "Loading device plugin failed: %s", error->message);
-			g_object_unref (factory);
-			g_module_close (plugin);
-			g_clear_error (&error);
+/* Loads deferred device plugins supporting @link_type or @setting_type */
+static void
+load_deferred_device_factories (NMManager *self, NMLinkType link_type, const char *setting_type)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	GSList *iter, *next;
+
+	for (iter = priv->deferred_factories; iter; iter = next) {
+		DeferredFactory *deferred = iter->data;
+		NMDeviceFactory *factory;
+		gboolean needed = FALSE;
+		gsize i;
+
+		next = iter->next;
+
+		for (i = 0; i < deferred->n_link_types; i++) {
+			if (deferred->link_types[i] == link_type)
+				needed = TRUE;
 		}
+		if (setting_type && deferred->setting_types)
+			needed |= _nm_utils_string_in_list (setting_type, (const char **) deferred->setting_types);
+		if (!needed)
+			continue;
+
+		priv->deferred_factories = g_slist_delete_link (priv->deferred_factories, iter);
+		factory = load_device_factory (self, deferred->path);
+		if (factory && priv->factories_started)
+			nm_device_factory_start (factory);
+		deferred_factory_free (deferred);
 	}
-	g_strfreev (paths);
 }
 
 /*******************************************************************/
 
+/* On container hosts veths come and go by the thousands.  Creating, exporting
+ * and setting up an NMDevice for each of them only to find out it is
+ * unmanaged is wasteful, so links matching "unmanaged-links" from the
+ * configuration, and veths matching the unmanaged devices from the settings,
+ * don't get a device.  They are just remembered by ifindex and get one once
+ * that no longer holds, e.g. because a connection for them shows up.  Other
+ * unmanaged devices stay visible on D-Bus as before.
+ */
+
+static char *
+link_get_hwaddr (int ifindex)
+{
+	gconstpointer addr;
+	size_t len = 0;
+
+	addr = nm_platform_link_get_address (ifindex, &len);
+	return addr && len ? nm_utils_hwaddr_ntoa (addr, len) : NULL;
+}
+
+/* "unmanaged-links" entries look like unmanaged device specs, but interface
+ * names may contain shell-style wildcards and "driver:" matches the kernel
+ * driver.
+ */
+static gboolean
+link_match_config (const NMPlatformLink *plink, const char *hwaddr)
+{
+	const char **specs = nm_config_get_unmanaged_links (nm_config_get ());
+
+	for (; specs && *specs; specs++) {
+		const char *spec = *specs;
+
+		if (!g_ascii_strncasecmp (spec, "interface-name:", STRLEN ("interface-name:"))) {
+			if (g_pattern_match_simple (spec + STRLEN ("interface-name:"), plink->name))
+				return TRUE;
+		} else if (!g_ascii_strncasecmp (spec, "driver:", STRLEN ("driver:"))) {
+			if (plink->driver && g_pattern_match_simple (spec + STRLEN ("driver:"), plink->driver))
+				return TRUE;
+		} else if (!g_ascii_strncasecmp (spec, "mac:", STRLEN ("mac:"))) {
+			if (hwaddr && nm_utils_hwaddr_matches (spec + STRLEN ("mac:"), -1, hwaddr, -1))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+connection_targets_link (NMConnection *connection, const char *ifname, const char *hwaddr)
+{
+	NMSettingWired *s_wired;
+	const char *mac;
+
+	if (g_strcmp0 (nm_connection_get_interface_name (connection), ifname) == 0)
+		return TRUE;
+
+	s_wired = nm_connection_get_setting_wired (connection);
+	mac = s_wired ? nm_setting_wired_get_mac_address (s_wired) : NULL;
+	return mac && hwaddr && nm_utils_hwaddr_matches (mac, -1, hwaddr, -1);
+}
+
+typedef struct {
+	const NMPlatformLink *plink;
+	const char *hwaddr;
+	gboolean targeted;
+} TargetsLinkData;
+
+static void
+connection_targets_link_cb (NMSettings *settings,
+                            NMSettingsConnection *connection,
+                            gpointer user_data)
+{
+	TargetsLinkData *data = user_data;
+
+	if (!data->targeted)
+		data->targeted = connection_targets_link (NM_CONNECTION (connection), data->plink->name, data->hwaddr);
+}
+
+static gboolean
+link_is_unmanaged_early (NMManager *self, const NMPlatformLink *plink)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	const GSList *specs;
+	gboolean unmanaged = FALSE;
+	char *hwaddr;
+
+	if (plink->type == NM_LINK_TYPE_LOOPBACK)
+		return FALSE;
+
+	hwaddr = link_get_hwaddr (plink->ifindex);
+
+	if (link_match_config (plink, hwaddr))
+		unmanaged = TRUE;
+	else if (plink->type == NM_LINK_TYPE_VETH) {
+		specs = nm_settings_get_unmanaged_specs (priv->settings);
+		unmanaged =    nm_match_spec_string (specs, "*")
+		            || nm_match_spec_interface_name (specs, plink->name)
+		            || (hwaddr && nm_match_spec_hwaddr (specs, hwaddr));
+	}
+
+	if (unmanaged) {
+		TargetsLinkData data = { plink, hwaddr, FALSE };
+
+		/* Order doesn't matter here, so don't ask for a sorted list */
+		nm_settings_for_each_connection (priv->settings, connection_targets_link_cb, &data);
+		unmanaged = !data.targeted;
+	}
+
+	g_free (hwaddr);
+	return unmanaged;
+}
+
+/* What a skipped link looked like, so that only renames and address changes
+ * make it worth checking again.
+ */
+typedef struct {
+	char *name;
+	char *hwaddr;
+} UnmanagedLink;
+
+static void
+unmanaged_link_free (gpointer data)
+{
+	UnmanagedLink *link = data;
+
+	g_free (link->name);
+	g_free (link->hwaddr);
+	g_slice_free (UnmanagedLink, link);
+}
+
+static void
+unmanaged_link_add (NMManager *self, const NMPlatformLink *plink)
+{
+	UnmanagedLink *link;
+
+	link = g_slice_new (UnmanagedLink);
+	link->name = g_strdup (plink->name);
+	link->hwaddr = link_get_hwaddr (plink->ifindex);
+	g_hash_table_insert (NM_MANAGER_GET_PRIVATE (self)->unmanaged_links,
+	                     GINT_TO_POINTER (plink->ifindex),
+	                     link);
+}
+
+/* Returns %TRUE if the skipped link was renamed or changed its address */
+static gboolean
+unmanaged_link_update (UnmanagedLink *link, const NMPlatformLink *plink)
+{
+	char *hwaddr = link_get_hwaddr (plink->ifindex);
+	gboolean changed = FALSE;
+
+	if (g_strcmp0 (link->name, plink->name)) {
+		g_free (link->name);
+		link->name = g_strdup (plink->name);
+		changed = TRUE;
+	}
+	if (g_strcmp0 (link->hwaddr, hwaddr)) {
+		g_free (link->hwaddr);
+		link->hwaddr = hwaddr;
+		hwaddr = NULL;
+		changed = TRUE;
+	}
+
+	g_free (hwaddr);
+	return changed;
+}
+
+static void platform_link_added (NMManager *self,
+                                 int ifindex,
+                                 NMPlatformLink *plink,
+                                 NMPlatformReason reason);
+
+static void
+unmanaged_link_promote (NMManager *self, int ifindex)
+{
+	NMPlatformLink plink;
+
+	g_hash_table_remove (NM_MANAGER_GET_PRIVATE (self)->unmanaged_links, GINT_TO_POINTER (ifindex));
+
+	if (nm_platform_link_get (ifindex, &plink)) {
+		nm_log_dbg (LOGD_HW, "(%s): no longer unmanaged, creating device", plink.name);
+		platform_link_added (self, ifindex, &plink, NM_PLATFORM_REASON_NONE);
+	}
+}
+
+/* Creates devices for the links that shouldn't be skipped any more; with
+ * @connection only for the links that connection is for.  That is matched
+ * against the remembered name and address, so only the links that get a
+ * device are looked up in the platform.
+ */
+static void
+unmanaged_links_recheck (NMManager *self, NMConnection *connection)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	gpointer key, value;
+	GSList *promote = NULL, *l;
+
+	g_hash_table_iter_init (&iter, priv->unmanaged_links);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		UnmanagedLink *link = value;
+		gboolean promote_link;
+
+		if (connection)
+			promote_link = connection_targets_link (connection, link->name, link->hwaddr);
+		else {
+			NMPlatformLink plink;
+
+			/* The configuration changed; that may match on the driver too */
+			if (!nm_platform_link_get (GPOINTER_TO_INT (key), &plink)) {
+				g_hash_table_iter_remove (&iter);
+				continue;
+			}
+			promote_link = !link_is_unmanaged_early (self, &plink);
+		}
+
+		if (promote_link)
+			promote = g_slist_prepend (promote, key);
+	}
+
+	for (l = promote; l; l = l->next)
+		unmanaged_link_promote (self, GPOINTER_TO_INT (l->data));
+	g_slist_free (promote);
+}
+
 static void
 platform_link_added (NMManager *self,
                      int ifindex,
@@ -2113,6 +2726,17 @@ platform_link_added (NMManager *self,
 	if (nm_manager_get_device_by_ifindex (self, ifindex))
 		return;
 
+	if (g_hash_table_contains (priv->unmanaged_links, GINT_TO_POINTER (ifindex)))
+		return;
+
+	if (link_is_unmanaged_early (self, plink)) {
+		nm_log_dbg (LOGD_HW, "(%s): unmanaged, not creating a device", plink->name);
+		unmanaged_link_add (self, plink);
+		return;
+	}
+
+	load_deferred_device_factories (self, plink->type, NULL);
+
 	/* Try registered device factories */
 	for (iter = priv->factories; iter; iter = iter->next) {
 		NMDeviceFactory *factory = NM_DEVICE_FACTORY (iter->data);
@@ -2179,10 +2803,25 @@ platform_link_cb (NMPlatform *platform,
 	case NM_PLATFORM_SIGNAL_ADDED:
 		platform_link_added (NM_MANAGER (user_data), ifindex, plink, reason);
 		break;
+	case NM_PLATFORM_SIGNAL_CHANGED: {
+		NMManager *self = NM_MANAGER (user_data);
+		UnmanagedLink *link;
+
+		/* The link may have been renamed or changed its address */
+		link = g_hash_table_lookup (NM_MANAGER_GET_PRIVATE (self)->unmanaged_links, GINT_TO_POINTER (ifindex));
+		if (   link
+		    && unmanaged_link_update (link, plink)
+		    && !link_is_unmanaged_early (self, plink))
+			unmanaged_link_promote (self, ifindex);
+		break;
+	 }
 	case NM_PLATFORM_SIGNAL_REMOVED: {
 		NMManager *self = NM_MANAGER (user_data);
 		NMDevice *device;
 
+		if (g_hash_table_remove (NM_MANAGER_GET_PRIVATE (self)->unmanaged_links, GINT_TO_POINTER (ifindex)))
+			break;
+
 		device = nm_manager_get_device_by_ifindex (self, ifindex);
 		if (device)
 			remove_device (self, device, FALSE, TRUE);
@@ -4051,6 +4690,28 @@ impl_manager_get_logging (NMManager *manager,
 	*domains = g_strdup (nm_logging_domains_to_string ());
 }
 
+static void
+impl_manager_get_trace (NMManager *manager,
+                        char **trace)
+{
+	*trace = nm_trace_to_json ();
+}
+
+static void
+impl_manager_get_properties_changed_stats (NMManager *manager,
+                                           guint64 *signals_sent,
+                                           guint64 *signals_suppressed,
+                                           guint64 *values_suppressed,
+                                           guint64 *throttled)
+{
+	const NMPropertiesChangedStats *stats = nm_properties_changed_signal_get_stats ();
+
+	*signals_sent = stats->signals_sent;
+	*signals_suppressed = stats->signals_suppressed;
+	*values_suppressed = stats->values_suppressed;
+	*throttled = stats->throttled;
+}
+
 static void
 connectivity_check_done (GObject *object,
                          GAsyncResult *result,
@@ -4169,6 +4830,7 @@ nm_manager_start (NMManager *self)
 	/* Start device factories */
 	for (iter = priv->factories; iter; iter = iter->next)
 		nm_device_factory_start (iter->data);
+	priv->factories_started = TRUE;
 
 	nm_platform_query_devices ();
 
@@ -4804,6 +5466,13 @@ nm_manager_init (NMManager *manager)
 	for (i = 0; i < RFKILL_TYPE_MAX; i++)
 		priv->radio_states[i].hw_enabled = TRUE;
 
+	priv->device_index[DEVICE_INDEX_IFINDEX] = g_hash_table_new (g_direct_hash, g_direct_equal);
+	for (i = DEVICE_INDEX_IFINDEX + 1; i < DEVICE_INDEX_LAST; i++)
+		priv->device_index[i] = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->device_keys = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                           NULL, (GDestroyNotify) device_keys_free);
+	priv->unmanaged_links = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, unmanaged_link_free);
+
 	priv->sleeping = FALSE;
 	priv->state = NM_STATE_DISCONNECTED;
 	priv->startup = TRUE;
@@ -5006,6 +5675,7 @@ dispose (GObject *object)
 	DBusGConnection *bus;
 	DBusConnection *dbus_connection;
 	GSList *iter;
+	guint i;
 
 	g_slist_free_full (priv->auth_chains, (GDestroyNotify) nm_auth_chain_unref);
 	priv->auth_chains = NULL;
@@ -5015,6 +5685,10 @@ dispose (GObject *object)
 	                                      manager);
 
 	g_assert (priv->devices == NULL);
+	for (i = 0; i < DEVICE_INDEX_LAST; i++)
+		g_clear_pointer (&priv->device_index[i], g_hash_table_destroy);
+	g_clear_pointer (&priv->device_keys, g_hash_table_destroy);
+	g_clear_pointer (&priv->unmanaged_links, g_hash_table_destroy);
 
 	if (priv->ac_cleanup_id) {
 		g_source_remove (priv->ac_cleanup_id);
@@ -5076,6 +5750,8 @@ dispose (GObject *object)
 		g_object_unref (factory);
 	}
 	g_clear_pointer (&priv->factories, g_slist_free);
+	g_slist_free_full (priv->deferred_factories, (GDestroyNotify) deferred_factory_free);
+	priv->deferred_factories = NULL;
 
 	if (priv->timestamp_update_id) {
 		g_source_remove (priv->timestamp_update_id);
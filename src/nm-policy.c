@@ -56,6 +56,7 @@ typedef struct {
 	NMManager *manager;
 	guint update_state_id;
 	GSList *pending_activation_checks;
+	guint autoactivate_id;  /* idle handler checking pending_activation_checks */
 	GSList *manager_ids;
 	GSList *settings_ids;
 	GSList *dev_ids;
@@ -615,7 +616,7 @@ check_activating_devices (NMPolicy *policy)
 typedef struct {
 	NMPolicy *policy;
 	NMDevice *device;
-	guint autoactivate_id;
+	gboolean scheduled;   /* waiting for the next autoactivate pass */
 } ActivateData;
 
 static void
@@ -626,40 +627,27 @@ activate_data_free (ActivateData *data)
 	nm_device_remove_pending_action (data->device, "autoactivate", TRUE);
 	priv->pending_activation_checks = g_slist_remove (priv->pending_activation_checks, data);
 
-	if (data->autoactivate_id)
-		g_source_remove (data->autoactivate_id);
 	g_object_unref (data->device);
 	g_free (data);
 }
 
-static gboolean
-auto_activate_device (gpointer user_data)
+/* Rank of every activatable connection in autoconnect order, starting at 1.
+ * Built once per autoactivate pass and shared by all devices checked in it.
+ */
+static GHashTable *
+autoconnect_rank_new (NMPolicy *policy)
 {
-	ActivateData *data = (ActivateData *) user_data;
-	NMPolicy *policy;
-	NMPolicyPrivate *priv;
-	NMConnection *best_connection;
-	char *specific_object = NULL;
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (policy);
+	GHashTable *rank;
 	GPtrArray *connections;
 	GSList *connection_list;
 	guint i;
 
-	g_assert (data);
-	policy = data->policy;
-	priv = NM_POLICY_GET_PRIVATE (policy);
-
-	data->autoactivate_id = 0;
-
-	// FIXME: if a device is already activating (or activated) with a connection
-	// but another connection now overrides the current one for that device,
-	// deactivate the device and activate the new connection instead of just
-	// bailing if the device is already active
-	if (nm_device_get_act_request (data->device))
-		goto out;
+	rank = g_hash_table_new (g_direct_hash, g_direct_equal);
 
 	connection_list = nm_manager_get_activatable_connections (priv->manager);
 	if (!connection_list)
-		goto out;
+		return rank;
 
 	connections = _nm_utils_copy_slist_to_array (connection_list, NULL, NULL);
 	g_slist_free (connection_list);
@@ -668,6 +656,58 @@ auto_activate_device (gpointer user_data)
 	 * with same priority are still sorted by last-connected-timestamp. */
 	g_ptr_array_sort (connections, (GCompareFunc) nm_utils_cmp_connection_by_autoconnect_priority);
 
+	for (i = 0; i < connections->len; i++)
+		g_hash_table_insert (rank, connections->pdata[i], GUINT_TO_POINTER (i + 1));
+	g_ptr_array_free (connections, TRUE);
+
+	return rank;
+}
+
+static int
+cmp_autoconnect_rank (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	GHashTable *rank = user_data;
+	guint rank_a = GPOINTER_TO_UINT (g_hash_table_lookup (rank, *((gpointer *) a)));
+	guint rank_b = GPOINTER_TO_UINT (g_hash_table_lookup (rank, *((gpointer *) b)));
+
+	return rank_a < rank_b ? -1 : (rank_a > rank_b);
+}
+
+static void
+auto_activate_device (ActivateData *data, GHashTable **rank)
+{
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (data->policy);
+	NMConnection *best_connection;
+	char *specific_object = NULL;
+	GPtrArray *connections;
+	guint i;
+
+	// FIXME: if a device is already activating (or activated) with a connection
+	// but another connection now overrides the current one for that device,
+	// deactivate the device and activate the new connection instead of just
+	// bailing if the device is already active
+	if (nm_device_get_act_request (data->device))
+		return;
+
+	/* Only connections available on the device can be auto-connected on it,
+	 * so check those in the order of the shared ranking instead of going
+	 * through all connections.
+	 */
+	connections = nm_device_get_available_connections (data->device, NULL);
+	if (!connections)
+		return;
+
+	if (!*rank)
+		*rank = autoconnect_rank_new (data->policy);
+
+	for (i = 0; i < connections->len; ) {
+		if (!g_hash_table_contains (*rank, connections->pdata[i]))
+			g_ptr_array_remove_index_fast (connections, i);
+		else
+			i++;
+	}
+	g_ptr_array_sort_with_data (connections, cmp_autoconnect_rank, *rank);
+
 	/* Find the first connection that should be auto-activated */
 	best_connection = NULL;
 	for (i = 0; i < connections->len; i++) {
@@ -700,12 +740,43 @@ auto_activate_device (gpointer user_data)
 			             error ? error->code : -1,
 			             error ? error->message : "(none)");
 			g_error_free (error);
+		} else {
+			/* Active connections are not activatable on other devices */
+			g_hash_table_remove (*rank, best_connection);
 		}
 		g_object_unref (subject);
 	}
+}
+
+/* Checks all devices that are waiting for autoactivation in one go */
+static gboolean
+auto_activate_pending (gpointer user_data)
+{
+	NMPolicy *policy = NM_POLICY (user_data);
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (policy);
+	GHashTable *rank = NULL;
+	GSList *pending, *iter;
+
+	priv->autoactivate_id = 0;
+
+	/* Checks may be added or cleared while activating */
+	pending = g_slist_copy (priv->pending_activation_checks);
+	for (iter = pending; iter; iter = iter->next) {
+		ActivateData *data = iter->data;
+
+		if (   !g_slist_find (priv->pending_activation_checks, data)
+		    || !data->scheduled)
+			continue;
+
+		data->scheduled = FALSE;
+		auto_activate_device (data, &rank);
+		activate_data_free (data);
+	}
+	g_slist_free (pending);
+
+	if (rank)
+		g_hash_table_unref (rank);
 
- out:
-	activate_data_free (data);
 	return G_SOURCE_REMOVE;
 }
 
@@ -924,8 +995,11 @@ schedule_activate_check (NMPolicy *policy, NMDevice *device)
 	data = g_malloc0 (sizeof (ActivateData));
 	data->policy = policy;
 	data->device = g_object_ref (device);
-	data->autoactivate_id = g_idle_add (auto_activate_device, data);
+	data->scheduled = TRUE;
 	priv->pending_activation_checks = g_slist_append (priv->pending_activation_checks, data);
+
+	if (!priv->autoactivate_id)
+		priv->autoactivate_id = g_idle_add (auto_activate_pending, policy);
 }
 
 static void
@@ -935,7 +1009,7 @@ clear_pending_activate_check (NMPolicy *policy, NMDevice *device)
 	ActivateData *data;
 
 	data = find_pending_activation (priv->pending_activation_checks, device);
-	if (data && data->autoactivate_id)
+	if (data && data->scheduled)
 		activate_data_free (data);
 }
 
@@ -1888,6 +1962,10 @@ dispose (GObject *object)
 
 	while (priv->pending_activation_checks)
 		activate_data_free (priv->pending_activation_checks->data);
+	if (priv->autoactivate_id) {
+		g_source_remove (priv->autoactivate_id);
+		priv->autoactivate_id = 0;
+	}
 
 	g_slist_free_full (priv->pending_secondaries, (GDestroyNotify) pending_secondary_data_free);
 	priv->pending_secondaries = NULL;
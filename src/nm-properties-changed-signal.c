@@ -28,6 +28,16 @@
 #include "nm-logging.h"
 #include "nm-properties-changed-signal.h"
 #include "nm-dbus-glib-types.h"
+#include "NetworkManagerUtils.h"
+
+/* Changes to exported properties of all objects are collected in a single
+ * queue that is flushed once per main loop iteration.  Each flush reads the
+ * properties that changed, drops the ones whose value is the same as the one
+ * last emitted, and emits one PropertiesChanged per object with the rest.
+ * An object that just emitted has to wait MIN_EMIT_INTERVAL_MS before the
+ * next signal; changes made meanwhile are merged into that one.
+ */
+#define MIN_EMIT_INTERVAL_MS 100
 
 typedef struct {
 	GHashTable *exported_props;
@@ -35,11 +45,23 @@ typedef struct {
 } NMPropertiesChangedClassInfo;
 
 typedef struct {
-	GHashTable *hash;
+	GObject *object;
+	GHashTable *pending;     /* D-Bus name -> GParamSpec */
+	GHashTable *last;        /* D-Bus name -> GVariant, last emitted value */
 	guint signal_id;
-	guint idle_id;
+	gint64 last_emitted_ms;
+	GList *queue_link;
+	guint throttle_id;
+	GList *throttled_link;
+	gboolean disposed;
 } NMPropertiesChangedInfo;
 
+static GQueue queue = G_QUEUE_INIT;
+static guint queue_idle_id = 0;
+static GQueue throttled = G_QUEUE_INIT;
+static guint min_emit_interval_ms = MIN_EMIT_INTERVAL_MS;
+static NMPropertiesChangedStats stats;
+
 static GQuark
 nm_properties_changed_signal_quark (void)
 {
@@ -60,15 +82,46 @@ destroy_value (gpointer data)
 	g_slice_free (GValue, val);
 }
 
+static void
+properties_changed_info_unqueue (NMPropertiesChangedInfo *info)
+{
+	if (info->queue_link) {
+		g_queue_delete_link (&queue, info->queue_link);
+		info->queue_link = NULL;
+	}
+	if (info->throttled_link) {
+		g_queue_delete_link (&throttled, info->throttled_link);
+		info->throttled_link = NULL;
+	}
+	if (info->throttle_id) {
+		g_source_remove (info->throttle_id);
+		info->throttle_id = 0;
+	}
+}
+
+/* Weak reference notify, called when the object is disposed: its properties
+ * can't be read any more, so changes still pending are dropped and later
+ * ones ignored.
+ */
+static void
+object_disposed (gpointer data, GObject *where_the_object_was)
+{
+	NMPropertiesChangedInfo *info = data;
+
+	info->disposed = TRUE;
+	properties_changed_info_unqueue (info);
+	g_hash_table_remove_all (info->pending);
+}
+
 static void
 properties_changed_info_destroy (gpointer data)
 {
 	NMPropertiesChangedInfo *info = data;
 
-	if (info->idle_id)
-		g_source_remove (info->idle_id);
+	properties_changed_info_unqueue (info);
 
-	g_hash_table_destroy (info->hash);
+	g_hash_table_destroy (info->pending);
+	g_hash_table_destroy (info->last);
 	g_slice_free (NMPropertiesChangedInfo, info);
 }
 
@@ -96,37 +149,149 @@ add_to_string (gpointer key, gpointer value, gpointer user_data)
 	g_value_unset (&str_val);
 }
 
-static gboolean
-properties_changed (gpointer data)
+/* Returns what @value looks like on the bus, to compare it with the value
+ * emitted before; or %NULL if it can't be converted, in which case it is
+ * always emitted.
+ */
+static GVariant *
+value_to_variant (const GValue *value)
 {
-	GObject *object = G_OBJECT (data);
-	NMPropertiesChangedInfo *info = g_object_get_qdata (object, nm_properties_changed_signal_quark ());
+	if (G_VALUE_HOLDS_OBJECT (value))
+		return NULL;
+	if (G_VALUE_HOLDS_STRING (value) && !g_value_get_string (value))
+		return NULL;
+	if (G_VALUE_HOLDS_BOXED (value) && !g_value_get_boxed (value))
+		return NULL;
+
+	return g_variant_ref_sink (dbus_g_value_build_g_variant (value));
+}
+
+static void
+properties_changed (NMPropertiesChangedInfo *info)
+{
+	GObject *object = info->object;
+	GHashTable *pending, *hash;
+	GHashTableIter iter;
+	const char *dbus_name;
+	GParamSpec *pspec;
+	GVariant *variant, *last;
+	GValue *value;
 
-	g_assert (info);
+	hash = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, destroy_value);
+
+	/* Getters may notify again; those changes go into a new table and are
+	 * sent with the next signal.
+	 */
+	pending = info->pending;
+	info->pending = g_hash_table_new (g_str_hash, g_str_equal);
+
+	g_hash_table_iter_init (&iter, pending);
+	while (g_hash_table_iter_next (&iter, (gpointer) &dbus_name, (gpointer) &pspec)) {
+		value = g_slice_new0 (GValue);
+		g_value_init (value, pspec->value_type);
+		g_object_get_property (object, pspec->name, value);
+
+		variant = value_to_variant (value);
+		if (variant) {
+			last = g_hash_table_lookup (info->last, dbus_name);
+			if (last && g_variant_equal (last, variant)) {
+				stats.values_suppressed++;
+				g_variant_unref (variant);
+				destroy_value (value);
+				continue;
+			}
+			g_hash_table_insert (info->last, (char *) dbus_name, variant);
+		} else
+			g_hash_table_remove (info->last, dbus_name);
+
+		g_hash_table_insert (hash, (char *) dbus_name, value);
+	}
+	g_hash_table_destroy (pending);
+
+	if (!g_hash_table_size (hash)) {
+		stats.signals_suppressed++;
+		g_hash_table_destroy (hash);
+		return;
+	}
 
 	if (nm_logging_enabled (LOGL_DEBUG, LOGD_DBUS_PROPS)) {
 		GString *buf = g_string_new (NULL);
 
-		g_hash_table_foreach (info->hash, add_to_string, buf);
+		g_hash_table_foreach (hash, add_to_string, buf);
 		nm_log_dbg (LOGD_DBUS_PROPS, "%s -> %s", G_OBJECT_TYPE_NAME (object), buf->str);
 		g_string_free (buf, TRUE);
 	}
 
-	g_signal_emit (object, info->signal_id, 0, info->hash);
-	g_hash_table_remove_all (info->hash);
+	info->last_emitted_ms = nm_utils_get_monotonic_timestamp_ms ();
+	stats.signals_sent++;
+
+	g_object_ref (object);
+	g_signal_emit (object, info->signal_id, 0, hash);
+	g_object_unref (object);
+
+	g_hash_table_destroy (hash);
+}
+
+static gboolean
+throttle_done (gpointer user_data)
+{
+	NMPropertiesChangedInfo *info = user_data;
+
+	info->throttle_id = 0;
+	g_queue_delete_link (&throttled, info->throttled_link);
+	info->throttled_link = NULL;
 
-	return FALSE;
+	if (g_hash_table_size (info->pending))
+		properties_changed (info);
+
+	return G_SOURCE_REMOVE;
 }
 
+/* (Re)starts the wait of a throttled object for the current interval */
 static void
-idle_id_reset (gpointer data)
+throttle_schedule (NMPropertiesChangedInfo *info, gint64 now)
+{
+	gint64 wait = info->last_emitted_ms + min_emit_interval_ms - now;
+
+	if (info->throttle_id)
+		g_source_remove (info->throttle_id);
+	info->throttle_id = g_timeout_add (MAX (wait, 0), throttle_done, info);
+}
+
+static gboolean
+flush_queue (gpointer user_data)
 {
-	GObject *object = G_OBJECT (data);
-	NMPropertiesChangedInfo *info = g_object_get_qdata (object, nm_properties_changed_signal_quark ());
+	NMPropertiesChangedInfo *info;
+	gint64 now, wait;
+	guint sent = stats.signals_sent;
+
+	queue_idle_id = 0;
+	now = nm_utils_get_monotonic_timestamp_ms ();
+
+	while ((info = g_queue_pop_head (&queue))) {
+		info->queue_link = NULL;
+
+		wait = info->last_emitted_ms + min_emit_interval_ms - now;
+		if (info->last_emitted_ms && wait > 0) {
+			stats.throttled++;
+			g_queue_push_tail (&throttled, info);
+			info->throttled_link = throttled.tail;
+			throttle_schedule (info, now);
+			continue;
+		}
+
+		properties_changed (info);
+	}
+
+	if (stats.signals_sent != sent) {
+		nm_log_dbg (LOGD_DBUS_PROPS, "PropertiesChanged: %" G_GUINT64_FORMAT " sent, "
+		            "%" G_GUINT64_FORMAT " suppressed, %" G_GUINT64_FORMAT " unchanged values dropped, "
+		            "%" G_GUINT64_FORMAT " throttled",
+		            stats.signals_sent, stats.signals_suppressed,
+		            stats.values_suppressed, stats.throttled);
+	}
 
-	/* info is unset when the object is being destroyed */
-	if (info)
-		info->idle_id = 0;
+	return G_SOURCE_REMOVE;
 }
 
 static void
@@ -135,7 +300,6 @@ notify (GObject *object, GParamSpec *pspec)
 	NMPropertiesChangedClassInfo *classinfo;
 	NMPropertiesChangedInfo *info;
 	const char *dbus_property_name = NULL;
-	GValue *value;
 	GType type;
 
 	for (type = G_OBJECT_TYPE (object); type; type = g_type_parent (type)) {
@@ -156,21 +320,30 @@ notify (GObject *object, GParamSpec *pspec)
 	info = g_object_get_qdata (object, nm_properties_changed_signal_quark ());
 	if (!info) {
 		info = g_slice_new0 (NMPropertiesChangedInfo);
-		info->hash = g_hash_table_new_full (g_str_hash, g_str_equal,
-		                                    NULL, destroy_value);
+		info->object = object;
+		info->pending = g_hash_table_new (g_str_hash, g_str_equal);
+		info->last = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                    NULL, (GDestroyNotify) g_variant_unref);
 		info->signal_id = classinfo->signal_id;
 
 		g_object_set_qdata_full (object, nm_properties_changed_signal_quark (),
 		                         info, properties_changed_info_destroy);
+		g_object_weak_ref (object, object_disposed, info);
 	}
 
-	value = g_slice_new0 (GValue);
-	g_value_init (value, pspec->value_type);
-	g_object_get_property (object, pspec->name, value);
-	g_hash_table_insert (info->hash, (char *) dbus_property_name, value);
+	if (info->disposed)
+		return;
+
+	/* The value is read when the queue is flushed */
+	g_hash_table_insert (info->pending, (char *) dbus_property_name, pspec);
+
+	if (info->queue_link || info->throttle_id)
+		return;
 
-	if (!info->idle_id)
-		info->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, properties_changed, object, idle_id_reset);
+	g_queue_push_tail (&queue, info);
+	info->queue_link = queue.tail;
+	if (!queue_idle_id)
+		queue_idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, flush_queue, NULL, NULL);
 }
 
 static NMPropertiesChangedClassInfo *
@@ -241,3 +414,35 @@ nm_properties_changed_signal_add_property (GType       type,
 	                     hyphen_name,
 	                     (char *) dbus_property_name);
 }
+
+/**
+ * nm_properties_changed_signal_set_min_interval:
+ * @interval_ms: the new minimum time between two signals of an object
+ *
+ * Changes the rate limit, also for the signals already waiting for it.  The
+ * default is MIN_EMIT_INTERVAL_MS; this is mostly for tests, which can't
+ * rely on timing.
+ */
+void
+nm_properties_changed_signal_set_min_interval (guint interval_ms)
+{
+	gint64 now = nm_utils_get_monotonic_timestamp_ms ();
+	GList *iter;
+
+	min_emit_interval_ms = interval_ms;
+	for (iter = throttled.head; iter; iter = iter->next)
+		throttle_schedule (iter->data, now);
+}
+
+/**
+ * nm_properties_changed_signal_get_stats:
+ *
+ * Returns: counters of PropertiesChanged signals emitted and of the ones
+ * that weren't because nothing had really changed.  The manager's
+ * GetPropertiesChangedStats D-Bus method returns them too.
+ */
+const NMPropertiesChangedStats *
+nm_properties_changed_signal_get_stats (void)
+{
+	return &stats;
+}
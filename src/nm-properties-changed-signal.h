@@ -28,4 +28,15 @@ void nm_properties_changed_signal_add_property (GType       type,
                                                 const char *dbus_property_name,
                                                 const char *gobject_property_name);
 
+typedef struct {
+	guint64 signals_sent;        /* PropertiesChanged signals emitted */
+	guint64 signals_suppressed;  /* not emitted, as no value really changed */
+	guint64 values_suppressed;   /* changed properties dropped as unchanged */
+	guint64 throttled;           /* emissions postponed by the rate limit */
+} NMPropertiesChangedStats;
+
+const NMPropertiesChangedStats *nm_properties_changed_signal_get_stats (void);
+
+void nm_properties_changed_signal_set_min_interval (guint interval_ms);
+
 #endif /* _NM_PROPERTIES_CHANGED_SIGNAL_H_ */
@@ -0,0 +1,222 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ */
+
+#include "config.h"
+
+#include <unistd.h>
+
+#include "nm-trace.h"
+#include "NetworkManagerUtils.h"
+
+/* Events are kept in a fixed-size ring buffer that is only allocated once
+ * tracing is enabled; once it is full the oldest events are overwritten.
+ * The strings are copied into the events, so recording one never allocates
+ * and memory use stays at about 1 MiB however many different interface
+ * names and sysctl paths come up.
+ */
+#define TRACE_CAPACITY 8192
+
+typedef struct {
+	gint64 ts;               /* monotonic, in microseconds */
+	char category[16];
+	char subject[24];
+	char name[80];
+	char phase;
+} TraceEvent;
+
+static gboolean enabled;
+static TraceEvent *events;
+static guint64 events_recorded;
+
+void
+nm_trace_set_enabled (gboolean enable)
+{
+	enabled = enable;
+	if (enabled && !events)
+		events = g_new0 (TraceEvent, TRACE_CAPACITY);
+}
+
+gboolean
+nm_trace_enabled (void)
+{
+	return enabled;
+}
+
+void
+nm_trace_event (NMTracePhase phase,
+                const char *category,
+                const char *subject,
+                const char *name)
+{
+	TraceEvent *ev;
+
+	if (G_LIKELY (!enabled))
+		return;
+
+	g_return_if_fail (category != NULL);
+	g_return_if_fail (name != NULL);
+
+	ev = &events[events_recorded++ % TRACE_CAPACITY];
+	ev->ts = nm_utils_get_monotonic_timestamp_us ();
+	g_strlcpy (ev->category, category, sizeof (ev->category));
+	g_strlcpy (ev->subject, subject && *subject ? subject : "NetworkManager", sizeof (ev->subject));
+	g_strlcpy (ev->name, name, sizeof (ev->name));
+	ev->phase = phase;
+}
+
+/*******************************************************************/
+
+static void
+append_json_string (GString *json, const char *str)
+{
+	g_string_append_c (json, '"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			g_string_append_printf (json, "\\%c", *str);
+		else if ((guchar) *str < 0x20)
+			g_string_append_printf (json, "\\u%04x", (guchar) *str);
+		else
+			g_string_append_c (json, *str);
+	}
+	g_string_append_c (json, '"');
+}
+
+typedef struct {
+	GString *json;
+	GHashTable *tids;
+	gboolean empty;
+} JsonWriter;
+
+static guint
+writer_get_tid (JsonWriter *w, const char *subject)
+{
+	guint tid;
+
+	tid = GPOINTER_TO_UINT (g_hash_table_lookup (w->tids, subject));
+	if (!tid) {
+		tid = g_hash_table_size (w->tids) + 1;
+		g_hash_table_insert (w->tids, (gpointer) subject, GUINT_TO_POINTER (tid));
+
+		/* Name the track after the subject */
+		g_string_append_printf (w->json, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":",
+		                        w->empty ? "" : ",", getpid (), tid);
+		append_json_string (w->json, subject);
+		g_string_append (w->json, "}}");
+		w->empty = FALSE;
+	}
+	return tid;
+}
+
+static void
+writer_append (JsonWriter *w, const TraceEvent *ev, gint64 dur, gboolean unfinished)
+{
+	guint tid = writer_get_tid (w, ev->subject);
+
+	g_string_append (w->json, w->empty ? "\n{\"name\":" : ",\n{\"name\":");
+	append_json_string (w->json, ev->name);
+	g_string_append (w->json, ",\"cat\":");
+	append_json_string (w->json, ev->category);
+	if (ev->phase == NM_TRACE_PHASE_INSTANT) {
+		g_string_append_printf (w->json, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%" G_GINT64_FORMAT,
+		                        ev->ts);
+	} else {
+		g_string_append_printf (w->json, ",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT,
+		                        ev->ts, dur);
+	}
+	g_string_append_printf (w->json, ",\"pid\":%d,\"tid\":%u", getpid (), tid);
+	if (unfinished)
+		g_string_append (w->json, ",\"args\":{\"unfinished\":true}");
+	g_string_append_c (w->json, '}');
+	w->empty = FALSE;
+}
+
+/**
+ * nm_trace_to_json:
+ *
+ * Returns: (transfer full): the recorded events in the Chrome trace event
+ * format, with one track per subject.  Matching begin and end events are
+ * merged into one complete event; spans that haven't ended yet last until
+ * now and are marked as unfinished.
+ */
+char *
+nm_trace_to_json (void)
+{
+	JsonWriter w;
+	GHashTable *open;
+	GHashTableIter iter;
+	const TraceEvent *ev;
+	guint64 i;
+	gint64 now;
+
+	w.json = g_string_new ("{\"traceEvents\":[");
+	w.tids = g_hash_table_new (g_str_hash, g_str_equal);
+	w.empty = TRUE;
+	open = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	i = events_recorded > TRACE_CAPACITY ? events_recorded - TRACE_CAPACITY : 0;
+	for (; i < events_recorded; i++) {
+		const TraceEvent *begin;
+		char *key;
+
+		ev = &events[i % TRACE_CAPACITY];
+		if (ev->phase == NM_TRACE_PHASE_INSTANT) {
+			writer_append (&w, ev, 0, FALSE);
+			continue;
+		}
+
+		key = g_strdup_printf ("%s\n%s\n%s", ev->category, ev->subject, ev->name);
+		if (ev->phase == NM_TRACE_PHASE_BEGIN)
+			g_hash_table_replace (open, key, (gpointer) ev);
+		else {
+			/* The begin event may have been overwritten already */
+			begin = g_hash_table_lookup (open, key);
+			if (begin) {
+				writer_append (&w, begin, ev->ts - begin->ts, FALSE);
+				g_hash_table_remove (open, key);
+			}
+			g_free (key);
+		}
+	}
+
+	now = nm_utils_get_monotonic_timestamp_us ();
+	g_hash_table_iter_init (&iter, open);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &ev))
+		writer_append (&w, ev, now - ev->ts, TRUE);
+
+	g_string_append (w.json, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	g_hash_table_destroy (open);
+	g_hash_table_destroy (w.tids);
+	return g_string_free (w.json, FALSE);
+}
+
+gboolean
+nm_trace_write_file (const char *path, GError **error)
+{
+	char *json;
+	gboolean success;
+
+	g_return_val_if_fail (path != NULL, FALSE);
+
+	json = nm_trace_to_json ();
+	success = g_file_set_contents (path, json, -1, error);
+	g_free (json);
+	return success;
+}
@@ -0,0 +1,63 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_TRACE_H__
+#define __NETWORKMANAGER_TRACE_H__
+
+#include <glib.h>
+
+/* Trace categories */
+#define NM_TRACE_CAT_MANAGER    "manager"
+#define NM_TRACE_CAT_STATE      "state"
+#define NM_TRACE_CAT_STAGE      "stage"
+#define NM_TRACE_CAT_PENDING    "pending"
+#define NM_TRACE_CAT_PLATFORM   "platform"
+#define NM_TRACE_CAT_DISPATCHER "dispatcher"
+#define NM_TRACE_CAT_DHCP       "dhcp"
+#define NM_TRACE_CAT_RDISC      "rdisc"
+
+/* Phases, named like in the Chrome trace event format */
+typedef enum {
+	NM_TRACE_PHASE_BEGIN   = 'B',
+	NM_TRACE_PHASE_END     = 'E',
+	NM_TRACE_PHASE_INSTANT = 'i',
+} NMTracePhase;
+
+void     nm_trace_set_enabled (gboolean enabled);
+gboolean nm_trace_enabled (void);
+
+/* Records an event for @subject, usually an interface name, or for the
+ * daemon itself if @subject is %NULL.  The strings are copied, and cut off
+ * if they are too long.  Does nothing unless tracing is enabled.
+ */
+void     nm_trace_event (NMTracePhase phase,
+                         const char *category,
+                         const char *subject,
+                         const char *name);
+
+#define nm_trace_begin(category, subject, name)   nm_trace_event (NM_TRACE_PHASE_BEGIN, category, subject, name)
+#define nm_trace_end(category, subject, name)     nm_trace_event (NM_TRACE_PHASE_END, category, subject, name)
+#define nm_trace_instant(category, subject, name) nm_trace_event (NM_TRACE_PHASE_INSTANT, category, subject, name)
+
+char *   nm_trace_to_json (void);
+
+gboolean nm_trace_write_file (const char *path, GError **error);
+
+#endif /* __NETWORKMANAGER_TRACE_H__ */
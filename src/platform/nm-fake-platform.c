@@ -720,6 +720,18 @@ wifi_get_rate (NMPlatform *platform, int ifindex)
 	return 0;
 }
 
+static gboolean
+wifi_get_link_info (NMPlatform *platform, int ifindex, guint8 *bssid, int *quality, guint32 *rate)
+{
+	return FALSE;
+}
+
+static gboolean
+wifi_monitor_link (NMPlatform *platform, int ifindex, gboolean monitor)
+{
+	return !monitor;
+}
+
 static NM80211Mode
 wifi_get_mode (NMPlatform *platform, int ifindex)
 {
@@ -1333,6 +1345,8 @@ nm_fake_platform_class_init (NMFakePlatformClass *klass)
 	platform_class->wifi_get_frequency = wifi_get_frequency;
 	platform_class->wifi_get_quality = wifi_get_quality;
 	platform_class->wifi_get_rate = wifi_get_rate;
+	platform_class->wifi_get_link_info = wifi_get_link_info;
+	platform_class->wifi_monitor_link = wifi_monitor_link;
 	platform_class->wifi_get_mode = wifi_get_mode;
 	platform_class->wifi_set_mode = wifi_set_mode;
 	platform_class->wifi_find_frequency = wifi_find_frequency;
@@ -89,7 +89,7 @@ typedef struct {
 	guint event_id;
 
 	GUdevClient *udev_client;
-	GHashTable *udev_devices;
+	GHashTable *udev_devices; /* ifindex -> UdevLinkInfo */
 
 	GHashTable *wifi_data;
 
@@ -99,6 +99,19 @@ typedef struct {
 
 #define NM_LINUX_PLATFORM_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_LINUX_PLATFORM, NMLinuxPlatformPrivate))
 
+/* What udev and ethtool tell about a link.  Finding out takes sysfs reads,
+ * ioctls and walking up the udev device tree, so it is done when udev
+ * announces the device (or renames or changes it) instead of every time
+ * the link is read from the kernel.
+ */
+typedef struct {
+	GUdevDevice *device;
+	NMLinkType type;             /* NM_LINK_TYPE_UNKNOWN if udev can't tell */
+	const char *type_name;
+	const char *driver;          /* interned */
+	const char *ethtool_driver;  /* interned */
+} UdevLinkInfo;
+
 G_DEFINE_TYPE (NMLinuxPlatform, nm_linux_platform, NM_TYPE_PLATFORM)
 
 static const char *to_string_object (NMPlatform *platform, struct nl_object *obj);
@@ -748,18 +761,12 @@ type_to_string (NMLinkType type)
 	} G_STMT_END
 
 static NMLinkType
-link_type_from_udev (NMPlatform *platform, int ifindex, const char *ifname, int arptype, const char **out_name)
+udev_detect_link_type (GUdevDevice *udev_device, const char *ifname, const char **out_name)
 {
-	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	GUdevDevice *udev_device;
 	const char *prop, *sysfs_path;
 
 	g_assert (ifname);
 
-	udev_device = g_hash_table_lookup (priv->udev_devices, GINT_TO_POINTER (ifindex));
-	if (!udev_device)
-		return_type (NM_LINK_TYPE_UNKNOWN, "unknown");
-
 	if (   g_udev_device_get_property (udev_device, "ID_NM_OLPC_MESH")
 	    || g_udev_device_get_sysfs_attr (udev_device, "anycast_mask"))
 		return_type (NM_LINK_TYPE_OLPC_MESH, "olpc-mesh");
@@ -773,6 +780,24 @@ link_type_from_udev (NMPlatform *platform, int ifindex, const char *ifname, int
 	else if (g_strcmp0 (prop, "wimax") == 0)
 		return_type (NM_LINK_TYPE_WIMAX, "wimax");
 
+	return_type (NM_LINK_TYPE_UNKNOWN, "unknown");
+}
+
+static NMLinkType
+link_type_from_udev (NMPlatform *platform, int ifindex, const char *ifname, int arptype, const char **out_name)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	UdevLinkInfo *udev_info;
+
+	g_assert (ifname);
+
+	udev_info = g_hash_table_lookup (priv->udev_devices, GINT_TO_POINTER (ifindex));
+	if (!udev_info)
+		return_type (NM_LINK_TYPE_UNKNOWN, "unknown");
+
+	if (udev_info->type != NM_LINK_TYPE_UNKNOWN)
+		return_type (udev_info->type, udev_info->type_name);
+
 	if (arptype == ARPHRD_ETHER)
 		return_type (NM_LINK_TYPE_ETHERNET, "ethernet");
 
@@ -860,6 +885,7 @@ link_extract_type (NMPlatform *platform, struct rtnl_link *rtnllink, const char
 
 	if (!type) {
 		int arptype = rtnl_link_get_arptype (rtnllink);
+		UdevLinkInfo *udev_info;
 		const char *driver;
 		const char *ifname;
 
@@ -881,7 +907,12 @@ link_extract_type (NMPlatform *platform, struct rtnl_link *rtnllink, const char
 				return_type (NM_LINK_TYPE_ETHERNET, "ethernet");
 		}
 
-		driver = ethtool_get_driver (ifname);
+		udev_info = g_hash_table_lookup (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->udev_devices,
+		                                 GINT_TO_POINTER (rtnl_link_get_ifindex (rtnllink)));
+		if (udev_info)
+			driver = udev_info->ethtool_driver;
+		else
+			driver = ethtool_get_driver (ifname);
 		if (!g_strcmp0 (driver, "openvswitch"))
 			return_type (NM_LINK_TYPE_OPENVSWITCH, "openvswitch");
 
@@ -979,11 +1010,31 @@ udev_get_driver (NMPlatform *platform, GUdevDevice *device, int ifindex)
 	return driver;
 }
 
+static UdevLinkInfo *
+udev_link_info_new (NMPlatform *platform, GUdevDevice *udev_device, const char *ifname, int ifindex)
+{
+	UdevLinkInfo *udev_info;
+
+	udev_info = g_slice_new0 (UdevLinkInfo);
+	udev_info->device = g_object_ref (udev_device);
+	udev_info->type = udev_detect_link_type (udev_device, ifname, &udev_info->type_name);
+	udev_info->driver = udev_get_driver (platform, udev_device, ifindex);
+	udev_info->ethtool_driver = ethtool_get_driver (ifname);
+	return udev_info;
+}
+
+static void
+udev_link_info_free (UdevLinkInfo *udev_info)
+{
+	g_object_unref (udev_info->device);
+	g_slice_free (UdevLinkInfo, udev_info);
+}
+
 static gboolean
 init_link (NMPlatform *platform, NMPlatformLink *info, struct rtnl_link *rtnllink)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	GUdevDevice *udev_device;
+	UdevLinkInfo *udev_info;
 	const char *name;
 
 	g_return_val_if_fail (rtnllink, FALSE);
@@ -1004,16 +1055,16 @@ init_link (NMPlatform *platform, NMPlatformLink *info, struct rtnl_link *rtnllin
 	info->parent = rtnl_link_get_link (rtnllink);
 	info->mtu = rtnl_link_get_mtu (rtnllink);
 
-	udev_device = g_hash_table_lookup (priv->udev_devices, GINT_TO_POINTER (info->ifindex));
-	if (udev_device) {
-		info->driver = udev_get_driver (platform, udev_device, info->ifindex);
+	udev_info = g_hash_table_lookup (priv->udev_devices, GINT_TO_POINTER (info->ifindex));
+	if (udev_info) {
+		info->driver = udev_info->driver;
 		if (!info->driver)
 			info->driver = rtnl_link_get_type (rtnllink);
 		if (!info->driver)
-			info->driver = ethtool_get_driver (info->name);
+			info->driver = udev_info->ethtool_driver;
 		if (!info->driver)
 			info->driver = "unknown";
-		info->udi = g_udev_device_get_sysfs_path (udev_device);
+		info->udi = g_udev_device_get_sysfs_path (udev_info->device);
 	}
 
 	return TRUE;
@@ -3337,6 +3388,33 @@ wifi_get_rate (NMPlatform *platform, int ifindex)
 	return wifi_utils_get_rate (wifi_data);
 }
 
+static gboolean
+wifi_get_link_info (NMPlatform *platform, int ifindex, guint8 *bssid, int *quality, guint32 *rate)
+{
+	WifiData *wifi_data = wifi_get_wifi_data (platform, ifindex);
+
+	if (!wifi_data)
+		return FALSE;
+	return wifi_utils_get_link_info (wifi_data, bssid, quality, rate);
+}
+
+static void
+wifi_link_event (int ifindex, gboolean bss_changed, gpointer user_data)
+{
+	g_signal_emit_by_name (NM_PLATFORM (user_data), NM_PLATFORM_SIGNAL_WIFI_LINK_EVENT,
+	                       ifindex, bss_changed);
+}
+
+static gboolean
+wifi_monitor_link (NMPlatform *platform, int ifindex, gboolean monitor)
+{
+	WifiData *wifi_data = wifi_get_wifi_data (platform, ifindex);
+
+	if (!wifi_data)
+		return FALSE;
+	return wifi_utils_monitor_link (wifi_data, monitor ? wifi_link_event : NULL, platform);
+}
+
 static NM80211Mode
 wifi_get_mode (NMPlatform *platform, int ifindex)
 {
@@ -4223,7 +4301,7 @@ udev_device_added (NMPlatform *platform,
 		was_announceable = link_is_announceable (platform, rtnllink);
 
 	g_hash_table_insert (priv->udev_devices, GINT_TO_POINTER (ifindex),
-	                     g_object_ref (udev_device));
+	                     udev_link_info_new (platform, udev_device, ifname, ifindex));
 
 	/* Announce devices only if they also have been discovered via Netlink. */
 	if (rtnllink && link_is_announceable (platform, rtnllink))
@@ -4251,7 +4329,7 @@ udev_device_removed (NMPlatform *platform,
 		 */
 		g_hash_table_iter_init (&iter, priv->udev_devices);
 		while (g_hash_table_iter_next (&iter, &key, &value)) {
-			if ((GUdevDevice *)value == udev_device) {
+			if (((UdevLinkInfo *) value)->device == udev_device) {
 				ifindex = GPOINTER_TO_INT (key);
 				break;
 			}
@@ -4296,7 +4374,8 @@ handle_udev_event (GUdevClient *client,
 	       action, subsys, g_udev_device_get_name (udev_device),
 	       ifindex ? ifindex : "unknown", seqnum);
 
-	if (!strcmp (action, "add") || !strcmp (action, "move"))
+	/* "change" may bring new properties, e.g. from rules run later */
+	if (!strcmp (action, "add") || !strcmp (action, "move") || !strcmp (action, "change"))
 		udev_device_added (platform, udev_device);
 	if (!strcmp (action, "remove"))
 		udev_device_removed (platform, udev_device);
@@ -4380,7 +4459,7 @@ setup (NMPlatform *platform)
 	/* Set up udev monitoring */
 	priv->udev_client = g_udev_client_new (udev_subsys);
 	g_signal_connect (priv->udev_client, "uevent", G_CALLBACK (handle_udev_event), platform);
-	priv->udev_devices = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+	priv->udev_devices = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) udev_link_info_free);
 
 	/* And read initial device list */
 	enumerator = g_udev_enumerator_new (priv->udev_client);
@@ -4505,6 +4584,8 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->wifi_get_frequency = wifi_get_frequency;
 	platform_class->wifi_get_quality = wifi_get_quality;
 	platform_class->wifi_get_rate = wifi_get_rate;
+	platform_class->wifi_get_link_info = wifi_get_link_info;
+	platform_class->wifi_monitor_link = wifi_monitor_link;
 	platform_class->wifi_get_mode = wifi_get_mode;
 	platform_class->wifi_set_mode = wifi_set_mode;
 	platform_class->wifi_find_frequency = wifi_find_frequency;
@@ -25,6 +25,7 @@
 #include <unistd.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <net/ethernet.h>
 #include <string.h>
 #include <netlink/route/addr.h>
 
@@ -35,6 +36,7 @@
 #include "NetworkManagerUtils.h"
 #include "nm-logging.h"
 #include "nm-enum-types.h"
+#include "nm-trace.h"
 
 #define debug(...) nm_log_dbg (LOGD_PLATFORM, __VA_ARGS__)
 
@@ -49,6 +51,7 @@ enum {
 	SIGNAL_IP6_ADDRESS_CHANGED,
 	SIGNAL_IP4_ROUTE_CHANGED,
 	SIGNAL_IP6_ROUTE_CHANGED,
+	SIGNAL_WIFI_LINK_EVENT,
 	LAST_SIGNAL
 };
 
@@ -235,6 +238,19 @@ nm_platform_check_support_user_ipv6ll (void)
 
 /******************************************************************/
 
+/* Copies the interface name of @ifindex for the activation trace, as the
+ * call being traced may change the link cache.
+ */
+static void
+trace_subject (int ifindex, char subject[IFNAMSIZ])
+{
+	const char *name = NULL;
+
+	if (nm_trace_enabled ())
+		name = nm_platform_link_get_name (ifindex);
+	g_strlcpy (subject, name ? name : "", IFNAMSIZ);
+}
+
 /**
  * nm_platform_sysctl_set:
  * @path: Absolute option path
@@ -249,13 +265,18 @@ nm_platform_check_support_user_ipv6ll (void)
 gboolean
 nm_platform_sysctl_set (const char *path, const char *value)
 {
+	gboolean success;
+
 	reset_error ();
 
 	g_return_val_if_fail (path, FALSE);
 	g_return_val_if_fail (value, FALSE);
 	g_return_val_if_fail (klass->sysctl_set, FALSE);
 
-	return klass->sysctl_set (platform, path, value);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, NULL, path);
+	success = klass->sysctl_set (platform, path, value);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, NULL, path);
+	return success;
 }
 
 /**
@@ -492,6 +513,8 @@ nm_platform_link_get (int ifindex, NMPlatformLink *link)
 static gboolean
 nm_platform_link_add (const char *name, NMLinkType type, const void *address, size_t address_len)
 {
+	gboolean success;
+
 	reset_error ();
 
 	g_return_val_if_fail (name, FALSE);
@@ -504,7 +527,10 @@ nm_platform_link_add (const char *name, NMLinkType type, const void *address, si
 		return FALSE;
 	}
 
-	return klass->link_add (platform, name, type, address, address_len);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, name, "link-add");
+	success = klass->link_add (platform, name, type, address, address_len);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, name, "link-add");
+	return success;
 }
 
 /**
@@ -862,13 +888,20 @@ nm_platform_link_supports_vlans (int ifindex)
 gboolean
 nm_platform_link_set_up (int ifindex)
 {
+	char subject[IFNAMSIZ];
+	gboolean success;
+
 	reset_error ();
 
 	g_return_val_if_fail (ifindex > 0, FALSE);
 	g_return_val_if_fail (klass->link_set_up, FALSE);
 
 	debug ("link: setting up '%s' (%d)", nm_platform_link_get_name (ifindex), ifindex);
-	return klass->link_set_up (platform, ifindex);
+	trace_subject (ifindex, subject);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, subject, "link-set-up");
+	success = klass->link_set_up (platform, ifindex);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, subject, "link-set-up");
+	return success;
 }
 
 /**
@@ -880,13 +913,20 @@ nm_platform_link_set_up (int ifindex)
 gboolean
 nm_platform_link_set_down (int ifindex)
 {
+	char subject[IFNAMSIZ];
+	gboolean success;
+
 	reset_error ();
 
 	g_return_val_if_fail (ifindex > 0, FALSE);
 	g_return_val_if_fail (klass->link_set_down, FALSE);
 
 	debug ("link: setting down '%s' (%d)", nm_platform_link_get_name (ifindex), ifindex);
-	return klass->link_set_down (platform, ifindex);
+	trace_subject (ifindex, subject);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, subject, "link-set-down");
+	success = klass->link_set_down (platform, ifindex);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, subject, "link-set-down");
+	return success;
 }
 
 /**
@@ -1007,6 +1047,9 @@ nm_platform_link_get_wake_on_lan (int ifindex)
 gboolean
 nm_platform_link_enslave (int master, int slave)
 {
+	char subject[IFNAMSIZ];
+	gboolean success;
+
 	reset_error ();
 
 	g_assert (platform);
@@ -1017,7 +1060,11 @@ nm_platform_link_enslave (int master, int slave)
 	debug ("link: enslaving '%s' (%d) to master '%s' (%d)",
 		nm_platform_link_get_name (slave), slave,
 		nm_platform_link_get_name (master), master);
-	return klass->link_enslave (platform, master, slave);
+	trace_subject (slave, subject);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, subject, "link-enslave");
+	success = klass->link_enslave (platform, master, slave);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, subject, "link-enslave");
+	return success;
 }
 
 /**
@@ -1030,6 +1077,9 @@ nm_platform_link_enslave (int master, int slave)
 gboolean
 nm_platform_link_release (int master, int slave)
 {
+	char subject[IFNAMSIZ];
+	gboolean success;
+
 	reset_error ();
 
 	g_assert (platform);
@@ -1045,7 +1095,11 @@ nm_platform_link_release (int master, int slave)
 	debug ("link: releasing '%s' (%d) from master '%s' (%d)",
 		nm_platform_link_get_name (slave), slave,
 		nm_platform_link_get_name (master), master);
-	return klass->link_release (platform, master, slave);
+	trace_subject (slave, subject);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, subject, "link-release");
+	success = klass->link_release (platform, master, slave);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, subject, "link-release");
+	return success;
 }
 
 /**
@@ -1379,6 +1433,55 @@ nm_platform_wifi_get_rate (int ifindex)
 	return klass->wifi_get_rate (platform, ifindex);
 }
 
+/**
+ * nm_platform_wifi_get_link_info:
+ * @ifindex: Interface index
+ * @bssid: (out): ETH_ALEN bytes for the BSSID of the current association
+ * @quality: (out): signal quality in percent, or -1
+ * @rate: (out): current bitrate in Kbps
+ *
+ * Reads everything periodic link monitoring needs with one query instead of
+ * one per value.
+ *
+ * Returns: %FALSE if the device is not associated.
+ */
+gboolean
+nm_platform_wifi_get_link_info (int ifindex, guint8 *bssid, int *quality, guint32 *rate)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (bssid != NULL, FALSE);
+	g_return_val_if_fail (quality != NULL, FALSE);
+	g_return_val_if_fail (rate != NULL, FALSE);
+
+	memset (bssid, 0, ETH_ALEN);
+	*quality = -1;
+	*rate = 0;
+
+	return klass->wifi_get_link_info (platform, ifindex, bssid, quality, rate);
+}
+
+/**
+ * nm_platform_wifi_monitor_link:
+ * @ifindex: Interface index
+ * @monitor: whether to start or stop monitoring
+ *
+ * Starts or stops emitting #NM_PLATFORM_SIGNAL_WIFI_LINK_EVENT for @ifindex.
+ *
+ * Returns: %FALSE if the driver can't report link events, in which case
+ * the caller has to keep polling.
+ */
+gboolean
+nm_platform_wifi_monitor_link (int ifindex, gboolean monitor)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+
+	return klass->wifi_monitor_link (platform, ifindex, monitor);
+}
+
 NM80211Mode
 nm_platform_wifi_get_mode (int ifindex)
 {
@@ -1508,6 +1611,9 @@ nm_platform_ip4_address_add (int ifindex,
                              guint32 preferred,
                              const char *label)
 {
+	char subject[IFNAMSIZ];
+	gboolean success;
+
 	reset_error ();
 
 	g_return_val_if_fail (ifindex > 0, FALSE);
@@ -1532,7 +1638,11 @@ nm_platform_ip4_address_add (int ifindex,
 
 		debug ("address: adding or updating IPv4 address: %s", nm_platform_ip4_address_to_string (&addr));
 	}
-	return klass->ip4_address_add (platform, ifindex, address, peer_address, plen, lifetime, preferred, label);
+	trace_subject (ifindex, subject);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, subject, "ip4-address-add");
+	success = klass->ip4_address_add (platform, ifindex, address, peer_address, plen, lifetime, preferred, label);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, subject, "ip4-address-add");
+	return success;
 }
 
 gboolean
@@ -1544,6 +1654,9 @@ nm_platform_ip6_address_add (int ifindex,
                              guint32 preferred,
                              guint flags)
 {
+	char subject[IFNAMSIZ];
+	gboolean success;
+
 	reset_error ();
 
 	g_return_val_if_fail (ifindex > 0, FALSE);
@@ -1566,7 +1679,11 @@ nm_platform_ip6_address_add (int ifindex,
 
 		debug ("address: adding or updating IPv6 address: %s", nm_platform_ip6_address_to_string (&addr));
 	}
-	return klass->ip6_address_add (platform, ifindex, address, peer_address, plen, lifetime, preferred, flags);
+	trace_subject (ifindex, subject);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, subject, "ip6-address-add");
+	success = klass->ip6_address_add (platform, ifindex, address, peer_address, plen, lifetime, preferred, flags);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, subject, "ip6-address-add");
+	return success;
 }
 
 gboolean
@@ -1913,6 +2030,9 @@ nm_platform_ip4_route_add (int ifindex, NMIPConfigSource source,
                            in_addr_t gateway, guint32 pref_src,
                            guint32 metric, guint32 mss)
 {
+	char subject[IFNAMSIZ];
+	gboolean success;
+
 	reset_error ();
 
 	g_return_val_if_fail (platform, FALSE);
@@ -1936,7 +2056,11 @@ nm_platform_ip4_route_add (int ifindex, NMIPConfigSource source,
 		       pref_src ? nm_utils_inet4_ntop (pref_src, pref_src_buf) : "",
 		       pref_src ? ")" : "");
 	}
-	return klass->ip4_route_add (platform, ifindex, source, network, plen, gateway, pref_src, metric, mss);
+	trace_subject (ifindex, subject);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, subject, "ip4-route-add");
+	success = klass->ip4_route_add (platform, ifindex, source, network, plen, gateway, pref_src, metric, mss);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, subject, "ip4-route-add");
+	return success;
 }
 
 gboolean
@@ -1944,6 +2068,9 @@ nm_platform_ip6_route_add (int ifindex, NMIPConfigSource source,
                            struct in6_addr network, int plen, struct in6_addr gateway,
                            guint32 metric, guint32 mss)
 {
+	char subject[IFNAMSIZ];
+	gboolean success;
+
 	g_return_val_if_fail (platform, FALSE);
 	g_return_val_if_fail (0 <= plen && plen <= 128, FALSE);
 	g_return_val_if_fail (klass->ip6_route_add, FALSE);
@@ -1961,7 +2088,11 @@ nm_platform_ip6_route_add (int ifindex, NMIPConfigSource source,
 
 		debug ("route: adding or updating IPv6 route: %s", nm_platform_ip6_route_to_string (&route));
 	}
-	return klass->ip6_route_add (platform, ifindex, source, network, plen, gateway, metric, mss);
+	trace_subject (ifindex, subject);
+	nm_trace_begin (NM_TRACE_CAT_PLATFORM, subject, "ip6-route-add");
+	success = klass->ip6_route_add (platform, ifindex, source, network, plen, gateway, metric, mss);
+	nm_trace_end (NM_TRACE_CAT_PLATFORM, subject, "ip6-route-add");
+	return success;
 }
 
 gboolean
@@ -2762,4 +2893,11 @@ nm_platform_class_init (NMPlatformClass *platform_class)
 	SIGNAL (SIGNAL_IP6_ADDRESS_CHANGED, log_ip6_address)
 	SIGNAL (SIGNAL_IP4_ROUTE_CHANGED, log_ip4_route)
 	SIGNAL (SIGNAL_IP6_ROUTE_CHANGED, log_ip6_route)
+
+	signals[SIGNAL_WIFI_LINK_EVENT] =
+		g_signal_new (NM_PLATFORM_SIGNAL_WIFI_LINK_EVENT,
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_FIRST,
+		              0, NULL, NULL, NULL,
+		              G_TYPE_NONE, 2, G_TYPE_INT, G_TYPE_BOOLEAN);
 }
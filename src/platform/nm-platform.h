@@ -400,6 +400,8 @@ typedef struct {
 	guint32     (*wifi_get_frequency)    (NMPlatform *, int ifindex);
 	int         (*wifi_get_quality)      (NMPlatform *, int ifindex);
 	guint32     (*wifi_get_rate)         (NMPlatform *, int ifindex);
+	gboolean    (*wifi_get_link_info)    (NMPlatform *, int ifindex, guint8 *bssid, int *quality, guint32 *rate);
+	gboolean    (*wifi_monitor_link)     (NMPlatform *, int ifindex, gboolean monitor);
 	NM80211Mode (*wifi_get_mode)         (NMPlatform *, int ifindex);
 	void        (*wifi_set_mode)         (NMPlatform *, int ifindex, NM80211Mode mode);
 	guint32     (*wifi_find_frequency)   (NMPlatform *, int ifindex, const guint32 *freqs);
@@ -459,6 +461,14 @@ typedef struct {
 #define NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED "ip4-route-changed"
 #define NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED "ip6-route-changed"
 
+/* Emitted for Wi-Fi links monitored with nm_platform_wifi_monitor_link()
+ * when the driver reports a new association, a roam or a disconnect
+ * (bss_changed is TRUE), or a significant change in signal strength.
+ *
+ * void (*wifi_link_event) (NMPlatform *platform, int ifindex, gboolean bss_changed);
+ */
+#define NM_PLATFORM_SIGNAL_WIFI_LINK_EVENT "wifi-link-event"
+
 /******************************************************************/
 
 GType nm_platform_get_type (void);
@@ -546,6 +556,8 @@ GByteArray *nm_platform_wifi_get_ssid         (int ifindex);
 guint32     nm_platform_wifi_get_frequency    (int ifindex);
 int         nm_platform_wifi_get_quality      (int ifindex);
 guint32     nm_platform_wifi_get_rate         (int ifindex);
+gboolean    nm_platform_wifi_get_link_info    (int ifindex, guint8 *bssid, int *quality, guint32 *rate);
+gboolean    nm_platform_wifi_monitor_link     (int ifindex, gboolean monitor);
 NM80211Mode nm_platform_wifi_get_mode         (int ifindex);
 void        nm_platform_wifi_set_mode         (int ifindex, NM80211Mode mode);
 guint32     nm_platform_wifi_find_frequency   (int ifindex, const guint32 *freqs);
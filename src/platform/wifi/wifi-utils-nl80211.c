@@ -51,8 +51,27 @@ typedef struct {
 	guint32 *freqs;
 	int num_freqs;
 	int phy;
+
+	/* Link event monitoring */
+	struct nl_sock *event_sock;
+	GIOChannel *event_channel;
+	guint event_id;
+	WifiLinkEventFunc event_func;
+	gpointer event_data;
+	gboolean event_pending;
+	gboolean event_bss_changed;
+
+	/* Associated BSSID as reported by CONNECT/ROAM events */
+	guint8 bssid[ETH_ALEN];
+	gboolean bssid_valid;
+
+	/* CQM RSSI threshold currently armed in the driver, in dBm; 0 if none */
+	gint32 cqm_thold;
 } WifiDataNl80211;
 
+#define CQM_RSSI_HYSTERESIS  4   /* dBm */
+#define CQM_RSSI_DEFAULT   -70   /* dBm */
+
 static int
 ack_handler (struct nl_msg *msg, void *arg)
 {
@@ -171,11 +190,14 @@ nl80211_send_and_recv (WifiDataNl80211 *nl80211,
 	                               valid_handler, valid_data);
 }
 
+static void nl80211_event_stop (WifiDataNl80211 *nl80211);
+
 static void
 wifi_nl80211_deinit (WifiData *parent)
 {
 	WifiDataNl80211 *nl80211 = (WifiDataNl80211 *) parent;
 
+	nl80211_event_stop (nl80211);
 	if (nl80211->nl_sock)
 		nl_socket_free (nl80211->nl_sock);
 	if (nl80211->nl_cb)
@@ -457,9 +479,12 @@ wifi_nl80211_get_bssid (WifiData *data, guint8 *out_bssid)
 }
 
 struct nl80211_station_info {
+	guint8 bssid[ETH_ALEN];
+	gboolean bssid_valid;
 	guint32 txrate;
 	gboolean txrate_valid;
 	guint8 signal;
+	gint8 signal_dbm;
 	gboolean signal_valid;
 };
 
@@ -503,6 +528,12 @@ nl80211_station_handler (struct nl_msg *msg, void *arg)
 	                      stats_policy))
 		return NL_SKIP;
 
+	if (sinfo[NL80211_STA_INFO_SIGNAL] != NULL) {
+		info->signal_dbm = (gint8) nla_get_u8 (sinfo[NL80211_STA_INFO_SIGNAL]);
+		info->signal = nl80211_xbm_to_percent (info->signal_dbm, 1);
+		info->signal_valid = TRUE;
+	}
+
 	if (sinfo[NL80211_STA_INFO_TX_BITRATE] == NULL)
 		return NL_SKIP;
 
@@ -518,11 +549,6 @@ nl80211_station_handler (struct nl_msg *msg, void *arg)
 	info->txrate = nla_get_u16 (rinfo[NL80211_RATE_INFO_BITRATE]) * 100;
 	info->txrate_valid = TRUE;
 
-	if (sinfo[NL80211_STA_INFO_SIGNAL] != NULL) {
-		info->signal = nl80211_xbm_to_percent ((gint8) nla_get_u8 (sinfo[NL80211_STA_INFO_SIGNAL]), 1);
-		info->signal_valid = TRUE;
-	}
-
 	return NL_SKIP;
 }
 
@@ -532,20 +558,42 @@ nl80211_get_ap_info (WifiDataNl80211 *nl80211,
 {
 	struct nl_msg *msg;
 	struct nl80211_bss_info bss_info;
+	gboolean cached;
+	int err;
 
 	memset(sta_info, 0, sizeof (*sta_info));
+	memset(&bss_info, 0, sizeof (bss_info));
 
-	nl80211_get_bss_info (nl80211, &bss_info);
-	if (!bss_info.valid)
-		return;
+	/* While link events are monitored the associated BSSID is already known
+	 * from CONNECT/ROAM notifications and the scan list dump can be skipped.
+	 */
+	cached = nl80211->bssid_valid;
+	if (cached)
+		memcpy (sta_info->bssid, nl80211->bssid, ETH_ALEN);
+	else {
+		nl80211_get_bss_info (nl80211, &bss_info);
+		if (!bss_info.valid)
+			return;
+		memcpy (sta_info->bssid, bss_info.bssid, ETH_ALEN);
+	}
+	sta_info->bssid_valid = TRUE;
 
 	msg = nl80211_alloc_msg (nl80211, NL80211_CMD_GET_STATION, 0);
 	if (msg) {
-		NLA_PUT (msg, NL80211_ATTR_MAC, ETH_ALEN, bss_info.bssid);
+		NLA_PUT (msg, NL80211_ATTR_MAC, ETH_ALEN, sta_info->bssid);
+
+		err = nl80211_send_and_recv (nl80211, msg, nl80211_station_handler, sta_info);
+		if (err < 0 && cached) {
+			/* We missed a disconnect or roam event; look the BSS up again */
+			nl80211->bssid_valid = FALSE;
+			nl80211_get_ap_info (nl80211, sta_info);
+			return;
+		}
 
-		nl80211_send_and_recv (nl80211, msg, nl80211_station_handler, sta_info);
 		if (!sta_info->signal_valid) {
 			/* Fall back to bss_info signal quality (both are in percent) */
+			if (cached)
+				nl80211_get_bss_info (nl80211, &bss_info);
 			sta_info->signal = bss_info.beacon_signal;
 		}
 	}
@@ -578,6 +626,237 @@ wifi_nl80211_get_qual (WifiData *data)
 	return sta_info.signal;
 }
 
+static gboolean
+nl80211_set_cqm_threshold (WifiDataNl80211 *nl80211, gint32 thold)
+{
+	struct nl_msg *msg;
+	struct nlattr *cqm;
+	int err;
+
+	msg = nl80211_alloc_msg (nl80211, NL80211_CMD_SET_CQM, 0);
+	if (!msg)
+		return FALSE;
+
+	cqm = nla_nest_start (msg, NL80211_ATTR_CQM);
+	if (!cqm)
+		goto nla_put_failure;
+	/* A threshold of 0 disables RSSI monitoring */
+	NLA_PUT_U32 (msg, NL80211_ATTR_CQM_RSSI_THOLD, (guint32) thold);
+	NLA_PUT_U32 (msg, NL80211_ATTR_CQM_RSSI_HYST, thold ? CQM_RSSI_HYSTERESIS : 0);
+	nla_nest_end (msg, cqm);
+
+	err = nl80211_send_and_recv (nl80211, msg, NULL, NULL);
+	if (err < 0) {
+		nm_log_dbg (LOGD_WIFI, "(%s): failed to set CQM RSSI threshold %d: %s",
+		            nl80211->parent.iface, thold, strerror (-err));
+		return FALSE;
+	}
+
+	nl80211->cqm_thold = thold;
+	return TRUE;
+
+ nla_put_failure:
+	nlmsg_free (msg);
+	return FALSE;
+}
+
+static gboolean
+wifi_nl80211_get_link_info (WifiData *data,
+                            guint8 *out_bssid,
+                            int *out_qual,
+                            guint32 *out_rate)
+{
+	WifiDataNl80211 *nl80211 = (WifiDataNl80211 *) data;
+	struct nl80211_station_info sta_info;
+
+	nl80211_get_ap_info (nl80211, &sta_info);
+	if (!sta_info.bssid_valid)
+		return FALSE;
+
+	memcpy (out_bssid, sta_info.bssid, ETH_ALEN);
+	*out_qual = sta_info.signal;
+	*out_rate = sta_info.txrate;
+
+	/* The driver only supports a single RSSI threshold, so keep it centered
+	 * on the current signal to be told about the next significant change.
+	 */
+	if (   nl80211->cqm_thold
+	    && sta_info.signal_valid
+	    && ABS (sta_info.signal_dbm - nl80211->cqm_thold) >= CQM_RSSI_HYSTERESIS)
+		nl80211_set_cqm_threshold (nl80211, sta_info.signal_dbm);
+
+	return TRUE;
+}
+
+static int
+nl80211_event_handler (struct nl_msg *msg, void *arg)
+{
+	WifiDataNl80211 *nl80211 = arg;
+	struct genlmsghdr *gnlh = nlmsg_data (nlmsg_hdr (msg));
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+
+	if (nla_parse (tb, NL80211_ATTR_MAX, genlmsg_attrdata (gnlh, 0),
+	               genlmsg_attrlen (gnlh, 0), NULL) < 0)
+		return NL_SKIP;
+
+	if (   !tb[NL80211_ATTR_IFINDEX]
+	    || nla_get_u32 (tb[NL80211_ATTR_IFINDEX]) != nl80211->parent.ifindex)
+		return NL_SKIP;
+
+	switch (gnlh->cmd) {
+	case NL80211_CMD_CONNECT:
+		if (   tb[NL80211_ATTR_STATUS_CODE]
+		    && nla_get_u16 (tb[NL80211_ATTR_STATUS_CODE]) != 0) {
+			nl80211->bssid_valid = FALSE;
+			nl80211->event_bss_changed = TRUE;
+			break;
+		}
+		/* fall through */
+	case NL80211_CMD_ROAM:
+		if (tb[NL80211_ATTR_MAC] && nla_len (tb[NL80211_ATTR_MAC]) == ETH_ALEN) {
+			memcpy (nl80211->bssid, nla_data (tb[NL80211_ATTR_MAC]), ETH_ALEN);
+			nl80211->bssid_valid = TRUE;
+		} else
+			nl80211->bssid_valid = FALSE;
+		nl80211->event_bss_changed = TRUE;
+		break;
+	case NL80211_CMD_DISCONNECT:
+		nl80211->bssid_valid = FALSE;
+		nl80211->event_bss_changed = TRUE;
+		break;
+	case NL80211_CMD_NOTIFY_CQM:
+		break;
+	default:
+		return NL_SKIP;
+	}
+
+	nl80211->event_pending = TRUE;
+	return NL_SKIP;
+}
+
+static gboolean
+nl80211_event_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	WifiDataNl80211 *nl80211 = user_data;
+	gboolean bss_changed;
+	int err;
+
+	nl80211->event_pending = FALSE;
+	nl80211->event_bss_changed = FALSE;
+
+	/* Drain the socket so that a burst of events results in one callback */
+	do {
+		err = nl_recvmsgs_default (nl80211->event_sock);
+	} while (err >= 0);
+
+	if (err != -NLE_AGAIN) {
+		/* Events were probably lost (socket overrun); forget the cached
+		 * BSSID and let the callback refresh everything.
+		 */
+		nm_log_dbg (LOGD_WIFI, "(%s): failed to read nl80211 events: %s",
+		            nl80211->parent.iface, nl_geterror (err));
+		nl80211->bssid_valid = FALSE;
+		nl80211->event_pending = TRUE;
+		nl80211->event_bss_changed = TRUE;
+	}
+
+	if (nl80211->event_pending && nl80211->event_func) {
+		bss_changed = nl80211->event_bss_changed;
+		/* May stop monitoring; don't touch nl80211 afterwards */
+		nl80211->event_func (nl80211->parent.ifindex, bss_changed, nl80211->event_data);
+	}
+
+	return TRUE;
+}
+
+static void
+nl80211_event_stop (WifiDataNl80211 *nl80211)
+{
+	if (nl80211->cqm_thold)
+		nl80211_set_cqm_threshold (nl80211, 0);
+	nl80211->cqm_thold = 0;
+	nl80211->bssid_valid = FALSE;
+	nl80211->event_func = NULL;
+	nl80211->event_data = NULL;
+
+	if (nl80211->event_id) {
+		g_source_remove (nl80211->event_id);
+		nl80211->event_id = 0;
+	}
+	if (nl80211->event_channel) {
+		g_io_channel_unref (nl80211->event_channel);
+		nl80211->event_channel = NULL;
+	}
+	if (nl80211->event_sock) {
+		nl_socket_free (nl80211->event_sock);
+		nl80211->event_sock = NULL;
+	}
+}
+
+static gboolean
+nl80211_event_start (WifiDataNl80211 *nl80211)
+{
+	int mlme_grp;
+
+	nl80211->event_sock = nl_socket_alloc ();
+	if (!nl80211->event_sock)
+		return FALSE;
+
+	if (genl_connect (nl80211->event_sock))
+		goto error;
+
+	mlme_grp = genl_ctrl_resolve_grp (nl80211->event_sock, "nl80211", "mlme");
+	if (mlme_grp < 0)
+		goto error;
+	if (nl_socket_add_membership (nl80211->event_sock, mlme_grp))
+		goto error;
+
+	nl_socket_disable_seq_check (nl80211->event_sock);
+	nl_socket_modify_cb (nl80211->event_sock, NL_CB_VALID, NL_CB_CUSTOM,
+	                     nl80211_event_handler, nl80211);
+	if (nl_socket_set_nonblocking (nl80211->event_sock))
+		goto error;
+
+	/* Signal strength changes are only reported once a threshold is armed.
+	 * Drivers without CQM support (and non-station modes) can't tell us
+	 * about them, so make the caller poll instead.
+	 */
+	if (!nl80211_set_cqm_threshold (nl80211, CQM_RSSI_DEFAULT))
+		goto error;
+
+	nl80211->event_channel = g_io_channel_unix_new (nl_socket_get_fd (nl80211->event_sock));
+	g_io_channel_set_encoding (nl80211->event_channel, NULL, NULL);
+	nl80211->event_id = g_io_add_watch (nl80211->event_channel,
+	                                    G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP,
+	                                    nl80211_event_cb, nl80211);
+	return TRUE;
+
+error:
+	nl80211_event_stop (nl80211);
+	return FALSE;
+}
+
+static gboolean
+wifi_nl80211_monitor_link (WifiData *data, WifiLinkEventFunc func, gpointer user_data)
+{
+	WifiDataNl80211 *nl80211 = (WifiDataNl80211 *) data;
+
+	if (!func) {
+		nl80211_event_stop (nl80211);
+		return TRUE;
+	}
+
+	if (!nl80211->event_sock && !nl80211_event_start (nl80211)) {
+		nm_log_dbg (LOGD_WIFI, "(%s): nl80211 link events unavailable, polling instead",
+		            nl80211->parent.iface);
+		return FALSE;
+	}
+
+	nl80211->event_func = func;
+	nl80211->event_data = user_data;
+	return TRUE;
+}
+
 #if HAVE_NL80211_CRITICAL_PROTOCOL_CMDS
 static gboolean
 wifi_nl80211_indicate_addressing_running (WifiData *data, gboolean running)
@@ -848,6 +1127,8 @@ wifi_nl80211_init (const char *iface, int ifindex)
 	nl80211->parent.get_bssid = wifi_nl80211_get_bssid;
 	nl80211->parent.get_rate = wifi_nl80211_get_rate;
 	nl80211->parent.get_qual = wifi_nl80211_get_qual;
+	nl80211->parent.get_link_info = wifi_nl80211_get_link_info;
+	nl80211->parent.monitor_link = wifi_nl80211_monitor_link;
 #if HAVE_NL80211_CRITICAL_PROTOCOL_CMDS
 	nl80211->parent.indicate_addressing_running = wifi_nl80211_indicate_addressing_running;
 #endif
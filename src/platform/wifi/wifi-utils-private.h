@@ -54,6 +54,14 @@ struct WifiData {
 	 */
 	int (*get_qual) (WifiData *data);
 
+	/* Return BSSID, quality and bitrate of the current association with as
+	 * few driver queries as possible; return FALSE if not associated.
+	 */
+	gboolean (*get_link_info) (WifiData *data, guint8 *out_bssid, int *out_qual, guint32 *out_rate);
+
+	/* Start (@func != NULL) or stop delivering link events */
+	gboolean (*monitor_link) (WifiData *data, WifiLinkEventFunc func, gpointer user_data);
+
 	void (*deinit) (WifiData *data);
 
 	gboolean (*get_wowlan) (WifiData *data);
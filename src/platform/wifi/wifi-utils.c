@@ -144,6 +144,38 @@ wifi_utils_get_qual (WifiData *data)
 	return data->get_qual (data);
 }
 
+gboolean
+wifi_utils_get_link_info (WifiData *data, guint8 *out_bssid, int *out_qual, guint32 *out_rate)
+{
+	g_return_val_if_fail (data != NULL, FALSE);
+	g_return_val_if_fail (out_bssid != NULL, FALSE);
+	g_return_val_if_fail (out_qual != NULL, FALSE);
+	g_return_val_if_fail (out_rate != NULL, FALSE);
+
+	memset (out_bssid, 0, ETH_ALEN);
+	*out_qual = -1;
+	*out_rate = 0;
+
+	if (data->get_link_info)
+		return data->get_link_info (data, out_bssid, out_qual, out_rate);
+
+	if (!data->get_bssid (data, out_bssid))
+		return FALSE;
+	*out_qual = data->get_qual (data);
+	*out_rate = data->get_rate (data);
+	return TRUE;
+}
+
+gboolean
+wifi_utils_monitor_link (WifiData *data, WifiLinkEventFunc func, gpointer user_data)
+{
+	g_return_val_if_fail (data != NULL, FALSE);
+
+	if (!data->monitor_link)
+		return func ? FALSE : TRUE;
+	return data->monitor_link (data, func, user_data);
+}
+
 gboolean
 wifi_utils_get_wowlan (WifiData *data)
 {
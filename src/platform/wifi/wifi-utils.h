@@ -59,6 +59,21 @@ guint32 wifi_utils_get_rate (WifiData *data);
 /* Returns quality 0 - 100% on succes, or -1 on error */
 int wifi_utils_get_qual (WifiData *data);
 
+/* Returns BSSID, quality and bitrate of the current association at once;
+ * out_bssid must be ETH_ALEN bytes.  Returns FALSE if not associated.
+ */
+gboolean wifi_utils_get_link_info (WifiData *data, guint8 *out_bssid, int *out_qual, guint32 *out_rate);
+
+/* Called when the driver reports a connect, roam or disconnect (@bss_changed
+ * is TRUE) or when the signal strength crossed the monitoring threshold.
+ */
+typedef void (*WifiLinkEventFunc) (int ifindex, gboolean bss_changed, gpointer user_data);
+
+/* Starts delivering link events to @func, or stops if @func is NULL.
+ * Returns FALSE if the driver can't report them and the caller must poll.
+ */
+gboolean wifi_utils_monitor_link (WifiData *data, WifiLinkEventFunc func, gpointer user_data);
+
 /* Tells the driver DHCP or SLAAC is running */
 gboolean wifi_utils_indicate_addressing_running (WifiData *data, gboolean running);
 
@@ -30,6 +30,7 @@
 
 #include "NetworkManagerUtils.h"
 #include "nm-logging.h"
+#include "nm-trace.h"
 #include "nm-platform.h"
 
 #define debug(...) nm_log_dbg (LOGD_IP6, __VA_ARGS__)
@@ -487,6 +488,7 @@ receive_ra (struct ndp *ndp, struct ndp_msg *msg, gpointer user_data)
 	 * come at any time.
 	 */
 	debug ("(%s): received router advertisement at %u", rdisc->ifname, now);
+	nm_trace_instant (NM_TRACE_CAT_RDISC, rdisc->ifname, "router advertisement");
 
 	clear_ra_timeout (NM_LNDP_RDISC (rdisc));
 	clear_rs_timeout (NM_LNDP_RDISC (rdisc));
@@ -666,6 +668,7 @@ rdisc_ra_timeout_cb (gpointer user_data)
 	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
 
 	priv->ra_timeout_id = 0;
+	nm_trace_instant (NM_TRACE_CAT_RDISC, NM_RDISC (rdisc)->ifname, "router advertisement timeout");
 	g_signal_emit_by_name (rdisc, NM_RDISC_RA_TIMEOUT);
 	return G_SOURCE_REMOVE;
 }
@@ -26,6 +26,7 @@
 #include "nm-rdisc.h"
 
 #include "nm-logging.h"
+#include "nm-trace.h"
 #include "nm-utils.h"
 
 #define debug(...) nm_log_dbg (LOGD_IP6, __VA_ARGS__)
@@ -58,6 +59,7 @@ nm_rdisc_start (NMRDisc *rdisc)
 	g_assert (klass->start);
 
 	debug ("(%s): starting router discovery: %d", rdisc->ifname, rdisc->ifindex);
+	nm_trace_instant (NM_TRACE_CAT_RDISC, rdisc->ifname, "router discovery started");
 
 	if (klass->start)
 		klass->start (rdisc);
@@ -129,6 +129,11 @@ typedef struct {
 	gint32 autoconnect_retry_time;
 	NMDeviceStateReason autoconnect_blocked_reason;
 
+	/* Asynchronous writes; see commit_changes() */
+	gpointer write_job;      /* WriteJob currently running in the write pool */
+	GQueue write_queue;      /* WriteJobs waiting for write_job to finish */
+	GSList *pending_deletes; /* DeleteInfo waiting for the write queue to drain */
+
 } NMSettingsConnectionPrivate;
 
 /**************************************************************/
@@ -516,8 +521,9 @@ ignore_cb (NMSettingsConnection *connection,
 
 /* Replaces the settings in this connection with those in 'new_connection'. If
  * any changes are made, commits them to permanent storage and to any other
- * subsystems watching this connection. Before returning, 'callback' is run
- * with the given 'user_data' along with any errors encountered.
+ * subsystems watching this connection. Once the write has finished, which is
+ * usually after this function returns, 'callback' is run with the given
+ * 'user_data' along with any errors encountered.
  */
 void
 nm_settings_connection_replace_and_commit (NMSettingsConnection *self,
@@ -540,9 +546,9 @@ nm_settings_connection_replace_and_commit (NMSettingsConnection *self,
 }
 
 static void
-commit_changes (NMSettingsConnection *self,
-                NMSettingsConnectionCommitFunc callback,
-                gpointer user_data)
+commit_succeeded (NMSettingsConnection *self,
+                  NMSettingsConnectionCommitFunc callback,
+                  gpointer user_data)
 {
 	/* Subclasses only call this function if the save was successful, so at
 	 * this point the connection is synced to disk and no longer unsaved.
@@ -554,6 +560,186 @@ commit_changes (NMSettingsConnection *self,
 	g_object_unref (self);
 }
 
+/**************************************************************/
+
+/* Plugin writes can block for a long time (fsync, slow storage), so they
+ * are done in a small shared thread pool.  Each connection has at most one
+ * write in the pool; further commits wait in the connection's write_queue
+ * so that the files always end up with the most recent settings.
+ */
+#define WRITE_POOL_MAX_THREADS 4
+
+static GThreadPool *write_pool = NULL;
+
+typedef struct {
+	NMSettingsConnection *self;
+	NMSettingsConnectionCommitFunc callback;
+	gpointer user_data;
+
+	/* Set when the write starts */
+	NMConnection *copy;
+	gpointer write_data;
+	gboolean (*write_func) (NMConnection *, gpointer, GError **);
+
+	/* Set by the worker thread */
+	gboolean success;
+	GError *error;
+} WriteJob;
+
+typedef struct {
+	NMSettingsConnectionDeleteFunc callback;
+	gpointer user_data;
+} DeleteInfo;
+
+static void write_queue_run (NMSettingsConnection *self);
+
+static void
+write_job_free (WriteJob *job)
+{
+	g_clear_object (&job->copy);
+	g_clear_error (&job->error);
+	g_object_unref (job->self);
+	g_slice_free (WriteJob, job);
+}
+
+static gboolean
+write_job_done (gpointer user_data)
+{
+	WriteJob *job = user_data;
+	NMSettingsConnection *self = job->self;
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	NMSettingsConnectionClass *klass = NM_SETTINGS_CONNECTION_GET_CLASS (self);
+
+	g_assert (priv->write_job == job);
+	priv->write_job = NULL;
+
+	if (klass->finish_write)
+		klass->finish_write (self, job->write_data, job->success);
+
+	if (job->success) {
+		/* The settings may have changed again while the write was in
+		 * progress; only mark the connection saved if what is on disk
+		 * still matches.
+		 */
+		if (nm_connection_compare (job->copy,
+		                           NM_CONNECTION (self),
+		                           NM_SETTING_COMPARE_FLAG_IGNORE_AGENT_OWNED_SECRETS |
+		                               NM_SETTING_COMPARE_FLAG_IGNORE_NOT_SAVED_SECRETS))
+			set_unsaved (self, FALSE);
+		job->callback (self, NULL, job->user_data);
+	} else {
+		nm_log_warn (LOGD_SETTINGS, "(%s/%s) failed to write connection: %s",
+		             nm_connection_get_uuid (NM_CONNECTION (self)),
+		             nm_connection_get_id (NM_CONNECTION (self)),
+		             job->error->message);
+		job->callback (self, job->error, job->user_data);
+	}
+
+	write_queue_run (self);
+	write_job_free (job);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+write_thread_func (gpointer data, gpointer user_data)
+{
+	WriteJob *job = data;
+
+	/* Only touch job->copy and job->write_data here; everything else is
+	 * owned by the main loop.
+	 */
+	job->success = job->write_func (job->copy, job->write_data, &job->error);
+	if (!job->success && !job->error) {
+		job->error = g_error_new_literal (NM_SETTINGS_ERROR,
+		                                  NM_SETTINGS_ERROR_FAILED,
+		                                  "Failed to write connection");
+	}
+
+	g_idle_add (write_job_done, job);
+}
+
+static void
+write_queue_run (NMSettingsConnection *self)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	NMSettingsConnectionClass *klass = NM_SETTINGS_CONNECTION_GET_CLASS (self);
+	WriteJob *job;
+
+	if (priv->write_job)
+		return;
+
+	job = g_queue_pop_head (&priv->write_queue);
+	if (!job) {
+		GSList *deletes = priv->pending_deletes, *iter;
+
+		/* All writes are done; run the deletes that waited for them */
+		priv->pending_deletes = NULL;
+		for (iter = deletes; iter; iter = iter->next) {
+			DeleteInfo *info = iter->data;
+
+			nm_settings_connection_delete (self, info->callback, info->user_data);
+			g_slice_free (DeleteInfo, info);
+		}
+		g_slist_free (deletes);
+		return;
+	}
+
+	/* Take the copy only now, so a write that waited in the queue picks up
+	 * any changes made in the meantime.
+	 */
+	job->copy = nm_simple_connection_new_clone (NM_CONNECTION (self));
+	job->write_func = klass->write_connection;
+	if (klass->prepare_write)
+		job->write_data = klass->prepare_write (self);
+
+	if (!write_pool)
+		write_pool = g_thread_pool_new (write_thread_func, NULL, WRITE_POOL_MAX_THREADS, FALSE, NULL);
+
+	priv->write_job = job;
+	g_thread_pool_push (write_pool, job, NULL);
+}
+
+/**
+ * nm_settings_connection_flush_writes:
+ *
+ * Waits for all writes in the write pool to finish and frees the pool.
+ * Their completion callbacks are not run anymore.
+ */
+void
+nm_settings_connection_flush_writes (void)
+{
+	if (write_pool) {
+		g_thread_pool_free (write_pool, FALSE, TRUE);
+		write_pool = NULL;
+	}
+}
+
+static void
+commit_changes (NMSettingsConnection *self,
+                NMSettingsConnectionCommitFunc callback,
+                gpointer user_data)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	WriteJob *job;
+
+	if (!NM_SETTINGS_CONNECTION_GET_CLASS (self)->write_connection) {
+		commit_succeeded (self, callback, user_data);
+		return;
+	}
+
+	/* The in-memory connection already has the new settings; the write
+	 * itself happens in the background and @callback is called once it
+	 * has finished.
+	 */
+	job = g_slice_new0 (WriteJob);
+	job->self = g_object_ref (self);
+	job->callback = callback;
+	job->user_data = user_data;
+	g_queue_push_tail (&priv->write_queue, job);
+
+	write_queue_run (self);
+}
+
 void
 nm_settings_connection_commit_changes (NMSettingsConnection *connection,
                                        NMSettingsConnectionCommitFunc callback,
@@ -580,8 +766,24 @@ nm_settings_connection_delete (NMSettingsConnection *connection,
                                NMSettingsConnectionDeleteFunc callback,
                                gpointer user_data)
 {
+	NMSettingsConnectionPrivate *priv;
+
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (connection));
 
+	priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (connection);
+	if (priv->write_job) {
+		DeleteInfo *info;
+
+		/* Don't let a queued write re-create the files after they were
+		 * removed; delete once all pending writes have finished.
+		 */
+		info = g_slice_new (DeleteInfo);
+		info->callback = callback;
+		info->user_data = user_data;
+		priv->pending_deletes = g_slist_append (priv->pending_deletes, info);
+		return;
+	}
+
 	if (NM_SETTINGS_CONNECTION_GET_CLASS (connection)->delete) {
 		NM_SETTINGS_CONNECTION_GET_CLASS (connection)->delete (connection,
 		                                                       callback ? callback : ignore_cb,
@@ -1107,14 +1309,14 @@ auth_start (NMSettingsConnection *self,
 
 /**** DBus method handlers ************************************/
 
-static gboolean
-check_writable (NMConnection *connection, GError **error)
+gboolean
+nm_settings_connection_check_writable (NMSettingsConnection *self, GError **error)
 {
 	NMSettingConnection *s_con;
 
-	g_return_val_if_fail (NM_IS_CONNECTION (connection), FALSE);
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (self), FALSE);
 
-	s_con = nm_connection_get_setting_connection (connection);
+	s_con = nm_connection_get_setting_connection (NM_CONNECTION (self));
 	if (!s_con) {
 		g_set_error_literal (error,
 		                     NM_SETTINGS_ERROR,
@@ -1214,12 +1416,17 @@ impl_settings_connection_get_settings (NMSettingsConnection *self,
 
 typedef struct {
 	DBusGMethodInvocation *context;
-	NMAgentManager *agent_mgr;
 	NMAuthSubject *subject;
 	NMConnection *new_settings;
 	gboolean save_to_disk;
 } UpdateInfo;
 
+typedef struct {
+	NMAuthSubject *subject;
+	NMSettingsConnectionCommitFunc callback;
+	gpointer callback_data;
+} ApplyUpdateInfo;
+
 static void
 has_some_secrets_cb (NMSetting *setting,
                      const char *key,
@@ -1275,28 +1482,12 @@ cached_secrets_to_connection (NMSettingsConnection *self, NMConnection *connecti
 }
 
 static void
-update_complete (NMSettingsConnection *self,
-                 UpdateInfo *info,
-                 GError *error)
-{
-	if (error)
-		dbus_g_method_return_error (info->context, error);
-	else
-		dbus_g_method_return (info->context);
-
-	g_clear_object (&info->subject);
-	g_clear_object (&info->agent_mgr);
-	g_clear_object (&info->new_settings);
-	memset (info, 0, sizeof (*info));
-	g_free (info);
-}
-
-static void
-con_update_cb (NMSettingsConnection *self,
-               GError *error,
-               gpointer user_data)
+apply_update_cb (NMSettingsConnection *self,
+                 GError *error,
+                 gpointer user_data)
 {
-	UpdateInfo *info = user_data;
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	ApplyUpdateInfo *info = user_data;
 	NMConnection *for_agent;
 
 	if (!error) {
@@ -1308,61 +1499,137 @@ con_update_cb (NMSettingsConnection *self,
 		nm_connection_clear_secrets_with_flags (for_agent,
 		                                        secrets_filter_cb,
 		                                        GUINT_TO_POINTER (NM_SETTING_SECRET_FLAG_AGENT_OWNED));
-		nm_agent_manager_save_secrets (info->agent_mgr, for_agent, info->subject);
+		nm_agent_manager_save_secrets (priv->agent_mgr, for_agent, info->subject);
 		g_object_unref (for_agent);
 	}
 
-	update_complete (self, info, error);
+	info->callback (self, error, info->callback_data);
+
+	g_object_unref (info->subject);
+	g_slice_free (ApplyUpdateInfo, info);
 }
 
-static void
-update_auth_cb (NMSettingsConnection *self,
-                DBusGMethodInvocation *context,
-                NMAuthSubject *subject,
-                GError *error,
-                gpointer data)
-{
-	UpdateInfo *info = data;
+/**
+ * nm_settings_connection_apply_update:
+ * @self: the #NMSettingsConnection
+ * @new_settings: (allow-none): the new settings, or %NULL to just save the
+ *   current ones
+ * @save_to_disk: whether to commit the changes to the backing plugin
+ * @subject: the subject the update is done for
+ * @callback: called when the update is done
+ * @user_data: data for @callback
+ *
+ * Updates @self with @new_settings on behalf of @subject, which must already
+ * have been authorized to modify the connection.  Existing secrets are kept
+ * if @new_settings has none, and agent-owned secrets are sent to the agents
+ * of @subject afterwards.
+ */
+void
+nm_settings_connection_apply_update (NMSettingsConnection *self,
+                                     NMConnection *new_settings,
+                                     gboolean save_to_disk,
+                                     NMAuthSubject *subject,
+                                     NMSettingsConnectionCommitFunc callback,
+                                     gpointer user_data)
+{
+	ApplyUpdateInfo *info;
 	GError *local = NULL;
 
-	if (error) {
-		update_complete (self, info, error);
-		return;
-	}
+	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
+	g_return_if_fail (NM_IS_AUTH_SUBJECT (subject));
+	g_return_if_fail (new_settings != NULL || save_to_disk == TRUE);
 
-	if (!any_secrets_present (info->new_settings)) {
-		/* If the new connection has no secrets, we do not want to remove all
-		 * secrets, rather we keep all the existing ones. Do that by merging
-		 * them in to the new connection.
-		 */
-		cached_secrets_to_connection (self, info->new_settings);
-	} else {
-		/* Cache the new secrets from the agent, as stuff like inotify-triggered
-		 * changes to connection's backing config files will blow them away if
-		 * they're in the main connection.
-		 */
-		update_agent_secrets_cache (self, info->new_settings);
+	info = g_slice_new0 (ApplyUpdateInfo);
+	info->subject = g_object_ref (subject);
+	info->callback = callback;
+	info->callback_data = user_data;
+
+	if (new_settings) {
+		if (!any_secrets_present (new_settings)) {
+			/* If the new connection has no secrets, we do not want to remove all
+			 * secrets, rather we keep all the existing ones. Do that by merging
+			 * them in to the new connection.
+			 */
+			cached_secrets_to_connection (self, new_settings);
+		} else {
+			/* Cache the new secrets from the agent, as stuff like inotify-triggered
+			 * changes to connection's backing config files will blow them away if
+			 * they're in the main connection.
+			 */
+			update_agent_secrets_cache (self, new_settings);
+		}
 	}
 
-	if (info->save_to_disk) {
+	if (save_to_disk) {
 		nm_settings_connection_replace_and_commit (self,
-		                                           info->new_settings,
-		                                           con_update_cb,
+		                                           new_settings,
+		                                           apply_update_cb,
 		                                           info);
 	} else {
 		/* Do nothing if there's nothing to update */
-		if (!nm_connection_compare (NM_CONNECTION (self), info->new_settings, NM_SETTING_COMPARE_FLAG_EXACT)) {
-			if (!nm_settings_connection_replace_settings (self, info->new_settings, TRUE, &local))
+		if (!nm_connection_compare (NM_CONNECTION (self), new_settings, NM_SETTING_COMPARE_FLAG_EXACT)) {
+			if (!nm_settings_connection_replace_settings (self, new_settings, TRUE, &local))
 				g_assert (local);
 		}
-		con_update_cb (self, local, info);
+		apply_update_cb (self, local, info);
 		g_clear_error (&local);
 	}
 }
 
-static const char *
-get_update_modify_permission (NMConnection *old, NMConnection *new)
+static void
+update_complete (NMSettingsConnection *self,
+                 GError *error,
+                 gpointer user_data)
+{
+	UpdateInfo *info = user_data;
+
+	if (error)
+		dbus_g_method_return_error (info->context, error);
+	else
+		dbus_g_method_return (info->context);
+
+	g_clear_object (&info->subject);
+	g_clear_object (&info->new_settings);
+	memset (info, 0, sizeof (*info));
+	g_free (info);
+}
+
+static void
+update_auth_cb (NMSettingsConnection *self,
+                DBusGMethodInvocation *context,
+                NMAuthSubject *subject,
+                GError *error,
+                gpointer data)
+{
+	UpdateInfo *info = data;
+
+	if (error) {
+		update_complete (self, error, info);
+		return;
+	}
+
+	nm_settings_connection_apply_update (self,
+	                                     info->new_settings,
+	                                     info->save_to_disk,
+	                                     info->subject,
+	                                     update_complete,
+	                                     info);
+}
+
+/**
+ * nm_settings_connection_get_modify_permission:
+ * @self: the #NMSettingsConnection
+ * @new_settings: (allow-none): settings @self would be updated with, or %NULL
+ *
+ * Returns: the permission a caller needs to modify or delete @self, or to
+ *   update it with @new_settings
+ */
+const char *
+nm_settings_connection_get_modify_permission (NMSettingsConnection *self,
+                                              NMConnection *new_settings)
 {
+	NMConnection *old = NM_CONNECTION (self);
+	NMConnection *new = new_settings ? new_settings : old;
 	NMSettingConnection *s_con;
 	guint32 orig_num = 0, new_num = 0;
 
@@ -1406,7 +1673,7 @@ impl_settings_connection_update_helper (NMSettingsConnection *self,
 	 * the problem (ex a system settings plugin that can't write connections out)
 	 * instead of over D-Bus.
 	 */
-	if (!check_writable (NM_CONNECTION (self), &error))
+	if (!nm_settings_connection_check_writable (self, &error))
 		goto error;
 
 	/* Check if the settings are valid first */
@@ -1442,13 +1709,11 @@ impl_settings_connection_update_helper (NMSettingsConnection *self,
 
 	info = g_malloc0 (sizeof (*info));
 	info->context = context;
-	info->agent_mgr = g_object_ref (priv->agent_mgr);
 	info->subject = subject;
 	info->save_to_disk = save_to_disk;
 	info->new_settings = tmp;
 
-	permission = get_update_modify_permission (NM_CONNECTION (self),
-	                                           tmp ? tmp : NM_CONNECTION (self));
+	permission = nm_settings_connection_get_modify_permission (self, tmp);
 	auth_start (self, context, subject, permission, update_auth_cb, info);
 	return;
 
@@ -1517,23 +1782,6 @@ delete_auth_cb (NMSettingsConnection *self,
 	nm_settings_connection_delete (self, con_delete_cb, context);
 }
 
-static const char *
-get_modify_permission_basic (NMSettingsConnection *connection)
-{
-	NMSettingConnection *s_con;
-
-	/* If the caller is the only user in the connection's permissions, then
-	 * we use the 'modify.own' permission instead of 'modify.system'.  If the
-	 * request affects more than just the caller, require 'modify.system'.
-	 */
-	s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
-	g_assert (s_con);
-	if (nm_setting_connection_get_num_permissions (s_con) == 1)
-		return NM_AUTH_PERMISSION_SETTINGS_MODIFY_OWN;
-
-	return NM_AUTH_PERMISSION_SETTINGS_MODIFY_SYSTEM;
-}
-
 static void
 impl_settings_connection_delete (NMSettingsConnection *self,
                                  DBusGMethodInvocation *context)
@@ -1541,7 +1789,7 @@ impl_settings_connection_delete (NMSettingsConnection *self,
 	NMAuthSubject *subject;
 	GError *error = NULL;
 	
-	if (!check_writable (NM_CONNECTION (self), &error)) {
+	if (!nm_settings_connection_check_writable (self, &error)) {
 		dbus_g_method_return_error (context, error);
 		g_error_free (error);
 		return;
@@ -1549,7 +1797,7 @@ impl_settings_connection_delete (NMSettingsConnection *self,
 
 	subject = _new_auth_subject (context, &error);
 	if (subject) {
-		auth_start (self, context, subject, get_modify_permission_basic (self), delete_auth_cb, NULL);
+		auth_start (self, context, subject, nm_settings_connection_get_modify_permission (self, NULL), delete_auth_cb, NULL);
 		g_object_unref (subject);
 	} else {
 		dbus_g_method_return_error (context, error);
@@ -1643,7 +1891,7 @@ impl_settings_connection_get_secrets (NMSettingsConnection *self,
 		auth_start (self,
 		            context,
 		            subject,
-		            get_modify_permission_basic (self),
+		            nm_settings_connection_get_modify_permission (self, NULL),
 		            dbus_get_secrets_auth_cb,
 		            g_strdup (setting_name));
 		g_object_unref (subject);
@@ -1704,7 +1952,7 @@ impl_settings_connection_clear_secrets (NMSettingsConnection *self,
 		auth_start (self,
 		            context,
 		            subject,
-		            get_modify_permission_basic (self),
+		            nm_settings_connection_get_modify_permission (self, NULL),
 		            dbus_clear_secrets_auth_cb,
 		            NULL);
 		g_object_unref (subject);
@@ -2188,6 +2436,8 @@ nm_settings_connection_init (NMSettingsConnection *self)
 	priv->autoconnect_retries = AUTOCONNECT_RETRIES_DEFAULT;
 	priv->autoconnect_blocked_reason = NM_DEVICE_STATE_REASON_NONE;
 
+	g_queue_init (&priv->write_queue);
+
 	g_signal_connect (self, NM_CONNECTION_SECRETS_CLEARED, G_CALLBACK (secrets_cleared_cb), NULL);
 	g_signal_connect (self, NM_CONNECTION_CHANGED, G_CALLBACK (changed_cb), GUINT_TO_POINTER (TRUE));
 }
@@ -105,6 +105,23 @@ struct _NMSettingsConnectionClass {
 
 	gboolean (*supports_secrets) (NMSettingsConnection *connection,
 	                              const char *setting_name);
+
+	/* Asynchronous commit.  If write_connection() is implemented, the default
+	 * commit_changes() queues the write instead of completing immediately.
+	 * Writes of one connection run in order: prepare_write() is called on the
+	 * main loop when the write starts and returns private data for it,
+	 * write_connection() then runs in a worker thread on a copy of the
+	 * settings, and finish_write() gets the data back on the main loop.
+	 */
+	gpointer (*prepare_write) (NMSettingsConnection *connection);
+
+	gboolean (*write_connection) (NMConnection *copy,
+	                              gpointer write_data,
+	                              GError **error);
+
+	void (*finish_write) (NMSettingsConnection *connection,
+	                      gpointer write_data,
+	                      gboolean success);
 };
 
 GType nm_settings_connection_get_type (void);
@@ -113,6 +130,8 @@ void nm_settings_connection_commit_changes (NMSettingsConnection *connection,
                                             NMSettingsConnectionCommitFunc callback,
                                             gpointer user_data);
 
+void nm_settings_connection_flush_writes (void);
+
 gboolean nm_settings_connection_replace_settings (NMSettingsConnection *self,
                                                   NMConnection *new_connection,
                                                   gboolean update_unsaved,
@@ -127,6 +146,19 @@ void nm_settings_connection_delete (NMSettingsConnection *connection,
                                     NMSettingsConnectionDeleteFunc callback,
                                     gpointer user_data);
 
+gboolean nm_settings_connection_check_writable (NMSettingsConnection *self,
+                                                GError **error);
+
+const char *nm_settings_connection_get_modify_permission (NMSettingsConnection *self,
+                                                          NMConnection *new_settings);
+
+void nm_settings_connection_apply_update (NMSettingsConnection *self,
+                                          NMConnection *new_settings,
+                                          gboolean save_to_disk,
+                                          NMAuthSubject *subject,
+                                          NMSettingsConnectionCommitFunc callback,
+                                          gpointer user_data);
+
 typedef void (*NMSettingsConnectionSecretsFunc) (NMSettingsConnection *connection,
                                                  guint32 call_id,
                                                  const char *agent_username,
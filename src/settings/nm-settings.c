@@ -94,10 +94,15 @@ EXPORT(nm_settings_connection_replace_settings)
 EXPORT(nm_settings_connection_replace_and_commit)
 /* END LINKER CRACKROCK */
 
+typedef struct _Batch Batch;
+
 static void claim_connection (NMSettings *self,
                               NMSettingsConnection *connection,
                               gboolean do_export);
 
+static void batch_connection_added (Batch *batch, NMSettingsConnection *connection);
+static void batch_connection_removed (Batch *batch, NMSettingsConnection *connection);
+
 static gboolean impl_settings_list_connections (NMSettings *self,
                                                 GPtrArray **connections,
                                                 GError **error);
@@ -114,6 +119,18 @@ static void impl_settings_add_connection_unsaved (NMSettings *self,
                                                   GHashTable *settings,
                                                   DBusGMethodInvocation *context);
 
+static void impl_settings_add_connections (NMSettings *self,
+                                           GPtrArray *connections,
+                                           DBusGMethodInvocation *context);
+
+static void impl_settings_update_connections (NMSettings *self,
+                                              GHashTable *connections,
+                                              DBusGMethodInvocation *context);
+
+static void impl_settings_delete_connections (NMSettings *self,
+                                              GPtrArray *connections,
+                                              DBusGMethodInvocation *context);
+
 static void impl_settings_load_connections (NMSettings *self,
                                             char **filenames,
                                             DBusGMethodInvocation *context);
@@ -151,6 +168,12 @@ typedef struct {
 	GSList *unmanaged_specs;
 	GSList *unrecognized_specs;
 	GSList *get_connections_cache;
+
+	/* Batched requests in progress; notifications are deferred meanwhile */
+	guint batch_depth;
+	gboolean batch_connections_changed;
+	Batch *batch_adding;          /* batch whose connections are being added */
+	GHashTable *batch_deleting;   /* NMSettingsConnection -> Batch */
 } NMSettingsPrivate;
 
 #define NM_SETTINGS_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_SETTINGS, NMSettingsPrivate))
@@ -164,7 +187,11 @@ enum {
 	CONNECTION_VISIBILITY_CHANGED,
 	AGENT_REGISTERED,
 
-	NEW_CONNECTION, /* exported, not used internally */
+	/* exported, not used internally */
+	NEW_CONNECTION,
+	DBUS_CONNECTION_REMOVED,
+	CONNECTIONS_ADDED,
+	CONNECTIONS_REMOVED,
 	LAST_SIGNAL
 };
 static guint signals[LAST_SIGNAL] = { 0 };
@@ -723,6 +750,17 @@ load_plugins (NMSettings *self, const char **plugins, GError **error)
 	return success;
 }
 
+static void
+notify_connections_changed (NMSettings *self)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	if (priv->batch_depth)
+		priv->batch_connections_changed = TRUE;
+	else
+		g_object_notify (G_OBJECT (self), NM_SETTINGS_CONNECTIONS);
+}
+
 static void
 connection_updated (NMSettingsConnection *connection, gpointer user_data)
 {
@@ -760,6 +798,8 @@ static void
 connection_removed (NMSettingsConnection *connection, gpointer user_data)
 {
 	NMSettings *self = NM_SETTINGS (user_data);
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	Batch *batch;
 
 	g_object_ref (connection);
 
@@ -773,16 +813,25 @@ connection_removed (NMSettingsConnection *connection, gpointer user_data)
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_updated_by_user), self);
 	g_signal_handlers_disconnect_by_func (connection, G_CALLBACK (connection_visibility_changed), self);
 
+	/* Notify D-Bus; connections deleted by a batched request are reported
+	 * together when it completes.
+	 */
+	batch = g_hash_table_lookup (priv->batch_deleting, connection);
+	if (batch) {
+		batch_connection_removed (batch, connection);
+		g_hash_table_remove (priv->batch_deleting, connection);
+	} else
+		g_signal_emit (self, signals[DBUS_CONNECTION_REMOVED], 0, connection);
+
 	/* Forget about the connection internally */
-	g_hash_table_remove (NM_SETTINGS_GET_PRIVATE (user_data)->connections,
+	g_hash_table_remove (priv->connections,
 	                     (gpointer) nm_connection_get_path (NM_CONNECTION (connection)));
 
-	/* Notify D-Bus */
 	g_signal_emit (self, signals[CONNECTION_REMOVED], 0, connection);
 
 	/* Re-emit for listeners like NMPolicy */
 	g_signal_emit_by_name (self, NM_CP_SIGNAL_CONNECTION_REMOVED, connection);
-	g_object_notify (G_OBJECT (self), NM_SETTINGS_CONNECTIONS);
+	notify_connections_changed (self);
 
 	g_object_unref (connection);
 }
@@ -910,10 +959,13 @@ claim_connection (NMSettings *self,
 		/* Internal added signal */
 		g_signal_emit (self, signals[CONNECTION_ADDED], 0, connection);
 		g_signal_emit_by_name (self, NM_CP_SIGNAL_CONNECTION_ADDED, connection);
-		g_object_notify (G_OBJECT (self), NM_SETTINGS_CONNECTIONS);
+		notify_connections_changed (self);
 
-		/* Exported D-Bus signal */
-		g_signal_emit (self, signals[NEW_CONNECTION], 0, connection);
+		/* Exported D-Bus signal; batched requests report additions together */
+		if (priv->batch_adding)
+			batch_connection_added (priv->batch_adding, connection);
+		else
+			g_signal_emit (self, signals[NEW_CONNECTION], 0, connection);
 	}
 }
 
@@ -1287,6 +1339,615 @@ impl_settings_add_connection_unsaved (NMSettings *self,
 	impl_settings_add_connection_helper (self, settings, FALSE, context);
 }
 
+/**************************************************************/
+
+/* Batched AddConnections/UpdateConnections/DeleteConnections.  The whole
+ * request is authorized with a single auth chain containing each distinct
+ * permission the items need.  New connections are handed to the plugin in
+ * one add_connections() transaction where the plugin supports it.  Until all
+ * items have been processed, the Connections property change is held back
+ * and the batch's own additions and removals are collected, to be announced
+ * by a single ConnectionsAdded and ConnectionsRemoved signal instead of one
+ * NewConnection or ConnectionRemoved signal per connection.  Changes made by
+ * anybody else in the meantime are signalled one by one as usual.
+ */
+
+typedef enum {
+	BATCH_OP_ADD,
+	BATCH_OP_UPDATE,
+	BATCH_OP_DELETE,
+} BatchOp;
+
+typedef struct {
+	Batch *batch;
+	char *path;                     /* target path; result path for add */
+	NMConnection *new_settings;     /* add, update */
+	NMSettingsConnection *target;   /* update, delete */
+	const char *perm;
+	GError *error;
+} BatchItem;
+
+struct _Batch {
+	NMSettings *self;
+	BatchOp op;
+	DBusGMethodInvocation *context;
+	NMAuthSubject *subject;
+	BatchItem *items;
+	guint num_items;
+	guint pending;
+	GPtrArray *added;     /* object paths */
+	GPtrArray *removed;   /* object paths */
+};
+
+static void
+batch_connection_added (Batch *batch, NMSettingsConnection *connection)
+{
+	g_ptr_array_add (batch->added, g_strdup (nm_connection_get_path (NM_CONNECTION (connection))));
+}
+
+static void
+batch_connection_removed (Batch *batch, NMSettingsConnection *connection)
+{
+	g_ptr_array_add (batch->removed, g_strdup (nm_connection_get_path (NM_CONNECTION (connection))));
+}
+
+static void
+batch_begin_coalesce (NMSettings *self)
+{
+	NM_SETTINGS_GET_PRIVATE (self)->batch_depth++;
+}
+
+static void
+batch_end_coalesce (NMSettings *self)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	g_return_if_fail (priv->batch_depth > 0);
+
+	if (--priv->batch_depth > 0)
+		return;
+
+	if (priv->batch_connections_changed) {
+		priv->batch_connections_changed = FALSE;
+		g_object_notify (G_OBJECT (self), NM_SETTINGS_CONNECTIONS);
+	}
+}
+
+static Batch *
+batch_new (NMSettings *self, BatchOp op, guint num_items, DBusGMethodInvocation *context)
+{
+	Batch *batch;
+	NMAuthSubject *subject;
+	GError *error = NULL;
+	guint i;
+
+	subject = nm_auth_subject_new_unix_process_from_context (context);
+	if (!subject) {
+		error = g_error_new_literal (NM_SETTINGS_ERROR,
+		                             NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                             "Unable to determine UID of request.");
+		dbus_g_method_return_error (context, error);
+		g_error_free (error);
+		return NULL;
+	}
+
+	batch = g_slice_new0 (Batch);
+	batch->self = g_object_ref (self);
+	batch->op = op;
+	batch->context = context;
+	batch->subject = subject;
+	batch->num_items = num_items;
+	batch->items = g_new0 (BatchItem, num_items);
+	for (i = 0; i < num_items; i++)
+		batch->items[i].batch = batch;
+	batch->added = g_ptr_array_new_with_free_func (g_free);
+	batch->removed = g_ptr_array_new_with_free_func (g_free);
+	return batch;
+}
+
+static void
+batch_free (Batch *batch)
+{
+	guint i;
+
+	for (i = 0; i < batch->num_items; i++) {
+		BatchItem *item = &batch->items[i];
+
+		g_free (item->path);
+		g_clear_object (&item->new_settings);
+		g_clear_object (&item->target);
+		g_clear_error (&item->error);
+	}
+	g_free (batch->items);
+	g_ptr_array_unref (batch->added);
+	g_ptr_array_unref (batch->removed);
+	g_object_unref (batch->subject);
+	g_object_unref (batch->self);
+	g_slice_free (Batch, batch);
+}
+
+static void
+batch_complete (Batch *batch)
+{
+	GPtrArray *paths;
+	GPtrArray *errors;
+	GHashTable *failures;
+	guint i;
+
+	/* Announce the changes before replying */
+	if (batch->added->len)
+		g_signal_emit (batch->self, signals[CONNECTIONS_ADDED], 0, batch->added);
+	if (batch->removed->len)
+		g_signal_emit (batch->self, signals[CONNECTIONS_REMOVED], 0, batch->removed);
+	batch_end_coalesce (batch->self);
+
+	if (batch->op == BATCH_OP_ADD) {
+		paths = g_ptr_array_sized_new (batch->num_items);
+		errors = g_ptr_array_sized_new (batch->num_items + 1);
+		for (i = 0; i < batch->num_items; i++) {
+			BatchItem *item = &batch->items[i];
+
+			g_ptr_array_add (paths, item->error ? (gpointer) "/" : item->path);
+			g_ptr_array_add (errors, item->error ? item->error->message : (gpointer) "");
+		}
+		g_ptr_array_add (errors, NULL);
+		dbus_g_method_return (batch->context, paths, (char **) errors->pdata);
+		g_ptr_array_unref (paths);
+		g_ptr_array_unref (errors);
+	} else {
+		failures = g_hash_table_new (g_str_hash, g_str_equal);
+		for (i = 0; i < batch->num_items; i++) {
+			BatchItem *item = &batch->items[i];
+
+			if (item->error)
+				g_hash_table_insert (failures, item->path, item->error->message);
+		}
+		dbus_g_method_return (batch->context, failures);
+		g_hash_table_unref (failures);
+	}
+
+	batch_free (batch);
+}
+
+static void
+batch_release (Batch *batch)
+{
+	g_return_if_fail (batch->pending > 0);
+
+	if (--batch->pending == 0)
+		batch_complete (batch);
+}
+
+static void
+batch_item_done (NMSettingsConnection *connection,
+                 GError *error,
+                 gpointer user_data)
+{
+	BatchItem *item = user_data;
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (item->batch->self);
+
+	/* The deletion failed, or the connection is still around for some other
+	 * reason; a later removal is no longer part of this batch.
+	 */
+	if (   item->batch->op == BATCH_OP_DELETE
+	    && g_hash_table_lookup (priv->batch_deleting, item->target) == item->batch)
+		g_hash_table_remove (priv->batch_deleting, item->target);
+
+	if (error && !item->error)
+		item->error = g_error_copy (error);
+	batch_release (item->batch);
+}
+
+static void
+batch_item_added (BatchItem *item, NMSettingsConnection *added)
+{
+	const char *path = nm_connection_get_path (NM_CONNECTION (added));
+
+	if (!path) {
+		item->error = g_error_new_literal (NM_SETTINGS_ERROR,
+		                                   NM_SETTINGS_ERROR_INVALID_CONNECTION,
+		                                   "The connection could not be added.");
+		return;
+	}
+	item->path = g_strdup (path);
+	send_agent_owned_secrets (item->batch->self, added, item->batch->subject);
+}
+
+/* Hands all new connections to the first modify-capable plugin in a single
+ * transaction.  If the plugin can't do that, or the transaction fails, the
+ * items are left to be added one by one.
+ */
+static void
+batch_add_all (Batch *batch)
+{
+	NMSettings *self = batch->self;
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	NMSystemConfigInterface *plugin;
+	GHashTable *uuids;
+	GHashTableIter citer;
+	NMConnection *candidate;
+	GSList *connections = NULL, *added, *iter;
+	GError *error = NULL;
+	guint i;
+
+	plugin = get_plugin (self, NM_SYSTEM_CONFIG_INTERFACE_CAP_MODIFY_CONNECTIONS);
+	if (!plugin || !nm_system_config_interface_can_add_connections (plugin))
+		return;
+
+	/* Refuse duplicate UUIDs, including ones repeated within the request */
+	uuids = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_iter_init (&citer, priv->connections);
+	while (g_hash_table_iter_next (&citer, NULL, (gpointer *) &candidate))
+		g_hash_table_add (uuids, (gpointer) nm_connection_get_uuid (candidate));
+
+	for (i = 0; i < batch->num_items; i++) {
+		BatchItem *item = &batch->items[i];
+		const char *uuid;
+
+		if (item->error)
+			continue;
+
+		uuid = nm_connection_get_uuid (item->new_settings);
+		if (g_hash_table_contains (uuids, uuid)) {
+			item->error = g_error_new_literal (NM_SETTINGS_ERROR,
+			                                   NM_SETTINGS_ERROR_UUID_EXISTS,
+			                                   "A connection with this UUID already exists.");
+			continue;
+		}
+		g_hash_table_add (uuids, (gpointer) uuid);
+		connections = g_slist_prepend (connections, item->new_settings);
+	}
+	g_hash_table_destroy (uuids);
+
+	if (!connections)
+		return;
+	connections = g_slist_reverse (connections);
+
+	added = nm_system_config_interface_add_connections (plugin, connections, TRUE, &error);
+	g_slist_free (connections);
+	if (!added) {
+		nm_log_dbg (LOGD_SETTINGS, "Failed to add connections in one transaction, adding them one by one: %s",
+		            error ? error->message : "(unknown)");
+		g_clear_error (&error);
+		return;
+	}
+
+	iter = added;
+	for (i = 0; i < batch->num_items && iter; i++) {
+		BatchItem *item = &batch->items[i];
+
+		if (item->error)
+			continue;
+
+		claim_connection (self, iter->data, TRUE);
+		batch_item_added (item, iter->data);
+		iter = iter->next;
+	}
+	g_slist_free (added);
+}
+
+static void
+batch_execute (Batch *batch)
+{
+	NMSettings *self = batch->self;
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	NMSettingsConnection *added;
+	guint i;
+
+	/* Hold the batch open until every item has been started */
+	batch->pending = 1;
+
+	/* Ended when the batch completes, after asynchronous items finished */
+	batch_begin_coalesce (self);
+
+	/* Adding is synchronous, so whatever gets claimed until the loop below
+	 * is done belongs to this batch.
+	 */
+	if (batch->op == BATCH_OP_ADD) {
+		priv->batch_adding = batch;
+		batch_add_all (batch);
+	}
+
+	for (i = 0; i < batch->num_items; i++) {
+		BatchItem *item = &batch->items[i];
+
+		if (item->error || (batch->op == BATCH_OP_ADD && item->path))
+			continue;
+
+		/* Connections may have gone away while authorization was pending */
+		if (   item->target
+		    && g_hash_table_lookup (priv->connections, item->path) != item->target) {
+			item->error = g_error_new_literal (NM_SETTINGS_ERROR,
+			                                   NM_SETTINGS_ERROR_INVALID_CONNECTION,
+			                                   "The connection was removed.");
+			continue;
+		}
+
+		switch (batch->op) {
+		case BATCH_OP_ADD:
+			added = nm_settings_add_connection (self, item->new_settings, TRUE, &item->error);
+			if (added)
+				batch_item_added (item, added);
+			break;
+		case BATCH_OP_UPDATE:
+			batch->pending++;
+			nm_settings_connection_apply_update (item->target,
+			                                     item->new_settings,
+			                                     TRUE,
+			                                     batch->subject,
+			                                     batch_item_done,
+			                                     item);
+			break;
+		case BATCH_OP_DELETE:
+			batch->pending++;
+			g_hash_table_insert (priv->batch_deleting, item->target, batch);
+			nm_settings_connection_delete (item->target, batch_item_done, item);
+			break;
+		}
+	}
+	priv->batch_adding = NULL;
+
+	batch_release (batch);
+}
+
+static void
+pk_batch_cb (NMAuthChain *chain,
+             GError *chain_error,
+             DBusGMethodInvocation *context,
+             gpointer user_data)
+{
+	Batch *batch = user_data;
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (batch->self);
+	NMAuthCallResult result;
+	guint i;
+
+	priv->auths = g_slist_remove (priv->auths, chain);
+
+	for (i = 0; i < batch->num_items; i++) {
+		BatchItem *item = &batch->items[i];
+
+		if (item->error || !item->perm)
+			continue;
+
+		result = nm_auth_chain_get_result (chain, item->perm);
+		if (chain_error) {
+			item->error = g_error_new (NM_SETTINGS_ERROR,
+			                           NM_SETTINGS_ERROR_FAILED,
+			                           "Error checking authorization: %s",
+			                           chain_error->message ? chain_error->message : "(unknown)");
+		} else if (result != NM_AUTH_CALL_RESULT_YES) {
+			item->error = g_error_new_literal (NM_SETTINGS_ERROR,
+			                                   NM_SETTINGS_ERROR_PERMISSION_DENIED,
+			                                   "Insufficient privileges.");
+		}
+	}
+
+	nm_auth_chain_unref (chain);
+	batch_execute (batch);
+}
+
+static void
+batch_authorize (Batch *batch)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (batch->self);
+	NMAuthChain *chain = NULL;
+	GHashTable *perms;
+	guint i;
+
+	/* Items only need 'modify.own' or 'modify.system'; ask for each once */
+	perms = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < batch->num_items; i++) {
+		BatchItem *item = &batch->items[i];
+
+		if (!item->error && item->perm)
+			g_hash_table_add (perms, (gpointer) item->perm);
+	}
+
+	if (g_hash_table_size (perms) > 0) {
+		GHashTableIter iter;
+		const char *perm;
+
+		chain = nm_auth_chain_new_subject (batch->subject, batch->context, pk_batch_cb, batch);
+		if (!chain) {
+			for (i = 0; i < batch->num_items; i++) {
+				BatchItem *item = &batch->items[i];
+
+				if (!item->error) {
+					item->error = g_error_new_literal (NM_SETTINGS_ERROR,
+					                                   NM_SETTINGS_ERROR_PERMISSION_DENIED,
+					                                   "Unable to authenticate the request.");
+				}
+			}
+		} else {
+			priv->auths = g_slist_append (priv->auths, chain);
+			g_hash_table_iter_init (&iter, perms);
+			while (g_hash_table_iter_next (&iter, (gpointer) &perm, NULL))
+				nm_auth_chain_add_call (chain, perm, TRUE);
+		}
+	}
+	g_hash_table_destroy (perms);
+
+	if (!chain)
+		batch_execute (batch);
+}
+
+static gboolean
+batch_item_check_acl (BatchItem *item, NMConnection *connection)
+{
+	char *error_desc = NULL;
+
+	if (!nm_auth_is_subject_in_acl (connection,
+	                                nm_session_monitor_get (),
+	                                item->batch->subject,
+	                                &error_desc)) {
+		item->error = g_error_new_literal (NM_SETTINGS_ERROR,
+		                                   NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                   error_desc);
+		g_free (error_desc);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static NMConnection *
+batch_item_parse_settings (BatchItem *item, GHashTable *settings)
+{
+	NMConnection *connection;
+	GVariant *dict;
+
+	dict = nm_utils_connection_hash_to_dict (settings);
+	connection = nm_simple_connection_new_from_dbus (dict, &item->error);
+	g_variant_unref (dict);
+	return connection;
+}
+
+static gboolean
+batch_item_set_target (Batch *batch, BatchItem *item, const char *path)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (batch->self);
+	NMSettingsConnection *target;
+
+	item->path = g_strdup (path);
+
+	target = g_hash_table_lookup (priv->connections, path);
+	if (!target) {
+		item->error = g_error_new (NM_SETTINGS_ERROR,
+		                           NM_SETTINGS_ERROR_INVALID_CONNECTION,
+		                           "No connection with the path '%s' exists.",
+		                           path);
+		return FALSE;
+	}
+	item->target = g_object_ref (target);
+
+	if (!nm_settings_connection_check_writable (target, &item->error))
+		return FALSE;
+
+	/* Ensure the caller can view this connection */
+	return batch_item_check_acl (item, NM_CONNECTION (target));
+}
+
+static void
+impl_settings_add_connections (NMSettings *self,
+                               GPtrArray *connections,
+                               DBusGMethodInvocation *context)
+{
+	Batch *batch;
+	guint i;
+
+	if (!get_plugin (self, NM_SYSTEM_CONFIG_INTERFACE_CAP_MODIFY_CONNECTIONS)) {
+		GError *error;
+
+		error = g_error_new_literal (NM_SETTINGS_ERROR,
+		                             NM_SETTINGS_ERROR_NOT_SUPPORTED,
+		                             "None of the registered plugins support add.");
+		dbus_g_method_return_error (context, error);
+		g_error_free (error);
+		return;
+	}
+
+	batch = batch_new (self, BATCH_OP_ADD, connections->len, context);
+	if (!batch)
+		return;
+
+	for (i = 0; i < connections->len; i++) {
+		BatchItem *item = &batch->items[i];
+		NMSettingConnection *s_con;
+		GError *tmp_error = NULL;
+
+		item->new_settings = batch_item_parse_settings (item, g_ptr_array_index (connections, i));
+		if (!item->new_settings)
+			continue;
+
+		if (!nm_connection_verify (item->new_settings, &tmp_error)) {
+			item->error = g_error_new (NM_SETTINGS_ERROR,
+			                           NM_SETTINGS_ERROR_INVALID_CONNECTION,
+			                           "The connection was invalid: %s",
+			                           tmp_error ? tmp_error->message : "(unknown)");
+			g_clear_error (&tmp_error);
+			continue;
+		}
+
+		if (is_adhoc_wpa (item->new_settings)) {
+			item->error = g_error_new_literal (NM_SETTINGS_ERROR,
+			                                   NM_SETTINGS_ERROR_INVALID_CONNECTION,
+			                                   "WPA Ad-Hoc disabled due to kernel bugs");
+			continue;
+		}
+
+		if (!batch_item_check_acl (item, item->new_settings))
+			continue;
+
+		s_con = nm_connection_get_setting_connection (item->new_settings);
+		g_assert (s_con);
+		if (nm_setting_connection_get_num_permissions (s_con) == 1)
+			item->perm = NM_AUTH_PERMISSION_SETTINGS_MODIFY_OWN;
+		else
+			item->perm = NM_AUTH_PERMISSION_SETTINGS_MODIFY_SYSTEM;
+	}
+
+	batch_authorize (batch);
+}
+
+static void
+impl_settings_update_connections (NMSettings *self,
+                                  GHashTable *connections,
+                                  DBusGMethodInvocation *context)
+{
+	Batch *batch;
+	GHashTableIter iter;
+	const char *path;
+	GHashTable *settings;
+	guint i = 0;
+
+	batch = batch_new (self, BATCH_OP_UPDATE, g_hash_table_size (connections), context);
+	if (!batch)
+		return;
+
+	g_hash_table_iter_init (&iter, connections);
+	while (g_hash_table_iter_next (&iter, (gpointer) &path, (gpointer) &settings)) {
+		BatchItem *item = &batch->items[i++];
+
+		if (!batch_item_set_target (batch, item, path))
+			continue;
+
+		item->new_settings = batch_item_parse_settings (item, settings);
+		if (!item->new_settings)
+			continue;
+
+		/* You can't make a connection invisible to yourself */
+		if (!batch_item_check_acl (item, item->new_settings))
+			continue;
+
+		item->perm = nm_settings_connection_get_modify_permission (item->target, item->new_settings);
+	}
+
+	batch_authorize (batch);
+}
+
+static void
+impl_settings_delete_connections (NMSettings *self,
+                                  GPtrArray *connections,
+                                  DBusGMethodInvocation *context)
+{
+	Batch *batch;
+	guint i;
+
+	batch = batch_new (self, BATCH_OP_DELETE, connections->len, context);
+	if (!batch)
+		return;
+
+	for (i = 0; i < connections->len; i++) {
+		BatchItem *item = &batch->items[i];
+
+		if (!batch_item_set_target (batch, item, g_ptr_array_index (connections, i)))
+			continue;
+
+		item->perm = nm_settings_connection_get_modify_permission (item->target, NULL);
+	}
+
+	batch_authorize (batch);
+}
+
 static gboolean
 ensure_root (NMDBusManager         *dbus_mgr,
              DBusGMethodInvocation *context)
@@ -1820,6 +2481,7 @@ nm_settings_init (NMSettings *self)
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	priv->connections = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	priv->batch_deleting = g_hash_table_new (g_direct_hash, g_direct_equal);
 
 	/* Hold a reference to the agent manager so it stays alive; the only
 	 * other holders are NMSettingsConnection objects which are often
@@ -1840,6 +2502,9 @@ dispose (GObject *object)
 	g_slist_free_full (priv->auths, (GDestroyNotify) nm_auth_chain_unref);
 	priv->auths = NULL;
 
+	/* Don't exit with connection files half-written */
+	nm_settings_connection_flush_writes ();
+
 	priv->dbus_mgr = NULL;
 
 	g_object_unref (priv->agent_mgr);
@@ -1855,6 +2520,7 @@ finalize (GObject *object)
 
 	g_hash_table_destroy (priv->connections);
 	g_slist_free (priv->get_connections_cache);
+	g_hash_table_destroy (priv->batch_deleting);
 
 	g_slist_free_full (priv->unmanaged_specs, g_free);
 	g_slist_free_full (priv->unrecognized_specs, g_free);
@@ -2020,6 +2686,27 @@ nm_settings_class_init (NMSettingsClass *class)
 	                              g_cclosure_marshal_VOID__OBJECT,
 	                              G_TYPE_NONE, 1, G_TYPE_OBJECT);
 
+	signals[DBUS_CONNECTION_REMOVED] =
+	                g_signal_new ("connection-removed",
+	                              G_OBJECT_CLASS_TYPE (object_class),
+	                              G_SIGNAL_RUN_FIRST, 0, NULL, NULL,
+	                              g_cclosure_marshal_VOID__OBJECT,
+	                              G_TYPE_NONE, 1, G_TYPE_OBJECT);
+
+	signals[CONNECTIONS_ADDED] =
+	                g_signal_new ("connections-added",
+	                              G_OBJECT_CLASS_TYPE (object_class),
+	                              G_SIGNAL_RUN_FIRST, 0, NULL, NULL,
+	                              g_cclosure_marshal_VOID__BOXED,
+	                              G_TYPE_NONE, 1, DBUS_TYPE_G_ARRAY_OF_OBJECT_PATH);
+
+	signals[CONNECTIONS_REMOVED] =
+	                g_signal_new ("connections-removed",
+	                              G_OBJECT_CLASS_TYPE (object_class),
+	                              G_SIGNAL_RUN_FIRST, 0, NULL, NULL,
+	                              g_cclosure_marshal_VOID__BOXED,
+	                              G_TYPE_NONE, 1, DBUS_TYPE_G_ARRAY_OF_OBJECT_PATH);
+
 	dbus_g_error_domain_register (NM_SETTINGS_ERROR,
 	                              NM_DBUS_INTERFACE_SETTINGS,
 	                              NM_TYPE_SETTINGS_ERROR);
@@ -214,3 +214,42 @@ nm_system_config_interface_add_connection (NMSystemConfigInterface *config,
 
 	return NULL;
 }
+
+gboolean
+nm_system_config_interface_can_add_connections (NMSystemConfigInterface *config)
+{
+	g_return_val_if_fail (config != NULL, FALSE);
+
+	return NM_SYSTEM_CONFIG_INTERFACE_GET_INTERFACE (config)->add_connections != NULL;
+}
+
+/**
+ * nm_system_config_interface_add_connections:
+ * @config: the #NMSystemConfigInterface
+ * @connections: a list of source #NMConnections
+ * @save_to_disk: %TRUE to save the connections to disk immediately, %FALSE to
+ * not save to disk
+ * @error: on return, a location to store any errors that may occur
+ *
+ * Creates new #NMSettingsConnections for all of @connections in a single
+ * transaction.  If any of them cannot be added, none is, and %NULL is
+ * returned.  The plugin owns the returned objects; the caller must free the
+ * list.
+ *
+ * Returns: a list of the new #NMSettingsConnections, in the order of
+ * @connections, or %NULL
+ */
+GSList *
+nm_system_config_interface_add_connections (NMSystemConfigInterface *config,
+                                            GSList *connections,
+                                            gboolean save_to_disk,
+                                            GError **error)
+{
+	g_return_val_if_fail (config != NULL, NULL);
+	g_return_val_if_fail (connections != NULL, NULL);
+
+	if (NM_SYSTEM_CONFIG_INTERFACE_GET_INTERFACE (config)->add_connections)
+		return NM_SYSTEM_CONFIG_INTERFACE_GET_INTERFACE (config)->add_connections (config, connections, save_to_disk, error);
+
+	return NULL;
+}
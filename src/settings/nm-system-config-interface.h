@@ -129,6 +129,18 @@ struct _NMSystemConfigInterface {
 	                                          gboolean save_to_disk,
 	                                          GError **error);
 
+	/*
+	 * Like add_connection(), but for a list of connections which are written
+	 * as one transaction: either all of them are added, or none is and an
+	 * error is returned.  Returns a list of the new NMSettingsConnection
+	 * objects in the order of @connections; the list is freed by the caller,
+	 * its elements are owned by the plugin.  Optional.
+	 */
+	GSList * (*add_connections) (NMSystemConfigInterface *config,
+	                             GSList *connections,
+	                             gboolean save_to_disk,
+	                             GError **error);
+
 	/* Signals */
 
 	/* Emitted when a new connection has been found by the plugin */
@@ -161,6 +173,13 @@ NMSettingsConnection *nm_system_config_interface_add_connection (NMSystemConfigI
                                                                  gboolean save_to_disk,
                                                                  GError **error);
 
+gboolean nm_system_config_interface_can_add_connections (NMSystemConfigInterface *config);
+
+GSList *nm_system_config_interface_add_connections (NMSystemConfigInterface *config,
+                                                    GSList *connections,
+                                                    gboolean save_to_disk,
+                                                    GError **error);
+
 G_END_DECLS
 
 #endif	/* NM_SYSTEM_CONFIG_INTERFACE_H */
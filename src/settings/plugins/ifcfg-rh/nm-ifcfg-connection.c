@@ -241,62 +241,71 @@ nm_ifcfg_connection_get_unrecognized_spec (NMIfcfgConnection *self)
 	return NM_IFCFG_CONNECTION_GET_PRIVATE (self)->unrecognized_spec;
 }
 
-static void
-commit_changes (NMSettingsConnection *connection,
-                NMSettingsConnectionCommitFunc callback,
-                gpointer user_data)
+typedef struct {
+	char *path;
+	char *keyfile;
+	char *new_path;
+	gboolean unchanged;
+} WriteData;
+
+static gpointer
+prepare_write (NMSettingsConnection *connection)
 {
 	NMIfcfgConnectionPrivate *priv = NM_IFCFG_CONNECTION_GET_PRIVATE (connection);
-	GError *error = NULL;
+	WriteData *data;
 	NMConnection *reread;
-	gboolean same = FALSE, success = FALSE;
-	char *ifcfg_path = NULL;
+
+	data = g_slice_new0 (WriteData);
+	data->path = g_strdup (priv->path);
+	data->keyfile = g_strdup (priv->keyfile);
 
 	/* To ensure we don't rewrite files that are only changed from other
 	 * processes on-disk, read the existing connection back in and only rewrite
-	 * it if it's really changed.
+	 * it if it's really changed.  The reader may query the platform, so this
+	 * stays on the main loop; only the write is done in the worker thread.
 	 */
 	if (priv->path) {
 		reread = connection_from_file (priv->path, NULL, NULL);
 		if (reread) {
-			same = nm_connection_compare (NM_CONNECTION (connection),
-			                              reread,
-			                              NM_SETTING_COMPARE_FLAG_IGNORE_AGENT_OWNED_SECRETS |
-			                                 NM_SETTING_COMPARE_FLAG_IGNORE_NOT_SAVED_SECRETS);
+			data->unchanged = nm_connection_compare (NM_CONNECTION (connection),
+			                                         reread,
+			                                         NM_SETTING_COMPARE_FLAG_IGNORE_AGENT_OWNED_SECRETS |
+			                                            NM_SETTING_COMPARE_FLAG_IGNORE_NOT_SAVED_SECRETS);
 			g_object_unref (reread);
-
-			/* Don't bother writing anything out if in-memory and on-disk data are the same */
-			if (same) {
-				/* But chain up to parent to handle success - emits updated signal */
-				NM_SETTINGS_CONNECTION_CLASS (nm_ifcfg_connection_parent_class)->commit_changes (connection, callback, user_data);
-				return;
-			}
-		}
-
-		success = writer_update_connection (NM_CONNECTION (connection),
-		                                    IFCFG_DIR,
-		                                    priv->path,
-		                                    priv->keyfile,
-		                                    &error);
-	} else {
-		success = writer_new_connection (NM_CONNECTION (connection),
-		                                 IFCFG_DIR,
-		                                 &ifcfg_path,
-		                                 &error);
-		if (success) {
-			nm_ifcfg_connection_set_path (NM_IFCFG_CONNECTION (connection), ifcfg_path);
-			g_free (ifcfg_path);
 		}
 	}
 
-	if (success) {
-		/* Chain up to parent to handle success */
-		NM_SETTINGS_CONNECTION_CLASS (nm_ifcfg_connection_parent_class)->commit_changes (connection, callback, user_data);
-	} else {
-		/* Otherwise immediate error */
-		callback (connection, error, user_data);
-		g_error_free (error);
-	}
+	return data;
+}
+
+/* Runs in a worker thread */
+static gboolean
+write_connection (NMConnection *copy, gpointer write_data, GError **error)
+{
+	WriteData *data = write_data;
+
+	/* Don't bother writing anything out if in-memory and on-disk data are the same */
+	if (data->unchanged)
+		return TRUE;
+
+	if (data->path)
+		return writer_update_connection (copy, IFCFG_DIR, data->path, data->keyfile, error);
+	else
+		return writer_new_connection (copy, IFCFG_DIR, &data->new_path, error);
+}
+
+static void
+finish_write (NMSettingsConnection *connection, gpointer write_data, gboolean success)
+{
+	WriteData *data = write_data;
+
+	if (success && data->new_path)
+		nm_ifcfg_connection_set_path (NM_IFCFG_CONNECTION (connection), data->new_path);
+
+	g_free (data->path);
+	g_free (data->keyfile);
+	g_free (data->new_path);
+	g_slice_free (WriteData, data);
 }
 
 static void
@@ -395,7 +404,9 @@ nm_ifcfg_connection_class_init (NMIfcfgConnectionClass *ifcfg_connection_class)
 	object_class->dispose      = dispose;
 	object_class->finalize     = finalize;
 	settings_class->delete = do_delete;
-	settings_class->commit_changes = commit_changes;
+	settings_class->prepare_write = prepare_write;
+	settings_class->write_connection = write_connection;
+	settings_class->finish_write = finish_write;
 
 	/* Properties */
 	g_object_class_install_property
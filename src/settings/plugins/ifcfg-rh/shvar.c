@@ -41,6 +41,91 @@
 
 #define PARSE_WARNING(msg...) nm_log_warn (LOGD_SETTINGS, "    " msg)
 
+/* Returns the length of the key of a "KEY=value" line, or -1 if the line
+ * doesn't assign anything (like comments and blank lines).
+ */
+static gssize
+line_key_len (const char *line)
+{
+	const char *eq = strchr (line, '=');
+
+	return eq ? eq - line : -1;
+}
+
+/* Make @link the line for its key unless an earlier line sets the key
+ * already; like the shell, the first assignment in the file wins for
+ * svGetValue().
+ */
+static void
+line_index_add (shvarFile *s, GList *link)
+{
+	const char *line = link->data;
+	gssize len = line_key_len (line);
+	char *key;
+
+	if (len < 0)
+		return;
+
+	key = g_strndup (line, len);
+	if (g_hash_table_contains (s->lineIndex, key))
+		g_free (key);
+	else
+		g_hash_table_insert (s->lineIndex, key, link);
+}
+
+/* @link is about to be removed from the line list; if it was indexed, index
+ * the next line setting the same key instead.
+ */
+static void
+line_index_remove (shvarFile *s, GList *link)
+{
+	const char *line = link->data;
+	gssize len = line_key_len (line);
+	GList *next;
+	char *key;
+
+	if (len < 0)
+		return;
+
+	key = g_strndup (line, len);
+	if (g_hash_table_lookup (s->lineIndex, key) == link) {
+		g_hash_table_remove (s->lineIndex, key);
+		for (next = link->next; next; next = next->next) {
+			const char *l = next->data;
+
+			if (line_key_len (l) == len && !strncmp (l, key, len)) {
+				g_hash_table_insert (s->lineIndex, g_strdup (key), next);
+				break;
+			}
+		}
+	}
+	g_free (key);
+}
+
+/* Append @line (taking ownership) to the line list of @s */
+static void
+line_append (shvarFile *s, char *line, GList **last)
+{
+	GList *link;
+
+	link = g_list_alloc ();
+	link->data = line;
+	link->prev = *last;
+	if (*last)
+		(*last)->next = link;
+	else
+		s->lineList = link;
+	*last = link;
+
+	line_index_add (s, link);
+}
+
+static GList *
+line_list_last (shvarFile *s)
+{
+	return s->lineList ? g_list_last (s->lineList) : NULL;
+}
+
 /* Open the file <name>, returning a shvarFile on success and NULL on failure.
  * Add a wrinkle to let the caller specify whether or not to create the file
  * (actually, return a structure anyway) if it doesn't exist.
@@ -53,6 +138,7 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 	int errsv = 0;
 
 	s = g_slice_new0 (shvarFile);
+	s->lineIndex = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
 	s->fd = -1;
 	if (create)
@@ -72,6 +158,7 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 		struct stat buf;
 		char *arena, *p, *q;
 		ssize_t nread, total = 0;
+		GList *last = NULL;
 
 		if (fstat (s->fd, &buf) < 0) {
 			errsv = errno;
@@ -92,9 +179,11 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 			total += nread;
 		}
 
-		/* we'd use g_strsplit() here, but we want a list, not an array */
+		/* Split into lines and index the keys in the same pass; we'd use
+		 * g_strsplit() here, but we want a list, not an array.
+		 */
 		for (p = arena; (q = strchr (p, '\n')) != NULL; p = q + 1)
-			s->lineList = g_list_append (s->lineList, g_strndup (p, q - p));
+			line_append (s, g_strndup (p, q - p), &last);
 		g_free (arena);
 
 		/* closefd is set if we opened the file read-only, so go ahead and
@@ -115,6 +204,7 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 	if (s->fd != -1)
 		close (s->fd);
 	g_free (s->fileName);
+	g_hash_table_destroy (s->lineIndex);
 	g_slice_free (shvarFile, s);
 
 	g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
@@ -254,27 +344,19 @@ char *
 svGetValue (shvarFile *s, const char *key, gboolean verbatim)
 {
 	char *value = NULL;
-	char *line;
-	char *keyString;
-	int len;
+	const char *line;
 
 	g_return_val_if_fail (s != NULL, NULL);
 	g_return_val_if_fail (key != NULL, NULL);
 
-	keyString = g_strdup_printf ("%s=", key);
-	len = strlen (keyString);
-
-	for (s->current = s->lineList; s->current; s->current = s->current->next) {
+	s->current = g_hash_table_lookup (s->lineIndex, key);
+	if (s->current) {
 		line = s->current->data;
-		if (!strncmp (keyString, line, len)) {
-			/* Strip trailing spaces before unescaping to preserve spaces quoted whitespace */
-			value = g_strchomp (g_strdup (line + len));
-			if (!verbatim)
-				svUnescape (value);
-			break;
-		}
+		/* Strip trailing spaces before unescaping to preserve spaces quoted whitespace */
+		value = g_strchomp (g_strdup (line + strlen (key) + 1));
+		if (!verbatim)
+			svUnescape (value);
 	}
-	g_free (keyString);
 
 	if (value && value[0]) {
 		return value;
@@ -371,8 +453,11 @@ svSetValue (shvarFile *s, const char *key, const char *value, gboolean verbatim)
 		/* delete value */
 		if (oldval) {
 			/* delete line */
+			line_index_remove (s, s->current);
 			s->lineList = g_list_remove_link (s->lineList, s->current);
+			g_free (s->current->data);
 			g_list_free_1 (s->current);
+			s->current = NULL;
 			s->modified = TRUE;
 		}
 		goto bail; /* do not need keyValue */
@@ -380,19 +465,20 @@ svSetValue (shvarFile *s, const char *key, const char *value, gboolean verbatim)
 
 	if (!oldval) {
 		/* append line */
-		s->lineList = g_list_append (s->lineList, keyValue);
+		GList *last = line_list_last (s);
+
+		line_append (s, keyValue, &last);
 		s->modified = TRUE;
 		goto end;
 	}
 
 	if (strcmp (oldval, newval) != 0) {
-		/* change line */
-		if (s->current)
-			s->current->data = keyValue;
-		else
-			s->lineList = g_list_append (s->lineList, keyValue);
+		/* change line; the key stays the same so the index is still valid */
+		g_free (s->current->data);
+		s->current->data = keyValue;
 		s->modified = TRUE;
-	}
+	} else
+		g_free (keyValue);
 
  end:
 	g_free (newval);
@@ -468,6 +554,7 @@ svCloseFile (shvarFile *s)
 		close (s->fd);
 
 	g_free (s->fileName);
+	g_hash_table_destroy (s->lineIndex);
 	g_list_free_full (s->lineList, g_free); /* implicitly frees s->current */
 	g_slice_free (shvarFile, s);
 }
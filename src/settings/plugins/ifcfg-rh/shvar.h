@@ -40,6 +40,7 @@ struct _shvarFile {
 	char      *fileName;    /* read-only */
 	int        fd;          /* read-only */
 	GList     *lineList;    /* read-only */
+	GHashTable *lineIndex;  /* read-only, key::first element of lineList setting it */
 	GList     *current;     /* set implicitly or explicitly, points to element of lineList */
 	gboolean   modified;    /* ignore */
 };
@@ -53,7 +54,8 @@ shvarFile *svOpenFile (const char *name, GError **error);
 
 /* Get the value associated with the key, and leave the current pointer
  * pointing at the line containing the value.  The char* returned MUST
- * be freed by the caller.
+ * be freed by the caller.  Keys are looked up in an index built when the
+ * file is read, so this does not scan the file.
  */
 char *svGetValue (shvarFile *s, const char *key, gboolean verbatim);
 
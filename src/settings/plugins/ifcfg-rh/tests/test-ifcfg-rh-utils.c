@@ -27,6 +27,7 @@
 
 #include "common.h"
 #include "utils.h"
+#include "shvar.h"
 
 #include "nm-test-utils.h"
 
@@ -115,6 +116,72 @@ test_ignored (const char *desc, const char *path, gboolean expected_ignored)
 	ASSERT (result == expected_ignored, desc, "unexpected ignore result for path '%s'", path);
 }
 
+static void
+test_shvar_index (void)
+{
+	const char *path = TEST_SCRATCH_DIR "ifcfg-test-shvar-index";
+	const char *contents =
+		"# comment line\n"
+		"DEVICE=eth0\n"
+		"NAME=\"first name\"\n"
+		"#NAME=commented\n"
+		"NAME=second\n"
+		"BOOTPROTO=dhcp\n";
+	shvarFile *f;
+	GError *error = NULL;
+	char *value, *written;
+	gboolean success;
+
+	success = g_file_set_contents (path, contents, -1, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+
+	f = svOpenFile (path, &error);
+	g_assert_no_error (error);
+	g_assert (f);
+
+	/* the first assignment of a key wins */
+	value = svGetValue (f, "NAME", FALSE);
+	g_assert_cmpstr (value, ==, "first name");
+	g_free (value);
+	value = svGetValue (f, "NAME", TRUE);
+	g_assert_cmpstr (value, ==, "\"first name\"");
+	g_free (value);
+	g_assert (svGetValue (f, "IPADDR", FALSE) == NULL);
+
+	/* deleting the first assignment exposes the next one */
+	svSetValue (f, "NAME", NULL, FALSE);
+	value = svGetValue (f, "NAME", FALSE);
+	g_assert_cmpstr (value, ==, "second");
+	g_free (value);
+
+	svSetValue (f, "BOOTPROTO", "none", FALSE);
+	svSetValue (f, "IPADDR", "192.168.1.5", FALSE);
+	value = svGetValue (f, "IPADDR", FALSE);
+	g_assert_cmpstr (value, ==, "192.168.1.5");
+	g_free (value);
+
+	success = svWriteFile (f, 0644, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+	svCloseFile (f);
+
+	/* comments and the order of lines are preserved */
+	success = g_file_get_contents (path, &written, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+	g_assert_cmpstr (written, ==,
+	                 "# comment line\n"
+	                 "DEVICE=eth0\n"
+	                 "#NAME=commented\n"
+	                 "NAME=second\n"
+	                 "BOOTPROTO=none\n"
+	                 "IPADDR=192.168.1.5\n");
+	g_free (written);
+
+	unlink (path);
+}
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -164,6 +231,8 @@ int main (int argc, char **argv)
 	test_ignored ("ignored-augnew", "ifcfg-FooBar" AUGNEW_TAG, TRUE);
 	test_ignored ("ignored-augtmp", "ifcfg-FooBar" AUGTMP_TAG, TRUE);
 
+	test_shvar_index ();
+
 	base = g_path_get_basename (argv[0]);
 	fprintf (stdout, "%s: SUCCESS\n", base);
 	g_free (base);
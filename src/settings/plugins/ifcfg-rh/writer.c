@@ -2608,13 +2608,24 @@ writer_can_write_connection (NMConnection *connection, GError **error)
 	return FALSE;
 }
 
+/* New connections are also written from the settings write pool; picking
+ * an unused ifcfg name and creating the file must not interleave between
+ * two writers, or both would choose the same name.
+ */
+static GMutex new_connection_mutex;
+
 gboolean
 writer_new_connection (NMConnection *connection,
                        const char *ifcfg_dir,
                        char **out_filename,
                        GError **error)
 {
-	return write_connection (connection, ifcfg_dir, NULL, NULL, out_filename, error);
+	gboolean success;
+
+	g_mutex_lock (&new_connection_mutex);
+	success = write_connection (connection, ifcfg_dir, NULL, NULL, out_filename, error);
+	g_mutex_unlock (&new_connection_mutex);
+	return success;
 }
 
 gboolean
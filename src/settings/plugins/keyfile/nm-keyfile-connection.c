@@ -42,6 +42,12 @@ typedef struct {
 	char *path;
 } NMKeyfileConnectionPrivate;
 
+enum {
+	WRITTEN,
+	LAST_SIGNAL
+};
+static guint signals[LAST_SIGNAL] = { 0 };
+
 NMKeyfileConnection *
 nm_keyfile_connection_new (NMConnection *source,
                            const char *full_path,
@@ -114,33 +120,50 @@ nm_keyfile_connection_set_path (NMKeyfileConnection *self, const char *path)
 	priv->path = g_strdup (path);
 }
 
+typedef struct {
+	char *path;
+	char *new_path;
+} WriteData;
+
+static gpointer
+prepare_write (NMSettingsConnection *connection)
+{
+	WriteData *data;
+
+	data = g_slice_new0 (WriteData);
+	data->path = g_strdup (NM_KEYFILE_CONNECTION_GET_PRIVATE (connection)->path);
+	return data;
+}
+
+/* Runs in a worker thread */
+static gboolean
+write_connection (NMConnection *copy, gpointer write_data, GError **error)
+{
+	WriteData *data = write_data;
+
+	return nm_keyfile_plugin_write_connection (copy, data->path, &data->new_path, error);
+}
+
 static void
-commit_changes (NMSettingsConnection *connection,
-                NMSettingsConnectionCommitFunc callback,
-                gpointer user_data)
+finish_write (NMSettingsConnection *connection, gpointer write_data, gboolean success)
 {
 	NMKeyfileConnectionPrivate *priv = NM_KEYFILE_CONNECTION_GET_PRIVATE (connection);
-	char *path = NULL;
-	GError *error = NULL;
-
-	if (!nm_keyfile_plugin_write_connection (NM_CONNECTION (connection),
-	                                         priv->path,
-	                                         &path,
-	                                         &error)) {
-		callback (connection, error, user_data);
-		g_clear_error (&error);
-		return;
-	}
+	WriteData *data = write_data;
 
 	/* Update the filename if it changed */
-	if (path) {
+	if (success && data->new_path) {
 		g_free (priv->path);
-		priv->path = path;
+		priv->path = data->new_path;
+		data->new_path = NULL;
 	}
 
-	NM_SETTINGS_CONNECTION_CLASS (nm_keyfile_connection_parent_class)->commit_changes (connection,
-	                                                                                   callback,
-	                                                                                   user_data);
+	/* Let the plugin know what is on disk now, passing the previous path */
+	if (success)
+		g_signal_emit (connection, signals[WRITTEN], 0, data->path);
+
+	g_free (data->path);
+	g_free (data->new_path);
+	g_slice_free (WriteData, data);
 }
 
 static void 
@@ -183,6 +206,17 @@ nm_keyfile_connection_class_init (NMKeyfileConnectionClass *keyfile_connection_c
 
 	/* Virtual methods */
 	object_class->finalize = finalize;
-	settings_class->commit_changes = commit_changes;
 	settings_class->delete = do_delete;
+	settings_class->prepare_write = prepare_write;
+	settings_class->write_connection = write_connection;
+	settings_class->finish_write = finish_write;
+
+	/* Signals */
+	signals[WRITTEN] =
+		g_signal_new (NM_KEYFILE_CONNECTION_WRITTEN,
+		              G_TYPE_FROM_CLASS (keyfile_connection_class),
+		              G_SIGNAL_RUN_FIRST,
+		              0, NULL, NULL,
+		              g_cclosure_marshal_VOID__STRING,
+		              G_TYPE_NONE, 1, G_TYPE_STRING);
 }
@@ -33,6 +33,9 @@ G_BEGIN_DECLS
 #define NM_IS_KEYFILE_CONNECTION_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_KEYFILE_CONNECTION))
 #define NM_KEYFILE_CONNECTION_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_KEYFILE_CONNECTION, NMKeyfileConnectionClass))
 
+/* Signals */
+#define NM_KEYFILE_CONNECTION_WRITTEN "written"
+
 typedef struct {
 	NMSettingsConnection parent;
 } NMKeyfileConnection;
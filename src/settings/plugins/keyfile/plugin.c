@@ -55,13 +55,32 @@ G_DEFINE_TYPE_EXTENDED (SCPluginKeyfile, sc_plugin_keyfile, G_TYPE_OBJECT, 0,
 
 #define SC_PLUGIN_KEYFILE_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), SC_TYPE_PLUGIN_KEYFILE, SCPluginKeyfilePrivate))
 
+/* Coalescing window for directory monitor events.  Tools which drop many
+ * profiles at once generate a burst of events; they are collected and the
+ * affected files are processed together once the burst settles.
+ */
+#define DIR_CHANGED_COALESCE_MS 250
+
+typedef struct {
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+	struct timespec ctime;
+	char *checksum;
+} FileState;
+
 typedef struct {
 	GHashTable *connections;  /* uuid::connection */
+	GHashTable *file_states;  /* path::FileState */
 
 	gboolean initialized;
 	GFileMonitor *monitor;
 	guint monitor_id;
 
+	GHashTable *pending_paths;  /* set of changed paths not yet processed */
+	guint pending_id;
+
 	const char *conf_file;
 	GFileMonitor *conf_file_monitor;
 	guint conf_file_monitor_id;
@@ -71,10 +90,107 @@ typedef struct {
 	gboolean disposed;
 } SCPluginKeyfilePrivate;
 
+static void
+file_state_free (gpointer data)
+{
+	FileState *state = data;
+
+	g_free (state->checksum);
+	g_slice_free (FileState, state);
+}
+
+static gboolean
+timespec_equal (const struct timespec *a, const struct timespec *b)
+{
+	return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+/**
+ * file_state_changed:
+ * @self: the plugin
+ * @path: full path of a connection file
+ *
+ * Compares the file at @path against what was recorded when it was last
+ * looked at, and records the new state.  A matching stat() signature is
+ * trusted without reading the file; otherwise the content checksum decides,
+ * so that a file rewritten with identical content is not reparsed.
+ *
+ * Returns: %TRUE if the file is new, gone or its content changed
+ */
+static gboolean
+file_state_changed (SCPluginKeyfile *self, const char *path)
+{
+	SCPluginKeyfilePrivate *priv = SC_PLUGIN_KEYFILE_GET_PRIVATE (self);
+	FileState *state;
+	struct stat st;
+	char *contents = NULL, *checksum;
+	gsize len = 0;
+	gboolean changed;
+
+	state = g_hash_table_lookup (priv->file_states, path);
+
+	if (stat (path, &st) != 0) {
+		g_hash_table_remove (priv->file_states, path);
+		return TRUE;
+	}
+
+	if (   state
+	    && state->dev == st.st_dev
+	    && state->ino == st.st_ino
+	    && state->size == st.st_size
+	    && timespec_equal (&state->mtime, &st.st_mtim)
+	    && timespec_equal (&state->ctime, &st.st_ctim))
+		return FALSE;
+
+	if (!g_file_get_contents (path, &contents, &len, NULL)) {
+		g_hash_table_remove (priv->file_states, path);
+		return TRUE;
+	}
+	checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA256, (const guchar *) contents, len);
+	g_free (contents);
+
+	if (!state) {
+		state = g_slice_new0 (FileState);
+		g_hash_table_insert (priv->file_states, g_strdup (path), state);
+		changed = TRUE;
+	} else
+		changed = (g_strcmp0 (state->checksum, checksum) != 0);
+
+	state->dev = st.st_dev;
+	state->ino = st.st_ino;
+	state->size = st.st_size;
+	state->mtime = st.st_mtim;
+	state->ctime = st.st_ctim;
+	g_free (state->checksum);
+	state->checksum = checksum;
+
+	return changed;
+}
+
+static void
+connection_written_cb (NMKeyfileConnection *connection,
+                       const char *old_path,
+                       gpointer user_data)
+{
+	SCPluginKeyfile *self = SC_PLUGIN_KEYFILE (user_data);
+	const char *path = nm_keyfile_connection_get_path (connection);
+
+	/* Record what NM wrote, so the resulting monitor event is a no-op */
+	if (old_path && g_strcmp0 (old_path, path) != 0)
+		g_hash_table_remove (SC_PLUGIN_KEYFILE_GET_PRIVATE (self)->file_states, old_path);
+	if (path)
+		file_state_changed (self, path);
+}
+
 static void
 connection_removed_cb (NMSettingsConnection *obj, gpointer user_data)
 {
-	g_hash_table_remove (SC_PLUGIN_KEYFILE_GET_PRIVATE (user_data)->connections,
+	SCPluginKeyfilePrivate *priv = SC_PLUGIN_KEYFILE_GET_PRIVATE (user_data);
+	const char *path = nm_keyfile_connection_get_path (NM_KEYFILE_CONNECTION (obj));
+
+	if (path)
+		g_hash_table_remove (priv->file_states, path);
+	g_hash_table_remove (priv->connections,
 	                     nm_connection_get_uuid (NM_CONNECTION (obj)));
 }
 
@@ -84,14 +200,19 @@ static void
 remove_connection (SCPluginKeyfile *self, NMKeyfileConnection *connection)
 {
 	gboolean removed;
+	const char *path;
 
 	g_return_if_fail (connection != NULL);
 
-	nm_log_info (LOGD_SETTINGS, "removed %s.", nm_keyfile_connection_get_path (connection));
+	path = nm_keyfile_connection_get_path (connection);
+	nm_log_info (LOGD_SETTINGS, "removed %s.", path);
+	if (path)
+		g_hash_table_remove (SC_PLUGIN_KEYFILE_GET_PRIVATE (self)->file_states, path);
 
 	/* Removing from the hash table should drop the last reference */
 	g_object_ref (connection);
 	g_signal_handlers_disconnect_by_func (connection, connection_removed_cb, self);
+	g_signal_handlers_disconnect_by_func (connection, connection_written_cb, self);
 	removed = g_hash_table_remove (SC_PLUGIN_KEYFILE_GET_PRIVATE (self)->connections,
 	                               nm_connection_get_uuid (NM_CONNECTION (connection)));
 	nm_settings_connection_signal_remove (NM_SETTINGS_CONNECTION (connection));
@@ -164,6 +285,9 @@ new_connection (SCPluginKeyfile *self,
 	if (out_old_path)
 		*out_old_path = NULL;
 
+	/* Record the state of what is about to be read */
+	file_state_changed (self, name);
+
 	tmp = nm_keyfile_connection_new (NULL, name, &error);
 	if (!tmp) {
 		nm_log_warn (LOGD_SETTINGS, "    error in connection %s: %s", name,
@@ -185,6 +309,8 @@ new_connection (SCPluginKeyfile *self,
 			g_assert_no_error (error);
 		}
 		g_object_unref (tmp);
+		if (nm_keyfile_connection_get_path (connection))
+			g_hash_table_remove (priv->file_states, nm_keyfile_connection_get_path (connection));
 		if (out_old_path)
 			*out_old_path = g_strdup (nm_keyfile_connection_get_path (connection));
 		nm_keyfile_connection_set_path (connection, name);
@@ -196,7 +322,94 @@ new_connection (SCPluginKeyfile *self,
 		g_signal_connect (tmp, NM_SETTINGS_CONNECTION_REMOVED,
 		                  G_CALLBACK (connection_removed_cb),
 		                  self);
+		g_signal_connect (tmp, NM_KEYFILE_CONNECTION_WRITTEN,
+		                  G_CALLBACK (connection_written_cb),
+		                  self);
+	}
+}
+
+static GHashTable *
+build_path_table (SCPluginKeyfile *self)
+{
+	SCPluginKeyfilePrivate *priv = SC_PLUGIN_KEYFILE_GET_PRIVATE (self);
+	GHashTable *paths;
+	GHashTableIter iter;
+	gpointer data;
+
+	paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	g_hash_table_iter_init (&iter, priv->connections);
+	while (g_hash_table_iter_next (&iter, NULL, &data)) {
+		const char *con_path = nm_keyfile_connection_get_path (data);
+		if (con_path)
+			g_hash_table_insert (paths, g_strdup (con_path), data);
 	}
+	return paths;
+}
+
+static gboolean
+process_pending_paths (gpointer user_data)
+{
+	SCPluginKeyfile *self = SC_PLUGIN_KEYFILE (user_data);
+	SCPluginKeyfilePrivate *priv = SC_PLUGIN_KEYFILE_GET_PRIVATE (self);
+	GHashTable *pending, *paths;
+	GHashTableIter iter;
+	GSList *deleted = NULL, *iter_d;
+	const char *path;
+
+	priv->pending_id = 0;
+
+	/* Take over the pending set; events arriving while we work start a new one */
+	pending = priv->pending_paths;
+	priv->pending_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	nm_log_dbg (LOGD_SETTINGS, "processing %u changed connection file(s)",
+	            g_hash_table_size (pending));
+
+	/* Look up connections by path once for the whole batch instead of
+	 * walking all connections for each changed file.
+	 */
+	paths = build_path_table (self);
+
+	/* Handle existing files first, so that a rename (which arrives as a
+	 * delete of the old and a create of the new file) is seen as such.
+	 */
+	g_hash_table_iter_init (&iter, pending);
+	while (g_hash_table_iter_next (&iter, (gpointer) &path, NULL)) {
+		NMKeyfileConnection *connection;
+		char *old_path = NULL;
+
+		if (!g_file_test (path, G_FILE_TEST_IS_REGULAR)) {
+			deleted = g_slist_prepend (deleted, (gpointer) path);
+			continue;
+		}
+
+		connection = g_hash_table_lookup (paths, path);
+		if (connection) {
+			if (file_state_changed (self, path))
+				update_connection (self, connection, path);
+			else
+				nm_log_dbg (LOGD_SETTINGS, "unchanged %s", path);
+		} else {
+			new_connection (self, path, &old_path);
+			if (old_path) {
+				g_hash_table_remove (paths, old_path);
+				g_free (old_path);
+			}
+		}
+	}
+
+	for (iter_d = deleted; iter_d; iter_d = iter_d->next) {
+		NMKeyfileConnection *connection;
+
+		connection = g_hash_table_lookup (paths, iter_d->data);
+		if (connection)
+			remove_connection (self, connection);
+	}
+
+	g_slist_free (deleted);
+	g_hash_table_destroy (paths);
+	g_hash_table_destroy (pending);
+	return G_SOURCE_REMOVE;
 }
 
 static void
@@ -206,36 +419,31 @@ dir_changed (GFileMonitor *monitor,
              GFileMonitorEvent event_type,
              gpointer user_data)
 {
-	NMSystemConfigInterface *config = NM_SYSTEM_CONFIG_INTERFACE (user_data);
-	SCPluginKeyfile *self = SC_PLUGIN_KEYFILE (config);
-	NMKeyfileConnection *connection;
+	SCPluginKeyfile *self = SC_PLUGIN_KEYFILE (user_data);
+	SCPluginKeyfilePrivate *priv = SC_PLUGIN_KEYFILE_GET_PRIVATE (self);
 	char *full_path;
 
-	full_path = g_file_get_path (file);
-	if (nm_keyfile_plugin_utils_should_ignore_file (full_path)) {
-		g_free (full_path);
-		return;
-	}
-
-	connection = find_by_path (self, full_path);
-
 	switch (event_type) {
 	case G_FILE_MONITOR_EVENT_DELETED:
-		if (connection)
-			remove_connection (SC_PLUGIN_KEYFILE (config), connection);
-		break;
 	case G_FILE_MONITOR_EVENT_CREATED:
 	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
-		if (connection)
-			update_connection (SC_PLUGIN_KEYFILE (config), connection, full_path);
-		else
-			new_connection (SC_PLUGIN_KEYFILE (config), full_path, NULL);
 		break;
 	default:
-		break;
+		return;
+	}
+
+	full_path = g_file_get_path (file);
+	if (nm_keyfile_plugin_utils_should_ignore_file (full_path)) {
+		g_free (full_path);
+		return;
 	}
 
-	g_free (full_path);
+	/* Only the path is remembered; whether the file was added, changed or
+	 * removed is decided when the batch is processed.
+	 */
+	g_hash_table_add (priv->pending_paths, full_path);
+	if (!priv->pending_id)
+		priv->pending_id = g_timeout_add (DIR_CHANGED_COALESCE_MS, process_pending_paths, self);
 }
 
 static void
@@ -327,13 +535,7 @@ read_connections (NMSystemConfigInterface *config)
 		return;
 	}
 
-	oldconns = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data)) {
-		const char *con_path = nm_keyfile_connection_get_path (data);
-		if (con_path)
-			g_hash_table_insert (oldconns, g_strdup (con_path), data);
-	}
+	oldconns = build_path_table (self);
 
 	while ((item = g_dir_read_name (dir))) {
 		NMKeyfileConnection *connection;
@@ -347,7 +549,12 @@ read_connections (NMSystemConfigInterface *config)
 		connection = g_hash_table_lookup (oldconns, full_path);
 		if (connection) {
 			g_hash_table_remove (oldconns, full_path);
-			update_connection (self, connection, full_path);
+			/* Files that did not change on disk are not reparsed, unless
+			 * the in-memory connection has unsaved changes to revert.
+			 */
+			if (   file_state_changed (self, full_path)
+			    || nm_settings_connection_get_unsaved (NM_SETTINGS_CONNECTION (connection)))
+				update_connection (self, connection, full_path);
 		} else {
 			new_connection (self, full_path, &old_path);
 			if (old_path) {
@@ -366,6 +573,13 @@ read_connections (NMSystemConfigInterface *config)
 		remove_connection (self, data);
 	}
 	g_hash_table_destroy (oldconns);
+
+	/* Everything is up to date now; drop events still waiting to be processed */
+	if (priv->pending_id) {
+		g_source_remove (priv->pending_id);
+		priv->pending_id = 0;
+	}
+	g_hash_table_remove_all (priv->pending_paths);
 }
 
 /* Plugin */
@@ -400,9 +614,10 @@ load_connection (NMSystemConfigInterface *config,
 		return FALSE;
 
 	connection = find_by_path (self, filename);
-	if (connection)
+	if (connection) {
+		file_state_changed (self, filename);
 		update_connection (self, connection, filename);
-	else {
+	} else {
 		new_connection (self, filename, NULL);
 		connection = find_by_path (self, filename);
 	}
@@ -416,14 +631,32 @@ reload_connections (NMSystemConfigInterface *config)
 	read_connections (config);
 }
 
+static void
+track_connection (SCPluginKeyfile *self, NMSettingsConnection *added, const char *path)
+{
+	SCPluginKeyfilePrivate *priv = SC_PLUGIN_KEYFILE_GET_PRIVATE (self);
+
+	/* Remember what we wrote so the resulting monitor event is a no-op */
+	if (path)
+		file_state_changed (self, path);
+
+	g_hash_table_insert (priv->connections,
+	                     g_strdup (nm_connection_get_uuid (NM_CONNECTION (added))),
+	                     added);
+	g_signal_connect (added, NM_SETTINGS_CONNECTION_REMOVED,
+	                  G_CALLBACK (connection_removed_cb),
+	                  self);
+	g_signal_connect (added, NM_KEYFILE_CONNECTION_WRITTEN,
+	                  G_CALLBACK (connection_written_cb),
+	                  self);
+}
+
 static NMSettingsConnection *
 add_connection (NMSystemConfigInterface *config,
                 NMConnection *connection,
                 gboolean save_to_disk,
                 GError **error)
 {
-	SCPluginKeyfile *self = SC_PLUGIN_KEYFILE (config);
-	SCPluginKeyfilePrivate *priv = SC_PLUGIN_KEYFILE_GET_PRIVATE (self);
 	NMSettingsConnection *added = NULL;
 	char *path = NULL;
 
@@ -433,18 +666,66 @@ add_connection (NMSystemConfigInterface *config,
 	}
 
 	added = (NMSettingsConnection *) nm_keyfile_connection_new (connection, path, error);
-	if (added) {
-		g_hash_table_insert (priv->connections,
-		                     g_strdup (nm_connection_get_uuid (NM_CONNECTION (added))),
-		                     added);
-		g_signal_connect (added, NM_SETTINGS_CONNECTION_REMOVED,
-		                  G_CALLBACK (connection_removed_cb),
-		                  self);
-	}
+	if (added)
+		track_connection (SC_PLUGIN_KEYFILE (config), added, path);
 	g_free (path);
 	return added;
 }
 
+static GSList *
+add_connections (NMSystemConfigInterface *config,
+                 GSList *connections,
+                 gboolean save_to_disk,
+                 GError **error)
+{
+	SCPluginKeyfile *self = SC_PLUGIN_KEYFILE (config);
+	GPtrArray *paths;
+	GSList *added = NULL, *iter;
+	guint i;
+
+	/* Write every file before creating any connection, so that a failure
+	 * can be undone by removing the files written so far.  Monitor events
+	 * for them are only handled back in the mainloop, by which time each
+	 * file is either known or gone again.
+	 */
+	paths = g_ptr_array_new_with_free_func (g_free);
+	for (iter = connections; iter; iter = iter->next) {
+		char *path = NULL;
+
+		if (save_to_disk) {
+			if (!nm_keyfile_plugin_write_connection (iter->data, NULL, &path, error))
+				goto rollback;
+		}
+		g_ptr_array_add (paths, path);
+	}
+
+	for (iter = connections, i = 0; iter; iter = iter->next, i++) {
+		NMSettingsConnection *connection;
+
+		connection = (NMSettingsConnection *) nm_keyfile_connection_new (iter->data, paths->pdata[i], error);
+		if (!connection)
+			goto rollback;
+		added = g_slist_prepend (added, connection);
+	}
+	added = g_slist_reverse (added);
+
+	for (iter = added, i = 0; iter; iter = iter->next, i++)
+		track_connection (self, iter->data, paths->pdata[i]);
+
+	nm_log_dbg (LOGD_SETTINGS, "added %u connections", paths->len);
+	g_ptr_array_unref (paths);
+	return added;
+
+rollback:
+	g_slist_free_full (added, g_object_unref);
+	for (i = 0; i < paths->len; i++) {
+		if (paths->pdata[i])
+			g_unlink (paths->pdata[i]);
+	}
+	g_ptr_array_unref (paths);
+	return NULL;
+}
+
 static gboolean
 parse_key_file_allow_none (SCPluginKeyfilePrivate  *priv,
                            GKeyFile                *key_file,
@@ -603,6 +884,8 @@ sc_plugin_keyfile_init (SCPluginKeyfile *plugin)
 	SCPluginKeyfilePrivate *priv = SC_PLUGIN_KEYFILE_GET_PRIVATE (plugin);
 
 	priv->connections = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+	priv->file_states = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, file_state_free);
+	priv->pending_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
 
 static void
@@ -666,6 +949,15 @@ dispose (GObject *object)
 		g_object_unref (priv->monitor);
 	}
 
+	if (priv->pending_id) {
+		g_source_remove (priv->pending_id);
+		priv->pending_id = 0;
+	}
+	if (priv->pending_paths) {
+		g_hash_table_destroy (priv->pending_paths);
+		priv->pending_paths = NULL;
+	}
+
 	if (priv->conf_file_monitor) {
 		if (priv->conf_file_monitor_id)
 			g_signal_handler_disconnect (priv->conf_file_monitor, priv->conf_file_monitor_id);
@@ -681,6 +973,11 @@ dispose (GObject *object)
 		priv->connections = NULL;
 	}
 
+	if (priv->file_states) {
+		g_hash_table_destroy (priv->file_states);
+		priv->file_states = NULL;
+	}
+
 out:
 	G_OBJECT_CLASS (sc_plugin_keyfile_parent_class)->dispose (object);
 }
@@ -721,6 +1018,7 @@ system_config_interface_init (NMSystemConfigInterface *system_config_interface_c
 	system_config_interface_class->load_connection = load_connection;
 	system_config_interface_class->reload_connections = reload_connections;
 	system_config_interface_class->add_connection = add_connection;
+	system_config_interface_class->add_connections = add_connections;
 	system_config_interface_class->get_unmanaged_specs = get_unmanaged_specs;
 }
 
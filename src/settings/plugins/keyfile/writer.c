@@ -915,18 +915,38 @@ out:
 	return success;
 }
 
+/* Writes also run in the settings write pool; when a file name has to be
+ * chosen, choosing it and creating the file must not interleave between two
+ * writers, or both would pick the same name.
+ */
+static GMutex new_path_mutex;
+
 gboolean
 nm_keyfile_plugin_write_connection (NMConnection *connection,
                                     const char *existing_path,
                                     char **out_path,
                                     GError **error)
 {
-	return _internal_write_connection (connection,
-	                                   KEYFILE_DIR,
-	                                   0, 0,
-	                                   existing_path,
-	                                   out_path,
-	                                   error);
+	gboolean success;
+
+	if (existing_path) {
+		return _internal_write_connection (connection,
+		                                   KEYFILE_DIR,
+		                                   0, 0,
+		                                   existing_path,
+		                                   out_path,
+		                                   error);
+	}
+
+	g_mutex_lock (&new_path_mutex);
+	success = _internal_write_connection (connection,
+	                                      KEYFILE_DIR,
+	                                      0, 0,
+	                                      NULL,
+	                                      out_path,
+	                                      error);
+	g_mutex_unlock (&new_path_mutex);
+	return success;
 }
 
 gboolean
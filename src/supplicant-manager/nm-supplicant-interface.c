@@ -61,7 +61,7 @@ static void wpas_iface_get_props (NMSupplicantInterface *self);
 enum {
 	STATE,               /* change in the interface's state */
 	REMOVED,             /* interface was removed by the supplicant */
-	NEW_BSS,             /* interface saw a new access point from a scan */
+	NEW_BSSES,           /* interface saw new access points */
 	BSS_UPDATED,         /* a BSS property changed */
 	BSS_REMOVED,         /* supplicant removed BSS from its scan list */
 	SCAN_DONE,           /* wifi scan is complete */
@@ -106,7 +106,14 @@ typedef struct {
 	DBusGProxy *          props_proxy;
 	char *                net_path;
 	guint32               blobs_left;
-	GHashTable *          bss_proxies;
+	GHashTable *          bss_paths;    /* BSSes known to the supplicant */
+	GHashTable *          bss_proxies;  /* proxies for pending GetAll calls */
+	gboolean              bss_filter_added;
+
+	GPtrArray *           new_bss_paths;
+	GPtrArray *           new_bss_props;
+	GHashTable *          bss_fetching; /* BSSes with a pending GetAll */
+	guint                 bss_batch_id;
 
 	gint32                last_scan; /* timestamp as returned by nm_utils_get_monotonic_timestamp_s() */
 
@@ -127,12 +134,75 @@ emit_error_helper (NMSupplicantInterface *self,
 	g_signal_emit (self, signals[CONNECTION_ERROR], 0, name, err->message);
 }
 
+/* New BSSes are not announced one by one.  They are collected in
+ * new_bss_paths/new_bss_props and handed out with a single NEW_BSSES
+ * signal once the scan is done and all property fetches have returned.
+ */
 static void
-signal_new_bss (NMSupplicantInterface *self,
-                const char *object_path,
-                GHashTable *props)
+bss_batch_emit (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	GPtrArray *paths, *props;
+
+	if (!priv->new_bss_paths->len || g_hash_table_size (priv->bss_fetching))
+		return;
+
+	paths = priv->new_bss_paths;
+	props = priv->new_bss_props;
+	priv->new_bss_paths = g_ptr_array_new_with_free_func (g_free);
+	priv->new_bss_props = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_unref);
+
+	nm_log_dbg (LOGD_SUPPLICANT, "(%s): %u new BSSes", priv->dev, paths->len);
+	g_signal_emit (self, signals[NEW_BSSES], 0, paths, props);
+
+	g_ptr_array_unref (paths);
+	g_ptr_array_unref (props);
+}
+
+static gboolean
+bss_batch_emit_cb (gpointer user_data)
+{
+	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	priv->bss_batch_id = 0;
+
+	/* While scanning, wait for ScanDone */
+	if (!priv->scanning)
+		bss_batch_emit (self);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+bss_batch_schedule (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	if (!priv->bss_batch_id)
+		priv->bss_batch_id = g_idle_add (bss_batch_emit_cb, self);
+}
+
+static void
+bss_batch_clear (NMSupplicantInterface *self)
 {
-	g_signal_emit (self, signals[NEW_BSS], 0, object_path, props);
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	if (priv->bss_batch_id) {
+		g_source_remove (priv->bss_batch_id);
+		priv->bss_batch_id = 0;
+	}
+	g_ptr_array_set_size (priv->new_bss_paths, 0);
+	g_ptr_array_set_size (priv->new_bss_props, 0);
+}
+
+static void
+bss_batch_add (NMSupplicantInterface *self, const char *object_path, GHashTable *props)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	g_ptr_array_add (priv->new_bss_paths, g_strdup (object_path));
+	g_ptr_array_add (priv->new_bss_props, g_hash_table_ref (props));
+	bss_batch_schedule (self);
 }
 
 static void
@@ -144,35 +214,99 @@ bssid_properties_cb  (DBusGProxy *proxy, DBusGProxyCall *call_id, gpointer user_
 	GHashTable *props = NULL;
 
 	nm_call_store_remove (priv->other_pcalls, proxy, call_id);
+	g_hash_table_remove (priv->bss_fetching, dbus_g_proxy_get_path (proxy));
+
 	if (dbus_g_proxy_end_call (proxy, call_id, &error,
 	                           DBUS_TYPE_G_MAP_OF_VARIANT, &props,
 	                           G_TYPE_INVALID)) {
-		signal_new_bss (self, dbus_g_proxy_get_path (proxy), props);
-		g_hash_table_destroy (props);
+		bss_batch_add (self, dbus_g_proxy_get_path (proxy), props);
+		g_hash_table_unref (props);
 	} else {
 		if (!strstr (error->message, "The BSSID requested was invalid")) {
 			nm_log_warn (LOGD_SUPPLICANT, "Couldn't retrieve BSSID properties: %s.",
 			             error->message);
 		}
 		g_error_free (error);
+		bss_batch_schedule (self);
 	}
 }
 
-static void
-bss_properties_changed (DBusGProxy *proxy,
-                        const char *interface,
-                        GHashTable *props,
-                        const char **unused,
-                        gpointer user_data)
+/* A single connection filter receives the PropertiesChanged signals of all
+ * BSS objects instead of one proxy and match rule per BSS.  Only the fact
+ * that a BSS changed is passed on, which is all NMDeviceWifi looks at.
+ */
+#define BSS_PROPERTIES_CHANGED_MATCH \
+	"type='signal',sender='" WPAS_DBUS_SERVICE "'," \
+	"interface='" DBUS_INTERFACE_PROPERTIES "',member='PropertiesChanged'," \
+	"arg0='" WPAS_DBUS_IFACE_BSS "'"
+
+static DBusHandlerResult
+bss_properties_changed_filter (DBusConnection *connection,
+                               DBusMessage *message,
+                               void *user_data)
 {
 	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	DBusMessageIter iter;
+	const char *path, *interface;
 
-	if (priv->scanning)
-		priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
+	if (!dbus_message_is_signal (message, DBUS_INTERFACE_PROPERTIES, "PropertiesChanged"))
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	path = dbus_message_get_path (message);
+	if (!path || !g_hash_table_contains (priv->bss_paths, path))
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	if (   !dbus_message_iter_init (message, &iter)
+	    || dbus_message_iter_get_arg_type (&iter) != DBUS_TYPE_STRING)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	dbus_message_iter_get_basic (&iter, &interface);
+
+	if (g_strcmp0 (interface, WPAS_DBUS_IFACE_BSS) == 0) {
+		if (priv->scanning)
+			priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
+		g_signal_emit (self, signals[BSS_UPDATED], 0, path);
+	}
+
+	return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static void
+bss_filter_add (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	DBusConnection *connection;
 
-	if (g_strcmp0 (interface, WPAS_DBUS_IFACE_BSS) == 0)
-		g_signal_emit (self, signals[BSS_UPDATED], 0, dbus_g_proxy_get_path (proxy), props);
+	if (priv->bss_filter_added)
+		return;
+
+	connection = nm_dbus_manager_get_dbus_connection (priv->dbus_mgr);
+	if (!connection)
+		return;
+
+	if (!dbus_connection_add_filter (connection, bss_properties_changed_filter, self, NULL)) {
+		nm_log_warn (LOGD_SUPPLICANT, "(%s): failed to register BSS signal filter", priv->dev);
+		return;
+	}
+	dbus_bus_add_match (connection, BSS_PROPERTIES_CHANGED_MATCH, NULL);
+	priv->bss_filter_added = TRUE;
+}
+
+static void
+bss_filter_remove (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	DBusConnection *connection;
+
+	if (!priv->bss_filter_added)
+		return;
+	priv->bss_filter_added = FALSE;
+
+	connection = nm_dbus_manager_get_dbus_connection (priv->dbus_mgr);
+	if (connection) {
+		dbus_bus_remove_match (connection, BSS_PROPERTIES_CHANGED_MATCH, NULL);
+		dbus_connection_remove_filter (connection, bss_properties_changed_filter, self);
+	}
 }
 
 static void
@@ -186,9 +320,19 @@ handle_new_bss (NMSupplicantInterface *self,
 
 	g_return_if_fail (object_path != NULL);
 
-	if (g_hash_table_lookup (priv->bss_proxies, object_path))
+	if (g_hash_table_contains (priv->bss_paths, object_path))
 		return;
+	g_hash_table_add (priv->bss_paths, g_strdup (object_path));
 
+	if (props) {
+		bss_batch_add (self, object_path, props);
+		return;
+	}
+
+	/* BSSAdded normally carries the properties already; only BSSes we learn
+	 * about from the interface's BSSs property need to be fetched.  The
+	 * fetches are all started at once and the batch waits for them.
+	 */
 	bss_proxy = dbus_g_proxy_new_for_name (nm_dbus_manager_get_connection (priv->dbus_mgr),
 	                                       WPAS_DBUS_SERVICE,
 	                                       object_path,
@@ -197,29 +341,14 @@ handle_new_bss (NMSupplicantInterface *self,
 	                     (gpointer) dbus_g_proxy_get_path (bss_proxy),
 	                     bss_proxy);
 
-	/* Standard D-Bus PropertiesChanged signal */
-	dbus_g_object_register_marshaller (g_cclosure_marshal_generic,
-	                                   G_TYPE_NONE,
-	                                   G_TYPE_STRING, DBUS_TYPE_G_MAP_OF_VARIANT, G_TYPE_STRV,
-	                                   G_TYPE_INVALID);
-	dbus_g_proxy_add_signal (bss_proxy, "PropertiesChanged",
-	                         G_TYPE_STRING, DBUS_TYPE_G_MAP_OF_VARIANT, G_TYPE_STRV,
-	                         G_TYPE_INVALID);
-	dbus_g_proxy_connect_signal (bss_proxy, "PropertiesChanged",
-	                             G_CALLBACK (bss_properties_changed),
-	                             self, NULL);
-
-	if (props) {
-		signal_new_bss (self, object_path, props);
-	} else {
-		call = dbus_g_proxy_begin_call (bss_proxy, "GetAll",
-		                                bssid_properties_cb,
-		                                self,
-		                                NULL,
-		                                G_TYPE_STRING, WPAS_DBUS_IFACE_BSS,
-		                                G_TYPE_INVALID);
-		nm_call_store_add (priv->other_pcalls, bss_proxy, call);
-	}
+	call = dbus_g_proxy_begin_call (bss_proxy, "GetAll",
+	                                bssid_properties_cb,
+	                                self,
+	                                NULL,
+	                                G_TYPE_STRING, WPAS_DBUS_IFACE_BSS,
+	                                G_TYPE_INVALID);
+	nm_call_store_add (priv->other_pcalls, bss_proxy, call);
+	g_hash_table_add (priv->bss_fetching, g_strdup (object_path));
 }
 
 static void
@@ -244,10 +373,25 @@ wpas_iface_bss_removed (DBusGProxy *proxy,
 {
 	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	guint i;
+
+	/* Drop it from the pending batch, if it didn't make it out yet */
+	for (i = 0; i < priv->new_bss_paths->len; i++) {
+		if (strcmp (priv->new_bss_paths->pdata[i], object_path) == 0) {
+			g_ptr_array_remove_index (priv->new_bss_paths, i);
+			g_ptr_array_remove_index (priv->new_bss_props, i);
+			break;
+		}
+	}
 
 	g_signal_emit (self, signals[BSS_REMOVED], 0, object_path);
 
+	g_hash_table_remove (priv->bss_paths, object_path);
 	g_hash_table_remove (priv->bss_proxies, object_path);
+
+	/* Unrefing the proxy cancelled any pending GetAll; don't wait for it */
+	if (g_hash_table_remove (priv->bss_fetching, object_path))
+		bss_batch_schedule (self);
 }
 
 static int
@@ -305,6 +449,9 @@ set_state (NMSupplicantInterface *self, guint32 new_state)
 		/* Cancel all pending calls when going down */
 		nm_call_store_clear (priv->other_pcalls);
 		nm_call_store_clear (priv->assoc_pcalls);
+		g_hash_table_remove_all (priv->bss_fetching);
+		bss_batch_clear (self);
+		bss_filter_remove (self);
 
 		/* Disconnect supplicant manager state listeners since we're done */
 		if (priv->smgr_avail_id) {
@@ -368,8 +515,10 @@ set_scanning (NMSupplicantInterface *self, gboolean new_scanning)
 		priv->scanning = new_scanning;
 
 		/* Cache time of last scan completion */
-		if (priv->scanning == FALSE)
+		if (priv->scanning == FALSE) {
 			priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
+			bss_batch_schedule (self);
+		}
 
 		g_object_notify (G_OBJECT (self), "scanning");
 	}
@@ -406,6 +555,9 @@ wpas_iface_scan_done (DBusGProxy *proxy,
 
 	/* Cache last scan completed time */
 	priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
+
+	/* Hand out the scan results before announcing the scan is done */
+	bss_batch_emit (self);
 	g_signal_emit (self, signals[SCAN_DONE], 0, success);
 }
 
@@ -753,6 +905,8 @@ interface_add_done (NMSupplicantInterface *self, char *path)
 	                             self,
 	                             NULL);
 
+	bss_filter_add (self);
+
 	dbus_g_object_register_marshaller (g_cclosure_marshal_generic,
 	                                   G_TYPE_NONE,
 	                                   DBUS_TYPE_G_OBJECT_PATH, G_TYPE_STRING, G_TYPE_STRING,
@@ -1213,8 +1367,50 @@ byte_array_array_to_gvalue (const GPtrArray *array)
 	return val;
 }
 
+#define DBUS_TYPE_G_SCAN_CHANNEL            (dbus_g_type_get_struct ("GValueArray", G_TYPE_UINT, G_TYPE_UINT, G_TYPE_INVALID))
+#define DBUS_TYPE_G_ARRAY_OF_SCAN_CHANNEL   (dbus_g_type_get_collection ("GPtrArray", DBUS_TYPE_G_SCAN_CHANNEL))
+
+/* Converts frequencies (MHz) to the supplicant's (frequency, width) pairs */
+static GValue *
+freqs_to_channels_gvalue (const GArray *freqs)
+{
+	GValue *val = g_slice_new0 (GValue);
+	GPtrArray *channels;
+	guint i;
+
+	channels = g_ptr_array_new_with_free_func ((GDestroyNotify) g_value_array_free);
+	for (i = 0; i < freqs->len; i++) {
+		GValueArray *channel = g_value_array_new (2);
+		GValue item = G_VALUE_INIT;
+
+		g_value_init (&item, G_TYPE_UINT);
+		g_value_set_uint (&item, g_array_index (freqs, guint32, i));
+		g_value_array_append (channel, &item);
+		g_value_set_uint (&item, 20);
+		g_value_array_append (channel, &item);
+		g_value_unset (&item);
+
+		g_ptr_array_add (channels, channel);
+	}
+
+	g_value_init (val, DBUS_TYPE_G_ARRAY_OF_SCAN_CHANNEL);
+	g_value_take_boxed (val, channels);
+	return val;
+}
+
+/**
+ * nm_supplicant_interface_request_scan:
+ * @self: the supplicant interface
+ * @ssids: (allow-none): SSIDs to probe for
+ * @freqs: (allow-none): frequencies in MHz to limit the scan to, or %NULL
+ *   to scan all channels
+ *
+ * Returns: %TRUE if the scan request was sent
+ */
 gboolean
-nm_supplicant_interface_request_scan (NMSupplicantInterface *self, const GPtrArray *ssids)
+nm_supplicant_interface_request_scan (NMSupplicantInterface *self,
+                                      const GPtrArray *ssids,
+                                      const GArray *freqs)
 {
 	NMSupplicantInterfacePrivate *priv;
 	DBusGProxyCall *call;
@@ -1229,6 +1425,8 @@ nm_supplicant_interface_request_scan (NMSupplicantInterface *self, const GPtrArr
 	g_hash_table_insert (hash, "Type", string_to_gvalue ("active"));
 	if (ssids)
 		g_hash_table_insert (hash, "SSIDs", byte_array_array_to_gvalue (ssids));
+	if (freqs && freqs->len)
+		g_hash_table_insert (hash, "Channels", freqs_to_channels_gvalue (freqs));
 
 	call = dbus_g_proxy_begin_call (priv->iface_proxy, "Scan",
 	                                scan_request_cb,
@@ -1375,7 +1573,11 @@ nm_supplicant_interface_init (NMSupplicantInterface * self)
 	                                              WPAS_DBUS_PATH,
 	                                              WPAS_DBUS_INTERFACE);
 
+	priv->bss_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 	priv->bss_proxies = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	priv->bss_fetching = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->new_bss_paths = g_ptr_array_new_with_free_func (g_free);
+	priv->new_bss_props = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_unref);
 }
 
 static void
@@ -1422,6 +1624,9 @@ dispose (GObject *object)
 	nm_call_store_clear (priv->other_pcalls);
 	nm_call_store_destroy (priv->other_pcalls);
 
+	bss_batch_clear (NM_SUPPLICANT_INTERFACE (object));
+	bss_filter_remove (NM_SUPPLICANT_INTERFACE (object));
+
 	nm_call_store_clear (priv->assoc_pcalls);
 	nm_call_store_destroy (priv->assoc_pcalls);
 
@@ -1440,6 +1645,10 @@ dispose (GObject *object)
 		g_object_unref (priv->wpas_proxy);
 
 	g_hash_table_destroy (priv->bss_proxies);
+	g_hash_table_destroy (priv->bss_paths);
+	g_hash_table_destroy (priv->bss_fetching);
+	g_ptr_array_unref (priv->new_bss_paths);
+	g_ptr_array_unref (priv->new_bss_props);
 
 	if (priv->smgr) {
 		if (priv->smgr_avail_id)
@@ -1496,13 +1705,13 @@ nm_supplicant_interface_class_init (NMSupplicantInterfaceClass *klass)
 		              NULL, NULL, NULL,
 		              G_TYPE_NONE, 0);
 
-	signals[NEW_BSS] =
-		g_signal_new (NM_SUPPLICANT_INTERFACE_NEW_BSS,
+	signals[NEW_BSSES] =
+		g_signal_new (NM_SUPPLICANT_INTERFACE_NEW_BSSES,
 		              G_OBJECT_CLASS_TYPE (object_class),
 		              G_SIGNAL_RUN_LAST,
-		              G_STRUCT_OFFSET (NMSupplicantInterfaceClass, new_bss),
+		              G_STRUCT_OFFSET (NMSupplicantInterfaceClass, new_bsses),
 		              NULL, NULL, NULL,
-		              G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_POINTER);
+		              G_TYPE_NONE, 2, G_TYPE_POINTER, G_TYPE_POINTER);
 
 	signals[BSS_UPDATED] =
 		g_signal_new (NM_SUPPLICANT_INTERFACE_BSS_UPDATED,
@@ -1510,7 +1719,7 @@ nm_supplicant_interface_class_init (NMSupplicantInterfaceClass *klass)
 		              G_SIGNAL_RUN_LAST,
 		              G_STRUCT_OFFSET (NMSupplicantInterfaceClass, bss_updated),
 		              NULL, NULL, NULL,
-		              G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_POINTER);
+		              G_TYPE_NONE, 1, G_TYPE_STRING);
 
 	signals[BSS_REMOVED] =
 		g_signal_new (NM_SUPPLICANT_INTERFACE_BSS_REMOVED,
@@ -56,7 +56,7 @@ enum {
 
 #define NM_SUPPLICANT_INTERFACE_STATE            "state"
 #define NM_SUPPLICANT_INTERFACE_REMOVED          "removed"
-#define NM_SUPPLICANT_INTERFACE_NEW_BSS          "new-bss"
+#define NM_SUPPLICANT_INTERFACE_NEW_BSSES        "new-bsses"
 #define NM_SUPPLICANT_INTERFACE_BSS_UPDATED      "bss-updated"
 #define NM_SUPPLICANT_INTERFACE_BSS_REMOVED      "bss-removed"
 #define NM_SUPPLICANT_INTERFACE_SCAN_DONE        "scan-done"
@@ -87,15 +87,15 @@ typedef struct {
 	/* interface was removed by the supplicant */
 	void (*removed)          (NMSupplicantInterface * iface);
 
-	/* interface saw a new BSS */
-	void (*new_bss)          (NMSupplicantInterface *iface,
-	                          const char *object_path,
-	                          GHashTable *props);
+	/* interface saw new BSSes; @paths are the BSS object paths and @props
+	 * the property hashes at the same indexes */
+	void (*new_bsses)        (NMSupplicantInterface *iface,
+	                          GPtrArray *paths,
+	                          GPtrArray *props);
 
 	/* a BSS property changed */
 	void (*bss_updated)      (NMSupplicantInterface *iface,
-	                          const char *object_path,
-	                          GHashTable *props);
+	                          const char *object_path);
 
 	/* supplicant removed a BSS from its scan list */
 	void (*bss_removed)      (NMSupplicantInterface *iface,
@@ -135,7 +135,9 @@ const char * nm_supplicant_interface_get_device (NMSupplicantInterface * iface);
 
 const char *nm_supplicant_interface_get_object_path (NMSupplicantInterface * iface);
 
-gboolean nm_supplicant_interface_request_scan (NMSupplicantInterface * self, const GPtrArray *ssids);
+gboolean nm_supplicant_interface_request_scan (NMSupplicantInterface * self,
+                                               const GPtrArray *ssids,
+                                               const GArray *freqs);
 
 guint32 nm_supplicant_interface_get_state (NMSupplicantInterface * self);
 
@@ -0,0 +1,302 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "nm-properties-changed-signal.h"
+
+#include "nm-test-utils.h"
+
+/*******************************************/
+
+typedef struct {
+	GObject parent;
+	guint num;
+	char *str;
+} TestObject;
+
+typedef struct {
+	GObjectClass parent;
+} TestObjectClass;
+
+enum {
+	PROP_0,
+	PROP_NUM,
+	PROP_STR,
+};
+
+static GType test_object_get_type (void);
+
+G_DEFINE_TYPE (TestObject, test_object, G_TYPE_OBJECT)
+
+static void
+test_object_init (TestObject *self)
+{
+}
+
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	TestObject *self = (TestObject *) object;
+
+	switch (prop_id) {
+	case PROP_NUM:
+		self->num = g_value_get_uint (value);
+		break;
+	case PROP_STR:
+		g_free (self->str);
+		self->str = g_value_dup_string (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+get_property (GObject *object, guint prop_id,
+              GValue *value, GParamSpec *pspec)
+{
+	TestObject *self = (TestObject *) object;
+
+	switch (prop_id) {
+	case PROP_NUM:
+		g_value_set_uint (value, self->num);
+		break;
+	case PROP_STR:
+		g_value_set_string (value, self->str);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+finalize (GObject *object)
+{
+	g_free (((TestObject *) object)->str);
+
+	G_OBJECT_CLASS (test_object_parent_class)->finalize (object);
+}
+
+static void
+test_object_class_init (TestObjectClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->set_property = set_property;
+	object_class->get_property = get_property;
+	object_class->finalize = finalize;
+
+	g_object_class_install_property
+		(object_class, PROP_NUM,
+		 g_param_spec_uint ("num", "", "",
+		                    0, G_MAXUINT, 0,
+		                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property
+		(object_class, PROP_STR,
+		 g_param_spec_string ("str", "", "",
+		                      NULL,
+		                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	nm_properties_changed_signal_add_property (G_TYPE_FROM_CLASS (klass), "Num", "num");
+	nm_properties_changed_signal_add_property (G_TYPE_FROM_CLASS (klass), "Str", "str");
+}
+
+/*******************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	guint emitted;
+
+	/* What the last signal contained */
+	guint n_values;
+	guint num;
+	char *str;
+} EmitInfo;
+
+static void
+properties_changed_cb (GObject *object, GHashTable *hash, gpointer user_data)
+{
+	EmitInfo *info = user_data;
+	GValue *value;
+
+	info->emitted++;
+	info->n_values = g_hash_table_size (hash);
+
+	value = g_hash_table_lookup (hash, "Num");
+	info->num = value ? g_value_get_uint (value) : G_MAXUINT;
+
+	g_free (info->str);
+	value = g_hash_table_lookup (hash, "Str");
+	info->str = value ? g_value_dup_string (value) : NULL;
+
+	g_main_loop_quit (info->loop);
+}
+
+static gboolean
+loop_timeout (gpointer user_data)
+{
+	g_main_loop_quit (user_data);
+	return G_SOURCE_REMOVE;
+}
+
+/* Runs the main loop until a signal arrives or @ms have passed */
+static void
+run_loop (EmitInfo *info, guint ms)
+{
+	guint id;
+
+	id = g_timeout_add (ms, loop_timeout, info->loop);
+	g_main_loop_run (info->loop);
+	g_source_remove (id);
+}
+
+static void
+test_coalesce (void)
+{
+	TestObject *obj;
+	EmitInfo info = { NULL };
+	const NMPropertiesChangedStats *stats = nm_properties_changed_signal_get_stats ();
+	guint64 suppressed;
+
+	/* Keep the rate limit out of the way */
+	nm_properties_changed_signal_set_min_interval (0);
+
+	info.loop = g_main_loop_new (NULL, FALSE);
+	obj = g_object_new (test_object_get_type (), NULL);
+	g_signal_connect (obj, "properties-changed", G_CALLBACK (properties_changed_cb), &info);
+
+	/* Several changes in one main loop iteration result in one signal */
+	g_object_set (obj, "num", 1, NULL);
+	g_object_set (obj, "num", 2, "str", "a", NULL);
+	run_loop (&info, 1000);
+	g_assert_cmpint (info.emitted, ==, 1);
+	g_assert_cmpint (info.n_values, ==, 2);
+	g_assert_cmpint (info.num, ==, 2);
+	g_assert_cmpstr (info.str, ==, "a");
+
+	/* Setting the same values again doesn't emit anything */
+	suppressed = stats->signals_suppressed;
+	g_object_set (obj, "num", 2, "str", "a", NULL);
+	run_loop (&info, 300);
+	g_assert_cmpint (info.emitted, ==, 1);
+	g_assert_cmpint (stats->signals_suppressed, ==, suppressed + 1);
+
+	/* Only what changed is emitted */
+	g_object_set (obj, "num", 3, "str", "a", NULL);
+	run_loop (&info, 1000);
+	g_assert_cmpint (info.emitted, ==, 2);
+	g_assert_cmpint (info.n_values, ==, 1);
+	g_assert_cmpint (info.num, ==, 3);
+
+	g_object_unref (obj);
+	g_free (info.str);
+	g_main_loop_unref (info.loop);
+}
+
+static void
+test_throttle (void)
+{
+	TestObject *obj;
+	EmitInfo info = { NULL };
+	const NMPropertiesChangedStats *stats = nm_properties_changed_signal_get_stats ();
+	guint64 throttled;
+
+	/* Long enough that the test never sees it run out by itself */
+	nm_properties_changed_signal_set_min_interval (3600 * 1000);
+
+	info.loop = g_main_loop_new (NULL, FALSE);
+	obj = g_object_new (test_object_get_type (), NULL);
+	g_signal_connect (obj, "properties-changed", G_CALLBACK (properties_changed_cb), &info);
+
+	/* The first signal isn't held back */
+	g_object_set (obj, "num", 1, NULL);
+	run_loop (&info, 1000);
+	g_assert_cmpint (info.emitted, ==, 1);
+
+	/* Changes right after an emission wait for the rate limit and are
+	 * merged into one signal.
+	 */
+	throttled = stats->throttled;
+	g_object_set (obj, "num", 2, NULL);
+	while (g_main_context_iteration (NULL, FALSE));
+	g_object_set (obj, "num", 3, NULL);
+	while (g_main_context_iteration (NULL, FALSE));
+	g_assert_cmpint (info.emitted, ==, 1);
+	g_assert_cmpint (stats->throttled, ==, throttled + 1);
+
+	/* Lifting the limit releases the waiting signal with the last values */
+	nm_properties_changed_signal_set_min_interval (0);
+	run_loop (&info, 1000);
+	g_assert_cmpint (info.emitted, ==, 2);
+	g_assert_cmpint (info.num, ==, 3);
+	g_assert_cmpint (stats->throttled, ==, throttled + 1);
+
+	g_object_unref (obj);
+	g_free (info.str);
+	g_main_loop_unref (info.loop);
+}
+
+static void
+test_dispose (void)
+{
+	TestObject *obj;
+	EmitInfo info = { NULL };
+
+	nm_properties_changed_signal_set_min_interval (0);
+
+	info.loop = g_main_loop_new (NULL, FALSE);
+	obj = g_object_new (test_object_get_type (), NULL);
+	g_signal_connect (obj, "properties-changed", G_CALLBACK (properties_changed_cb), &info);
+
+	/* Changes still queued when the object is disposed are dropped, and
+	 * so are later ones.
+	 */
+	g_object_set (obj, "num", 1, NULL);
+	g_object_run_dispose (G_OBJECT (obj));
+	g_object_set (obj, "num", 2, NULL);
+	run_loop (&info, 300);
+	g_assert_cmpint (info.emitted, ==, 0);
+
+	g_object_unref (obj);
+	g_main_loop_unref (info.loop);
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	g_test_add_func ("/properties-changed/coalesce", test_coalesce);
+	g_test_add_func ("/properties-changed/throttle", test_throttle);
+	g_test_add_func ("/properties-changed/dispose", test_dispose);
+
+	return g_test_run ();
+}
@@ -83,15 +83,29 @@ def to_path(src):
     return dbus.ObjectPath("/")
 
 class ExportedObj(dbus.service.Object):
+    # path -> ExportedObj, for GetManagedObjects
+    exported = {}
+
     def __init__(self, bus, object_path):
         dbus.service.Object.__init__(self, bus, object_path)
         self._bus = bus
         self.path = object_path
         self.__dbus_ifaces = {}
+        ExportedObj.exported[object_path] = self
+
+    def remove_from_connection(self, *args, **kwargs):
+        ExportedObj.exported.pop(self.path, None)
+        dbus.service.Object.remove_from_connection(self, *args, **kwargs)
 
     def add_dbus_interface(self, dbus_iface, get_props_func):
         self.__dbus_ifaces[dbus_iface] = get_props_func
 
+    def get_managed_interfaces(self):
+        ifaces = dbus.Dictionary({}, signature='sa{sv}')
+        for iface in self.__dbus_ifaces.keys():
+            ifaces[iface] = dbus.Dictionary(self._get_dbus_properties(iface), signature='sv')
+        return ifaces
+
     def _get_dbus_properties(self, iface):
         return self.__dbus_ifaces[iface]()
 
@@ -1128,6 +1142,20 @@ class AgentManager(dbus.service.Object):
                 continue
         return secrets
 
+###################################################################
+IFACE_OBJECT_MANAGER = 'org.freedesktop.DBus.ObjectManager'
+
+class ObjectManager(dbus.service.Object):
+    def __init__(self, bus, object_path):
+        dbus.service.Object.__init__(self, bus, object_path)
+
+    @dbus.service.method(dbus_interface=IFACE_OBJECT_MANAGER, in_signature='', out_signature='a{oa{sa{sv}}}')
+    def GetManagedObjects(self):
+        objects = dbus.Dictionary({}, signature='oa{sa{sv}}')
+        for path, obj in ExportedObj.exported.items():
+            objects[dbus.ObjectPath(path)] = obj.get_managed_interfaces()
+        return objects
+
 ###################################################################
 
 def stdin_cb(io, condition):
@@ -1143,7 +1171,8 @@ def main():
 
     bus = dbus.SessionBus()
 
-    global manager, settings, agent_manager
+    global manager, settings, agent_manager, object_manager
+    object_manager = ObjectManager(bus, "/org/freedesktop")
     manager = NetworkManager(bus, "/org/freedesktop/NetworkManager")
     settings = Settings(bus, "/org/freedesktop/NetworkManager/Settings")
     agent_manager = AgentManager(bus, "/org/freedesktop/NetworkManager/AgentManager")
@@ -0,0 +1,408 @@
+#!/usr/bin/env python
+# -*- Mode: python; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+
+# A mock of wpa_supplicant's D-Bus interface (fi.w1.wpa_supplicant1) for
+# benchmarking NetworkManager's scan handling without radio hardware.
+#
+# Every scan "finds" a set of BSSes, either generated (--bsses N) or replayed
+# from a recording (--replay FILE).  A recording is a JSON list of objects
+# with the keys "bssid", "ssid", "frequency", "signal" (dBm), and optionally
+# "privacy" (bool) and "rsn" (list of key management suites, e.g. ["wpa-psk"]).
+#
+# The org.freedesktop.NetworkManager.TestSupplicant interface on the root
+# object lets the benchmark script changes:
+#
+#   Churn(u count)           replace @count BSSes with new ones at the next scan
+#   SetSignal(s bssid, i dbm)  change a BSS's signal and notify right away
+#   GetStats() -> a{su}      counts of signals sent and method calls received
+#   ResetStats()
+
+from __future__ import print_function
+
+from gi.repository import GLib
+import sys
+import json
+import random
+import argparse
+import dbus
+import dbus.service
+import dbus.mainloop.glib
+
+mainloop = GLib.MainLoop()
+
+WPAS_SERVICE = 'fi.w1.wpa_supplicant1'
+WPAS_PATH = '/fi/w1/wpa_supplicant1'
+IFACE_WPAS = 'fi.w1.wpa_supplicant1'
+IFACE_INTERFACE = IFACE_WPAS + '.Interface'
+IFACE_BSS = IFACE_WPAS + '.BSS'
+IFACE_TEST = 'org.freedesktop.NetworkManager.TestSupplicant'
+
+# How long a scan takes, in milliseconds
+SCAN_DURATION = 50
+
+stats = {}
+
+def count(what):
+    stats[what] = stats.get(what, 0) + 1
+
+#########################################################
+IFACE_DBUS = 'org.freedesktop.DBus'
+
+class UnknownInterfaceException(dbus.DBusException):
+    _dbus_error_name = IFACE_DBUS + '.UnknownInterface'
+
+class UnknownPropertyException(dbus.DBusException):
+    _dbus_error_name = IFACE_DBUS + '.UnknownProperty'
+
+class InvalidArgsException(dbus.DBusException):
+    _dbus_error_name = IFACE_WPAS + '.InvalidArgs'
+
+class InterfaceExistsException(dbus.DBusException):
+    _dbus_error_name = IFACE_WPAS + '.InterfaceExists'
+
+class InterfaceUnknownException(dbus.DBusException):
+    _dbus_error_name = IFACE_WPAS + '.InterfaceUnknown'
+
+class ExportedObj(dbus.service.Object):
+    def __init__(self, bus, object_path):
+        dbus.service.Object.__init__(self, bus, object_path)
+        self._bus = bus
+        self.path = object_path
+        self.__dbus_ifaces = {}
+
+    def add_dbus_interface(self, dbus_iface, get_props_func):
+        self.__dbus_ifaces[dbus_iface] = get_props_func
+
+    def _get_dbus_properties(self, iface):
+        return self.__dbus_ifaces[iface]()
+
+    @dbus.service.method(dbus_interface=dbus.PROPERTIES_IFACE, in_signature='s', out_signature='a{sv}')
+    def GetAll(self, iface):
+        count('method:GetAll')
+        if iface not in self.__dbus_ifaces.keys():
+            raise UnknownInterfaceException()
+        return self._get_dbus_properties(iface)
+
+    @dbus.service.method(dbus_interface=dbus.PROPERTIES_IFACE, in_signature='ss', out_signature='v')
+    def Get(self, iface, name):
+        count('method:Get')
+        if iface not in self.__dbus_ifaces.keys():
+            raise UnknownInterfaceException()
+        props = self._get_dbus_properties(iface)
+        if not name in props.keys():
+            raise UnknownPropertyException()
+        return props[name]
+
+    @dbus.service.method(dbus_interface=dbus.PROPERTIES_IFACE, in_signature='ssv', out_signature='')
+    def Set(self, iface, name, value):
+        count('method:Set')
+
+    @dbus.service.signal(dbus.PROPERTIES_IFACE, signature='sa{sv}as')
+    def PropertiesChanged(self, iface, changed, invalidated):
+        count('signal:PropertiesChanged')
+
+###################################################################
+
+def random_mac():
+    return '%02x:%02x:%02x:%02x:%02x:%02x' % (
+        0x02, random.randint(0, 255), random.randint(0, 255),
+        random.randint(0, 255), random.randint(0, 255), random.randint(0, 255)
+    )
+
+def mac_to_bytes(mac):
+    return dbus.ByteArray(bytes(bytearray(int(b, 16) for b in mac.split(':'))))
+
+CHANNELS = [ 2412, 2437, 2462, 5180, 5200, 5220, 5240, 5745, 5765, 5785 ]
+
+def random_bss_info(n):
+    return {
+        'bssid': random_mac(),
+        'ssid': 'bench-%d' % (n % 50),
+        'frequency': random.choice(CHANNELS),
+        'signal': random.randint(-90, -30),
+        'privacy': True,
+        'rsn': [ 'wpa-psk' ],
+    }
+
+class Bss(ExportedObj):
+    def __init__(self, bus, iface_path, n, info):
+        ExportedObj.__init__(self, bus, "%s/BSSs/%d" % (iface_path, n))
+        self.add_dbus_interface(IFACE_BSS, self.__get_props)
+        self.info = info
+
+    def __get_props(self):
+        info = self.info
+        props = {}
+        props['BSSID'] = mac_to_bytes(info['bssid'])
+        props['SSID'] = dbus.ByteArray(info['ssid'].encode('utf-8'))
+        props['Mode'] = 'infrastructure'
+        props['Frequency'] = dbus.UInt16(info['frequency'])
+        props['Signal'] = dbus.Int16(info['signal'])
+        props['Privacy'] = dbus.Boolean(info.get('privacy', False))
+        props['Rates'] = dbus.Array([ dbus.UInt32(54000000) ], signature='u')
+        props['WPA'] = dbus.Dictionary({ 'KeyMgmt': dbus.Array([], signature='s') }, signature='sv')
+        props['RSN'] = dbus.Dictionary({
+            'KeyMgmt': dbus.Array(info.get('rsn', []), signature='s'),
+            'Pairwise': dbus.Array([ 'ccmp' ] if info.get('rsn') else [], signature='s'),
+            'Group': 'ccmp',
+        }, signature='sv')
+        return props
+
+    def set_signal(self, signal):
+        self.info['signal'] = signal
+        self.PropertiesChanged(IFACE_BSS, { 'Signal': dbus.Int16(signal) }, [])
+
+###################################################################
+
+class Interface(ExportedObj):
+    counter = 0
+
+    def __init__(self, bus, ifname, source):
+        path = "%s/Interfaces/%d" % (WPAS_PATH, Interface.counter)
+        Interface.counter = Interface.counter + 1
+        ExportedObj.__init__(self, bus, path)
+        self.add_dbus_interface(IFACE_INTERFACE, self.__get_props)
+        self.ifname = ifname
+        self.source = source
+        self.bsses = {}
+        self.bss_counter = 0
+        self.churn = 0
+        self.scanning = False
+
+    def __get_props(self):
+        props = {}
+        props['State'] = 'disconnected'
+        props['Scanning'] = dbus.Boolean(self.scanning)
+        props['Ifname'] = self.ifname
+        props['BSSs'] = dbus.Array([ b.path for b in self.bsses.values() ], signature='o')
+        props['Capabilities'] = dbus.Dictionary({
+            'Scan': dbus.Array([ 'active', 'passive', 'ssid' ], signature='s'),
+            'MaxScanSSID': dbus.Int32(4),
+            'Modes': dbus.Array([ 'infrastructure', 'ad-hoc', 'ap' ], signature='s'),
+        }, signature='sv')
+        props['DisconnectReason'] = dbus.Int32(0)
+        return props
+
+    def __notify(self, propname):
+        props = self.__get_props()
+        self.InterfacePropertiesChanged({ propname: props[propname] })
+
+    # wpa_supplicant emits its own PropertiesChanged on the Interface
+    # interface, which would clash with ExportedObj's by name
+    def _iface_properties_changed(self, changed):
+        count('signal:Interface.PropertiesChanged')
+    _iface_properties_changed.__name__ = 'PropertiesChanged'
+    InterfacePropertiesChanged = dbus.service.signal(IFACE_INTERFACE, signature='a{sv}')(_iface_properties_changed)
+
+    @dbus.service.signal(IFACE_INTERFACE, signature='oa{sv}')
+    def BSSAdded(self, path, props):
+        count('signal:BSSAdded')
+
+    @dbus.service.signal(IFACE_INTERFACE, signature='o')
+    def BSSRemoved(self, path):
+        count('signal:BSSRemoved')
+
+    @dbus.service.signal(IFACE_INTERFACE, signature='b')
+    def ScanDone(self, success):
+        count('signal:ScanDone')
+
+    @dbus.service.method(dbus_interface=IFACE_INTERFACE, in_signature='a{sv}', out_signature='')
+    def Scan(self, args):
+        count('method:Scan')
+        if self.scanning:
+            return
+        self.scanning = True
+        self.__notify('Scanning')
+        GLib.timeout_add(SCAN_DURATION, self.__scan_done_cb, args.get('Channels'))
+
+    def __add_bss(self, info):
+        bss = Bss(self._bus, self.path, self.bss_counter, info)
+        self.bss_counter = self.bss_counter + 1
+        self.bsses[info['bssid']] = bss
+        self.BSSAdded(bss.path, bss._get_dbus_properties(IFACE_BSS))
+
+    def __remove_bss(self, bssid):
+        bss = self.bsses.pop(bssid)
+        self.BSSRemoved(bss.path)
+        bss.remove_from_connection()
+
+    def __scan_done_cb(self, channels):
+        freqs = None
+        if channels:
+            freqs = [ int(c[0]) for c in channels ]
+
+        # Replace some BSSes by new ones, as if the device moved
+        for bssid in list(self.bsses.keys())[:self.churn]:
+            self.__remove_bss(bssid)
+            self.source.remove(bssid)
+            self.source.add()
+        self.churn = 0
+
+        for info in self.source.bsses():
+            if freqs and info['frequency'] not in freqs:
+                continue
+            bss = self.bsses.get(info['bssid'])
+            if bss:
+                bss.PropertiesChanged(IFACE_BSS, { 'Signal': dbus.Int16(info['signal']) }, [])
+            else:
+                self.__add_bss(info)
+
+        self.scanning = False
+        self.__notify('Scanning')
+        self.ScanDone(True)
+        return False
+
+    @dbus.service.method(dbus_interface=IFACE_INTERFACE, in_signature='', out_signature='')
+    def Disconnect(self):
+        count('method:Disconnect')
+
+    @dbus.service.method(dbus_interface=IFACE_INTERFACE, in_signature='o', out_signature='')
+    def RemoveNetwork(self, path):
+        count('method:RemoveNetwork')
+
+    @dbus.service.method(dbus_interface=IFACE_INTERFACE, in_signature='oss', out_signature='')
+    def NetworkReply(self, path, field, value):
+        count('method:NetworkReply')
+        raise InvalidArgsException('Invalid network')
+
+    @dbus.service.method(dbus_interface=IFACE_INTERFACE, in_signature='s', out_signature='')
+    def ProbeRequest(self, arg):
+        pass
+
+    def set_signal(self, bssid, signal):
+        bss = self.bsses.get(bssid)
+        if not bss:
+            raise InvalidArgsException('Unknown BSS %s' % bssid)
+        bss.set_signal(signal)
+
+###################################################################
+
+class BssSource(object):
+    def __init__(self, replay, n):
+        self.counter = 0
+        if replay:
+            with open(replay) as f:
+                recorded = json.load(f)
+            self.infos = dict((i['bssid'], i) for i in recorded)
+        else:
+            self.infos = {}
+            for i in range(0, n):
+                self.add()
+
+    def add(self):
+        info = random_bss_info(self.counter)
+        self.counter = self.counter + 1
+        self.infos[info['bssid']] = info
+
+    def remove(self, bssid):
+        self.infos.pop(bssid, None)
+
+    def bsses(self):
+        return list(self.infos.values())
+
+class Supplicant(ExportedObj):
+    def __init__(self, bus, source):
+        ExportedObj.__init__(self, bus, WPAS_PATH)
+        self.add_dbus_interface(IFACE_WPAS, self.__get_props)
+        self.source = source
+        self.interfaces = {}
+
+    def __get_props(self):
+        props = {}
+        props['Capabilities'] = dbus.Array([ 'ap' ], signature='s')
+        props['EapMethods'] = dbus.Array([ 'MD5', 'TLS', 'PEAP', 'TTLS' ], signature='s')
+        props['Interfaces'] = dbus.Array([ i.path for i in self.interfaces.values() ], signature='o')
+        props['DebugLevel'] = 'info'
+        return props
+
+    @dbus.service.method(dbus_interface=IFACE_WPAS, in_signature='a{sv}', out_signature='o')
+    def CreateInterface(self, args):
+        count('method:CreateInterface')
+        ifname = args.get('Ifname')
+        if not ifname:
+            raise InvalidArgsException('No Ifname')
+        if ifname in self.interfaces:
+            raise InterfaceExistsException('Interface %s exists' % ifname)
+        iface = Interface(self._bus, ifname, self.source)
+        self.interfaces[ifname] = iface
+        return dbus.ObjectPath(iface.path)
+
+    @dbus.service.method(dbus_interface=IFACE_WPAS, in_signature='s', out_signature='o')
+    def GetInterface(self, ifname):
+        count('method:GetInterface')
+        if ifname not in self.interfaces:
+            raise InterfaceUnknownException('No interface %s' % ifname)
+        return dbus.ObjectPath(self.interfaces[ifname].path)
+
+    @dbus.service.method(dbus_interface=IFACE_WPAS, in_signature='o', out_signature='')
+    def RemoveInterface(self, path):
+        count('method:RemoveInterface')
+        for ifname, iface in list(self.interfaces.items()):
+            if iface.path == path:
+                del self.interfaces[ifname]
+                iface.remove_from_connection()
+                return
+        raise InterfaceUnknownException('No interface %s' % path)
+
+    # Benchmark control
+    @dbus.service.method(dbus_interface=IFACE_TEST, in_signature='u', out_signature='')
+    def Churn(self, n):
+        for iface in self.interfaces.values():
+            iface.churn = n
+
+    @dbus.service.method(dbus_interface=IFACE_TEST, in_signature='si', out_signature='')
+    def SetSignal(self, bssid, signal):
+        for iface in self.interfaces.values():
+            iface.set_signal(bssid, signal)
+
+    @dbus.service.method(dbus_interface=IFACE_TEST, in_signature='', out_signature='a{su}')
+    def GetStats(self):
+        return dbus.Dictionary(stats, signature='su')
+
+    @dbus.service.method(dbus_interface=IFACE_TEST, in_signature='', out_signature='')
+    def ResetStats(self):
+        stats.clear()
+
+###################################################################
+
+def stdin_cb(io, condition):
+    mainloop.quit()
+
+def main():
+    parser = argparse.ArgumentParser(description='Mock wpa_supplicant D-Bus service')
+    parser.add_argument('--bsses', type=int, default=300,
+                        help='number of BSSes to generate (default: 300)')
+    parser.add_argument('--replay', metavar='FILE',
+                        help='JSON file with recorded scan results')
+    parser.add_argument('--system', action='store_true',
+                        help='use the system bus instead of the session bus')
+    args = parser.parse_args()
+
+    dbus.mainloop.glib.DBusGMainLoop(set_as_default=True)
+
+    random.seed(42)
+
+    if args.system:
+        bus = dbus.SystemBus()
+    else:
+        bus = dbus.SessionBus()
+
+    global supplicant
+    supplicant = Supplicant(bus, BssSource(args.replay, args.bsses))
+
+    if not bus.request_name(WPAS_SERVICE):
+        sys.exit(1)
+
+    # Watch stdin; if it closes, assume our parent has crashed, and exit
+    io = GLib.IOChannel.unix_new(0)
+    io.add_watch(GLib.IOCondition.HUP, stdin_cb)
+
+    try:
+        mainloop.run()
+    except Exception as e:
+        pass
+
+    sys.exit(0)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,175 @@
+#!/usr/bin/env python
+# -*- Mode: python; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+# Copyright (C) 2015 Red Hat, Inc.
+#
+# Shows what NetworkManager was waiting for before "startup complete", from
+# an activation trace: either a file written by the "trace-file" option or,
+# without arguments, the trace of the running daemon.
+#
+# Startup completes once no device has a pending action any more, so the
+# device whose pending action ended last is on the critical path.  If it had
+# to wait for its master or VLAN parent, the path continues there.
+
+from __future__ import print_function
+
+import argparse
+import json
+import sys
+
+def load_trace(path):
+    if path:
+        with open(path) as f:
+            return json.load(f)
+
+    import dbus
+    bus = dbus.SystemBus()
+    proxy = bus.get_object('org.freedesktop.NetworkManager', '/org/freedesktop/NetworkManager')
+    manager = dbus.Interface(proxy, 'org.freedesktop.NetworkManager')
+    return json.loads(str(manager.GetTrace()))
+
+class Trace(object):
+    def __init__(self, data):
+        self.subjects = {}
+        self.spans = []
+        self.instants = []
+
+        for ev in data['traceEvents']:
+            if ev['ph'] == 'M':
+                self.subjects[ev['tid']] = ev['args']['name']
+        for ev in data['traceEvents']:
+            subject = self.subjects.get(ev['tid'], str(ev['tid']))
+            if ev['ph'] == 'X':
+                self.spans.append((ev['ts'], ev['ts'] + ev['dur'], subject, ev['cat'], ev['name']))
+            elif ev['ph'] == 'i':
+                self.instants.append((ev['ts'], subject, ev['cat'], ev['name']))
+        self.spans.sort()
+        self.instants.sort()
+
+        times = [s[0] for s in self.spans] + [i[0] for i in self.instants]
+        self.origin = min(times) if times else 0
+
+    def ms(self, ts):
+        return (ts - self.origin) / 1000.0
+
+    def startup_complete(self):
+        for ts, subject, cat, name in self.instants:
+            if cat == 'manager' and name == 'startup complete':
+                return ts
+        return None
+
+    def gate(self, until):
+        # The pending action that ended last before startup completed
+        best = None
+        for span in self.spans:
+            if span[3] != 'pending':
+                continue
+            if until is not None and span[1] > until:
+                continue
+            if best is None or span[1] > best[1]:
+                best = span
+        return best
+
+    def activation_start(self, subject, end):
+        start = None
+        for begin, finish, subj, cat, name in self.spans:
+            if subj == subject and cat == 'state' and name == 'prepare' and begin <= end:
+                start = begin
+        if start is None:
+            for begin, finish, subj, cat, name in self.spans:
+                if subj == subject and begin <= end:
+                    return begin
+            return end
+        return start
+
+    def waited_for(self, subject, start, end):
+        # The last device @subject waited for, and when it could go on
+        for ts, subj, cat, name in reversed(self.instants):
+            if subj != subject or ts < start or ts > end:
+                continue
+            if name.startswith('waiting for '):
+                resumed = end
+                for begin, finish, s, c, n in self.spans:
+                    if s == subject and c == 'state' and begin > ts and n != 'prepare':
+                        resumed = begin
+                        break
+                return name[len('waiting for '):], ts, resumed
+        return None
+
+    def report(self, subject, start, end, note, top):
+        print('%s%s: %.1f ms - %.1f ms (%.1f ms)'
+              % (subject, note, self.ms(start), self.ms(end), (end - start) / 1000.0))
+        for begin, finish, subj, cat, name in self.spans:
+            if subj == subject and cat == 'state' and finish > start and begin < end:
+                print('    %-14s %8.1f ms' % (name, (min(finish, end) - max(begin, start)) / 1000.0))
+
+        busy = [s for s in self.spans
+                if s[2] == subject and s[3] not in ('state', 'pending')
+                and s[1] > start and s[0] < end]
+        busy.sort(key=lambda s: s[1] - s[0], reverse=True)
+        for begin, finish, subj, cat, name in busy[:top]:
+            print('    longest: %s %s %.1f ms at %.1f ms'
+                  % (cat, name, (finish - begin) / 1000.0, self.ms(begin)))
+
+def main():
+    parser = argparse.ArgumentParser(description='Show the critical path to NetworkManager\'s "startup complete".')
+    parser.add_argument('file', nargs='?',
+                        help='trace file; the running daemon\'s trace is used if not given')
+    parser.add_argument('--top', type=int, default=3,
+                        help='number of longest operations to show per device')
+    args = parser.parse_args()
+
+    trace = Trace(load_trace(args.file))
+
+    complete = trace.startup_complete()
+    if complete is None:
+        print('startup not complete yet, or no longer in the trace')
+    else:
+        print('startup complete at %.1f ms' % trace.ms(complete))
+
+    gate = trace.gate(complete)
+    if gate is None:
+        print('no pending actions in the trace')
+        return 1
+    print('last pending action: %s "%s" ended at %.1f ms\n'
+          % (gate[2], gate[4], trace.ms(gate[1])))
+
+    # Follow the dependencies back from the gating device
+    path = []
+    subject = gate[2]
+    end = gate[1]
+    seen = set()
+    while subject not in seen:
+        seen.add(subject)
+        start = trace.activation_start(subject, end)
+        wait = trace.waited_for(subject, start, end)
+        if not wait:
+            path.append((subject, start, end, ''))
+            break
+        dep, waited, resumed = wait
+        path.append((subject, resumed, end, ''))
+        path.append((subject, start, waited, ' (until waiting for %s)' % dep))
+        subject = dep
+        end = resumed
+
+    for subject, start, end, note in reversed(path):
+        trace.report(subject, start, end, note, args.top)
+        print()
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())